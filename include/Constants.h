@@ -22,11 +22,71 @@ namespace constants
     inline constexpr const char* ConfigKeyOvernightSleepStart = "n";
     inline constexpr const char* ConfigKeyOvernightSleepLength = "l";
     inline constexpr const char* ConfigKeyDisplaySimpleBattery = "b";
+    inline constexpr const char* ConfigKeyWatchlist = "w";
 
     inline constexpr const char* ConfigDisplayModeSimple = "simple";
     inline constexpr const char* ConfigDisplayModeAdvanced = "advanced";
 
+    // a watchlist of several cryptos is shown as a table of current prices, a page of them each wake
+    inline constexpr const int WatchlistMaxSymbols = 10;
+    inline constexpr const int WatchlistSymbolsPerPage = 4;
+
+    // the BSSID, channel and DHCP lease of the last connection are kept across deep sleep to reconnect without
+    // a scan or DHCP, if that doesn't connect in time the normal connection is used instead
+    inline constexpr const unsigned long WiFiFastConnectTimeoutMillis = 3000;
+    inline constexpr const unsigned long WiFiFullConnectTimeoutMillis = 7500;
+    // the lease is renewed with DHCP after being reused this many times, in case the router has changed it
+    inline constexpr const int WiFiStaticLeaseMaxUses = 24;
+
     inline constexpr const int WiFiRequestRetries = 2;
+    inline constexpr const unsigned long HttpReadTimeoutMillis = 5000; // give up if nothing received for this long
+    inline constexpr const unsigned long TlsConnectTimeoutMillis = 5000;
+    inline constexpr const unsigned long TlsHandshakeTimeoutMillis = 10000;
+
+    // TLS sessions for each data source host are kept across deep sleep so the next wake can resume them
+    // one slot per host, sessions too big for a slot are saved to SPIFFS instead
+    inline constexpr const int TlsSessionCacheSlots = 3;
+    inline constexpr const int TlsSessionRtcSlotBytes = 320;
+
+    // results of recent requests for each (source, crypto, fiat, unix offset) are kept across deep sleep
+    inline constexpr const int SourceScoreboardSlots = 24;
+    inline constexpr const int SourceScoreboardLatencySamples = 5;
+    // after this many failures in a row a combination isn't tried for a cooldown, which doubles with each
+    // further failure up to the max
+    inline constexpr const int SourceFailuresBeforeCooldown = 2;
+    inline constexpr const long SourceCooldownBaseSeconds = 600;
+    inline constexpr const long SourceCooldownMaxSeconds = 21600;
+    // latency assumed for a combination that hasn't been tried, so known working sources stay ahead of it
+    inline constexpr const unsigned long SourceUnknownLatencyMillis = 1500;
+
+    // a single history request is used when at least this many historical prices are needed
+    inline constexpr const int PriceHistoryMinOffsets = 2;
+    // a history sample is only used for an offset if it is within (offset / divisor) of the requested time
+    // e.g. within 1 day for 1M, but within 48 mins for 1d so daily samples will not be used for it
+    inline constexpr const long PriceHistoryMaxSampleErrorDivisor = 30;
+
+    // daily prices kept on the device for each crypto/fiat, enough for 1Y with some to spare
+    inline constexpr const int PriceStoreMaxDays = 400;
+    // current prices kept from earlier wakes, at least this far apart so they cover just over a day
+    inline constexpr const int PriceStoreRecentSamples = 56;
+    inline constexpr const long PriceStoreRecentSpacingSeconds = 1800;
+
+    // timings of the phases of the last few wakes are kept across deep sleep, and appended to a log in SPIFFS
+    // every few wakes so flash is written rarely
+    inline constexpr const int WakeTimingCycles = 16;
+    inline constexpr const int WakeTimingFlushCycles = 8;
+    // the log is moved to the old file when it gets this big, so the last ~2700 wakes are kept
+    inline constexpr const unsigned long WakeTimingLogMaxBytes = 65536;
+
+    // the parts of the price display that changed are refreshed on their own, with a full refresh after this
+    // many to clear the ghosting partial refreshes leave, any other screen is always a full refresh
+    inline constexpr const int DisplayPartialRefreshesBeforeFull = 10;
+    // most separate windows of changed bytes sent for a partial refresh, more are joined together
+    inline constexpr const int DisplayMaxDirtyRects = 8;
+    // for the task that brings the panel up while the WiFi is busy
+    inline constexpr const int DisplayInitTaskStackBytes = 4096;
+    // longest light sleep while the panel is busy before checking BUSY again, in case its wakeup is missed
+    inline constexpr const uint64_t DisplayBusySleepMaxMillis = 1000;
 
     inline constexpr const int MicrosToSecondsFactor = 1000000;
 
@@ -40,10 +100,48 @@ namespace constants
 
     inline constexpr const char* SpiffsConfigFileName = "/config.json";
     inline constexpr const char* SpiffsBatLogFileName = "/low_battery.txt";
+    inline constexpr const char* SpiffsWakeTimingFileName = "/wake_timings.bin";
+    inline constexpr const char* SpiffsWakeTimingOldFileName = "/wake_timings.old";
 
     inline constexpr const int MinimumAllowedBatteryPercent = 10;
     inline constexpr const int NtpResyncTimeoutSeconds = 15;
 
+    inline constexpr const char* NtpServer = "pool.ntp.org";
+    inline constexpr const unsigned long NtpSyncTimeoutMillis = 5000;
+    inline constexpr const long MinValidEpoch = 1700000000; // anything before is a clock that was never set
+
+    // the time kept through deep sleep is used without NTP until it could be out by more than this
+    inline constexpr const float TimeMaxPredictedErrorSeconds = 30;
+    // the RTC slow clock can drift by ~20 seconds per hour, until it has been measured assume it could be that far out
+    inline constexpr const float RtcDriftDefaultUncertaintySecondsPerHour = 20;
+    inline constexpr const float RtcDriftMinUncertaintySecondsPerHour = 1;
+    inline constexpr const long RtcDriftLearnMinSeconds = 1800; // shorter gaps between syncs are too noisy to learn from
+    inline constexpr const float RtcDriftLearnRate = 0.3f;
+
+    // the chain of overnight sleeps ends this long before the end of the sleep, to resync the time before the last
+    // one, scaled by how far the time could drift during the chain
+    inline constexpr const int OvernightSleepMinReserveSeconds = 60;
+    inline constexpr const int OvernightSleepMaxReserveSeconds = 600;
+
+    // RTC slow memory is 8 KB, 512 bytes of which the linker script keeps for the ULP, everything kept through deep
+    // sleep has to fit in the rest, each module checks what it keeps against its share so a new RTC_DATA_ATTR that
+    // would overflow it fails to compile in that module instead of at link time or not at all
+    inline constexpr const unsigned int RtcSlowMemoryBytes = 8192 - 512;
+    inline constexpr const unsigned int RtcBytesDisplay = 4032; // the frame on the panel, to diff the next one against
+    inline constexpr const unsigned int RtcBytesTlsSessions = 1040;
+    inline constexpr const unsigned int RtcBytesPriceHistory = 752;
+    inline constexpr const unsigned int RtcBytesWakeTimer = 784;
+    inline constexpr const unsigned int RtcBytesSourceScoreboard = 688;
+    inline constexpr const unsigned int RtcBytesTimeKeeper = 48;
+    inline constexpr const unsigned int RtcBytesWiFiProfile = 48;
+    inline constexpr const unsigned int RtcBytesMain = 64;
+    inline constexpr const unsigned int RtcBytesReserved = 128; // arduino core and esp-idf variables, padding
+    static_assert(RtcBytesDisplay + RtcBytesTlsSessions + RtcBytesPriceHistory + RtcBytesWakeTimer +
+                          RtcBytesSourceScoreboard + RtcBytesTimeKeeper + RtcBytesWiFiProfile + RtcBytesMain +
+                          RtcBytesReserved <=
+                      RtcSlowMemoryBytes,
+                  "the RTC memory shares add up to more than there is, keep the frame in SPIFFS instead");
+
     inline constexpr const char* AdminPageUsername = "admin";
     inline constexpr const char* AdminPagePassword = "pass";
 }
@@ -8,10 +8,26 @@ DisplayManager::DisplayManager() :
 
 DisplayManager::~DisplayManager() = default;
 
-void DisplayManager::writeDisplay(const String& crypto, const String& fiat, std::map<long, float>& priceData, const String& dayMonth, 
+void DisplayManager::initInBackground()
+{
+    m_impl->initInBackground();
+}
+
+void DisplayManager::setLightSleepWhileBusy(bool lightSleep)
+{
+    m_impl->setLightSleepWhileBusy(lightSleep);
+}
+
+void DisplayManager::writeDisplay(const String& crypto, const String& fiat, const Quotes& quotes, const String& dayMonth, 
                                   const String& time, const int batteryPercent)
 {    
-    m_impl->writeDisplay(crypto, fiat, priceData, dayMonth, time, batteryPercent);
+    m_impl->writeDisplay(crypto, fiat, quotes, dayMonth, time, batteryPercent);
+}
+
+void DisplayManager::writeWatchlist(const std::vector<String>& cryptos, const String& fiat, const std::map<String, Price>& prices,
+                                    const int page, const int numPages, const String& dayMonth, const String& time)
+{
+    m_impl->writeWatchlist(cryptos, fiat, prices, page, numPages, dayMonth, time);
 }
 
 void DisplayManager::writeGenericText(const String& textToWrite)
@@ -4,17 +4,34 @@
 #include <Arduino.h>
 #include <memory>
 #include <map>
+#include <vector>
+
+#include "Price.h"
+#include "Quotes.h"
 
 class DisplayManagerImpl;
 
+// the prices each layout of writeDisplay shows, the advanced layout is drawn if quotes has all of its timeframes,
+// otherwise the simple one if it has all of those
+inline constexpr TimeframeSet SimpleLayoutTimeframes = {Timeframe::NOW, Timeframe::ONE_DAY};
+inline constexpr TimeframeSet AdvancedLayoutTimeframes = {Timeframe::NOW, Timeframe::ONE_DAY, Timeframe::THIRTY_DAYS,
+                                                          Timeframe::ONE_YEAR};
+
 class DisplayManager
 {
 public:
     DisplayManager();
     ~DisplayManager();
 
-    void writeDisplay(const String& crypto, const String& fiat, std::map<long, float>& priceData, const String& dayMonth, 
+    // the panel is brought up on the first draw, this starts it in the background while something else runs
+    void initInBackground();
+    // the CPU light sleeps through each refresh unless told not to, e.g. with the access point up
+    void setLightSleepWhileBusy(bool lightSleep);
+
+    void writeDisplay(const String& crypto, const String& fiat, const Quotes& quotes, const String& dayMonth, 
                       const String& time, const int batteryPercent);
+    void writeWatchlist(const std::vector<String>& cryptos, const String& fiat, const std::map<String, Price>& prices,
+                        const int page, const int numPages, const String& dayMonth, const String& time);
     void writeGenericText(const String& textToWrite);
     void hibernate();
 
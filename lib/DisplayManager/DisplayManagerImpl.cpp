@@ -1,8 +1,14 @@
 #include "DisplayManagerImpl.h"
+#include "DisplayManager.h"
 #include "Utils.h"
 
 #include "bitmaps.h"
 #include "Constants.h"
+#include "WakeTimer.h"
+#include "FrameDiff.h"
+#include "TextLayout.h"
+
+#include <driver/gpio.h>
 
 #include "FreeSansBold24pt7b_edit.h"
 #include <Fonts/FreeSans12pt7b.h>
@@ -13,26 +19,140 @@
 #include <Fonts/FreeMono9pt7b.h>
 #include <Fonts/Org_01.h>
 
+namespace
+{
+    // what the panel shows, which it keeps showing through deep sleep, so a wake that would draw exactly the
+    // same frame can leave the panel alone, or only send the parts of it that changed
+    struct PanelState
+    {
+        uint32_t shownFingerprint;  // of the whole frame, 0 if it isn't known
+        uint32_t layoutFingerprint; // of what stays put between partial refreshes, 0 if it can't be partially refreshed
+        int partialRefreshes;       // since the last full refresh
+    };
+    RTC_DATA_ATTR PanelState panel = {};
+    // the frame last sent to the panel to diff the next one against, only used while the layout is the same so
+    // it is known to be valid. About half of the RTC slow memory - RTC fast memory can only be reached from the
+    // core the sketch doesn't run on
+    RTC_DATA_ATTR uint8_t shownFrame[DisplayManagerImpl::FrameBytes];
+    static_assert(sizeof(panel) + sizeof(shownFrame) <= constants::RtcBytesDisplay, "over the display's RTC share");
+
+    // tried in turn for the crypto symbol until one fits in the crypto box
+    const GFXfont* const CryptoBoxFonts[] = {&FreeSans18pt7b, &FreeSans12pt7b, &FreeSans9pt7b};
+
+    // high while the panel is refreshing or powering off
+    constexpr gpio_num_t BusyPin = GPIO_NUM_4;
+
+    // of everything that decides the pixels of a frame: the name of the screen, then the text drawn on it
+    uint32_t fingerprint(const std::vector<String>& parts)
+    {
+        uint32_t hash = utils::hash(nullptr, 0);
+        for (const String& part : parts)
+            hash = utils::hash(part.c_str(), part.length() + 1, hash); // with the terminator, so "ab","c" != "a","bc"
+        return hash == 0 ? 1 : hash;
+    }
+}
 
-DisplayManagerImpl::DisplayManagerImpl(int rotation) :
-    m_display(GxEPD2_213_BN(/*CS=5*/ SS, /*DC=*/ 17, /*RST=*/ 16, /*BUSY=*/ 4))
+DisplayManagerImpl::DisplayManagerImpl(int rotation, DisplayTarget target) :
+    m_target(target),
+    m_panel(/*CS=5*/ SS, /*DC=*/ 17, /*RST=*/ 16, BusyPin),
+    m_display(GxEPD2_213_BN::WIDTH_VISIBLE, GxEPD2_213_BN::HEIGHT)
 {
-    m_display.init(115200, true, 2, false);
+    // the panel is left hibernating until there is a frame to send, plenty of wakes don't draw anything
     m_display.setRotation(rotation);
     m_display.setTextWrap(false);
 };
 
-void DisplayManagerImpl::writeDisplay(const String& crypto, const String& fiat, std::map<long, float>& priceData, const String& dayMonth, 
+DisplayManagerImpl::~DisplayManagerImpl()
+{
+    // the task still has this to init
+    if (m_panelInit == PanelInit::IN_BACKGROUND)
+        xEventGroupWaitBits(m_panelEvents, PanelReadyBit, pdFALSE, pdTRUE, portMAX_DELAY);
+    if (m_panelEvents)
+        vEventGroupDelete(m_panelEvents);
+}
+
+void DisplayManagerImpl::initInBackground()
+{
+    if (m_panelInit != PanelInit::NOT_STARTED || m_target != DisplayTarget::PANEL)
+        return;
+
+    m_panelEvents = xEventGroupCreate();
+    m_panelInit = PanelInit::IN_BACKGROUND;
+    xTaskCreatePinnedToCore(initPanelTask, "panel init", constants::DisplayInitTaskStackBytes, this, 1, nullptr,
+                            tskNO_AFFINITY);
+}
+
+void DisplayManagerImpl::initPanelTask(void* displayManager)
+{
+    DisplayManagerImpl* self = static_cast<DisplayManagerImpl*>(displayManager);
+    self->initPanel();
+    xEventGroupSetBits(self->m_panelEvents, PanelReadyBit);
+    vTaskDelete(nullptr);
+}
+
+void DisplayManagerImpl::initPanel()
+{
+    // a panel that was drawn on before deep sleep still has the frame in its controller, so it can be partially
+    // refreshed without a full refresh first
+    // no serial diagnostics, GxEPD2 waits 100ms after starting the serial for them
+    m_panel.init(0, panel.shownFingerprint == 0, 2, false);
+}
+
+void DisplayManagerImpl::waitWhileBusy(const void* displayManager)
+{
+    const DisplayManagerImpl* self = static_cast<const DisplayManagerImpl*>(displayManager);
+    if (!self->m_lightSleepWhileBusy)
+    {
+        delay(1); // as GxEPD2 does without a callback
+        return;
+    }
+
+    // the panel refreshes without the CPU, so it light sleeps until BUSY goes low, with the timer in case it is
+    // held high for longer. GxEPD2 checks the pin after each call and calls again if the panel is still busy
+    Serial.flush();
+    gpio_wakeup_enable(BusyPin, GPIO_INTR_LOW_LEVEL);
+    esp_sleep_enable_gpio_wakeup();
+    esp_sleep_enable_timer_wakeup(constants::DisplayBusySleepMaxMillis * 1000);
+    esp_light_sleep_start();
+
+    // neither should wake the deep sleep at the end of the wake
+    esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_GPIO);
+    esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_TIMER);
+    gpio_wakeup_disable(BusyPin);
+}
+
+void DisplayManagerImpl::setLightSleepWhileBusy(bool lightSleep)
+{
+    m_lightSleepWhileBusy = lightSleep;
+}
+
+void DisplayManagerImpl::waitForPanel()
+{
+    if (m_panelInit == PanelInit::DONE)
+        return;
+
+    // only the time the wake is held up for, not what the init took in the background
+    PhaseTimer initTimer(WakePhase::DISPLAY_INIT);
+    if (m_panelInit == PanelInit::IN_BACKGROUND)
+        xEventGroupWaitBits(m_panelEvents, PanelReadyBit, pdFALSE, pdTRUE, portMAX_DELAY);
+    else
+        initPanel();
+    // set here rather than in the init so the task in the background never light sleeps the WiFi
+    m_panel.setBusyCallback(waitWhileBusy, this);
+    m_panelInit = PanelInit::DONE;
+}
+
+void DisplayManagerImpl::writeDisplay(const String& crypto, const String& fiat, const Quotes& quotes, const String& dayMonth, 
                                       const String& time, const int batteryPercent)
 {
-    if (priceData.size() == 2 && priceData[0] != 0 && priceData[constants::SecondsOneDay] != 0)
+    TimeframeSet timeframes = quotes.valid();
+    if (timeframes.contains(AdvancedLayoutTimeframes))
     {
-        writeDisplaySimple(crypto, fiat, priceData, dayMonth, time, batteryPercent);
+        writeDisplayAdvanced(crypto, fiat, quotes, dayMonth, time, batteryPercent);
     }
-    else if (priceData.size() == 4 && (priceData[0] != 0 || priceData[constants::SecondsOneDay] != 0 || 
-        priceData[constants::SecondsOneMonth] != 0 || priceData[constants::SecondsOneYear] != 0))
+    else if (timeframes.contains(SimpleLayoutTimeframes))
     {
-        writeDisplayAdvanced(crypto, fiat, priceData, dayMonth, time, batteryPercent);
+        writeDisplaySimple(crypto, fiat, quotes, dayMonth, time, batteryPercent);
     }
     else
     {
@@ -42,56 +162,148 @@ void DisplayManagerImpl::writeDisplay(const String& crypto, const String& fiat,
     }
 }
 
-void DisplayManagerImpl::writeDisplayAdvanced(const String& crypto, const String& fiat, std::map<long, float>& priceData, const String& dayMonth, 
+void DisplayManagerImpl::writeDisplayAdvanced(const String& crypto, const String& fiat, const Quotes& quotes, const String& dayMonth, 
                                               const String& time, const int batteryPercent)
 {
+    const Price& now = quotes[Timeframe::NOW].price;
+    char price[PriceStringBytes + 1] = {m_fiatSymbols[fiat]};
+    formatPriceString(now, price + 1);
+    Price dayChange = now.percentChangeFrom(quotes[Timeframe::ONE_DAY].price);
+    char dayChangeLine[PriceChangeStringBytes], monthChangeLine[PriceChangeStringBytes], yearChangeLine[PriceChangeStringBytes];
+    formatPriceChangeString(dayChange, "1d", dayChangeLine);
+    formatPriceChangeString(now.percentChangeFrom(quotes[Timeframe::THIRTY_DAYS].price), "1M", monthChangeLine);
+    formatPriceChangeString(now.percentChangeFrom(quotes[Timeframe::ONE_YEAR].price), "1Y", yearChangeLine);
+    if (isShown(fingerprint({"advanced", crypto, price, dayChangeLine, monthChangeLine, yearChangeLine, dayMonth, time,
+                             String(batteryPercent)})))
+        return;
+
     setCryptoBoxWidth(crypto, dayMonth, time);
 
-    m_display.setFullWindow();
-    m_display.firstPage();
+    setWindow(fingerprint({"advanced", crypto, String(m_crypto_box_x2), String(m_current_crypto_box_font->yAdvance)}));
+    firstPage();
     do
     {
         m_display.fillScreen(GxEPD_WHITE);
         addLines();
         fillCryptoBox();
-        writeMainPriceAdvanced(m_fiatSymbols[fiat] + formatPriceString(priceData[0]));
+        writeMainPriceAdvanced(price);
         writeCrypto(crypto);
         writeDateTimeAdvanced(dayMonth, time);
         writeBatteryAdvanced(batteryPercent);
 
         // could try and split them by thirds but these offsets fit well
-        drawArrow(writePriceChange(priceData[0], priceData[constants::SecondsOneDay], "1d", -6));
-        writePriceChange(priceData[0], priceData[constants::SecondsOneMonth], "1M", 20);
-        writePriceChange(priceData[0], priceData[constants::SecondsOneYear], "1Y", 46);
+        writePriceChange(dayChangeLine, -6);
+        drawArrow(!dayChange.isNegative());
+        writePriceChange(monthChangeLine, 20);
+        writePriceChange(yearChangeLine, 46);
     }
-    while (m_display.nextPage());
+    while (nextPage());
 }
 
-void DisplayManagerImpl::writeDisplaySimple(const String& crypto, const String& fiat, std::map<long, float>& priceData, const String& dayMonth, 
+void DisplayManagerImpl::writeDisplaySimple(const String& crypto, const String& fiat, const Quotes& quotes, const String& dayMonth, 
                                             const String& time, const int batteryPercent)
 {
+    const Price& now = quotes[Timeframe::NOW].price;
+    char price[PriceStringBytes + 1] = {m_fiatSymbols[fiat]};
+    formatPriceString(now, price + 1);
+    char dayChangeLine[PriceChangeStringBytes];
+    formatPriceChangeString(now.percentChangeFrom(quotes[Timeframe::ONE_DAY].price), "1 day", dayChangeLine);
+    if (isShown(fingerprint({"simple", crypto, price, dayChangeLine, dayMonth, time, String(batteryPercent)})))
+        return;
+
     setCryptoBoxWidth(crypto, dayMonth, time, true);
 
-    m_display.setFullWindow();
-    m_display.firstPage();
+    setWindow(fingerprint({"simple", crypto, String(m_crypto_box_x2), String(m_current_crypto_box_font->yAdvance)}));
+    firstPage();
     do
     {
         m_display.fillScreen(GxEPD_WHITE);
         fillCryptoBox(true);
         writeCrypto(crypto, true);
-        writeMainPriceSimple(m_fiatSymbols[fiat] + formatPriceString(priceData[0]));
-        writePriceChange(priceData[0], priceData[constants::SecondsOneDay], "1 day", 48, true);
+        writeMainPriceSimple(price);
+        writePriceChange(dayChangeLine, 48, true);
         writeDateTimeSimple(dayMonth, time);
         writeBatterySimple(batteryPercent);
     }
-    while (m_display.nextPage());
+    while (nextPage());
+}
+
+void DisplayManagerImpl::writeWatchlist(const std::vector<String>& cryptos, const String& fiat, const std::map<String, Price>& prices,
+                                        const int page, const int numPages, const String& dayMonth, const String& time)
+{
+    // header with the date/time, fiat and page number, then a row per crypto with its price on the right
+    // e.g. 12 Oct 12:34     USD     1/3
+    //      BTC               37,500
+    //      ETH             2,050.10
+    String pageString = String(page + 1) + "/" + String(numPages);
+    std::vector<String> priceStrings;
+    for (const String& crypto : cryptos)
+    {
+        char priceString[PriceStringBytes] = "--";
+        auto it = prices.find(crypto);
+        if (it != prices.end())
+            formatPriceString(it->second, priceString);
+        priceStrings.push_back(priceString);
+    }
+
+    std::vector<String> content = {"watchlist", fiat, pageString, dayMonth, time};
+    content.insert(content.end(), cryptos.begin(), cryptos.end());
+    content.insert(content.end(), priceStrings.begin(), priceStrings.end());
+    if (isShown(fingerprint(content)))
+        return;
+
+    setFullWindow();
+    firstPage();
+    do
+    {
+        m_display.fillScreen(GxEPD_WHITE);
+        m_display.setTextColor(GxEPD_BLACK);
+
+        m_display.setFont(&FreeSans9pt7b);
+        int16_t tbx, tby; uint16_t tbw, tbh;
+        m_display.setCursor(3, 16);
+        m_display.print(dayMonth);
+        m_display.print(" ");
+        m_display.print(time);
+
+        m_display.getTextBounds(fiat, 0, 0, &tbx, &tby, &tbw, &tbh);
+        m_display.setCursor(((m_max_x - tbw) / 2) - tbx + 30, 16); // right of centre to stay clear of the time
+        m_display.print(fiat);
+
+        m_display.getTextBounds(pageString, 0, 0, &tbx, &tby, &tbw, &tbh);
+        m_display.setCursor(m_max_x - tbw - tbx - 3, 16);
+        m_display.print(pageString);
+
+        m_display.writeLine(0,       m_watchlist_header_y2,
+                            m_max_x, m_watchlist_header_y2,
+                            GxEPD_BLACK);
+
+        for (size_t i = 0; i < cryptos.size(); i++)
+        {
+            int y = m_watchlist_header_y2 + (i * m_watchlist_row_height) + 20;
+
+            m_display.setFont(&FreeSansBold12pt7b);
+            m_display.setCursor(3, y);
+            m_display.print(cryptos[i]);
+
+            const String& price = priceStrings[i];
+            m_display.setFont(&FreeSans12pt7b);
+            m_display.getTextBounds(price, 0, 0, &tbx, &tby, &tbw, &tbh);
+            m_display.setCursor(m_max_x - tbw - tbx - 3, y);
+            m_display.print(price);
+        }
+    }
+    while (nextPage());
 }
 
 void DisplayManagerImpl::writeGenericText(const String& textToWrite)
 {
+    if (isShown(fingerprint({"text", textToWrite})))
+        return;
+
     m_display.setTextWrap(true); // only place where we should wrap text
-    m_display.setFullWindow();
-    m_display.firstPage();
+    setFullWindow();
+    firstPage();
     do
     {
         m_display.fillScreen(GxEPD_WHITE);
@@ -103,19 +315,162 @@ void DisplayManagerImpl::writeGenericText(const String& textToWrite)
         m_display.print(textToWrite);
 
     }
-    while (m_display.nextPage());
+    while (nextPage());
     m_display.setTextWrap(false);
 }
+void DisplayManagerImpl::firstPage()
+{
+    m_pageStart = millis();
+}
+
+bool DisplayManagerImpl::nextPage()
+{
+    // drawing happens between the pages, the whole frame is in the canvas so there is only ever one page
+    uint32_t renderEnd = millis();
+    WakeTimer::record(WakePhase::RENDER, renderEnd - m_pageStart);
+    if (m_target != DisplayTarget::PANEL)
+        return false;
+
+    showFrame();
+    m_pageStart = millis();
+    WakeTimer::record(WakePhase::PANEL_REFRESH, m_pageStart - renderEnd);
+
+    // only counts as shown once the whole frame is on the panel
+    panel.shownFingerprint = m_frameFingerprint;
+    panel.layoutFingerprint = m_frameLayoutFingerprint;
+    m_frameFingerprint = 0;
+    m_frameLayoutFingerprint = 0;
+    return false;
+}
+
+void DisplayManagerImpl::showFrame()
+{
+    waitForPanel();
+
+    const uint8_t* frame = m_display.getBuffer();
+    const int16_t w = GxEPD2_213_BN::WIDTH;
+    const int16_t h = GxEPD2_213_BN::HEIGHT;
+
+    // everything moves if the layout changed, and the panel ghosts after too many partial refreshes
+    if (m_frameLayoutFingerprint == 0 || m_frameLayoutFingerprint != panel.layoutFingerprint ||
+        panel.partialRefreshes >= constants::DisplayPartialRefreshesBeforeFull)
+    {
+        m_panel.writeImageForFullRefresh(frame, 0, 0, w, h);
+        m_panel.refresh(false);
+        m_panel.writeImageAgain(frame, 0, 0, w, h);
+        panel.partialRefreshes = 0;
+        memcpy(shownFrame, frame, FrameBytes);
+        return;
+    }
+
+    // only the bytes that changed are sent, then one refresh of the window around them
+    DirtyRect rects[constants::DisplayMaxDirtyRects];
+    size_t numRects = FrameDiff::diff(shownFrame, frame, FrameBytesPerRow, h, rects, constants::DisplayMaxDirtyRects);
+    if (numRects == 0)
+    {
+        log_i("Frame has the same pixels as the panel, not refreshing it");
+        return;
+    }
+
+    for (size_t i = 0; i < numRects; i++)
+    {
+        const DirtyRect& rect = rects[i];
+        m_panel.writeImagePart(frame, rect.x*8, rect.y, w, h, rect.x*8, rect.y, rect.w*8, rect.h);
+    }
+    DirtyRect window = FrameDiff::bounds(rects, numRects);
+    log_d("Partial refresh of %d bytes in %d rects within %d,%d %dx%d, %d since the last full refresh",
+          (int)FrameDiff::area(rects, numRects), (int)numRects, window.x*8, window.y, window.w*8, window.h, panel.partialRefreshes);
+    m_panel.refresh(window.x*8, window.y, window.w*8, window.h);
+    for (size_t i = 0; i < numRects; i++)
+    {
+        const DirtyRect& rect = rects[i];
+        m_panel.writeImagePartAgain(frame, rect.x*8, rect.y, w, h, rect.x*8, rect.y, rect.w*8, rect.h);
+    }
+
+    panel.partialRefreshes++;
+    memcpy(shownFrame, frame, FrameBytes);
+}
+
+void DisplayManagerImpl::setFullWindow()
+{
+    m_frameLayoutFingerprint = 0;
+}
+
+void DisplayManagerImpl::setWindow(uint32_t layoutFingerprint)
+{
+    m_frameLayoutFingerprint = layoutFingerprint;
+}
+
+int DisplayManagerImpl::partialRefreshesSinceFull()
+{
+    return panel.partialRefreshes;
+}
+
+bool DisplayManagerImpl::isShown(uint32_t frameFingerprint)
+{
+    // the panel's state is left for the panel
+    if (m_target != DisplayTarget::PANEL)
+        return false;
+
+    if (frameFingerprint == panel.shownFingerprint)
+    {
+        log_i("Display already shows this, not refreshing it");
+        return true;
+    }
+    m_frameFingerprint = frameFingerprint;
+    return false;
+}
+
+int16_t DisplayManagerImpl::width()
+{
+    return m_display.width();
+}
+
+int16_t DisplayManagerImpl::height()
+{
+    return m_display.height();
+}
+
+bool DisplayManagerImpl::isBlack(int16_t x, int16_t y)
+{
+    return !m_display.getPixel(x, y);
+}
+
+void DisplayManagerImpl::writePbm(Print& out)
+{
+    out.printf("P4\n%d %d\n", width(), height());
+    uint8_t row[(GxEPD2_213_BN::HEIGHT + 7) / 8]; // the longer side, whichever way it is rotated
+    const int16_t rowBytes = (width() + 7) / 8;
+    for (int16_t y = 0; y < height(); y++)
+    {
+        memset(row, 0, rowBytes);
+        for (int16_t x = 0; x < width(); x++)
+        {
+            if (isBlack(x, y))
+                row[x / 8] |= 0x80 >> (x & 7);
+        }
+        out.write(row, rowBytes);
+    }
+}
+
 void DisplayManagerImpl::hibernate()
 {
-    delay(200);
-    m_display.hibernate();
+    // nothing was sent so the panel is still hibernating from the last wake
+    if (m_panelInit == PanelInit::NOT_STARTED)
+        return;
+
+    // the refresh has already waited for BUSY to go low, and powering off before hibernating waits again
+    waitForPanel();
+    m_panel.hibernate();
 }
 
 void DisplayManagerImpl::drawCannotConnectToWifi(const String& ssid, const String& password)
 {
-    m_display.setFullWindow();
-    m_display.firstPage();
+    if (isShown(fingerprint({"no wifi", ssid, password})))
+        return;
+
+    setFullWindow();
+    firstPage();
     do
     {
         m_display.fillScreen(GxEPD_WHITE);
@@ -138,13 +493,16 @@ void DisplayManagerImpl::drawCannotConnectToWifi(const String& ssid, const Strin
         m_display.print(password);
 
     }
-    while (m_display.nextPage());
+    while (nextPage());
 }
 
 void DisplayManagerImpl::drawWifiHasNoInternet()
 {
-    m_display.setFullWindow();
-    m_display.firstPage();
+    if (isShown(fingerprint({"no internet"})))
+        return;
+
+    setFullWindow();
+    firstPage();
     do
     {
         m_display.fillScreen(GxEPD_WHITE);
@@ -167,13 +525,16 @@ void DisplayManagerImpl::drawWifiHasNoInternet()
         m_display.print("refresh time");
 
     }
-    while (m_display.nextPage());
+    while (nextPage());
 }
 
 void DisplayManagerImpl::drawLowBattery()
 {
-    m_display.setFullWindow();
-    m_display.firstPage();
+    if (isShown(fingerprint({"low battery"})))
+        return;
+
+    setFullWindow();
+    firstPage();
     do
     {
         m_display.fillScreen(GxEPD_WHITE);
@@ -192,13 +553,16 @@ void DisplayManagerImpl::drawLowBattery()
         m_display.print("Please charge device");
 
     }
-    while (m_display.nextPage());
+    while (nextPage());
 }
 
 void DisplayManagerImpl::drawYesWifiNoCrypto(const String& dayMonth, const String& time)
 {
-    m_display.setFullWindow();
-    m_display.firstPage();
+    if (isShown(fingerprint({"no crypto", dayMonth, time})))
+        return;
+
+    setFullWindow();
+    firstPage();
     do
     {
         m_display.fillScreen(GxEPD_WHITE);
@@ -219,15 +583,18 @@ void DisplayManagerImpl::drawYesWifiNoCrypto(const String& dayMonth, const Strin
         m_display.print(")");
 
     }
-    while (m_display.nextPage());
+    while (nextPage());
 }
 
 void DisplayManagerImpl::drawConfig(const String& ssid, const String& password, const String& crypto, const String& fiat,
                                     const int refreshInterval)
 {
     const String topMsg = "Starting Ticker";
-    m_display.setFullWindow();
-    m_display.firstPage();
+    if (isShown(fingerprint({"config", ssid, password, crypto, fiat, String(refreshInterval)})))
+        return;
+
+    setFullWindow();
+    firstPage();
     do
     {
         m_display.fillScreen(GxEPD_WHITE);
@@ -269,15 +636,18 @@ void DisplayManagerImpl::drawConfig(const String& ssid, const String& password,
         m_display.print(" mins");
 
     }
-    while (m_display.nextPage());
+    while (nextPage());
 }
 
 void DisplayManagerImpl::drawAccessPoint(const String& ip)
 {
     const char* browserMsg = "Open in browser:";
 
-    m_display.setFullWindow();
-    m_display.firstPage();
+    if (isShown(fingerprint({"access point", ip})))
+        return;
+
+    setFullWindow();
+    firstPage();
     do
     {
         m_display.fillScreen(GxEPD_WHITE);
@@ -313,13 +683,16 @@ void DisplayManagerImpl::drawAccessPoint(const String& ip)
         m_display.print(browserMsg);
 
     }
-    while (m_display.nextPage());
+    while (nextPage());
 }
 
 void DisplayManagerImpl::drawOvernightSleep()
 {
-    m_display.setFullWindow();
-    m_display.firstPage();
+    if (isShown(fingerprint({"overnight sleep"})))
+        return;
+
+    setFullWindow();
+    firstPage();
     do
     {
         m_display.fillScreen(GxEPD_WHITE);
@@ -333,13 +706,16 @@ void DisplayManagerImpl::drawOvernightSleep()
         m_display.setCursor(153, 83);
         m_display.print("Sleep");
     }
-    while (m_display.nextPage());
+    while (nextPage());
 }
 
 void DisplayManagerImpl::drawStartingConfigMode()
 {
-    m_display.setFullWindow();
-    m_display.firstPage();
+    if (isShown(fingerprint({"starting config"})))
+        return;
+
+    setFullWindow();
+    firstPage();
     do
     {
         m_display.fillScreen(GxEPD_WHITE);
@@ -355,18 +731,19 @@ void DisplayManagerImpl::drawStartingConfigMode()
         m_display.setCursor(146, 100);
         m_display.print("Mode");
     }
-    while (m_display.nextPage());
+    while (nextPage());
 }
 
 void DisplayManagerImpl::fillScreen()
 {
-    m_display.setFullWindow();
-    m_display.firstPage();
+    m_frameFingerprint = 0; // always drawn, and nothing else is left alone after it
+    setFullWindow();
+    firstPage();
     do
     {
         m_display.fillScreen(GxEPD_BLACK);
     }
-    while (m_display.nextPage());
+    while (nextPage());
 }
 
 void DisplayManagerImpl::addLines()
@@ -401,10 +778,9 @@ void DisplayManagerImpl::writeMainPriceAdvanced(const String& price)
     m_display.setTextColor(GxEPD_BLACK);
 
     // centre the price in this region
-    int16_t tbx, tby; uint16_t tbw, tbh;
-    m_display.getTextBounds(price, 0, 0, &tbx, &tby, &tbw, &tbh);
-    uint16_t x = (((m_max_x-m_crypto_box_x2) - tbw) / 2) - tbx;
-    uint16_t y = ((m_crypto_box_y2 - tbh) / 2) - tby;
+    TextBounds tb = TextLayout::bounds(FreeSans18pt7b, price.c_str());
+    uint16_t x = (((m_max_x-m_crypto_box_x2) - tb.w) / 2) - tb.x;
+    uint16_t y = ((m_crypto_box_y2 - tb.h) / 2) - tb.y;
 
     if (price.indexOf(",") != -1)
         y += 2; // comma goes below text, looks better moving it down
@@ -418,9 +794,8 @@ void DisplayManagerImpl::writeMainPriceSimple(const String& price)
     m_display.setTextColor(GxEPD_BLACK);
 
     // centre the price in this region
-    int16_t tbx, tby; uint16_t tbw, tbh;
-    m_display.getTextBounds(price, 0, 0, &tbx, &tby, &tbw, &tbh);
-    uint16_t x = ((m_max_x - tbw) / 2) - tbx;
+    TextBounds tb = TextLayout::bounds(FreeSansBold24pt7b, price.c_str());
+    uint16_t x = ((m_max_x - tb.w) / 2) - tb.x;
     uint16_t y = 82;
 
     m_display.setCursor(x, y);
@@ -435,20 +810,18 @@ void DisplayManagerImpl::writeCrypto(const String& crypto, const bool centre)
     if (centre)
     {
         // centre the crypto in this region
-        int16_t tbx, tby; uint16_t tbw, tbh;
-        m_display.getTextBounds(crypto, 0, 0, &tbx, &tby, &tbw, &tbh);
-        uint16_t x = ((m_max_x - tbw) / 2) - tbx;
-        uint16_t y = ((m_crypto_box_y2 - tbh) / 2) - tby;
+        TextBounds tb = TextLayout::bounds(*m_current_crypto_box_font, crypto.c_str());
+        uint16_t x = ((m_max_x - tb.w) / 2) - tb.x;
+        uint16_t y = ((m_crypto_box_y2 - tb.h) / 2) - tb.y;
         
         m_display.setCursor(x, y+1); // looked better moving down 1 more pixel
     }
     else
     {
         // centre the crypto in this region
-        int16_t tbx, tby; uint16_t tbw, tbh;
-        m_display.getTextBounds(crypto, 0, 0, &tbx, &tby, &tbw, &tbh);
-        uint16_t x = ((m_crypto_box_x2 - tbw) / 2) - tbx;
-        uint16_t y = ((m_crypto_box_y2 - tbh) / 2) - tby;
+        TextBounds tb = TextLayout::bounds(*m_current_crypto_box_font, crypto.c_str());
+        uint16_t x = ((m_crypto_box_x2 - tb.w) / 2) - tb.x;
+        uint16_t y = ((m_crypto_box_y2 - tb.h) / 2) - tb.y;
         
         m_display.setCursor(x, y+1); // looked better moving down 1 more pixel
     }
@@ -461,19 +834,18 @@ void DisplayManagerImpl::writeDateTimeAdvanced(const String& dayMonth, const Str
     m_display.setTextColor(GxEPD_BLACK);
 
     // centre the day/month in this region
-    int16_t tbx, tby; uint16_t tbw, tbh;
-    m_display.getTextBounds(dayMonth, 0, 0, &tbx, &tby, &tbw, &tbh);
-    uint16_t x = (((m_crypto_box_x2-m_date_box_x1) - tbw) / 2) - tbx;
-    uint16_t y = (((m_date_box_y2-m_date_box_y1) - tbh) / 2) - tby;
+    TextBounds tb = TextLayout::bounds(FreeSans9pt7b, dayMonth.c_str());
+    uint16_t x = (((m_crypto_box_x2-m_date_box_x1) - tb.w) / 2) - tb.x;
+    uint16_t y = (((m_date_box_y2-m_date_box_y1) - tb.h) / 2) - tb.y;
 
     // but move 10 px higher
     m_display.setCursor(x+m_date_box_x1, y+m_date_box_y1-9);
     m_display.print(dayMonth);
 
     // centre the day/month in this region
-    m_display.getTextBounds(time, 0, 0, &tbx, &tby, &tbw, &tbh);
-    x = (((m_crypto_box_x2-m_date_box_x1) - tbw) / 2) - tbx;
-    y = (((m_date_box_y2-m_date_box_y1) - tbh) / 2) - tby;
+    tb = TextLayout::bounds(FreeSans9pt7b, time.c_str());
+    x = (((m_crypto_box_x2-m_date_box_x1) - tb.w) / 2) - tb.x;
+    y = (((m_date_box_y2-m_date_box_y1) - tb.h) / 2) - tb.y;
 
     // and move this 10 px lower
     m_display.setCursor(x+m_date_box_x1, y+m_date_box_y1+11);
@@ -486,17 +858,16 @@ void DisplayManagerImpl::writeDateTimeSimple(const String& dayMonth, const Strin
     m_display.setTextColor(GxEPD_BLACK);
 
     // centre the day/month in this region (m_max_x-m_crypto_box_x2)/2
-    int16_t tbx, tby; uint16_t tbw, tbh;
-    m_display.getTextBounds(dayMonth, 0, 0, &tbx, &tby, &tbw, &tbh);
-    uint16_t x = ((((m_max_x-m_crypto_box_x2)/2) - tbw) / 2) - tbx;
-    uint16_t y = ((m_crypto_box_y2 - tbh) / 2) - tby;
+    TextBounds tb = TextLayout::bounds(FreeSansBold9pt7b, dayMonth.c_str());
+    uint16_t x = ((((m_max_x-m_crypto_box_x2)/2) - tb.w) / 2) - tb.x;
+    uint16_t y = ((m_crypto_box_y2 - tb.h) / 2) - tb.y;
 
     m_display.setCursor(x, y);
     m_display.print(dayMonth);
 
-    m_display.getTextBounds(time, 0, 0, &tbx, &tby, &tbw, &tbh);
-    x = ((((m_max_x-m_crypto_box_x2)/2) - tbw) / 2) - tbx;
-    y = ((m_crypto_box_y2 - tbh) / 2) - tby;
+    tb = TextLayout::bounds(FreeSansBold9pt7b, time.c_str());
+    x = ((((m_max_x-m_crypto_box_x2)/2) - tb.w) / 2) - tb.x;
+    y = ((m_crypto_box_y2 - tb.h) / 2) - tb.y;
 
     // and move this 10 px lower
     m_display.setCursor(x+((m_max_x-m_crypto_box_x2)/2)+m_crypto_box_x2, y);
@@ -547,8 +918,7 @@ void DisplayManagerImpl::writeBatterySimple(const int batPct)
                         GxEPD_BLACK);
 }
 
-bool DisplayManagerImpl::writePriceChange(const float mainPrice, const float priceToCompare, const String& timeframe, 
-                                          const int yOffset, const bool centre)
+void DisplayManagerImpl::writePriceChange(const String& changeLine, const int yOffset, const bool centre)
 {
     if (centre)
         m_display.setFont(&FreeSansBold12pt7b);
@@ -556,24 +926,17 @@ bool DisplayManagerImpl::writePriceChange(const float mainPrice, const float pri
         m_display.setFont(&FreeMonoBold12pt7b);
     m_display.setTextColor(GxEPD_BLACK);
 
-    float percentChange = ((mainPrice - priceToCompare) / priceToCompare) * 100;
-
-    String changeLine = formatPriceChangeString(percentChange, timeframe);
-
     // centre the change in this region
-    int16_t tbx, tby; uint16_t tbw, tbh;
-    m_display.getTextBounds(changeLine, 0, 0, &tbx, &tby, &tbw, &tbh);
+    TextBounds tb = TextLayout::bounds(centre ? FreeSansBold12pt7b : FreeMonoBold12pt7b, changeLine.c_str());
     uint16_t x;
     if (centre)
-        x = ((m_max_x - tbw) / 2) - tbx;
+        x = ((m_max_x - tb.w) / 2) - tb.x;
     else
-        x = (((m_max_x-m_crypto_box_x2) - tbw) / 2) - tbx;
-    uint16_t y = ((m_max_y - tbh) / 2) - tby;
+        x = (((m_max_x-m_crypto_box_x2) - tb.w) / 2) - tb.x;
+    uint16_t y = ((m_max_y - tb.h) / 2) - tb.y;
 
     m_display.setCursor(x+(centre ? 0 : m_crypto_box_x2), y+yOffset);
     m_display.print(changeLine);
-
-    return percentChange >= 0;
 }
 
 void DisplayManagerImpl::drawArrow(const bool isPositive)
@@ -605,68 +968,27 @@ void DisplayManagerImpl::drawArrow(const bool isPositive)
 
 void DisplayManagerImpl::setCryptoBoxWidth(const String& crypto, const String& dayMonth, const String& time, bool centre)
 {
-    // calculate the width that the crypto box should be, based on the widest of the symbol/date/time   
-    uint16_t m_max_allowed_crypto_box_width = 0;
-    if (centre)
-        m_max_allowed_crypto_box_width = m_max_allowed_crypto_box_width_simple;
-    else
-        m_max_allowed_crypto_box_width = m_max_allowed_crypto_box_width_advanced;
-
-    // crypto symbol
-    m_display.setFont(m_current_crypto_box_font);
-    int16_t tbx, tby; uint16_t tbw, tbh;
-    m_display.getTextBounds(crypto, 0, 0, &tbx, &tby, &tbw, &tbh);
-    uint16_t cryptoWidth = (2 * m_min_crypto_padding) + tbw;
-    log_d("cryptoWidth = %d", cryptoWidth);
-    
-    // date
-    m_display.setFont(&FreeSans9pt7b);
-    m_display.getTextBounds(dayMonth, 0, 0, &tbx, &tby, &tbw, &tbh);
-    uint16_t dateWidth = (2 * m_min_date_padding) + tbw;
-    log_d("dateWidth1 = %d", dateWidth);
-
-    // time
-    m_display.getTextBounds(time, 0, 0, &tbx, &tby, &tbw, &tbh);
-    if (((2 * m_min_date_padding) + tbw) > dateWidth)
-        dateWidth = (2 * m_min_date_padding) + tbw;
-    log_d("dateWidth2 = %d", dateWidth);
-
-    dateWidth += m_date_box_x1;
-    log_d("dateWidth3 = %d", dateWidth);
-    uint16_t maxWidth = cryptoWidth > dateWidth ? cryptoWidth : dateWidth;
-
-    log_d("Max width = %d", maxWidth);
-
-    if (maxWidth > m_max_allowed_crypto_box_width && m_current_crypto_box_font == m_default_crypto_box_font)
-    {
-        log_d("Set font to 12pt and try again");
-        m_current_crypto_box_font = &FreeSans12pt7b;
-        setCryptoBoxWidth(crypto, dayMonth, time);
-        return;
-    }
-    else if (maxWidth > m_max_allowed_crypto_box_width && m_current_crypto_box_font != &FreeSans9pt7b)
-    {
-        log_d("Set font to 9pt and try again");
-        m_current_crypto_box_font = &FreeSans9pt7b;
-        setCryptoBoxWidth(crypto, dayMonth, time);
-        return;
-    }
-    else if (maxWidth > m_max_allowed_crypto_box_width)
+    // calculate the width that the crypto box should be, based on the widest of the symbol/date/time, using the
+    // largest font the symbol fits in
+    uint16_t maxAllowedWidth = centre ? m_max_allowed_crypto_box_width_simple : m_max_allowed_crypto_box_width_advanced;
+    CryptoBoxLayout layout = TextLayout::cryptoBox(crypto.c_str(), dayMonth.c_str(), time.c_str(),
+                                                   CryptoBoxFonts, sizeof(CryptoBoxFonts) / sizeof(CryptoBoxFonts[0]),
+                                                   FreeSans9pt7b, m_min_crypto_padding, m_min_date_padding,
+                                                   m_date_box_x1, m_min_allowed_crypto_box_width, maxAllowedWidth);
+    log_d("Crypto box font yAdvance = %d, width = %d", layout.font->yAdvance, layout.width);
+
+    if (!layout.fits)
     {
         // no symbol should be still longer then the max at 9pt
-        log_w("Very long symbol/date/time (%s/%s/%s) cannot fit within crypto box, max width of these is %d", 
-              crypto.c_str(), dayMonth.c_str(), time.c_str(), maxWidth);
+        log_w("Very long symbol/date/time (%s/%s/%s) cannot fit within crypto box, max width is %d",
+              crypto.c_str(), dayMonth.c_str(), time.c_str(), maxAllowedWidth);
     }
 
-    if (maxWidth < m_min_allowed_crypto_box_width)
-        m_crypto_box_x2 = m_min_allowed_crypto_box_width;
-    else if (maxWidth > m_max_allowed_crypto_box_width)
-        m_crypto_box_x2 = m_max_allowed_crypto_box_width;
-    else
-        m_crypto_box_x2 = maxWidth;
+    m_current_crypto_box_font = layout.font;
+    m_crypto_box_x2 = layout.width;
 }
 
-String DisplayManagerImpl::formatPriceString(const float price)
+void DisplayManagerImpl::formatPriceString(const Price& price, char* buf_out)
 {
     // crypto price can be anything from <1 to >10k
     // we want to write something neat like "12,345" or "0.1234"
@@ -674,27 +996,23 @@ String DisplayManagerImpl::formatPriceString(const float price)
     // if number < 1000, keep 2 decimals
     // if number < 10, keep 3 decimals
     // if number < 1, keep 4 decimals
-
-    String formattedPrice;
-
-    if (price < 1)
-        formattedPrice = String(price, 4);
-    else if (price < 10)
-        formattedPrice = String(price, 3);
-    else if (price < 1000)
-        formattedPrice = String(price, 2);
+    // rounded from the exact decimal price, so nothing is lost before here
+
+    if (price < Price(1))
+        price.format(buf_out, PriceStringBytes, 4);
+    else if (price < Price(10))
+        price.format(buf_out, PriceStringBytes, 3);
+    else if (price < Price(1000))
+        price.format(buf_out, PriceStringBytes, 2);
     else
     {
         // >1000 needs formatting with commas
-        char buf[21] = "";
-        formatCommas(buf, (int)(price+0.5));
-        formattedPrice = buf;
+        buf_out[0] = '\0';
+        formatCommas(buf_out, price.roundedTo(0));
     }
-
-    return formattedPrice;
 }
 
-String DisplayManagerImpl::formatPriceChangeString(float percentChange, const String& timeframe)
+void DisplayManagerImpl::formatPriceChangeString(const Price& percentChange, const char* timeframe, char* buf_out)
 {
     // for price change we want constant width
     // e.g. 1d: +1.23%
@@ -702,37 +1020,36 @@ String DisplayManagerImpl::formatPriceChangeString(float percentChange, const St
     //      1Y: + 123%
     //      1d: +1234%
 
-    String changeLine = timeframe + ": ";
-    if (percentChange >= 0)
-        changeLine.concat("+");
-    else
-        changeLine.concat("-");
-
-    percentChange = abs(percentChange); // work with +ve for rounding, +/- already appended
+    Price change = percentChange.abs(); // work with +ve for rounding, +/- written separately
+    // at most 13 digits, the whole part of a percentage at Price::PercentScale in an int64
+    char number[14];
+    const char* padding = "";
 
-    if (percentChange < 10)
-        changeLine.concat(String(percentChange, 2));
-    else if (percentChange < 100)
-        changeLine.concat(String(percentChange, 1));
-    else if (percentChange < 1000)
-        changeLine.concat(" " + String(percentChange, 0));
+    if (change < Price(10))
+        change.format(number, sizeof(number), 2);
+    else if (change < Price(100))
+        change.format(number, sizeof(number), 1);
+    else if (change < Price(1000))
+    {
+        padding = " ";
+        change.format(number, sizeof(number), 0);
+    }
     else
-        changeLine.concat(String(percentChange, 0));
-
-    changeLine.concat("%");
+        change.format(number, sizeof(number), 0);
 
-    return changeLine;
+    snprintf(buf_out, PriceChangeStringBytes, "%s: %c%s%s%%", timeframe, percentChange.isNegative() ? '-' : '+',
+             padding, number);
 }
 
-void DisplayManagerImpl::formatCommas(char *buf, const int price)
+void DisplayManagerImpl::formatCommas(char *buf, const int64_t price)
 {
     // recursively call dividing by 1000 until we get here to write the first digit(s) before first comma
     if (price < 1000) {
-        sprintf(buf+strlen(buf), "%d", price);
+        sprintf(buf+strlen(buf), "%lld", (long long)price);
         return;
     }
     formatCommas(buf, price / 1000);
     // continue writing a comma and next 3 digits as the recursions come back
-    sprintf(buf+strlen(buf), ",%03d", price % 1000);
+    sprintf(buf+strlen(buf), ",%03lld", (long long)(price % 1000));
     return;
 }
@@ -3,22 +3,47 @@
 
 #include <Arduino.h>
 #include <map>
+#include <vector>
+
+#include <freertos/event_groups.h>
 
 #include <GxEPD2_BW.h>
+#include <Adafruit_GFX.h>
 
 #include <FreeSans18pt7b_edit.h>
 
+#include "Price.h"
+#include "Quotes.h"
+
 class DisplayManagerTest_formatPrice_Test;
 class DisplayManagerTest_formatPriceChange_Test;
 
+// where the frames go once drawn
+enum class DisplayTarget
+{
+    PANEL,      // sent to the e-paper panel
+    FRAMEBUFFER // only kept in memory, to check the layout off the device, every frame is drawn whatever the panel shows
+};
+
 // implementation for a 250x122 display
 class DisplayManagerImpl
 {
 public:
-    DisplayManagerImpl(int rotation = 1);
+    DisplayManagerImpl(int rotation = 1, DisplayTarget target = DisplayTarget::PANEL);
+    ~DisplayManagerImpl();
+
+    // brings the panel up in another task, so it is ready by the time the first frame is drawn, otherwise it is
+    // brought up when the first frame is sent
+    void initInBackground();
+    // light sleep while waiting for the panel to refresh, on unless something needs the CPU or the WiFi meanwhile
+    void setLightSleepWhileBusy(bool lightSleep);
 
-    void writeDisplay(const String& crypto, const String& fiat, std::map<long, float>& priceData, const String& dayMonth, 
+    // the layout is chosen by which timeframes quotes has prices for, see AdvancedLayoutTimeframes
+    void writeDisplay(const String& crypto, const String& fiat, const Quotes& quotes, const String& dayMonth, 
                       const String& time, const int batteryPercent);
+    // table of current prices for a page of the watchlist
+    void writeWatchlist(const std::vector<String>& cryptos, const String& fiat, const std::map<String, Price>& prices,
+                        const int page, const int numPages, const String& dayMonth, const String& time);
 
     void writeGenericText(const String& textToWrite);
     void hibernate();
@@ -34,13 +59,26 @@ public:
     void drawStartingConfigMode();
     void fillScreen();
 
+    int partialRefreshesSinceFull();
+
+    // the last frame drawn, as it is seen on the display after rotation
+    int16_t width();
+    int16_t height();
+    bool isBlack(int16_t x, int16_t y);
+    // as a binary PBM image, width x height with black as 1
+    void writePbm(Print& out);
+
+    // the whole frame is drawn into a canvas in the layout of the controller's memory
+    static constexpr size_t FrameBytesPerRow = GxEPD2_213_BN::WIDTH / 8;
+    static constexpr size_t FrameBytes = FrameBytesPerRow * GxEPD2_213_BN::HEIGHT;
+
 private:
     friend class ::DisplayManagerTest_formatPrice_Test;
     friend class ::DisplayManagerTest_formatPriceChange_Test;
 
-    void writeDisplayAdvanced(const String& crypto, const String& fiat, std::map<long, float>& priceData, const String& dayMonth, 
+    void writeDisplayAdvanced(const String& crypto, const String& fiat, const Quotes& quotes, const String& dayMonth, 
                               const String& time, const int batteryPercent);
-    void writeDisplaySimple(const String& crypto, const String& fiat, std::map<long, float>& priceData, const String& dayMonth, 
+    void writeDisplaySimple(const String& crypto, const String& fiat, const Quotes& quotes, const String& dayMonth, 
                             const String& time, const int batteryPercent);
 
     void addLines();
@@ -52,17 +90,57 @@ private:
     void writeDateTimeSimple(const String& dayMonth, const String& time);
     void writeBatteryAdvanced(const int batPct);
     void writeBatterySimple(const int batPct);
-    bool writePriceChange(const float mainPrice, const float priceToCompare, const String& timeframe, const int yOffset, 
-                          const bool centre = false);
+    void writePriceChange(const String& changeLine, const int yOffset, const bool centre = false);
 
     void drawArrow(const bool isPositive);
 
-    void setCryptoBoxWidth(const String& crypto, const String& dayMonth, const String& time, bool centre = false);
-    String formatPriceString(const float price);
-    String formatPriceChangeString(float percentChange, const String& timeframe);
-    void formatCommas(char *buf, const int price);
+    // wrap the drawing of the display to time the drawing and the refresh separately, the drawing loops run once
+    // as the whole frame is in the canvas
+    void firstPage();
+    bool nextPage();
+    // whether the panel already shows the frame with this fingerprint, if not it is drawn and becomes what the
+    // panel shows once refreshed
+    bool isShown(uint32_t frameFingerprint);
+
+    // the next frame is a full refresh
+    void setFullWindow();
+    // the next frame only sends what changed since the last one and partially refreshes the panel if the layout
+    // is the same as what it shows, otherwise it is a full refresh
+    void setWindow(uint32_t layoutFingerprint);
+    // sends the canvas to the panel and refreshes it
+    void showFrame();
+
+    void initPanel();
+    static void initPanelTask(void* displayManager);
+    // GxEPD2 calls this until the panel's BUSY line goes low
+    static void waitWhileBusy(const void* displayManager);
+    // brings the panel up if it isn't already, or waits for the task doing it
+    void waitForPanel();
 
-    GxEPD2_BW<GxEPD2_213_BN, GxEPD2_213_BN::HEIGHT> m_display;
+    void setCryptoBoxWidth(const String& crypto, const String& dayMonth, const String& time, bool centre = false);
+    // the formatting writes into buffers of these sizes rather than building Strings
+    static constexpr size_t PriceStringBytes = 28;       // 19 digits, 6 commas, a sign and the terminator
+    static constexpr size_t PriceChangeStringBytes = 32; // timeframe, sign, up to 13 digits and the %
+    void formatPriceString(const Price& price, char* buf_out);
+    void formatPriceChangeString(const Price& percentChange, const char* timeframe, char* buf_out);
+    void formatCommas(char *buf, const int64_t price);
+
+    const DisplayTarget m_target;
+    GxEPD2_213_BN m_panel;
+    GFXcanvas1 m_display;
+    enum class PanelInit
+    {
+        NOT_STARTED,
+        IN_BACKGROUND,
+        DONE
+    };
+    PanelInit m_panelInit = PanelInit::NOT_STARTED;
+    EventGroupHandle_t m_panelEvents = nullptr;
+    static constexpr EventBits_t PanelReadyBit = BIT0;
+    bool m_lightSleepWhileBusy = true;
+    uint32_t m_pageStart = 0;
+    uint32_t m_frameFingerprint = 0; // of the frame being drawn, 0 if it isn't known
+    uint32_t m_frameLayoutFingerprint = 0;
 
     const int m_max_x = 249;
     const int m_max_y = 121;
@@ -87,8 +165,10 @@ private:
     const int m_bat_box_x2 = m_date_box_x1;
     const int m_bat_box_y2 = m_max_y;
 
-    const GFXfont* const m_default_crypto_box_font = &FreeSans18pt7b;
-    const GFXfont* m_current_crypto_box_font = m_default_crypto_box_font;
+    const int m_watchlist_header_y2 = 22;
+    const int m_watchlist_row_height = 25;
+
+    const GFXfont* m_current_crypto_box_font = &FreeSans18pt7b;
 
     std::map<String, char> m_fiatSymbols = {{"GBP", '#'},
                                             {"USD", '$'},
@@ -0,0 +1,231 @@
+#include "FrameDiff.h"
+
+#include <string.h>
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "FrameDiff finds the changed bytes of a word assuming it is little endian, as the ESP32 and x86 are"
+#endif
+
+namespace
+{
+    // most separate changes looked for in a row, any after this are joined onto the last
+    constexpr size_t MaxRowSpans = 8;
+
+    // bytes x1 to x2 (exclusive) of a row
+    struct Span
+    {
+        uint16_t x1;
+        uint16_t x2;
+    };
+
+    // any alignment, compiles down to a single load where the CPU allows it
+    inline uint32_t loadWord(const uint8_t* p)
+    {
+        uint32_t word;
+        memcpy(&word, p, sizeof(word));
+        return word;
+    }
+
+    // of the bytes that differ in a word, the first and one past the last, in memory order
+    inline uint16_t firstByte(uint32_t difference)
+    {
+        return __builtin_ctz(difference) / 8;
+    }
+
+    inline uint16_t endByte(uint32_t difference)
+    {
+        return (31 - __builtin_clz(difference)) / 8 + 1;
+    }
+
+    // changes in a row, those with a whole unchanged word between them are kept apart
+    size_t rowSpans(const uint8_t* previous, const uint8_t* next, uint16_t bytesPerRow, Span* spans)
+    {
+        size_t numSpans = 0;
+        bool lastWordChanged = false;
+        for (uint16_t x = 0; x < bytesPerRow; x += 4)
+        {
+            uint32_t difference;
+            if (x + 4 <= bytesPerRow)
+                difference = loadWord(previous + x) ^ loadWord(next + x);
+            else
+            {
+                // the end of a row that isn't a whole number of words
+                uint32_t a = 0, b = 0;
+                memcpy(&a, previous + x, bytesPerRow - x);
+                memcpy(&b, next + x, bytesPerRow - x);
+                difference = a ^ b;
+            }
+
+            if (difference == 0)
+            {
+                lastWordChanged = false;
+                continue;
+            }
+            if (lastWordChanged || numSpans == MaxRowSpans)
+                spans[numSpans-1].x2 = x + endByte(difference);
+            else
+                spans[numSpans++] = {(uint16_t)(x + firstByte(difference)), (uint16_t)(x + endByte(difference))};
+            lastWordChanged = true;
+        }
+        return numSpans;
+    }
+
+    DirtyRect join(const DirtyRect& a, const DirtyRect& b)
+    {
+        uint16_t x1 = a.x < b.x ? a.x : b.x;
+        uint16_t y1 = a.y < b.y ? a.y : b.y;
+        uint16_t x2 = a.x + a.w > b.x + b.w ? a.x + a.w : b.x + b.w;
+        uint16_t y2 = a.y + a.h > b.y + b.h ? a.y + a.h : b.y + b.h;
+        return {x1, y1, (uint16_t)(x2 - x1), (uint16_t)(y2 - y1)};
+    }
+
+    inline size_t rectArea(const DirtyRect& rect)
+    {
+        return (size_t)rect.w * rect.h;
+    }
+
+    bool overlap(const DirtyRect& a, const DirtyRect& b)
+    {
+        return a.x < b.x + b.w && b.x < a.x + a.w && a.y < b.y + b.h && b.y < a.y + a.h;
+    }
+
+    size_t addedArea(const DirtyRect& a, const DirtyRect& b)
+    {
+        size_t joinedArea = rectArea(join(a, b));
+        size_t separateArea = rectArea(a) + rectArea(b);
+        return joinedArea > separateArea ? joinedArea - separateArea : 0;
+    }
+
+    // the rect that adds the least area when joined with this one
+    size_t closestTo(const DirtyRect* rects, size_t numRects, const DirtyRect& rect)
+    {
+        size_t best = 0;
+        size_t bestAdded = SIZE_MAX;
+        for (size_t i = 0; i < numRects; i++)
+        {
+            size_t added = addedArea(rects[i], rect);
+            if (added < bestAdded)
+            {
+                bestAdded = added;
+                best = i;
+            }
+        }
+        return best;
+    }
+
+    void removeRect(DirtyRect* rects, size_t& numRects, size_t i)
+    {
+        rects[i] = rects[--numRects];
+    }
+
+    // joins every pair that overlaps, as the bytes would otherwise be sent twice
+    void joinOverlapping(DirtyRect* rects, size_t& numRects)
+    {
+        bool joined = true;
+        while (joined)
+        {
+            joined = false;
+            for (size_t i = 0; i < numRects; i++)
+            {
+                for (size_t j = i + 1; j < numRects; j++)
+                {
+                    if (!overlap(rects[i], rects[j]))
+                        continue;
+                    rects[i] = join(rects[i], rects[j]);
+                    removeRect(rects, numRects, j);
+                    joined = true;
+                    j = i; // rects[i] grew, check it against all of them again
+                }
+            }
+        }
+    }
+
+    // joins the pair that adds the least area, which could then overlap others
+    void joinClosest(DirtyRect* rects, size_t& numRects)
+    {
+        size_t bestI = 0, bestJ = 1;
+        size_t bestAdded = SIZE_MAX;
+        for (size_t i = 0; i < numRects; i++)
+        {
+            for (size_t j = i + 1; j < numRects; j++)
+            {
+                size_t added = addedArea(rects[i], rects[j]);
+                if (added < bestAdded)
+                {
+                    bestAdded = added;
+                    bestI = i;
+                    bestJ = j;
+                }
+            }
+        }
+        rects[bestI] = join(rects[bestI], rects[bestJ]);
+        removeRect(rects, numRects, bestJ);
+    }
+}
+
+size_t FrameDiff::diff(const uint8_t* previous, const uint8_t* next, uint16_t bytesPerRow, uint16_t rows,
+                       DirtyRect* rects_out, size_t maxRects)
+{
+    if (maxRects == 0)
+        return 0;
+
+    DirtyRect rects[MaxWorkingRects];
+    size_t numRects = 0;
+    Span spans[MaxRowSpans];
+
+    for (uint16_t y = 0; y < rows; y++)
+    {
+        size_t offset = (size_t)y * bytesPerRow;
+        size_t numSpans = rowSpans(previous + offset, next + offset, bytesPerRow, spans);
+
+        for (size_t s = 0; s < numSpans; s++)
+        {
+            // grow a rectangle that reached the row above (or already this row) and is above or beside the span,
+            // so a change drawn across several rows becomes one rectangle
+            size_t i = 0;
+            for (; i < numRects; i++)
+            {
+                DirtyRect& rect = rects[i];
+                if (rect.y + rect.h >= y && spans[s].x1 <= rect.x + rect.w && rect.x <= spans[s].x2)
+                    break;
+            }
+
+            DirtyRect spanRect = {spans[s].x1, y, (uint16_t)(spans[s].x2 - spans[s].x1), 1};
+            if (i == numRects && numRects == MaxWorkingRects)
+                i = closestTo(rects, numRects, spanRect);
+            if (i < numRects)
+                rects[i] = join(rects[i], spanRect);
+            else
+                rects[numRects++] = spanRect;
+        }
+    }
+
+    joinOverlapping(rects, numRects);
+    while (numRects > maxRects)
+    {
+        joinClosest(rects, numRects);
+        joinOverlapping(rects, numRects);
+    }
+
+    memcpy(rects_out, rects, numRects * sizeof(DirtyRect));
+    return numRects;
+}
+
+DirtyRect FrameDiff::bounds(const DirtyRect* rects, size_t numRects)
+{
+    if (numRects == 0)
+        return {0, 0, 0, 0};
+
+    DirtyRect all = rects[0];
+    for (size_t i = 1; i < numRects; i++)
+        all = join(all, rects[i]);
+    return all;
+}
+
+size_t FrameDiff::area(const DirtyRect* rects, size_t numRects)
+{
+    size_t total = 0;
+    for (size_t i = 0; i < numRects; i++)
+        total += rectArea(rects[i]);
+    return total;
+}
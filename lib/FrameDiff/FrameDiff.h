@@ -0,0 +1,41 @@
+#ifndef FRAMEDIFF_H
+#define FRAMEDIFF_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// finds what changed between two 1 bit per pixel frames, as a few rectangles that can be sent to the panel as
+// partial windows instead of the whole frame
+// the frames are compared a 32 bit word at a time, so a row that hasn't changed costs a handful of XORs
+// kept apart from the display so the native tests can check and time it on the host
+
+// x and w are in bytes (8 pixels), y and h in rows
+struct DirtyRect
+{
+    uint16_t x;
+    uint16_t y;
+    uint16_t w;
+    uint16_t h;
+};
+
+class FrameDiff
+{
+public:
+    // rectangles covering every byte that differs between the frames, each rows of bytesPerRow bytes
+    // rectangles that overlap are joined, then while there are more than maxRects the two that add the least area
+    // when joined are joined
+    // returns how many were put in rects_out, 0 if the frames are the same
+    static size_t diff(const uint8_t* previous, const uint8_t* next, uint16_t bytesPerRow, uint16_t rows,
+                       DirtyRect* rects_out, size_t maxRects);
+
+    // one rectangle around all of them
+    static DirtyRect bounds(const DirtyRect* rects, size_t numRects);
+
+    // bytes of the frame covered by the rectangles
+    static size_t area(const DirtyRect* rects, size_t numRects);
+
+    // most rectangles kept while scanning, past this a change is joined onto the closest one
+    static constexpr size_t MaxWorkingRects = 32;
+};
+
+#endif
@@ -0,0 +1,266 @@
+#include "Price.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+namespace
+{
+    constexpr int64_t Pow10[Price::MaxScale + 1] = {
+        1LL, 10LL, 100LL, 1000LL, 10000LL, 100000LL, 1000000LL, 10000000LL, 100000000LL, 1000000000LL,
+        10000000000LL, 100000000000LL, 1000000000000LL, 10000000000000LL, 100000000000000LL, 1000000000000000LL,
+        10000000000000000LL, 100000000000000000LL, 1000000000000000000LL};
+
+    // largest percentage percentChangeFrom gives, as a ratio, past this the long division would overflow
+    constexpr uint64_t MaxRatio = 10000000000ULL;
+
+    inline uint64_t magnitude(int64_t value)
+    {
+        return value < 0 ? 0 - (uint64_t)value : (uint64_t)value;
+    }
+
+    // value / 10^places, rounded half away from zero
+    int64_t roundedDivide(int64_t value, uint8_t places)
+    {
+        if (places > Price::MaxScale)
+            return 0;
+        int64_t divisor = Pow10[places];
+        int64_t quotient = value / divisor;
+        uint64_t remainder = magnitude(value % divisor);
+        if (remainder * 2 >= (uint64_t)divisor)
+            quotient += value < 0 ? -1 : 1;
+        return quotient;
+    }
+
+    // brings both to the same scale, raising the mantissa of the one with fewer places while that keeps it
+    // below 10^17, otherwise dropping places from the other
+    void align(int64_t& a, uint8_t& scaleA, int64_t& b, uint8_t& scaleB)
+    {
+        while (scaleA != scaleB)
+        {
+            int64_t& lower = scaleA < scaleB ? a : b;
+            uint8_t& lowerScale = scaleA < scaleB ? scaleA : scaleB;
+            int64_t& higher = scaleA < scaleB ? b : a;
+            uint8_t& higherScale = scaleA < scaleB ? scaleB : scaleA;
+            if (magnitude(lower) < (uint64_t)Pow10[Price::MaxDigits])
+            {
+                lower *= 10;
+                lowerScale++;
+            }
+            else
+            {
+                higher = roundedDivide(higher, 1);
+                higherScale--;
+            }
+        }
+    }
+}
+
+bool Price::parse(const char* text, Price& price_out)
+{
+    return text != nullptr && parse(text, strlen(text), price_out);
+}
+
+bool Price::parse(const char* text, size_t length, Price& price_out)
+{
+    size_t i = 0;
+    bool negative = false;
+    if (i < length && (text[i] == '-' || text[i] == '+'))
+        negative = text[i++] == '-';
+
+    int64_t mantissa = 0;
+    int digits = 0; // significant, from the first that isn't 0
+    int scale = 0;
+    bool anyDigits = false, point = false, dropped = false, roundUp = false;
+    for (; i < length; i++)
+    {
+        char c = text[i];
+        if (c == '.' && !point)
+        {
+            point = true;
+            continue;
+        }
+        if (c < '0' || c > '9')
+            break;
+        anyDigits = true;
+
+        if (digits == MaxDigits || (point && scale == MaxScale))
+        {
+            if (!point)
+                return false; // too big to keep the whole part of
+            if (!dropped)
+                roundUp = c >= '5';
+            dropped = true;
+            continue;
+        }
+        mantissa = mantissa * 10 + (c - '0');
+        if (mantissa != 0)
+            digits++;
+        if (point)
+            scale++;
+    }
+    if (roundUp)
+        mantissa++;
+
+    // exponent as in 8.12e-06, which is how some JSON writers put small numbers
+    if (i < length && (text[i] == 'e' || text[i] == 'E'))
+    {
+        i++;
+        bool negativeExponent = false;
+        if (i < length && (text[i] == '-' || text[i] == '+'))
+            negativeExponent = text[i++] == '-';
+        int exponent = 0;
+        bool anyExponentDigits = false;
+        for (; i < length && text[i] >= '0' && text[i] <= '9'; i++)
+        {
+            anyExponentDigits = true;
+            if (exponent < 1000)
+                exponent = exponent * 10 + (text[i] - '0');
+        }
+        if (!anyExponentDigits)
+            return false;
+        scale += negativeExponent ? exponent : -exponent;
+    }
+    if (i != length || !anyDigits)
+        return false;
+
+    for (; scale < 0; scale++)
+    {
+        if (mantissa >= Pow10[MaxDigits])
+            return false;
+        mantissa *= 10;
+    }
+    if (scale > MaxScale)
+    {
+        mantissa = roundedDivide(mantissa, scale - MaxScale > MaxScale ? MaxScale + 1 : scale - MaxScale);
+        scale = MaxScale;
+    }
+    // no trailing 0s, so the same price always has the same scale
+    while (scale > 0 && mantissa % 10 == 0)
+    {
+        mantissa /= 10;
+        scale--;
+    }
+    if (mantissa == 0)
+        scale = 0;
+
+    price_out = Price(negative ? -mantissa : mantissa, scale);
+    return true;
+}
+
+bool Price::fromDouble(double value, Price& price_out)
+{
+    if (!isfinite(value))
+        return false;
+
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.15g", value);
+    return parse(buf, price_out);
+}
+
+double Price::toDouble() const
+{
+    return (double)m_mantissa / (double)Pow10[m_scale];
+}
+
+int64_t Price::roundedTo(uint8_t decimals) const
+{
+    if (decimals < m_scale)
+        return roundedDivide(m_mantissa, m_scale - decimals);
+
+    uint8_t places = decimals - m_scale;
+    if (places > MaxScale || magnitude(m_mantissa) > (uint64_t)(INT64_MAX / Pow10[places]))
+        return m_mantissa < 0 ? INT64_MIN : INT64_MAX;
+    return m_mantissa * Pow10[places];
+}
+
+Price Price::percentChangeFrom(const Price& earlier) const
+{
+    int64_t now = m_mantissa, then = earlier.m_mantissa;
+    uint8_t nowScale = m_scale, thenScale = earlier.m_scale;
+    align(now, nowScale, then, thenScale);
+    if (then <= 0)
+        return Price();
+
+    // (now - then) / then to PercentScale + 2 places, then one more to round the last, below 10^18 so none of
+    // it overflows
+    int64_t difference = now - then;
+    uint64_t divisor = then;
+    uint64_t quotient = magnitude(difference) / divisor;
+    uint64_t remainder = magnitude(difference) % divisor;
+    if (quotient >= MaxRatio)
+    {
+        quotient = MaxRatio;
+        remainder = 0;
+    }
+    for (int place = 0; place < PercentScale + 2; place++)
+    {
+        remainder *= 10;
+        quotient = quotient * 10 + remainder / divisor;
+        remainder %= divisor;
+    }
+    if ((remainder * 10) / divisor >= 5)
+        quotient++;
+
+    int64_t percent = (int64_t)quotient;
+    return Price(difference < 0 ? -percent : percent, PercentScale);
+}
+
+size_t Price::format(char* buf_out, size_t size, uint8_t decimals) const
+{
+    int64_t rounded = roundedTo(decimals);
+    uint64_t value = magnitude(rounded);
+
+    // digits least significant first, with 0s up to the one before the point
+    char digits[24];
+    size_t numDigits = 0;
+    do
+    {
+        digits[numDigits++] = '0' + value % 10;
+        value /= 10;
+    }
+    while (value != 0);
+    while (numDigits < (size_t)decimals + 1 && numDigits < sizeof(digits))
+        digits[numDigits++] = '0';
+
+    size_t length = 0;
+    auto put = [&](char c)
+    {
+        if (length + 1 < size)
+            buf_out[length] = c;
+        length++;
+    };
+    if (rounded < 0)
+        put('-');
+    for (size_t i = numDigits; i > 0; i--)
+    {
+        put(digits[i - 1]);
+        if (i - 1 == decimals && decimals > 0)
+            put('.');
+    }
+    if (size > 0)
+        buf_out[length < size ? length : size - 1] = '\0';
+    return length;
+}
+
+int Price::compare(const Price& a, const Price& b)
+{
+    int64_t mantissaA = a.m_mantissa, mantissaB = b.m_mantissa;
+    if (a.m_scale == b.m_scale)
+        return mantissaA < mantissaB ? -1 : mantissaA > mantissaB;
+
+    int signA = (mantissaA > 0) - (mantissaA < 0);
+    int signB = (mantissaB > 0) - (mantissaB < 0);
+    if (signA != signB)
+        return signA < signB ? -1 : 1;
+
+    // whole parts first, then what is after the point at the larger scale, which is below 10^18
+    int64_t wholeA = mantissaA / Pow10[a.m_scale], wholeB = mantissaB / Pow10[b.m_scale];
+    if (wholeA != wholeB)
+        return wholeA < wholeB ? -1 : 1;
+
+    uint8_t scale = a.m_scale > b.m_scale ? a.m_scale : b.m_scale;
+    int64_t fractionA = (mantissaA % Pow10[a.m_scale]) * Pow10[scale - a.m_scale];
+    int64_t fractionB = (mantissaB % Pow10[b.m_scale]) * Pow10[scale - b.m_scale];
+    return fractionA < fractionB ? -1 : fractionA > fractionB;
+}
@@ -0,0 +1,69 @@
+#ifndef PRICE_H
+#define PRICE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// a decimal price, mantissa x 10^-scale, so it is exactly what the data source sent
+// a float has 24 bits of mantissa, which loses the cents of a BTC price and the later digits of a SHIB one
+// read straight from the decimal strings in the responses, without going through a float, and compared, divided
+// and formatted in integer arithmetic
+// packed to 9 bytes as samples of it are kept in RTC memory and SPIFFS
+class __attribute__((packed)) Price
+{
+public:
+    // digits past this are rounded off, 10^MaxScale must fit in the mantissa
+    static constexpr uint8_t MaxScale = 18;
+    // most significant digits kept, so aligning two prices to the same scale can't overflow
+    static constexpr int MaxDigits = 17;
+    // of the percentage from percentChangeFrom
+    static constexpr uint8_t PercentScale = 6;
+
+    constexpr Price() : m_mantissa(0), m_scale(0) {}
+    constexpr Price(int64_t mantissa, uint8_t scale = 0) : m_mantissa(mantissa), m_scale(scale) {}
+
+    // a decimal such as "29396.32000000", "-1.5" or "8.12e-06", the whole of text must be the number
+    // returns false if it isn't one or its whole part has more than MaxDigits digits
+    static bool parse(const char* text, Price& price_out);
+    // as above for text that isn't null terminated
+    static bool parse(const char* text, size_t length, Price& price_out);
+    // a number JSON has already read as a double, which holds 15 significant digits exactly, so this is the
+    // decimal the response had for any price with up to 15 digits
+    static bool fromDouble(double value, Price& price_out);
+
+    int64_t mantissa() const { return m_mantissa; }
+    uint8_t scale() const { return m_scale; }
+    bool isZero() const { return m_mantissa == 0; }
+    bool isNegative() const { return m_mantissa < 0; }
+    bool isPositive() const { return m_mantissa > 0; }
+    Price abs() const { return Price(m_mantissa < 0 ? -m_mantissa : m_mantissa, m_scale); }
+    // only for logging and the tests, nothing is worked out from it
+    double toDouble() const;
+
+    // mantissa of this at decimals places, rounded half away from zero
+    int64_t roundedTo(uint8_t decimals) const;
+
+    // change from the earlier price to this one as a percentage at PercentScale, 0 if earlier isn't positive
+    // worked out by long division so it is exact to the last place, which is rounded half away from zero
+    Price percentChangeFrom(const Price& earlier) const;
+
+    // this rounded to decimals places, e.g. "-12.30", into buf_out which is always terminated
+    // returns the length written, or what it would have been if size is too small, as snprintf
+    size_t format(char* buf_out, size_t size, uint8_t decimals) const;
+
+    // -1, 0 or 1 as a is less than, the same as or more than b, whatever their scales
+    static int compare(const Price& a, const Price& b);
+
+private:
+    int64_t m_mantissa;
+    uint8_t m_scale;
+};
+
+inline bool operator==(const Price& a, const Price& b) { return Price::compare(a, b) == 0; }
+inline bool operator!=(const Price& a, const Price& b) { return Price::compare(a, b) != 0; }
+inline bool operator<(const Price& a, const Price& b) { return Price::compare(a, b) < 0; }
+inline bool operator>(const Price& a, const Price& b) { return Price::compare(a, b) > 0; }
+inline bool operator<=(const Price& a, const Price& b) { return Price::compare(a, b) <= 0; }
+inline bool operator>=(const Price& a, const Price& b) { return Price::compare(a, b) >= 0; }
+
+#endif
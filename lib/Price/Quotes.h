@@ -0,0 +1,131 @@
+#ifndef QUOTES_H
+#define QUOTES_H
+
+#include "Price.h"
+#include "Constants.h"
+
+#include <array>
+#include <initializer_list>
+#include <stdint.h>
+
+// identifies the data source a price came from
+enum class SourceId : uint8_t
+{
+    NONE,
+    COINGECKO,
+    KUCOIN,
+    BINANCE,
+    STORE // the price history kept on the device
+};
+
+// how long before now a price is for
+enum class Timeframe : uint8_t
+{
+    NOW,
+    ONE_HOUR,
+    ONE_DAY,
+    SEVEN_DAYS,
+    THIRTY_DAYS,
+    ONE_YEAR
+};
+
+inline constexpr size_t NumTimeframes = 6;
+
+// seconds before now of each timeframe, the unix offset it was asked for by before
+constexpr long timeframeSeconds(Timeframe timeframe)
+{
+    constexpr long Seconds[NumTimeframes] = {0, 3600, constants::SecondsOneDay, 7 * constants::SecondsOneDay,
+                                             constants::SecondsOneMonth, constants::SecondsOneYear};
+    return Seconds[static_cast<size_t>(timeframe)];
+}
+
+// a set of timeframes as one bit each, iterated shortest first
+class TimeframeSet
+{
+public:
+    class Iterator
+    {
+    public:
+        constexpr explicit Iterator(uint8_t bits) : m_bits(bits) {}
+        Timeframe operator*() const { return static_cast<Timeframe>(__builtin_ctz(m_bits)); }
+        Iterator& operator++()
+        {
+            m_bits &= m_bits - 1;
+            return *this;
+        }
+        constexpr bool operator!=(const Iterator& other) const { return m_bits != other.m_bits; }
+
+    private:
+        uint8_t m_bits;
+    };
+
+    constexpr TimeframeSet() : m_bits(0) {}
+    constexpr TimeframeSet(std::initializer_list<Timeframe> timeframes) : m_bits(0)
+    {
+        for (Timeframe timeframe : timeframes)
+            m_bits |= bit(timeframe);
+    }
+
+    constexpr bool has(Timeframe timeframe) const { return (m_bits & bit(timeframe)) != 0; }
+    constexpr bool contains(TimeframeSet other) const { return (m_bits & other.m_bits) == other.m_bits; }
+    constexpr bool empty() const { return m_bits == 0; }
+    int size() const { return __builtin_popcount(m_bits); }
+    void insert(Timeframe timeframe) { m_bits |= bit(timeframe); }
+    void erase(Timeframe timeframe) { m_bits &= ~bit(timeframe); }
+    // the longest timeframe in the set, NOW if it is empty
+    Timeframe longest() const { return m_bits == 0 ? Timeframe::NOW : static_cast<Timeframe>(31 - __builtin_clz(m_bits)); }
+
+    constexpr TimeframeSet with(TimeframeSet other) const { return TimeframeSet(m_bits | other.m_bits); }
+    constexpr TimeframeSet without(TimeframeSet other) const { return TimeframeSet(m_bits & ~other.m_bits); }
+    constexpr bool operator==(TimeframeSet other) const { return m_bits == other.m_bits; }
+    constexpr bool operator!=(TimeframeSet other) const { return m_bits != other.m_bits; }
+
+    Iterator begin() const { return Iterator(m_bits); }
+    Iterator end() const { return Iterator(0); }
+
+private:
+    constexpr explicit TimeframeSet(uint8_t bits) : m_bits(bits) {}
+    static constexpr uint8_t bit(Timeframe timeframe) { return 1 << static_cast<uint8_t>(timeframe); }
+
+    uint8_t m_bits;
+};
+
+// a price for one timeframe, with where and when it was from
+struct Quote
+{
+    Price price;
+    uint32_t sampleUnix = 0; // time of the sample the price is from, 0 if not known
+    SourceId source = SourceId::NONE;
+    bool valid = false;      // whether a price was found for the timeframe, nothing else is set if not
+};
+
+// the price for each timeframe of one crypto/fiat, in a fixed array on the stack rather than a map
+class Quotes
+{
+public:
+    const Quote& operator[](Timeframe timeframe) const { return m_quotes[static_cast<size_t>(timeframe)]; }
+    bool has(Timeframe timeframe) const { return (*this)[timeframe].valid; }
+
+    void set(Timeframe timeframe, const Price& price, uint32_t sampleUnix = 0, SourceId source = SourceId::NONE)
+    {
+        m_quotes[static_cast<size_t>(timeframe)] = {price, sampleUnix, source, true};
+    }
+    void clear() { m_quotes = {}; }
+
+    // the timeframes that have a price
+    TimeframeSet valid() const
+    {
+        TimeframeSet timeframes;
+        for (size_t i = 0; i < NumTimeframes; i++)
+        {
+            if (m_quotes[i].valid)
+                timeframes.insert(static_cast<Timeframe>(i));
+        }
+        return timeframes;
+    }
+
+private:
+    std::array<Quote, NumTimeframes> m_quotes{};
+};
+
+#endif
@@ -0,0 +1,144 @@
+#include "SleepSchedule.h"
+#include "TimeKeeper.h"
+#include "Constants.h"
+
+int SleepSchedule::refreshSeconds(const String& refreshMins)
+{
+    int seconds = refreshMins.toInt() * 60;
+    // in case of some kind of error - don't want this null
+    return seconds < 60 ? 300 : seconds;
+}
+
+int SleepSchedule::secondsAfterWiFiFail(int consecutiveFails)
+{
+    int failLevel = constrain(consecutiveFails, 1, constants::SleepSecondsAfterWiFiFailLevels);
+    return constants::SleepSecondsAfterWiFiFail[failLevel-1];
+}
+
+int SleepSchedule::secondsAfterDataFail(int consecutiveFails)
+{
+    int failLevel = constrain(consecutiveFails, 1, constants::SleepSecondsAfterDataFailLevels);
+    return constants::SleepSecondsAfterDataFail[failLevel-1];
+}
+
+bool SleepSchedule::isDuringOvernightSleep(const struct tm& timeinfo, int sleepStartHour, int sleepHoursLength,
+                                           uint64_t& secondsLeftOfSleep)
+{
+    for (int i = 0; i < sleepHoursLength; i++)
+    {
+        int compareHour = i + sleepStartHour; // could be over 23, i.e. 1am would be value of 25
+        if (compareHour >= 24) compareHour -= 24; // turn a value of e.g. 25 -> 1
+        if (compareHour == timeinfo.tm_hour)
+        {
+            // full hours left during sleep is length - (i+1)
+            // full time between now and end of sleep is that + the minutes left to next hour number
+            int fullHoursToSleepEnd = sleepHoursLength - (i + 1);
+            int minsToNextHour = 60 - timeinfo.tm_min;
+            secondsLeftOfSleep = ((fullHoursToSleepEnd*3600) + (minsToNextHour*60)) - timeinfo.tm_sec;
+            return true;
+        }
+    }
+    return false;
+}
+
+EndOfWakeScreen SleepSchedule::finishWake(int wifiFails, int dataFails, int bootCount, WakeOutcome& outcome)
+{
+    // a failure isn't drawn the first time, the short sleep after it is a retry that usually gets past it,
+    // unless it is the first boot and there is nothing else on the screen
+    if (outcome.wifiFailed)
+    {
+        log_d("Consecutive WiFi connection failure number %d", wifiFails + 1);
+        outcome.refreshSeconds = secondsAfterWiFiFail(wifiFails + 1);
+        log_d("Set sleep time to %d", outcome.refreshSeconds);
+        return wifiFails > 0 || bootCount == 1 ? EndOfWakeScreen::WIFI_FAILURE : EndOfWakeScreen::NONE;
+    }
+
+    if (outcome.dataFailed) // wifi fail takes priority so this is only if wifi was ok
+    {
+        log_d("Consecutive data retrieval failure number %d", dataFails + 1);
+        outcome.refreshSeconds = secondsAfterDataFail(dataFails + 1);
+        log_d("Set sleep time to %d", outcome.refreshSeconds);
+        return dataFails > 0 || bootCount == 1 ? EndOfWakeScreen::DATA_FAILURE : EndOfWakeScreen::NONE;
+    }
+
+    if (outcome.secondsLeftOfSleep > 0)
+    {
+        log_d("Should be in overnight sleep - updating display");
+        return EndOfWakeScreen::OVERNIGHT_SLEEP;
+    }
+    return EndOfWakeScreen::NONE;
+}
+
+bool SleepSchedule::continueOvernightSleep(SleepState& state, uint64_t& sleepSeconds_out)
+{
+    if (state.overnightSleepPeriodsLeft <= 0)
+        return false;
+
+    // perform another required sleep period
+    state.overnightSleepPeriodsLeft--;
+    log_d("Overnight sleeping for %d seconds, with %d periods left after this",
+          state.overnightSleepPeriodLength,
+          state.overnightSleepPeriodsLeft);
+    if (state.overnightSleepPeriodsLeft == 0)
+    {
+        log_d("Ticker will wait for NTP on next reboot");
+        state.waitForNtpSync = true;
+    }
+    sleepSeconds_out = state.overnightSleepPeriodLength;
+    return true;
+}
+
+uint64_t SleepSchedule::endWake(SleepState& state, const WakeOutcome& outcome)
+{
+    if (outcome.wifiFailed)
+        state.wifiFails++;
+    else
+        state.wifiFails = 0;
+
+    if (outcome.dataFailed)
+        state.dataFails++;
+    else
+        state.dataFails = 0;
+
+    if (outcome.secondsLeftOfSleep == 0)
+        return outcome.refreshSeconds;
+
+    // if overnight sleep value returned, do an overnight sleep period
+    // max deep sleep time of ESP is ~1h10m (unsigned 32 bit number of microseconds)
+    // the internal clock of the ESP isn't great - can be out by ~20 seconds per hour before its drift is learned
+    // fine for a single 1 hour sleep but to get it more accurate at the end of the sleep we will aim
+    // to finish a chain of sleeps with some time remaining, then after resyncing the time with NTP,
+    // the last sleep will be pretty close to the requested end time. The time left is enough to cover how far
+    // TimeKeeper predicts the time could drift during the chain, between 1 and 10 minutes
+    // with a max of 1 hour individual sleep length, calculate minimum number required to get to that time
+    // left of total sleep time, then divide them evenly
+    // E.g. for 100 mins overnight sleep, to get to 10 mins left we have 90 mins, need 2 sleeps of 45 mins
+
+    // should either be many hours, or ~10 mins (call it under 1 hour)
+    log_d("Ticker should be in overnight sleep with %" PRIu64 " seconds left", outcome.secondsLeftOfSleep);
+    if (outcome.secondsLeftOfSleep < 3600) // 1 hour, can just sleep this then continue normally
+    {
+        log_d("Final sleep, resetting overnight sleeps");
+        state.overnightSleepPeriodsLeft = 0;
+        state.overnightSleepPeriodLength = 0;
+        return outcome.secondsLeftOfSleep;
+    }
+
+    float predictedError = TimeKeeper::predictedErrorSeconds(outcome.secondsLeftOfSleep);
+    int reserveSeconds = constrain((int)predictedError, constants::OvernightSleepMinReserveSeconds,
+                                   constants::OvernightSleepMaxReserveSeconds);
+    log_d("Overnight sleep will end with %d seconds left to resync the time", reserveSeconds);
+
+    int secondsUntilReserveRemaining = outcome.secondsLeftOfSleep - reserveSeconds;
+    int minNumberOfSleeps = secondsUntilReserveRemaining / 3600;
+    if (secondsUntilReserveRemaining % 3600 > 0)
+        minNumberOfSleeps++;
+
+    state.overnightSleepPeriodLength = secondsUntilReserveRemaining / minNumberOfSleeps; // close enough
+    state.overnightSleepPeriodsLeft = minNumberOfSleeps - 1; // -1 as we are about to do one of them
+
+    log_d("Overnight sleeping for %d seconds, with %d periods left after this",
+          state.overnightSleepPeriodLength,
+          state.overnightSleepPeriodsLeft);
+    return state.overnightSleepPeriodLength;
+}
@@ -0,0 +1,65 @@
+#ifndef SLEEPSCHEDULE_H
+#define SLEEPSCHEDULE_H
+
+#include <Arduino.h>
+
+// decides how long the ticker deep sleeps between wakes: the refresh time from the config, backing off after
+// failures, and the chain of sleeps through the overnight sleep
+// kept apart from the display and the network so the battery simulator in test/native runs the same decisions
+
+// kept in RTC memory across deep sleep
+struct SleepState
+{
+    int wifiFails;
+    int dataFails;
+    int overnightSleepPeriodsLeft;  // how many individual deep sleeps left in overnight sleep
+    int overnightSleepPeriodLength; // length of each sleep during overnight sleep (seconds)
+    bool waitForNtpSync;            // after a long sleep time we want to resync before using the time
+};
+
+// what a normal wake found
+struct WakeOutcome
+{
+    int refreshSeconds;          // already backed off if something failed
+    bool wifiFailed;
+    bool dataFailed;
+    uint64_t secondsLeftOfSleep; // more than 0 if it should be in the overnight sleep
+};
+
+// what a normal wake draws over the screen before it sleeps
+enum class EndOfWakeScreen
+{
+    NONE,            // the prices are already drawn, or a failure isn't shown yet
+    WIFI_FAILURE,    // couldn't connect, or connected without internet
+    DATA_FAILURE,    // connected but no data source answered
+    OVERNIGHT_SLEEP
+};
+
+class SleepSchedule
+{
+public:
+    // refresh time for the minutes in the config, 300 seconds if it isn't valid
+    static int refreshSeconds(const String& refreshMins);
+
+    // sleep time after this many WiFi or data failures in a row, including the one just seen
+    static int secondsAfterWiFiFail(int consecutiveFails);
+    static int secondsAfterDataFail(int consecutiveFails);
+
+    // whether the local time given is in the overnight sleep, and if so how long is left of it
+    static bool isDuringOvernightSleep(const struct tm& timeinfo, int sleepStartHour, int sleepHoursLength,
+                                       uint64_t& secondsLeftOfSleep);
+
+    // at the end of a normal wake, backs off outcome.refreshSeconds after a failure and says what to draw
+    // wifiFails and dataFails are the failures in a row before this wake, as kept in SleepState
+    static EndOfWakeScreen finishWake(int wifiFails, int dataFails, int bootCount, WakeOutcome& outcome);
+
+    // at the start of a wake, whether it is only one of the chain of overnight sleeps, and if so how long to sleep
+    // again straight away
+    static bool continueOvernightSleep(SleepState& state, uint64_t& sleepSeconds_out);
+
+    // at the end of a normal wake, counts the failures and starts the chain of overnight sleeps if needed
+    // returns how long to sleep
+    static uint64_t endWake(SleepState& state, const WakeOutcome& outcome);
+};
+
+#endif
@@ -0,0 +1,31 @@
+#include "TextLayout.h"
+
+CryptoBoxLayout TextLayout::cryptoBox(const char* crypto, const char* dayMonth, const char* time,
+                                      const GFXfont* const* cryptoFonts, size_t numFonts, const GFXfont& dateFont,
+                                      uint16_t cryptoPadding, uint16_t datePadding, uint16_t dateBoxX1,
+                                      uint16_t minWidth, uint16_t maxWidth)
+{
+    uint16_t dayMonthWidth = width(dateFont, dayMonth);
+    uint16_t timeWidth = width(dateFont, time);
+    uint16_t dateWidth = dateBoxX1 + (2 * datePadding) + (dayMonthWidth > timeWidth ? dayMonthWidth : timeWidth);
+
+    CryptoBoxLayout layout = {numFonts > 0 ? cryptoFonts[0] : nullptr, minWidth, true};
+    uint16_t boxWidth = dateWidth;
+    for (size_t i = 0; i < numFonts; i++)
+    {
+        uint16_t cryptoWidth = (2 * cryptoPadding) + width(*cryptoFonts[i], crypto);
+        layout.font = cryptoFonts[i];
+        boxWidth = cryptoWidth > dateWidth ? cryptoWidth : dateWidth;
+        if (boxWidth <= maxWidth)
+            break;
+    }
+
+    layout.fits = boxWidth <= maxWidth;
+    if (boxWidth < minWidth)
+        layout.width = minWidth;
+    else if (!layout.fits)
+        layout.width = maxWidth;
+    else
+        layout.width = boxWidth;
+    return layout;
+}
@@ -0,0 +1,91 @@
+#ifndef TEXTLAYOUT_H
+#define TEXTLAYOUT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <gfxfont.h>
+
+// measures text straight from the glyph tables of the GFX fonts, the advance and bounds of every glyph, without
+// going through the display to set its font and ask for the bounds of each string
+// constexpr so text in a font with constexpr glyphs is measured at compile time, the shipped fonts are declared
+// const so theirs are measured when drawing, still without any of the display's state
+
+// as Adafruit_GFX::getTextBounds, the box around the pixels relative to the cursor
+struct TextBounds
+{
+    int16_t x;
+    int16_t y;
+    uint16_t w;
+    uint16_t h;
+};
+
+// font for the crypto symbol and width of the box it goes in, alongside the date and time
+struct CryptoBoxLayout
+{
+    const GFXfont* font;
+    uint16_t width;
+    bool fits; // false if even the last font is too wide, the width is then the max
+};
+
+class TextLayout
+{
+public:
+    // the same as getTextBounds from 0,0 with text wrap off
+    static constexpr TextBounds bounds(const GFXfont& font, const char* text)
+    {
+        int16_t x = 0, y = 0;
+        int16_t minx = 0x7FFF, miny = 0x7FFF, maxx = -1, maxy = -1;
+        for (; *text; text++)
+        {
+            uint8_t c = *text;
+            if (c == '\n')
+            {
+                x = 0;
+                y += font.yAdvance;
+                continue;
+            }
+            if (c == '\r' || c < font.first || c > font.last)
+                continue;
+
+            const GFXglyph& glyph = font.glyph[c - font.first];
+            int16_t x1 = x + glyph.xOffset;
+            int16_t y1 = y + glyph.yOffset;
+            int16_t x2 = x1 + glyph.width - 1;
+            int16_t y2 = y1 + glyph.height - 1;
+            minx = x1 < minx ? x1 : minx;
+            miny = y1 < miny ? y1 : miny;
+            maxx = x2 > maxx ? x2 : maxx;
+            maxy = y2 > maxy ? y2 : maxy;
+            x += glyph.xAdvance;
+        }
+
+        TextBounds result = {0, 0, 0, 0};
+        if (maxx >= minx)
+        {
+            result.x = minx;
+            result.w = maxx - minx + 1;
+        }
+        if (maxy >= miny)
+        {
+            result.y = miny;
+            result.h = maxy - miny + 1;
+        }
+        return result;
+    }
+
+    static constexpr uint16_t width(const GFXfont& font, const char* text)
+    {
+        return bounds(font, text).w;
+    }
+
+    // the first of the fonts, largest first, that fits the crypto symbol and the date and time in a box no wider
+    // than maxWidth, and that width. The date and time are the same in every font so are measured once
+    // the box is at least minWidth, with padding either side of the symbol and the date/time, which sit right of
+    // dateBoxX1
+    static CryptoBoxLayout cryptoBox(const char* crypto, const char* dayMonth, const char* time,
+                                     const GFXfont* const* cryptoFonts, size_t numFonts, const GFXfont& dateFont,
+                                     uint16_t cryptoPadding, uint16_t datePadding, uint16_t dateBoxX1,
+                                     uint16_t minWidth, uint16_t maxWidth);
+};
+
+#endif
@@ -0,0 +1,156 @@
+#include "TimeKeeper.h"
+#include "Constants.h"
+
+#include "esp_sntp.h"
+#include <sys/time.h>
+
+namespace
+{
+    constexpr float MicrosPerHour = 3600.0f * 1000000.0f;
+    // an error bigger than this means the time was changed some other way, so it isn't drift
+    constexpr float MaxPlausibleDriftSecondsPerHour = 360.0f;
+
+    constexpr TimeKeeperState initialState = {0, 0, 0, 0.0f, constants::RtcDriftDefaultUncertaintySecondsPerHour, 0};
+    RTC_DATA_ATTR TimeKeeperState state = initialState;
+    static_assert(sizeof(state) <= constants::RtcBytesTimeKeeper, "over the time keeper's RTC share");
+
+    int64_t nowMicros()
+    {
+        struct timeval tv;
+        gettimeofday(&tv, nullptr);
+        return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+    }
+
+    void setMicros(int64_t micros)
+    {
+        struct timeval tv;
+        tv.tv_sec = micros / 1000000;
+        tv.tv_usec = micros % 1000000;
+        settimeofday(&tv, nullptr);
+    }
+}
+
+bool TimeKeeper::hasValidTime()
+{
+    return time(nullptr) > constants::MinValidEpoch;
+}
+
+bool TimeKeeper::needsSync()
+{
+    if (!hasValidTime() || state.lastSyncMicros == 0)
+        return true;
+
+    float error = predictedErrorSeconds();
+    log_d("Predicted time error is %.1f seconds", error);
+    return error > constants::TimeMaxPredictedErrorSeconds;
+}
+
+bool TimeKeeper::sync(uint32_t timeoutMillis)
+{
+    bool hadValidTime = hasValidTime();
+    int64_t before = nowMicros();
+    uint32_t start = millis();
+
+    log_d("Syncing time with NTP");
+    sntp_set_sync_status(SNTP_SYNC_STATUS_RESET);
+    configTime(0, 0, constants::NtpServer);
+    while (sntp_get_sync_status() != SNTP_SYNC_STATUS_COMPLETED)
+    {
+        if (millis() - start > timeoutMillis)
+        {
+            log_w("No NTP response after %d ms", timeoutMillis);
+            return false;
+        }
+        delay(10);
+    }
+    sntp_stop(); // one sync per wake is enough, stop it adjusting the time again later
+
+    // the system time should have moved on by the time spent waiting, anything else is how far out it was
+    int64_t after = nowMicros();
+    int64_t error = after - (before + (int64_t)(millis() - start) * 1000);
+    log_d("Synced time with NTP in %d ms, error was %lld ms", millis() - start, error / 1000);
+
+    if (!hadValidTime)
+        state.lastSyncMicros = 0; // nothing to learn from
+    learnFromSync(after, error);
+    return true;
+}
+
+void TimeKeeper::learnFromSync(int64_t syncMicros, int64_t errorMicros)
+{
+    if (state.lastSyncMicros > 0 && syncMicros > state.lastSyncMicros)
+    {
+        float hours = (syncMicros - state.lastSyncMicros) / MicrosPerHour;
+        float errorSeconds = errorMicros / 1000000.0f;
+        // the error the clock would have had without the corrections applied since the last sync
+        float driftSecondsPerHour = (errorSeconds + state.correctedMicros / 1000000.0f) / hours;
+
+        if (hours * 3600 < constants::RtcDriftLearnMinSeconds ||
+            fabsf(driftSecondsPerHour) > MaxPlausibleDriftSecondsPerHour)
+            log_d("Not learning drift from this sync, %.2f hours since last sync, drift %.1f s/h", hours, driftSecondsPerHour);
+        else
+        {
+            // the uncertainty halves after each sync the corrected time was close at, but jumps up to twice
+            // any bigger error seen so it syncs sooner next time
+            // without a learned drift nothing was corrected, so the error says nothing about the corrections
+            if (state.driftSamples > 0)
+            {
+                float residual = fabsf(errorSeconds) / hours;
+                state.uncertaintySecondsPerHour = max(state.uncertaintySecondsPerHour / 2, residual * 2);
+            }
+            else
+                state.uncertaintySecondsPerHour /= 2;
+            state.uncertaintySecondsPerHour = max(state.uncertaintySecondsPerHour,
+                                                  constants::RtcDriftMinUncertaintySecondsPerHour);
+
+            if (state.driftSamples == 0)
+                state.driftSecondsPerHour = driftSecondsPerHour;
+            else
+                state.driftSecondsPerHour += constants::RtcDriftLearnRate * (driftSecondsPerHour - state.driftSecondsPerHour);
+            state.driftSamples++;
+
+            log_i("Time drift measured at %.2f s/h, now using %.2f s/h with uncertainty %.2f s/h",
+                  driftSecondsPerHour, state.driftSecondsPerHour, state.uncertaintySecondsPerHour);
+        }
+    }
+
+    state.lastSyncMicros = syncMicros;
+    state.lastCorrectionMicros = syncMicros;
+    state.correctedMicros = 0;
+}
+
+void TimeKeeper::applyDriftCorrection()
+{
+    if (state.driftSamples == 0 || state.lastCorrectionMicros == 0 || !hasValidTime())
+        return;
+
+    int64_t now = nowMicros();
+    if (now <= state.lastCorrectionMicros)
+        return;
+
+    int64_t correction = (int64_t)(state.driftSecondsPerHour * ((now - state.lastCorrectionMicros) / MicrosPerHour) * 1000000.0f);
+    setMicros(now + correction);
+    state.correctedMicros += correction;
+    state.lastCorrectionMicros = now + correction;
+    log_d("Corrected time by %lld ms for drift", correction / 1000);
+}
+
+float TimeKeeper::predictedErrorSeconds(uint32_t secondsFromNow)
+{
+    // could be out by any amount, a day is more than any bound it will be compared against
+    if (state.lastSyncMicros == 0 || !hasValidTime())
+        return constants::SecondsOneDay;
+
+    float hours = (nowMicros() - state.lastSyncMicros) / MicrosPerHour + secondsFromNow / 3600.0f;
+    return max(hours, 0.0f) * state.uncertaintySecondsPerHour;
+}
+
+TimeKeeperState TimeKeeper::getState()
+{
+    return state;
+}
+
+void TimeKeeper::reset()
+{
+    state = initialState;
+}
@@ -0,0 +1,47 @@
+#ifndef TIMEKEEPER_H
+#define TIMEKEEPER_H
+
+#include <Arduino.h>
+
+// keeps the time accurate across deep sleep without syncing with NTP on every wake
+// the system time carries on through deep sleep using the RTC slow clock, which can drift by ~20 seconds per hour
+// the drift seen at each NTP sync is learned and corrected for on the wakes in between, and NTP is only used
+// again once the predicted error of the corrected time could be more than TimeMaxPredictedErrorSeconds
+
+struct TimeKeeperState
+{
+    int64_t lastSyncMicros;       // epoch time of the last NTP sync, 0 if never synced
+    int64_t lastCorrectionMicros; // epoch time the drift was last corrected up to
+    int64_t correctedMicros;      // total correction applied since the last sync
+    float driftSecondsPerHour;    // learned drift of the system time, positive if it runs slow
+    float uncertaintySecondsPerHour; // how far out the corrected time could be per hour since the last sync
+    int driftSamples;             // number of syncs the drift has been learned from
+};
+
+class TimeKeeper
+{
+public:
+    // whether the system time has been set at all, e.g. not after power on
+    static bool hasValidTime();
+
+    // whether the time could be too far out to use without syncing with NTP first
+    static bool needsSync();
+
+    // syncs with NTP, waiting up to timeoutMillis for the response, and learns the drift from the error seen
+    // returns false if there was no response
+    static bool sync(uint32_t timeoutMillis);
+
+    // corrects the system time for the drift predicted since it was last corrected or synced
+    static void applyDriftCorrection();
+
+    // how far out the time could be after another secondsFromNow without a sync
+    static float predictedErrorSeconds(uint32_t secondsFromNow = 0);
+
+    // updates the drift from the error seen at a sync at syncMicros, error is the NTP time minus the system time
+    static void learnFromSync(int64_t syncMicros, int64_t errorMicros);
+
+    static TimeKeeperState getState();
+    static void reset();
+};
+
+#endif
@@ -2,6 +2,7 @@
 #include "SPIFFS.h"
 #include "Constants.h"
 #include <ArduinoJson.h>
+#include <algorithm>
 
 namespace utils
 {
@@ -134,6 +135,23 @@ String getDeviceID()
     return String(macStr);
 }
 
+uint32_t hash(const void* data, size_t length, uint32_t seed)
+{
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    uint32_t h = seed;
+    for (size_t i = 0; i < length; i++)
+    {
+        h ^= bytes[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+uint32_t hash(const String& str, uint32_t seed)
+{
+    return hash(str.c_str(), str.length(), seed);
+}
+
 ConfigState readConfig(CurrentConfig& cfg)
 {
     // read config from spiffs
@@ -144,7 +162,7 @@ ConfigState readConfig(CurrentConfig& cfg)
     }
 
     File file = SPIFFS.open(constants::SpiffsConfigFileName);
-    StaticJsonDocument<512> doc;
+    StaticJsonDocument<768> doc; // same size as when it is written
     DeserializationError error = deserializeJson(doc, file);
     file.close();
     if (error)
@@ -165,11 +183,12 @@ ConfigState readConfig(CurrentConfig& cfg)
     int overnightSleepStart = doc[constants::ConfigKeyOvernightSleepStart].isNull() ? -1 : doc[constants::ConfigKeyOvernightSleepStart].as<int>();
     int overnightSleepLength = doc[constants::ConfigKeyOvernightSleepLength].isNull() ? 0 : doc[constants::ConfigKeyOvernightSleepLength].as<int>();
     bool simpleBattery = doc[constants::ConfigKeyDisplaySimpleBattery].isNull() ? true : (doc[constants::ConfigKeyDisplaySimpleBattery] == "1");
+    std::vector<String> watchlist = parseWatchlist(doc[constants::ConfigKeyWatchlist].isNull() ? String() : doc[constants::ConfigKeyWatchlist]);
 
-    log_d("Read config: ssid=%s, pass=%s, crypto=%s, fiat=%s, refresh mins=%s, display mode=%s, timezone=%s, is24Hour=%d, NightStart=%d, NightLength=%d, simpleBattery=%d", 
-            ssid, pass, crypto, fiat, refreshMins, displayMode, tz.c_str(), is24Hour, overnightSleepStart, overnightSleepLength, simpleBattery);
+    log_d("Read config: ssid=%s, pass=%s, crypto=%s, fiat=%s, refresh mins=%s, display mode=%s, timezone=%s, is24Hour=%d, NightStart=%d, NightLength=%d, simpleBattery=%d, watchlist size=%d", 
+            ssid, pass, crypto, fiat, refreshMins, displayMode, tz.c_str(), is24Hour, overnightSleepStart, overnightSleepLength, simpleBattery, watchlist.size());
 
-    cfg = CurrentConfig{ssid, pass, crypto, fiat, refreshMins, tz, displayMode, is24Hour, overnightSleepStart, overnightSleepLength, simpleBattery};
+    cfg = CurrentConfig{ssid, pass, crypto, fiat, refreshMins, tz, displayMode, is24Hour, overnightSleepStart, overnightSleepLength, simpleBattery, watchlist};
 
     if (cfg.ssid.isEmpty()) // password allowed to be blank, others have defaults in html. Could enforce this in html instead 
         return ConfigState::CONFIG_NO_SSID;
@@ -183,4 +202,24 @@ ConfigState readConfig(CurrentConfig& cfg)
     return ConfigState::CONFIG_FAIL;    
 }
 
+std::vector<String> parseWatchlist(const String& list)
+{
+    std::vector<String> watchlist;
+    int start = 0;
+    while (start <= (int)list.length() && (int)watchlist.size() < constants::WatchlistMaxSymbols)
+    {
+        int end = list.indexOf(',', start);
+        if (end == -1)
+            end = list.length();
+
+        String symbol = list.substring(start, end);
+        symbol.trim();
+        symbol.toUpperCase();
+        if (!symbol.isEmpty() && std::find(watchlist.begin(), watchlist.end(), symbol) == watchlist.end())
+            watchlist.push_back(symbol);
+        start = end + 1;
+    }
+    return watchlist;
+}
+
 }
@@ -2,6 +2,7 @@
 #define TICKER_UTILS_H
 
 #include <Arduino.h>
+#include <vector>
 
 // various hardware utility functions that don't really fit into a class
 
@@ -21,6 +22,7 @@ struct CurrentConfig
     int overnightSleepStart = -1;
     int overnightSleepLength = 0;
     bool showSimpleBattery = true;
+    std::vector<String> watchlist; // more than one crypto here shows these instead of just crypto
 };
 
 enum class ConfigState
@@ -44,8 +46,16 @@ bool initSpiffs(const bool formatOnFail = true);
 
 String getDeviceID();
 
+// FNV-1a, for cheap keys/fingerprints of data kept in RTC memory - not for anything security related
+uint32_t hash(const void* data, size_t length, uint32_t seed = 2166136261u);
+uint32_t hash(const String& str, uint32_t seed = 2166136261u);
+
 ConfigState readConfig(CurrentConfig& cfg);
 
+// comma separated list of crypto symbols e.g. "btc, ETH,sol" -> {"BTC", "ETH", "SOL"}
+// duplicates are removed and only the first WatchlistMaxSymbols are kept
+std::vector<String> parseWatchlist(const String& list);
+
 }
 
 #endif
@@ -0,0 +1,200 @@
+#include "WakeTimer.h"
+#include "Constants.h"
+
+#include "SPIFFS.h"
+
+#include <algorithm>
+
+namespace
+{
+    constexpr uint16_t FileVersion = 1;
+
+    struct FileHeader
+    {
+        uint16_t version;
+        uint16_t cycleBytes; // so a log written with a different set of phases isn't misread
+    };
+
+    RTC_DATA_ATTR WakeCycle cycles[constants::WakeTimingCycles];
+    RTC_DATA_ATTR uint32_t cyclesBegun = 0;   // the current wake is in cycles[(cyclesBegun - 1) % WakeTimingCycles]
+    RTC_DATA_ATTR uint32_t cyclesFlushed = 0; // wakes before this one are in the log, or were replaced before they got there
+    RTC_DATA_ATTR bool inWake = false;
+    static_assert(sizeof(cycles) + sizeof(cyclesBegun) + sizeof(cyclesFlushed) + sizeof(inWake) <=
+                      constants::RtcBytesWakeTimer,
+                  "fewer WakeTimingCycles fit in RTC memory");
+
+    const char* const phaseNames[NumWakePhases] = {"battery", "display init", "config", "wifi", "ntp", "dns",
+                                                   "tls", "first byte", "parse", "render", "refresh"};
+
+    WakeCycle& cycleAt(uint32_t index)
+    {
+        return cycles[index % constants::WakeTimingCycles];
+    }
+
+    uint32_t oldestKept()
+    {
+        return cyclesBegun > (uint32_t)constants::WakeTimingCycles ? cyclesBegun - constants::WakeTimingCycles : 0;
+    }
+
+    bool readCycles(const char* fileName, std::vector<WakeCycle>& cycles_out)
+    {
+        File file = SPIFFS.open(fileName, FILE_READ);
+        if (!file)
+            return false;
+
+        FileHeader header;
+        bool valid = file.read((uint8_t*)&header, sizeof(header)) == sizeof(header) && header.version == FileVersion &&
+                     header.cycleBytes == sizeof(WakeCycle);
+        if (valid)
+        {
+            WakeCycle cycle;
+            while (file.read((uint8_t*)&cycle, sizeof(cycle)) == sizeof(cycle))
+                cycles_out.push_back(cycle);
+        }
+        file.close();
+        return valid;
+    }
+}
+
+void WakeTimer::beginWake(uint32_t bootCount)
+{
+    if (inWake)
+        log_w("Previous wake %d never finished", cycleAt(cyclesBegun - 1).bootCount);
+
+    WakeCycle& cycle = cycleAt(cyclesBegun++);
+    cycle = WakeCycle{};
+    cycle.bootCount = bootCount;
+    inWake = true;
+}
+
+void WakeTimer::record(WakePhase phase, uint32_t elapsedMillis)
+{
+    if (!inWake || phase >= WakePhase::COUNT)
+        return;
+
+    WakeCycle& cycle = cycleAt(cyclesBegun - 1);
+    int i = static_cast<int>(phase);
+    cycle.phaseMillis[i] = std::min<uint32_t>(cycle.phaseMillis[i] + elapsedMillis, UINT16_MAX);
+    if (cycle.phaseCounts[i] < UINT8_MAX)
+        cycle.phaseCounts[i]++;
+}
+
+void WakeTimer::endWake()
+{
+    if (!inWake)
+        return;
+
+    WakeCycle& cycle = cycleAt(cyclesBegun - 1);
+    cycle.awakeMillis = std::max<uint32_t>(millis(), 1); // 0 marks an unfinished wake
+    time_t now = time(nullptr);
+    cycle.endUnix = now >= constants::MinValidEpoch ? now : 0;
+    inWake = false;
+
+    for (int i = 0; i < NumWakePhases; i++)
+    {
+        if (cycle.phaseCounts[i] > 0)
+            log_d("Wake phase %s: %d ms over %d", phaseNames[i], cycle.phaseMillis[i], cycle.phaseCounts[i]);
+    }
+    log_i("Wake %d took %d ms", cycle.bootCount, cycle.awakeMillis);
+
+    if (cyclesBegun - std::max(cyclesFlushed, oldestKept()) >= (uint32_t)constants::WakeTimingFlushCycles)
+        flush();
+}
+
+bool WakeTimer::flush()
+{
+    uint32_t from = std::max(cyclesFlushed, oldestKept());
+    uint32_t to = inWake ? cyclesBegun - 1 : cyclesBegun;
+    if (from >= to)
+        return true;
+
+    // the log is started again once it gets too big, keeping the previous one
+    if (SPIFFS.exists(constants::SpiffsWakeTimingFileName))
+    {
+        File existing = SPIFFS.open(constants::SpiffsWakeTimingFileName, FILE_READ);
+        size_t size = existing ? existing.size() : 0;
+        existing.close();
+        if (size >= constants::WakeTimingLogMaxBytes)
+        {
+            SPIFFS.remove(constants::SpiffsWakeTimingOldFileName);
+            SPIFFS.rename(constants::SpiffsWakeTimingFileName, constants::SpiffsWakeTimingOldFileName);
+        }
+    }
+
+    bool isNew = !SPIFFS.exists(constants::SpiffsWakeTimingFileName);
+    File file = SPIFFS.open(constants::SpiffsWakeTimingFileName, FILE_APPEND);
+    if (!file)
+    {
+        log_w("Failed to open the wake timing log");
+        return false;
+    }
+
+    bool success = true;
+    if (isNew)
+    {
+        FileHeader header{FileVersion, sizeof(WakeCycle)};
+        success = file.write((const uint8_t*)&header, sizeof(header)) == sizeof(header);
+    }
+    for (uint32_t i = from; i < to && success; i++)
+        success = file.write((const uint8_t*)&cycleAt(i), sizeof(WakeCycle)) == sizeof(WakeCycle);
+    file.close();
+
+    if (!success)
+    {
+        log_w("Failed to write the wake timing log");
+        return false;
+    }
+    log_d("Wrote %d wakes to the wake timing log", to - from);
+    cyclesFlushed = to;
+    return true;
+}
+
+std::vector<WakeCycle> WakeTimer::recentCycles()
+{
+    std::vector<WakeCycle> recent;
+    for (uint32_t i = oldestKept(); i < cyclesBegun; i++)
+        recent.push_back(cycleAt(i));
+    return recent;
+}
+
+std::vector<WakeCycle> WakeTimer::readLog()
+{
+    std::vector<WakeCycle> logged;
+    readCycles(constants::SpiffsWakeTimingOldFileName, logged);
+    readCycles(constants::SpiffsWakeTimingFileName, logged);
+    return logged;
+}
+
+const char* WakeTimer::phaseName(WakePhase phase)
+{
+    return phase < WakePhase::COUNT ? phaseNames[static_cast<int>(phase)] : "unknown";
+}
+
+void WakeTimer::reset()
+{
+    std::fill(std::begin(cycles), std::end(cycles), WakeCycle{});
+    cyclesBegun = 0;
+    cyclesFlushed = 0;
+    inWake = false;
+    SPIFFS.remove(constants::SpiffsWakeTimingFileName);
+    SPIFFS.remove(constants::SpiffsWakeTimingOldFileName);
+}
+
+PhaseTimer::PhaseTimer(WakePhase phase) :
+    m_phase(phase),
+    m_start(millis())
+{
+}
+
+PhaseTimer::~PhaseTimer()
+{
+    stop();
+}
+
+void PhaseTimer::stop()
+{
+    if (!m_running)
+        return;
+    m_running = false;
+    WakeTimer::record(m_phase, millis() - m_start);
+}
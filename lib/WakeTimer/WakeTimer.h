@@ -0,0 +1,78 @@
+#ifndef WAKETIMER_H
+#define WAKETIMER_H
+
+#include <Arduino.h>
+#include <vector>
+
+// how long each phase of a wake took, to see where the awake time goes across many wakes
+// the last WakeTimingCycles wakes are kept in a ring buffer in RTC memory, and the finished ones are appended
+// to a log in SPIFFS every WakeTimingFlushCycles wakes
+
+enum class WakePhase : uint8_t
+{
+    BATTERY_READ,
+    DISPLAY_INIT,
+    CONFIG_READ,
+    WIFI_CONNECT,
+    NTP_SYNC,
+    DNS_LOOKUP,
+    TLS_HANDSHAKE,
+    FIRST_BYTE,    // from sending a request until its headers are in
+    PARSE,
+    RENDER,        // drawing into the display buffer
+    PANEL_REFRESH, // sending the buffer to the panel and waiting for the refresh
+    COUNT
+};
+
+constexpr int NumWakePhases = static_cast<int>(WakePhase::COUNT);
+
+struct WakeCycle
+{
+    uint32_t bootCount;
+    uint32_t endUnix;                    // 0 if the time wasn't known
+    uint32_t awakeMillis;                // 0 if the wake never finished, e.g. the failsafe timer fired
+    uint16_t phaseMillis[NumWakePhases]; // total of each phase over the wake
+    uint8_t phaseCounts[NumWakePhases];  // times each phase happened, e.g. a DNS lookup for each server
+};
+
+class WakeTimer
+{
+public:
+    // starts the timings of a new wake, a wake that was begun but never ended is kept as unfinished
+    static void beginWake(uint32_t bootCount);
+    // adds the time of one phase to the current wake, ignored if no wake has begun
+    static void record(WakePhase phase, uint32_t elapsedMillis);
+    // finishes the current wake, and writes the finished wakes to SPIFFS if enough have built up
+    static void endWake();
+
+    // appends the finished wakes not yet in the log, returns false if they could not be written
+    // they stay in RTC memory to try again next time, until they are replaced by newer wakes
+    static bool flush();
+
+    // the wakes in RTC memory, oldest first, including the current one
+    static std::vector<WakeCycle> recentCycles();
+    // every wake in the log, oldest first
+    static std::vector<WakeCycle> readLog();
+
+    static const char* phaseName(WakePhase phase);
+
+    // clears the wakes in RTC memory and removes the log
+    static void reset();
+};
+
+// times a phase of the current wake, from construction until stop() or destruction
+class PhaseTimer
+{
+public:
+    explicit PhaseTimer(WakePhase phase);
+    ~PhaseTimer();
+
+    void stop();
+
+private:
+    WakePhase m_phase;
+    uint32_t m_start;
+    bool m_running = true;
+};
+
+#endif
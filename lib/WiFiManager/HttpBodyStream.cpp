@@ -0,0 +1,151 @@
+#include "HttpBodyStream.h"
+
+HttpBodyStream::HttpBodyStream(Client& client) :
+    m_client(client)
+{
+    setTimeout(client.getTimeout());
+}
+
+bool HttpBodyStream::readHeaders()
+{
+    // status line e.g. "HTTP/1.1 200 OK"
+    String line = m_client.readStringUntil('\n');
+    if (!line.startsWith("HTTP/1."))
+    {
+        log_w("No HTTP status line received");
+        return false;
+    }
+    m_statusCode = line.substring(9, 12).toInt();
+    m_keepAlive = line.startsWith("HTTP/1.1"); // 1.0 closes by default
+
+    bool haveLength = false;
+    bool chunked = false;
+    while (m_client.connected() || m_client.available())
+    {
+        line = m_client.readStringUntil('\n');
+        if (line == "\r" || line.isEmpty())
+            break;
+
+        int colon = line.indexOf(':');
+        if (colon < 0)
+            continue;
+
+        String name = line.substring(0, colon);
+        name.toLowerCase();
+        String value = line.substring(colon + 1);
+        value.trim();
+        value.toLowerCase();
+
+        if (name == "content-length")
+        {
+            m_contentLength = value.toInt();
+            haveLength = true;
+        }
+        else if (name == "transfer-encoding")
+            chunked = value.indexOf("chunked") != -1;
+        else if (name == "connection")
+            m_keepAlive = value != "close";
+    }
+
+    // chunked takes priority over a content length if both are given
+    if (chunked)
+        m_framing = Framing::CHUNKED;
+    else if (haveLength)
+    {
+        m_framing = Framing::LENGTH;
+        m_remaining = m_contentLength;
+        m_finished = m_contentLength == 0;
+    }
+    else
+        m_framing = Framing::CLOSE;
+
+    log_d("Headers received: status=%d, length=%d, chunked=%d, keepAlive=%d",
+          m_statusCode, m_contentLength, chunked, m_keepAlive);
+    return true;
+}
+
+bool HttpBodyStream::skipRemaining()
+{
+    while (!m_finished)
+    {
+        if (timedRead() < 0)
+            return false;
+    }
+    return true;
+}
+
+int HttpBodyStream::available()
+{
+    if (m_finished)
+        return 0;
+
+    int clientAvailable = m_client.available();
+    if (m_framing == Framing::CLOSE || m_remaining == 0)
+        return clientAvailable > 0 ? 1 : 0; // at least the next chunk header is there, or will be once read
+    return min((size_t)clientAvailable, m_remaining);
+}
+
+int HttpBodyStream::read()
+{
+    int c = peek();
+    if (c >= 0)
+    {
+        m_client.read();
+        consumed();
+    }
+    return c;
+}
+
+int HttpBodyStream::peek()
+{
+    if (m_finished)
+        return -1;
+
+    if (m_framing == Framing::CHUNKED && m_remaining == 0 && !startNextChunk())
+        return -1;
+    if (m_finished) // that was the last chunk
+        return -1;
+
+    int c = m_client.peek();
+    if (c < 0 && m_framing == Framing::CLOSE && !m_client.connected() && !m_client.available())
+        m_finished = true;
+    return c;
+}
+
+bool HttpBodyStream::startNextChunk()
+{
+    // each chunk is "<size in hex>\r\n<data>\r\n", the body ends with a chunk of size 0
+    if (!m_client.available())
+        return false; // not arrived yet, caller will retry until its timeout
+
+    if (m_readFirstChunk)
+        m_client.readStringUntil('\n'); // the \r\n after the last chunk's data
+
+    String sizeLine = m_client.readStringUntil('\n');
+    sizeLine.trim();
+    if (sizeLine.isEmpty())
+        return false;
+
+    m_readFirstChunk = true;
+    m_remaining = strtoul(sizeLine.c_str(), nullptr, 16);
+    if (m_remaining == 0)
+    {
+        // last chunk, skip any trailers up to the final empty line
+        String trailer;
+        do
+            trailer = m_client.readStringUntil('\n');
+        while (trailer != "\r" && !trailer.isEmpty());
+        m_finished = true;
+    }
+    return true;
+}
+
+void HttpBodyStream::consumed()
+{
+    if (m_framing == Framing::CLOSE)
+        return;
+
+    m_remaining--;
+    if (m_remaining == 0 && m_framing == Framing::LENGTH)
+        m_finished = true;
+}
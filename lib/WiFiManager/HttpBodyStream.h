@@ -0,0 +1,57 @@
+#ifndef HTTPBODYSTREAM_H
+#define HTTPBODYSTREAM_H
+
+#include <Arduino.h>
+#include <Client.h>
+
+// reads a single HTTP/1.1 response from a connected client
+// the body is delimited by its Content-Length or chunked encoding, so once it has been fully read the
+// connection is left at the start of the next response and can be used for another request
+class HttpBodyStream : public Stream
+{
+public:
+    explicit HttpBodyStream(Client& client);
+
+    // reads the status line and headers, must be called before reading the body
+    bool readHeaders();
+
+    int statusCode() const { return m_statusCode; }
+    int contentLength() const { return m_framing == Framing::LENGTH ? m_contentLength : -1; }
+
+    // whether the server will keep the connection open after this response
+    bool keepAlive() const { return m_keepAlive && m_framing != Framing::CLOSE; }
+
+    // whether the whole body has been read
+    bool finished() const { return m_finished; }
+
+    // read and discard whatever is left of the body, returns true if it could all be read
+    bool skipRemaining();
+
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t write(uint8_t) override { return 0; }
+
+private:
+    enum class Framing
+    {
+        LENGTH,  // Content-Length header
+        CHUNKED, // Transfer-Encoding: chunked
+        CLOSE    // neither, body ends when the server closes the connection
+    };
+
+    bool startNextChunk();
+    void consumed();
+
+    Client& m_client;
+    Framing m_framing = Framing::CLOSE;
+    int m_statusCode = 0;
+    int m_contentLength = 0;
+    bool m_keepAlive = true;
+    bool m_finished = false;
+
+    size_t m_remaining = 0;     // bytes left in the body for LENGTH, or in the current chunk for CHUNKED
+    bool m_readFirstChunk = false;
+};
+
+#endif
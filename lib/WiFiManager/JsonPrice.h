@@ -0,0 +1,21 @@
+#ifndef JSONPRICE_H
+#define JSONPRICE_H
+
+#include "Price.h"
+
+#include <ArduinoJson.h>
+
+// a price from a JSON value, without it going through a float
+// binance and kucoin send prices as strings, which are read exactly, coingecko sends numbers, which ArduinoJson has
+// already read as a double and are taken to 15 significant digits
+// returns false if the value is neither or isn't a number
+inline bool jsonPrice(JsonVariantConst value, Price& price_out)
+{
+    if (value.is<const char*>())
+        return Price::parse(value.as<const char*>(), price_out);
+    if (value.is<double>())
+        return Price::fromDouble(value.as<double>(), price_out);
+    return false;
+}
+
+#endif
@@ -0,0 +1,235 @@
+#include "PriceHistoryStore.h"
+#include "Constants.h"
+#include "Utils.h"
+
+#include "SPIFFS.h"
+#include <algorithm>
+
+namespace
+{
+    constexpr uint32_t FileVersion = 2; // 1 had float prices
+    constexpr const char* FilePrefix = "/ph_";
+
+    struct FileHeader
+    {
+        uint32_t version;
+        uint32_t key;   // of the crypto/fiat, in case of a hash collision in the file name
+        uint32_t count; // samples following the header
+    };
+
+    // current prices of the crypto/fiat last fetched, oldest first
+    RTC_DATA_ATTR uint32_t recentKey = 0;
+    RTC_DATA_ATTR PriceSample recentSamples[constants::PriceStoreRecentSamples];
+    RTC_DATA_ATTR int numRecentSamples = 0;
+    static_assert(sizeof(recentKey) + sizeof(recentSamples) + sizeof(numRecentSamples) <= constants::RtcBytesPriceHistory,
+                  "fewer PriceStoreRecentSamples fit in RTC memory");
+
+    uint32_t distance(uint32_t a, uint32_t b)
+    {
+        return a > b ? a - b : b - a;
+    }
+
+    uint32_t dayOf(uint32_t unix)
+    {
+        return unix / constants::SecondsOneDay;
+    }
+}
+
+PriceHistoryStore::PriceHistoryStore(const String& crypto, const String& fiat)
+{
+    uint32_t key = utils::hash(fiat, utils::hash(crypto));
+    m_key = key == 0 ? 1 : key; // 0 marks no recent samples
+}
+
+bool PriceHistoryStore::load()
+{
+    m_daily.clear();
+    m_changed = false;
+
+    File file = SPIFFS.open(fileName(), FILE_READ);
+    if (!file)
+    {
+        log_d("No price history saved for this crypto/fiat");
+        return false;
+    }
+
+    FileHeader header{};
+    bool valid = file.read((uint8_t*)&header, sizeof(header)) == sizeof(header) && header.version == FileVersion &&
+                 header.key == m_key && header.count <= (uint32_t)constants::PriceStoreMaxDays;
+    if (valid)
+    {
+        m_daily.resize(header.count);
+        size_t bytes = header.count * sizeof(PriceSample);
+        valid = file.read((uint8_t*)m_daily.data(), bytes) == bytes;
+    }
+    file.close();
+
+    if (!valid)
+    {
+        log_w("Saved price history is not valid, ignoring it");
+        m_daily.clear();
+        return false;
+    }
+
+    log_d("Loaded %d daily prices", m_daily.size());
+    return !m_daily.empty();
+}
+
+bool PriceHistoryStore::save()
+{
+    if (!m_changed)
+        return true;
+
+    File file = SPIFFS.open(fileName(), FILE_WRITE);
+    FileHeader header = {FileVersion, m_key, (uint32_t)m_daily.size()};
+    size_t bytes = m_daily.size() * sizeof(PriceSample);
+    bool success = file && file.write((const uint8_t*)&header, sizeof(header)) == sizeof(header) &&
+                   file.write((const uint8_t*)m_daily.data(), bytes) == bytes;
+    file.close();
+
+    if (!success)
+    {
+        log_w("Failed to save price history to SPIFFS");
+        return false;
+    }
+
+    log_d("Saved %d daily prices", m_daily.size());
+    m_changed = false;
+    return true;
+}
+
+bool PriceHistoryStore::priceAt(uint32_t unixTime, uint32_t maxErrorSeconds, Price& price_out, uint32_t* sampleUnix_out) const
+{
+    const PriceSample* closest = nullptr;
+
+    auto it = std::lower_bound(m_daily.begin(), m_daily.end(), unixTime,
+                               [](const PriceSample& sample, uint32_t unix) { return sample.unix < unix; });
+    if (it != m_daily.end())
+        closest = &*it;
+    if (it != m_daily.begin() && (closest == nullptr || distance(std::prev(it)->unix, unixTime) < distance(closest->unix, unixTime)))
+        closest = &*std::prev(it);
+
+    if (recentKey == m_key)
+    {
+        for (int i = 0; i < numRecentSamples; i++)
+        {
+            if (closest == nullptr || distance(recentSamples[i].unix, unixTime) < distance(closest->unix, unixTime))
+                closest = &recentSamples[i];
+        }
+    }
+
+    if (closest == nullptr || distance(closest->unix, unixTime) > maxErrorSeconds)
+        return false;
+
+    price_out = closest->price;
+    if (sampleUnix_out)
+        *sampleUnix_out = closest->unix;
+    return true;
+}
+
+void PriceHistoryStore::addHistorySample(uint32_t sampleUnix, const Price& price)
+{
+    if (!price.isPositive())
+        return;
+
+    // samples are in time order in some responses but reversed in others, so find where this one goes
+    auto it = std::lower_bound(m_daily.begin(), m_daily.end(), sampleUnix,
+                               [](const PriceSample& sample, uint32_t unix) { return sample.unix < unix; });
+    if (it != m_daily.end() && dayOf(it->unix) == dayOf(sampleUnix))
+    {
+        // only the earliest sample of the day, which is as close to its start as the response has
+        if (sampleUnix < it->unix)
+        {
+            *it = {sampleUnix, price};
+            m_changed = true;
+        }
+        return;
+    }
+    if (it != m_daily.begin() && dayOf(std::prev(it)->unix) == dayOf(sampleUnix))
+        return;
+
+    m_daily.insert(it, {sampleUnix, price});
+    m_changed = true;
+
+    // drop the days too old to keep
+    uint32_t oldestDay = dayOf(m_daily.back().unix) - (constants::PriceStoreMaxDays - 1);
+    auto keep = std::find_if(m_daily.begin(), m_daily.end(),
+                             [oldestDay](const PriceSample& sample) { return dayOf(sample.unix) >= oldestDay; });
+    m_daily.erase(m_daily.begin(), keep);
+}
+
+void PriceHistoryStore::addCurrentPrice(uint32_t unixTime, const Price& price)
+{
+    if (!price.isPositive())
+        return;
+
+    if (recentKey != m_key)
+    {
+        recentKey = m_key;
+        numRecentSamples = 0;
+    }
+
+    // the newest price is always kept, but the one before it only if it is far enough from the one before
+    // that, so waking more often than the spacing doesn't shorten the time covered
+    if (numRecentSamples >= 2 &&
+        recentSamples[numRecentSamples - 1].unix - recentSamples[numRecentSamples - 2].unix <
+            (uint32_t)constants::PriceStoreRecentSpacingSeconds)
+        numRecentSamples--;
+
+    if (numRecentSamples == constants::PriceStoreRecentSamples)
+    {
+        memmove(recentSamples, recentSamples + 1, (numRecentSamples - 1) * sizeof(PriceSample));
+        numRecentSamples--;
+    }
+    recentSamples[numRecentSamples++] = {unixTime, price};
+}
+
+uint32_t PriceHistoryStore::fillFrom(uint32_t currentUnix, uint32_t unixTime) const
+{
+    uint32_t oldestDay = dayOf(currentUnix) - (constants::PriceStoreMaxDays - 1);
+    if (dayOf(unixTime) < oldestDay)
+        return 0;
+
+    // nothing yet, or older than anything kept, so get everything
+    if (m_daily.empty() || dayOf(unixTime) < dayOf(m_daily.front().unix))
+        return oldestDay * constants::SecondsOneDay;
+
+    // newer than anything kept, so get the days since the newest sample
+    if (dayOf(unixTime) > dayOf(m_daily.back().unix))
+        return m_daily.back().unix;
+
+    // a day missing in between is one the sources didn't have, getting it again wouldn't help
+    return 0;
+}
+
+int PriceHistoryStore::numDailySamples() const
+{
+    return m_daily.size();
+}
+
+void PriceHistoryStore::clear()
+{
+    File root = SPIFFS.open("/");
+    std::vector<String> names;
+    for (File file = root.openNextFile(); file; file = root.openNextFile())
+    {
+        String name = file.name();
+        if (!name.startsWith("/"))
+            name = "/" + name; // depends on the core version
+        if (name.startsWith(FilePrefix))
+            names.push_back(name);
+    }
+    root.close();
+
+    for (const auto& name : names)
+        SPIFFS.remove(name);
+    recentKey = 0;
+    numRecentSamples = 0;
+}
+
+String PriceHistoryStore::fileName() const
+{
+    char name[20];
+    snprintf(name, sizeof(name), "%s%08x.bin", FilePrefix, m_key);
+    return String(name);
+}
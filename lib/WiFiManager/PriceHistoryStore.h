@@ -0,0 +1,58 @@
+#ifndef PRICEHISTORYSTORE_H
+#define PRICEHISTORYSTORE_H
+
+#include "Price.h"
+
+#include <Arduino.h>
+#include <vector>
+
+// keeps the price history of a crypto/fiat on the device so historical prices don't need to be downloaded
+// on every wake
+// one sample per day for the last PriceStoreMaxDays days is kept in SPIFFS, filled from a price history
+// response once and then topped up with the days since the newest sample
+// the current prices fetched on earlier wakes are kept in RTC memory for offsets too short for daily samples
+
+// packed to 13 bytes, there are PriceStoreRecentSamples of them in RTC memory
+struct __attribute__((packed)) PriceSample
+{
+    uint32_t unix; // seconds
+    Price price;
+};
+
+class PriceHistoryStore
+{
+public:
+    PriceHistoryStore(const String& crypto, const String& fiat);
+
+    // reads the daily samples from SPIFFS, returns false if none have been saved yet
+    bool load();
+    // writes the daily samples to SPIFFS if any were added since they were loaded
+    bool save();
+
+    // price of the sample closest to unixTime, returns false if there isn't one within maxErrorSeconds
+    // sampleUnix_out is given the time of the sample if set
+    bool priceAt(uint32_t unixTime, uint32_t maxErrorSeconds, Price& price_out, uint32_t* sampleUnix_out = nullptr) const;
+
+    // adds a sample from a price history response, only the earliest sample of each day is kept
+    void addHistorySample(uint32_t sampleUnix, const Price& price);
+    // adds a current price fetched by the device
+    void addCurrentPrice(uint32_t unixTime, const Price& price);
+
+    // unix time a price history request should start from to fill the store so it has unixTime
+    // 0 if the store already has the day unixTime is in or it is too old to be kept
+    uint32_t fillFrom(uint32_t currentUnix, uint32_t unixTime) const;
+
+    int numDailySamples() const;
+
+    // removes the saved samples of every crypto/fiat
+    static void clear();
+
+private:
+    String fileName() const;
+
+    uint32_t m_key;
+    std::vector<PriceSample> m_daily; // oldest first, at most one per day
+    bool m_changed = false;
+};
+
+#endif
@@ -0,0 +1,128 @@
+#include "RequestBase.h"
+#include "Constants.h"
+#include "StringReadStream.h"
+
+namespace
+{
+    String serverOverride;
+}
+
+String RequestBase::getServer()
+{
+    return serverOverride.isEmpty() ? defaultServer() : serverOverride;
+}
+
+void RequestBase::setServerOverride(const String& server)
+{
+    serverOverride = server;
+}
+
+bool RequestBase::currentPrice(const String& content, const String& crypto, const String& fiat, Price& price_out)
+{
+    StringReadStream stream(content);
+    return currentPrice(stream, crypto, fiat, price_out);
+}
+
+bool RequestBase::priceAtTime(const String& content, Price& priceAtTime_out)
+{
+    StringReadStream stream(content);
+    return priceAtTime(stream, priceAtTime_out);
+}
+
+bool RequestBase::pricesAtTimes(Stream& content, uint32_t currentUnix, TimeframeSet timeframes, Quotes& quotes_out)
+{
+    // closest sample seen so far for each timeframe, as its distance from the wanted time, and its time and price
+    struct Closest
+    {
+        uint32_t distance;
+        uint32_t sampleUnix;
+        Price price;
+    };
+    std::array<Closest, NumTimeframes> closest;
+    TimeframeSet found;
+    int numSamples = 0;
+
+    bool success = priceHistory(content, [&](uint32_t sampleUnix, const Price& price)
+    {
+        numSamples++;
+        if (!price.isPositive())
+            return;
+
+        for (Timeframe timeframe : timeframes)
+        {
+            uint32_t wantedUnix = currentUnix - timeframeSeconds(timeframe);
+            uint32_t distance = sampleUnix > wantedUnix ? sampleUnix - wantedUnix : wantedUnix - sampleUnix;
+
+            Closest& current = closest[static_cast<size_t>(timeframe)];
+            if (!found.has(timeframe) || distance < current.distance)
+            {
+                current = {distance, sampleUnix, price};
+                found.insert(timeframe);
+            }
+        }
+    });
+
+    log_d("Read %d history samples", numSamples);
+    if (!success || numSamples == 0)
+        return false;
+
+    for (Timeframe timeframe : found)
+    {
+        long offset = timeframeSeconds(timeframe);
+        const Closest& current = closest[static_cast<size_t>(timeframe)];
+        uint32_t maxError = offset / constants::PriceHistoryMaxSampleErrorDivisor;
+        if (current.distance <= maxError)
+        {
+            quotes_out.set(timeframe, current.price, current.sampleUnix, getSourceId());
+            log_d("Offset %d has price %f from a sample %d seconds away", offset, current.price.toDouble(),
+                  current.distance);
+        }
+        else
+            log_d("Offset %d closest sample is %d seconds away, not using it", offset, current.distance);
+    }
+
+    return true;
+}
+
+TimeframeSet RequestBase::possibleTimeframes(const String& crypto, const String& fiat, uint32_t currentUnix,
+                                             TimeframeSet timeframes)
+{
+    const CryptoSymbol* entry = SymbolCatalog::find(crypto.c_str());
+    if (entry == nullptr)
+        return TimeframeSet();
+
+    SourceCapabilities caps = capabilities();
+    if (caps.listedFiats != nullptr && (entry->*caps.listedFiats & fiatBit(fiat.c_str())) == 0)
+        return TimeframeSet();
+
+    // a price too old for single requests can still come from a history request, and the other way round
+    auto reaches = [](uint32_t depth, long offset) { return depth == 0 || (uint32_t)offset <= depth; };
+    TimeframeSet possible;
+    for (Timeframe timeframe : timeframes)
+    {
+        long offset = timeframeSeconds(timeframe);
+        if (offset != 0 && currentUnix - offset < entry->historyFromUnix)
+            continue; // from before the crypto was listed
+        if (reaches(caps.minuteHistorySeconds, offset) || (caps.priceHistory && reaches(caps.dailyHistorySeconds, offset)))
+            possible.insert(timeframe);
+    }
+    return possible;
+}
+
+bool RequestBase::canRequestHistory(uint32_t maxOffset)
+{
+    uint32_t limit = maxHistoryOffset();
+    return capabilities().priceHistory && (limit == 0 || maxOffset <= limit);
+}
+
+uint32_t RequestBase::maxHistoryOffset()
+{
+    // the window starts a day before the offset so the sample of the day it is in is included
+    SourceCapabilities caps = capabilities();
+    uint32_t window = caps.maxHistoryWindowSeconds;
+    if (caps.dailyHistorySeconds != 0 && (window == 0 || caps.dailyHistorySeconds < window))
+        window = caps.dailyHistorySeconds;
+    if (window == 0)
+        return 0;
+    return window > constants::SecondsOneDay ? window - constants::SecondsOneDay : 1;
+}
@@ -1,8 +1,35 @@
 #ifndef REQUESTBASE_H
 #define REQUESTBASE_H
 
+#include "Price.h"
+#include "Quotes.h"
+#include "SymbolCatalog.h"
+
 #include <Arduino.h>
+#include <functional>
 #include <memory>
+#include <map>
+#include <vector>
+
+// called for each sample in a price history response, unix time in seconds
+using PriceSampleCallback = std::function<void(uint32_t sampleUnix, const Price& price)>;
+
+// what a data source can give, declared for each one so a request that can't succeed is never sent
+struct SourceCapabilities
+{
+    // the catalog's fiats for the pairs the source lists, nullptr if it has every crypto in the catalog in any fiat
+    uint8_t CryptoSymbol::*listedFiats = nullptr;
+    // how far back prices go for a single price request, which asks for a 1 minute sample, and for a history
+    // request, which asks for daily ones, 0 if as far back as the crypto has been listed
+    uint32_t minuteHistorySeconds = 0;
+    uint32_t dailyHistorySeconds = 0;
+    // whether urlCurrentPrices can give the prices of several cryptos in one request
+    bool batchCurrentPrices = true;
+    // whether urlPriceHistory can give the prices of several timeframes in one request
+    bool priceHistory = true;
+    // longest range of daily samples a history request can cover, 0 if there is no limit
+    uint32_t maxHistoryWindowSeconds = 0;
+};
 
 class RequestBase
 {
@@ -12,25 +39,64 @@ public:
     // has functions for:
     //   - generating a url for a given request type
     //   - taking content received from this url and returning data of interest
+    //   - getting the prices at several times from one history request
 
     virtual ~RequestBase() = default;
 
-    virtual String getServer() = 0;
+    // the server every request is sent to, the data source's own unless overridden
+    String getServer();
+    virtual SourceId getSourceId() = 0;
+
+    // sends the requests of every data source to server instead, e.g. a local mock exchange for testing, empty to
+    // go back to the real ones
+    // the urls are unchanged so the server can still tell which data source a request is for
+    static void setServerOverride(const String& server);
 
     // url functions
     virtual String urlCurrentPrice(const String& crypto, const String& fiat) = 0;
     virtual String urlPriceAtTime(uint32_t currentUnix, uint32_t unixOffset, const String& crypto, const String& fiat) = 0;
 
     // data functions
-    virtual bool currentPrice(const String& content, const String& crypto, const String& fiat, float& price_out) = 0;
-    virtual bool priceAtTime(const String& content, float& priceAtTime_out) = 0;
-
-    // some sources will have restrictions on which cryptos/fiats are available
-    // crypto restrictions will be complex, probably just allow these requests to fail. Before making a crypto available,
-    // will just make sure it is available form at least 1 data source
-    virtual bool isValidRequest(const String& crypto, const String& fiat) = 0;
+    // content is read straight from the connection, only the fields needed are ever stored
+    virtual bool currentPrice(Stream& content, const String& crypto, const String& fiat, Price& price_out) = 0;
+    virtual bool priceAtTime(Stream& content, Price& priceAtTime_out) = 0;
+
+    // as above for content that is already in memory
+    bool currentPrice(const String& content, const String& crypto, const String& fiat, Price& price_out);
+    bool priceAtTime(const String& content, Price& priceAtTime_out);
+
+    // watchlist functions - a single request for the current price of several cryptos
+    // prices_out gets the price of each of the cryptos found in content, returns false if none were
+    virtual String urlCurrentPrices(const std::vector<String>& cryptos, const String& fiat) = 0;
+    virtual bool currentPrices(Stream& content, const std::vector<String>& cryptos, const String& fiat,
+                               std::map<String, Price>& prices_out) = 0;
+
+    // history functions - a single request for every sample from maxOffset ago until now
+    // the response can be tens of KB so it is read from a Stream one sample at a time
+    virtual String urlPriceHistory(uint32_t currentUnix, uint32_t maxOffset, const String& crypto, const String& fiat) = 0;
+    virtual bool priceHistory(Stream& content, const PriceSampleCallback& onSample) = 0;
+
+    // reads a priceHistory response and picks out the sample closest to each of the timeframes
+    // timeframes with no sample close enough to their time are left as they were in quotes_out
+    // returns false if the content had no samples at all
+    bool pricesAtTimes(Stream& content, uint32_t currentUnix, TimeframeSet timeframes, Quotes& quotes_out);
+
+    // what this data source can give, see SourceCapabilities
+    virtual SourceCapabilities capabilities() = 0;
+
+    // the timeframes of crypto/fiat this source can possibly give at currentUnix, worked out from its capabilities
+    // and the symbol catalog without sending anything, empty if it doesn't have the pair at all
+    TimeframeSet possibleTimeframes(const String& crypto, const String& fiat, uint32_t currentUnix,
+                                    TimeframeSet timeframes);
+    // whether one history request can cover every daily sample from a day before maxOffset ago until now
+    bool canRequestHistory(uint32_t maxOffset);
+    // the longest maxOffset canRequestHistory allows, 0 if there is no limit
+    uint32_t maxHistoryOffset();
 
     // **Note** unix time between all functions should be consistent as SECONDS
+
+protected:
+    virtual String defaultServer() = 0;
 };
 
 using RequestBasePtr = std::unique_ptr<RequestBase>;
@@ -39,45 +105,81 @@ class RequestBinance : public RequestBase
 {
 public:
     // defines functions as needed for the Binance API
-    String getServer() override;
+    SourceId getSourceId() override;
 
     String urlCurrentPrice(const String& crypto, const String& fiat) override;
     String urlPriceAtTime(uint32_t currentUnix, uint32_t unixOffset, const String& crypto, const String& fiat) override;
 
-    bool currentPrice(const String& content, const String& crypto, const String& fiat, float& price_out) override;
-    bool priceAtTime(const String& content, float& priceAtTime_out) override;
+    using RequestBase::currentPrice;
+    using RequestBase::priceAtTime;
+    bool currentPrice(Stream& content, const String& crypto, const String& fiat, Price& price_out) override;
+    bool priceAtTime(Stream& content, Price& priceAtTime_out) override;
+
+    String urlCurrentPrices(const std::vector<String>& cryptos, const String& fiat) override;
+    bool currentPrices(Stream& content, const std::vector<String>& cryptos, const String& fiat,
+                       std::map<String, Price>& prices_out) override;
 
-    bool isValidRequest(const String& crypto, const String& fiat) override;
+    String urlPriceHistory(uint32_t currentUnix, uint32_t maxOffset, const String& crypto, const String& fiat) override;
+    bool priceHistory(Stream& content, const PriceSampleCallback& onSample) override;
+
+    SourceCapabilities capabilities() override;
+
+protected:
+    String defaultServer() override;
 };
 
 class RequestCoinGecko : public RequestBase
 {
 public:
     // defines functions as needed for the CoinGecko API
-    String getServer() override;
+    SourceId getSourceId() override;
 
     String urlCurrentPrice(const String& crypto, const String& fiat) override;
     String urlPriceAtTime(uint32_t currentUnix, uint32_t unixOffset, const String& crypto, const String& fiat) override;
 
-    bool currentPrice(const String& content, const String& crypto, const String& fiat, float& price_out) override;
-    bool priceAtTime(const String& content, float& priceAtTime_out) override;
+    using RequestBase::currentPrice;
+    using RequestBase::priceAtTime;
+    bool currentPrice(Stream& content, const String& crypto, const String& fiat, Price& price_out) override;
+    bool priceAtTime(Stream& content, Price& priceAtTime_out) override;
+
+    String urlCurrentPrices(const std::vector<String>& cryptos, const String& fiat) override;
+    bool currentPrices(Stream& content, const std::vector<String>& cryptos, const String& fiat,
+                       std::map<String, Price>& prices_out) override;
+
+    String urlPriceHistory(uint32_t currentUnix, uint32_t maxOffset, const String& crypto, const String& fiat) override;
+    bool priceHistory(Stream& content, const PriceSampleCallback& onSample) override;
 
-    bool isValidRequest(const String& crypto, const String& fiat) override;
+    SourceCapabilities capabilities() override;
+
+protected:
+    String defaultServer() override;
 };
 
 class RequestKuCoin : public RequestBase
 {
 public:
     // defines functions as needed for the KuCoin API
-    String getServer() override;
+    SourceId getSourceId() override;
 
     String urlCurrentPrice(const String& crypto, const String& fiat) override;
     String urlPriceAtTime(uint32_t currentUnix, uint32_t unixOffset, const String& crypto, const String& fiat) override;
 
-    bool currentPrice(const String& content, const String& crypto, const String& fiat, float& price_out) override;
-    bool priceAtTime(const String& content, float& priceAtTime_out) override;
+    using RequestBase::currentPrice;
+    using RequestBase::priceAtTime;
+    bool currentPrice(Stream& content, const String& crypto, const String& fiat, Price& price_out) override;
+    bool priceAtTime(Stream& content, Price& priceAtTime_out) override;
+
+    String urlCurrentPrices(const std::vector<String>& cryptos, const String& fiat) override;
+    bool currentPrices(Stream& content, const std::vector<String>& cryptos, const String& fiat,
+                       std::map<String, Price>& prices_out) override;
+
+    String urlPriceHistory(uint32_t currentUnix, uint32_t maxOffset, const String& crypto, const String& fiat) override;
+    bool priceHistory(Stream& content, const PriceSampleCallback& onSample) override;
+
+    SourceCapabilities capabilities() override;
 
-    bool isValidRequest(const String& crypto, const String& fiat) override;
+protected:
+    String defaultServer() override;
 };
 
 #endif
@@ -2,19 +2,29 @@
 #define REQUESTBINANCE_H
 
 #include "RequestBase.h"
+#include "Constants.h"
+#include "JsonPrice.h"
 
 #include <ArduinoJson.h>
 
-String RequestBinance::getServer()
+String RequestBinance::defaultServer()
 {
     return "api.binance.com";
 }
 
-bool RequestBinance::isValidRequest(const String& crypto, const String& fiat)
+SourceId RequestBinance::getSourceId()
 {
-    // binance cannot do GBP
-    if (fiat == "GBP") return false;
-    return true;
+    return SourceId::BINANCE;
+}
+
+SourceCapabilities RequestBinance::capabilities()
+{
+    // only pairs the catalog has listed on binance, it no longer has any GBP pairs
+    // klines go back to when the pair was listed, at most 1000 of them in a request
+    SourceCapabilities caps;
+    caps.listedFiats = &CryptoSymbol::binanceFiats;
+    caps.maxHistoryWindowSeconds = 1000 * constants::SecondsOneDay;
+    return caps;
 }
 
 String RequestBinance::urlCurrentPrice(const String& crypto, const String& fiat)
@@ -55,55 +65,169 @@ String RequestBinance::urlPriceAtTime(uint32_t currentUnix, uint32_t unixOffset,
     return rtn;
 }
 
-bool RequestBinance::currentPrice(const String& content, const String& crypto, const String& fiat, float& price_out)
+bool RequestBinance::currentPrice(Stream& content, const String& crypto, const String& fiat, Price& price_out)
 {
-    log_d("content = %s", content.c_str());
-    DynamicJsonDocument doc(96); // https://arduinojson.org/v6/assistant/#/step1
-    deserializeJson(doc, content);
+    // {"symbol":"BTCGBP","price":"29396.32000000"}
+    StaticJsonDocument<96> doc; // https://arduinojson.org/v6/assistant/#/step1
+    DeserializationError error = deserializeJson(doc, content);
+    if (error)
+    {
+        log_w("Could not parse content, error=%s", error.c_str());
+        return false;
+    }
 
     if (doc.containsKey("symbol") && doc.containsKey("price"))
     {
         String symbol = doc["symbol"];
-        String price = doc["price"];
-        price_out = price.toFloat();
-        log_d("symbol: %s has price: %f", symbol.c_str(), price_out);
+        if (!jsonPrice(doc["price"], price_out))
+            return false;
+        log_d("symbol: %s has price: %f", symbol.c_str(), price_out.toDouble());
         return true;
     }
 
     return false;
 }
 
-bool RequestBinance::priceAtTime(const String& content, float& priceAtTime_out)
+bool RequestBinance::priceAtTime(Stream& content, Price& priceAtTime_out)
 {
-    log_d("content = %s", content.c_str());
-
-    if (content == "" || content.charAt(0) != '[') // errors will have some json starting with {, data is only an array
-    {
-        log_w("Bad content, returning");
-        return false;
-    }
-
     // for binance we will use the open price of this kline
     // content e.g:
     // [[1697382420000,"22138.72000000","22138.72000000","22138.72000000","22138.72000000","0.00000000",1697382479999,"0.00000000",0,"0.00000000","0.00000000","0"]]
     // we want this     ^^^^^^^^^^^^^^
 
     StaticJsonDocument<384> doc;
-    deserializeJson(doc, content);
+    DeserializationError error = deserializeJson(doc, content);
+    if (error || !doc.is<JsonArray>()) // errors will have some json starting with {, data is only an array
+    {
+        log_w("Bad content, returning");
+        return false;
+    }
 
     JsonArray dataArray = doc.as<JsonArray>();
 
-    priceAtTime_out = 0;
+    priceAtTime_out = Price();
     if (dataArray.size() && dataArray[0].size() == 12)
     {
-        priceAtTime_out = dataArray[0][1].as<float>();
+        jsonPrice(dataArray[0][1], priceAtTime_out);
     }
-    log_d("priceAtTime_out = %f", priceAtTime_out);
+    log_d("priceAtTime_out = %f", priceAtTime_out.toDouble());
 
-    if (priceAtTime_out > 0)
+    if (priceAtTime_out.isPositive())
         return true;
 
     return false;
 }
 
+String RequestBinance::urlCurrentPrices(const std::vector<String>& cryptos, const String& fiat)
+{
+    // https://api.binance.com/api/v3/ticker/price?symbols=["BTCUSDT","ETHUSDT"] with the [" and "] url encoded
+    String rtn;
+    rtn.reserve(64 + 16 * cryptos.size());
+
+    rtn += "https://api.binance.com/api/v3/ticker/price?symbols=%5B";
+    for (size_t i = 0; i < cryptos.size(); i++)
+    {
+        if (i > 0)
+            rtn += ",";
+        rtn += "%22";
+        rtn += cryptos[i];
+        rtn += (fiat == "USD") ? "USDT" : fiat; // Binance prices USD with only USDT
+        rtn += "%22";
+    }
+    rtn += "%5D";
+
+    return rtn;
+}
+
+bool RequestBinance::currentPrices(Stream& content, const std::vector<String>& cryptos, const String& fiat,
+                                   std::map<String, Price>& prices_out)
+{
+    // same as currentPrice for each symbol, in an array
+    // [{"symbol":"BTCUSDT","price":"37500.30000000"},{"symbol":"ETHUSDT","price":"2050.10000000"}]
+    // errors are a single object, e.g. if one of the symbols isn't on binance, so won't have the [
+
+    if (!content.find("["))
+    {
+        log_w("No prices in content, returning");
+        return false;
+    }
+
+    String quote = (fiat == "USD") ? "USDT" : fiat;
+    int found = 0;
+    StaticJsonDocument<96> doc; // one symbol at a time
+    do
+    {
+        if (deserializeJson(doc, content))
+            break;
+
+        String symbol = doc["symbol"];
+        for (const auto& crypto : cryptos)
+        {
+            if (symbol == crypto + quote)
+            {
+                Price price;
+                if (jsonPrice(doc["price"], price))
+                {
+                    prices_out[crypto] = price;
+                    log_d("symbol: %s has price: %f", symbol.c_str(), price.toDouble());
+                    found++;
+                }
+                break;
+            }
+        }
+    }
+    while (content.findUntil(",", "]"));
+
+    return found > 0;
+}
+
+String RequestBinance::urlPriceHistory(uint32_t currentUnix, uint32_t maxOffset, const String& crypto, const String& fiat)
+{
+    // daily klines from a day before the largest offset up until now, at most 1000 per request
+    // https://api.binance.com/api/v3/klines?symbol=BTCUSDT&interval=1d&startTime=1669398897000&endTime=1701021297000&limit=1000
+    uint32_t startTime = currentUnix - maxOffset - constants::SecondsOneDay;
+    String rtn;
+    rtn.reserve(128);
+
+    rtn += "https://api.binance.com/api/v3/klines?symbol=";
+    rtn += crypto;
+    rtn += (fiat == "USD") ? "USDT" : fiat; // Binance prices USD with only USDT
+    rtn += "&interval=1d&startTime=";
+    rtn += startTime;
+    rtn += "000&endTime=";
+    rtn += currentUnix;
+    rtn += "000&limit=1000";
+
+    return rtn;
+}
+
+bool RequestBinance::priceHistory(Stream& content, const PriceSampleCallback& onSample)
+{
+    // content is an array of klines in the same format as priceAtTime, use the open time and open price of each
+    // [[1697328000000,"22138.72000000",...],[1697414400000,"22210.01000000",...]]
+    //   ^^^^^^^^^^^^^  ^^^^^^^^^^^^^^
+    // errors will be some json starting with {
+
+    if (!content.find("["))
+    {
+        log_w("Bad content, returning");
+        return false;
+    }
+
+    StaticJsonDocument<512> doc; // one kline at a time
+    do
+    {
+        if (deserializeJson(doc, content))
+            break;
+
+        JsonArray kline = doc.as<JsonArray>();
+        Price price;
+        if (kline.size() == 12 && jsonPrice(kline[1], price))
+            onSample(kline[0].as<uint64_t>() / 1000, price);
+    }
+    while (content.findUntil(",", "]"));
+
+    return true;
+}
+
 #endif
@@ -3,81 +3,37 @@
 
 #include "RequestBase.h"
 #include "Constants.h"
+#include "JsonPrice.h"
+#include "SymbolCatalog.h"
 
 #include <ArduinoJson.h>
-#include <map>
 
 namespace
 {
-    // map of crypto symbol to coingecko id, e.g. BTC -> bitcoin
-    // the coingecko api cannot be called with symbol, they annoyingly have their own ids
-    std::map<String, String> coinGeckoSymbolToId = {{"BTC", "bitcoin"},
-                                                    {"ETH", "ethereum"},
-                                                    {"BNB", "binancecoin"},
-                                                    {"SOL", "solana"},
-                                                    {"XRP", "ripple"},
-                                                    {"ADA", "cardano"},
-                                                    {"AVAX", "avalanche-2"},
-                                                    {"DOGE", "dogecoin"},
-                                                    {"TRX", "tron"},
-                                                    {"DOT", "polkadot"},
-                                                    {"MATIC", "matic-network"},
-                                                    {"LINK", "chainlink"},
-                                                    {"TON", "the-open-network"},
-                                                    {"ICP", "internet-computer"},
-                                                    {"SHIB", "shiba-inu"},
-                                                    {"DAI", "dai"},
-                                                    {"LTC", "litecoin"},
-                                                    {"BCH", "bitcoin-cash"},
-                                                    {"ETC", "ethereum-classic"},
-                                                    {"ATOM", "cosmos"},
-                                                    {"UNI", "uniswap"},
-                                                    {"LEO", "leo-token"},
-                                                    {"OP", "optimism"},
-                                                    {"NEAR", "near"},
-                                                    {"APT", "aptos"},
-                                                    {"XLM", "stellar"},
-                                                    {"OKB", "okb"},
-                                                    {"INJ", "injective-protocol"},
-                                                    {"FIL", "filecoin"},
-                                                    {"LDO", "lido-dao"},
-                                                    {"IMX", "immutable-xeckoid"},
-                                                    {"XMR", "monero"},
-                                                    {"TIA", "celestia"},
-                                                    {"ARB", "arbitrum"},
-                                                    {"HBAR", "hedera-hashgraph"},
-                                                    {"KAS", "kaspa"},
-                                                    {"STX", "blockstack"},
-                                                    {"MNT", "mantle"},
-                                                    {"VET", "vechain"},
-                                                    {"CRO", "crypto-com-chain"},
-                                                    {"MKR", "maker"},
-                                                    {"BSV", "bitcoin-cash-sv"},
-                                                    {"SEI", "sei-network"},
-                                                    {"GRT", "the-graph"},
-                                                    {"RUNE", "thorchain"},
-                                                    {"AAVE", "aave"},
-                                                    {"ALGO", "algorand"},
-                                                    {"ORDI", "ordinals"},
-                                                    {"QNT", "quant-network"},
-                                                    {"RNDR", "render-token"},
-                                                    {"EGLD", "elrond-erd-2"},
-                                                    {"SUI", "sui"},
-                                                    {"MINA", "mina-protocol"}};
+    // coingecko id of a crypto symbol, e.g. BTC -> bitcoin, empty if it isn't in the catalog
+    const char* coinGeckoId(const String& crypto)
+    {
+        const CryptoSymbol* entry = SymbolCatalog::find(crypto.c_str());
+        return entry ? entry->coinGeckoId : "";
+    }
 }
 
-
-String RequestCoinGecko::getServer()
+String RequestCoinGecko::defaultServer()
 {
     return "api.coingecko.com";
 }
 
-bool RequestCoinGecko::isValidRequest(const String& crypto, const String& fiat)
+SourceId RequestCoinGecko::getSourceId()
 {
-    // no restrictions on coingecko
-    // really it can only do cryptos which have a mapped id in coinGeckoSymbolToId
-    // but shouldn't be possible to call one that isn't - html is using this same list
-    return true;
+    return SourceId::COINGECKO;
+}
+
+SourceCapabilities RequestCoinGecko::capabilities()
+{
+    // every crypto in the catalog in any fiat, the public API only serves the last 365 days of a range
+    SourceCapabilities caps;
+    caps.maxHistoryWindowSeconds = 365 * constants::SecondsOneDay;
+    return caps;
 }
 
 String RequestCoinGecko::urlCurrentPrice(const String& crypto, const String& fiat)
@@ -89,7 +45,7 @@ String RequestCoinGecko::urlCurrentPrice(const String& crypto, const String& fia
     rtn.reserve(96); // can vary a bit more due to id instead of symbol
 
     rtn += "https://api.coingecko.com/api/v3/simple/price?ids=";
-    rtn += coinGeckoSymbolToId[crypto];
+    rtn += coinGeckoId(crypto);
     rtn += "&vs_currencies=";
     rtn += fiat;
     rtn += "&precision=4";
@@ -130,7 +86,7 @@ String RequestCoinGecko::urlPriceAtTime(uint32_t currentUnix, uint32_t unixOffse
     rtn.reserve(128); // expect it is ~123 but allow a few extra in case of longer symbol
 
     rtn += "https://api.coingecko.com/api/v3/coins/";
-    rtn += coinGeckoSymbolToId[crypto];
+    rtn += coinGeckoId(crypto);
     rtn += "/market_chart/range?vs_currency=";
     rtn += fiat;
     rtn += "&from=";
@@ -142,61 +98,173 @@ String RequestCoinGecko::urlPriceAtTime(uint32_t currentUnix, uint32_t unixOffse
     return rtn;
 }
 
-bool RequestCoinGecko::currentPrice(const String& content, const String& crypto, const String& fiat, float& price_out)
+bool RequestCoinGecko::currentPrice(Stream& content, const String& crypto, const String& fiat, Price& price_out)
 {
-    log_d("content = %s", content.c_str());
-    DynamicJsonDocument doc(64); // https://arduinojson.org/v6/assistant/#/step1
-    deserializeJson(doc, content);
-
+    // {"bitcoin":{"gbp":33357.5612}}
     String accessString = fiat;
     accessString.toLowerCase(); // coingecko converts all fiat symbols to lower case
+    const char* id = coinGeckoId(crypto);
+
+    StaticJsonDocument<96> filter;
+    filter[id][accessString] = true;
 
-    if (doc.containsKey(coinGeckoSymbolToId[crypto]))
+    StaticJsonDocument<96> doc; // https://arduinojson.org/v6/assistant/#/step1
+    DeserializationError error = deserializeJson(doc, content, DeserializationOption::Filter(filter));
+    if (error)
     {
-        String price = doc[coinGeckoSymbolToId[crypto]][accessString];
-        price_out = price.toFloat();
-        log_d("symbol: %s has price: %f", coinGeckoSymbolToId[crypto].c_str(), price_out);
+        log_w("Could not parse content, error=%s", error.c_str());
+        return false;
+    }
+
+    if (doc.containsKey(id) && jsonPrice(doc[id][accessString], price_out))
+    {
+        log_d("symbol: %s has price: %f", id, price_out.toDouble());
         return true;
     }
 
     return false;
 }
 
-bool RequestCoinGecko::priceAtTime(const String& content, float& priceAtTime_out)
+bool RequestCoinGecko::priceAtTime(Stream& content, Price& priceAtTime_out)
 {
-    log_d("content = %s", content.c_str());
-
-    if (content == "")
-    {
-        log_w("No content, returning");
-        return false;
-    }
-
     // for coingecko we will use the first price returned in the json tag "prices"
     // content e.g. {"prices":[[1701021346883,29585.391271772718]],
     //                                        ^^^^^^^^^^^^^^^^^^
     //               "market_caps":[[1701021346883,578750969047.6592]],
     //               "total_volumes":[[1701021346883,8726978835.980974]]}
     // might end up with 2 data points due to granularity errors but this is fine
+    // market_caps and total_volumes are never needed so they are filtered out as they are read
+
+    StaticJsonDocument<16> filter;
+    filter["prices"] = true;
 
-    DynamicJsonDocument doc(384); // https://arduinojson.org/v6/assistant/#/step1
-    deserializeJson(doc, content);
+    DynamicJsonDocument doc(192); // https://arduinojson.org/v6/assistant/#/step1
+    DeserializationError error = deserializeJson(doc, content, DeserializationOption::Filter(filter));
+    if (error)
+    {
+        log_w("Could not parse content, error=%s", error.c_str());
+        return false;
+    }
 
-    priceAtTime_out = 0;
+    priceAtTime_out = Price();
     if (doc.containsKey("prices"))
     {
         JsonArray pricesContent = doc["prices"];
         if (pricesContent.size() && pricesContent[0].size() == 2)
         {
-            priceAtTime_out = pricesContent[0][1].as<float>();
+            jsonPrice(pricesContent[0][1], priceAtTime_out);
         }
-        log_d("priceAtTime_out = %f", priceAtTime_out);
+        log_d("priceAtTime_out = %f", priceAtTime_out.toDouble());
 
-        if (priceAtTime_out > 0)
+        if (priceAtTime_out.isPositive())
             return true;
     }
 
     return false;
 }
 
+String RequestCoinGecko::urlCurrentPrices(const std::vector<String>& cryptos, const String& fiat)
+{
+    // https://api.coingecko.com/api/v3/simple/price?ids=bitcoin,ethereum&vs_currencies=gbp&precision=4
+    String rtn;
+    rtn.reserve(80 + 20 * cryptos.size());
+
+    rtn += "https://api.coingecko.com/api/v3/simple/price?ids=";
+    for (size_t i = 0; i < cryptos.size(); i++)
+    {
+        if (i > 0)
+            rtn += ",";
+        rtn += coinGeckoId(cryptos[i]);
+    }
+    rtn += "&vs_currencies=";
+    rtn += fiat;
+    rtn += "&precision=4";
+
+    return rtn;
+}
+
+bool RequestCoinGecko::currentPrices(Stream& content, const std::vector<String>& cryptos, const String& fiat,
+                                     std::map<String, Price>& prices_out)
+{
+    // {"bitcoin":{"gbp":33357.5612},"ethereum":{"gbp":1650.1234}}
+    String accessString = fiat;
+    accessString.toLowerCase(); // coingecko converts all fiat symbols to lower case
+
+    DynamicJsonDocument filter(64 + 64 * cryptos.size());
+    for (const auto& crypto : cryptos)
+        filter[coinGeckoId(crypto)][accessString] = true;
+
+    DynamicJsonDocument doc(64 + 64 * cryptos.size()); // https://arduinojson.org/v6/assistant/#/step1
+    DeserializationError error = deserializeJson(doc, content, DeserializationOption::Filter(filter));
+    if (error)
+    {
+        log_w("Could not parse content, error=%s", error.c_str());
+        return false;
+    }
+
+    int found = 0;
+    for (const auto& crypto : cryptos)
+    {
+        Price price;
+        if (!jsonPrice(doc[coinGeckoId(crypto)][accessString], price))
+            continue;
+        prices_out[crypto] = price;
+        log_d("symbol: %s has price: %f", crypto.c_str(), price.toDouble());
+        found++;
+    }
+
+    return found > 0;
+}
+
+String RequestCoinGecko::urlPriceHistory(uint32_t currentUnix, uint32_t maxOffset, const String& crypto, const String& fiat)
+{
+    // same endpoint as urlPriceAtTime but a range from a day before the largest offset up until now
+    // the granularity depends on the range - hourly up to 90 days, daily above that
+    // https://api.coingecko.com/api/v3/coins/bitcoin/market_chart/range?vs_currency=gbp&from=1669398897&to=1701021297&precision=4
+    uint32_t startTime = currentUnix - maxOffset - constants::SecondsOneDay;
+
+    String rtn;
+    rtn.reserve(128);
+
+    rtn += "https://api.coingecko.com/api/v3/coins/";
+    rtn += coinGeckoId(crypto);
+    rtn += "/market_chart/range?vs_currency=";
+    rtn += fiat;
+    rtn += "&from=";
+    rtn += startTime;
+    rtn += "&to=";
+    rtn += currentUnix;
+    rtn += "&precision=4";
+
+    return rtn;
+}
+
+bool RequestCoinGecko::priceHistory(Stream& content, const PriceSampleCallback& onSample)
+{
+    // only the "prices" array is wanted, the rest of the content is never read
+    // {"prices":[[1669420800000,14210.1234],[1669507200000,14301.5678],...],"market_caps":[...],"total_volumes":[...]}
+    //             ^^^^^^^^^^^^^ ^^^^^^^^^^
+
+    if (!content.find("\"prices\":["))
+    {
+        log_w("No prices in content, returning");
+        return false;
+    }
+
+    StaticJsonDocument<64> doc; // one [time, price] pair at a time
+    do
+    {
+        if (deserializeJson(doc, content))
+            break;
+
+        JsonArray sample = doc.as<JsonArray>();
+        Price price;
+        if (sample.size() == 2 && jsonPrice(sample[1], price))
+            onSample(sample[0].as<uint64_t>() / 1000, price);
+    }
+    while (content.findUntil(",", "]"));
+
+    return true;
+}
+
 #endif
@@ -2,19 +2,29 @@
 #define REQUESTKUCOIN_H
 
 #include "RequestBase.h"
+#include "Constants.h"
+#include "JsonPrice.h"
 
 #include <ArduinoJson.h>
 
-String RequestKuCoin::getServer()
+String RequestKuCoin::defaultServer()
 {
     return "api.kucoin.com";
 }
 
-bool RequestKuCoin::isValidRequest(const String& crypto, const String& fiat)
+SourceId RequestKuCoin::getSourceId()
 {
-    // kucoin can only do USD
-    if (fiat != "USD") return false;
-    return true;
+    return SourceId::KUCOIN;
+}
+
+SourceCapabilities RequestKuCoin::capabilities()
+{
+    // only pairs the catalog has listed on kucoin, which are all USD(T), its GBP/EUR candles only start in March 2023
+    // candles go back to when the pair was listed, at most 1500 of them in a request
+    SourceCapabilities caps;
+    caps.listedFiats = &CryptoSymbol::kuCoinFiats;
+    caps.maxHistoryWindowSeconds = 1500 * constants::SecondsOneDay;
+    return caps;
 }
 
 String RequestKuCoin::urlCurrentPrice(const String& crypto, const String& fiat)
@@ -54,20 +64,26 @@ String RequestKuCoin::urlPriceAtTime(uint32_t currentUnix, uint32_t unixOffset,
     return rtn;
 }
 
-bool RequestKuCoin::currentPrice(const String& content, const String& crypto, const String& fiat, float& price_out)
+bool RequestKuCoin::currentPrice(Stream& content, const String& crypto, const String& fiat, Price& price_out)
 {
     // {"code":"200000","data":{"BTC":"33388.8675121283881416"}}
-    log_d("content = %s", content.c_str());
-    DynamicJsonDocument doc(128); // https://arduinojson.org/v6/assistant/#/step1
-    deserializeJson(doc, content);
+    // only keep the price of the crypto asked for
+    StaticJsonDocument<64> filter;
+    filter["data"][crypto] = true;
+
+    StaticJsonDocument<128> doc; // https://arduinojson.org/v6/assistant/#/step1
+    DeserializationError error = deserializeJson(doc, content, DeserializationOption::Filter(filter));
+    if (error)
+    {
+        log_w("Could not parse content, error=%s", error.c_str());
+        return false;
+    }
 
     if (doc.containsKey("data"))
     {
-        String price = doc["data"][crypto];
-        if (!price.isEmpty())
+        if (jsonPrice(doc["data"][crypto], price_out))
         {
-            price_out = price.toFloat();
-            log_d("crypto: %s has price: %f", crypto.c_str(), price_out);
+            log_d("crypto: %s has price: %f", crypto.c_str(), price_out.toDouble());
             return true;
         }
     }
@@ -75,37 +91,133 @@ bool RequestKuCoin::currentPrice(const String& content, const String& crypto, co
     return false;
 }
 
-bool RequestKuCoin::priceAtTime(const String& content, float& priceAtTime_out)
+bool RequestKuCoin::priceAtTime(Stream& content, Price& priceAtTime_out)
 {
-    log_d("content = %s", content.c_str());
-
-    if (content == "")
-    {
-        log_w("No content, returning");
-        return false;
-    }
-
     // for kucoin we will use the second element in the json tag "data"
     // content e.g. {"code":"200000","data":[["1702653780","32372.62","32372.62","32372.62","32372.62","0","0"]]}
     //                                                      ^^^^^^^^
     // might end up with 2 data points due to granularity errors but this is fine
 
+    StaticJsonDocument<16> filter;
+    filter["data"] = true;
+
     DynamicJsonDocument doc(256); // https://arduinojson.org/v6/assistant/#/step1
-    deserializeJson(doc, content);
+    DeserializationError error = deserializeJson(doc, content, DeserializationOption::Filter(filter));
+    if (error)
+    {
+        log_w("Could not parse content, error=%s", error.c_str());
+        return false;
+    }
 
-    priceAtTime_out = 0;
+    priceAtTime_out = Price();
     if (doc.containsKey("data"))
     {
         JsonArray dataContent = doc["data"];
         if (dataContent.size() && dataContent[0].size() == 7)
-            priceAtTime_out = dataContent[0][1].as<float>();
-        log_d("priceAtTime_out = %f", priceAtTime_out);
+            jsonPrice(dataContent[0][1], priceAtTime_out);
+        log_d("priceAtTime_out = %f", priceAtTime_out.toDouble());
 
-        if (priceAtTime_out > 0)
+        if (priceAtTime_out.isPositive())
             return true;
     }
 
     return false;
 }
 
+String RequestKuCoin::urlCurrentPrices(const std::vector<String>& cryptos, const String& fiat)
+{
+    // https://api.kucoin.com/api/v1/prices?base=USD&currencies=BTC,ETH
+    String rtn;
+    rtn.reserve(60 + 8 * cryptos.size());
+
+    rtn += "https://api.kucoin.com/api/v1/prices?base=";
+    rtn += fiat;
+    rtn += "&currencies=";
+    for (size_t i = 0; i < cryptos.size(); i++)
+    {
+        if (i > 0)
+            rtn += ",";
+        rtn += cryptos[i];
+    }
+
+    return rtn;
+}
+
+bool RequestKuCoin::currentPrices(Stream& content, const std::vector<String>& cryptos, const String& fiat,
+                                  std::map<String, Price>& prices_out)
+{
+    // {"code":"200000","data":{"BTC":"33388.8675121283881416","ETH":"1650.1234"}}
+    StaticJsonDocument<16> filter;
+    filter["data"] = true;
+
+    DynamicJsonDocument doc(64 + 64 * cryptos.size()); // https://arduinojson.org/v6/assistant/#/step1
+    DeserializationError error = deserializeJson(doc, content, DeserializationOption::Filter(filter));
+    if (error)
+    {
+        log_w("Could not parse content, error=%s", error.c_str());
+        return false;
+    }
+
+    int found = 0;
+    for (const auto& crypto : cryptos)
+    {
+        Price price;
+        if (!jsonPrice(doc["data"][crypto], price))
+            continue;
+        prices_out[crypto] = price;
+        log_d("crypto: %s has price: %f", crypto.c_str(), price.toDouble());
+        found++;
+    }
+
+    return found > 0;
+}
+
+String RequestKuCoin::urlPriceHistory(uint32_t currentUnix, uint32_t maxOffset, const String& crypto, const String& fiat)
+{
+    // daily candles from a day before the largest offset up until now, at most 1500 per request
+    // https://api.kucoin.com/api/v1/market/candles?type=1day&symbol=BTC-USDT&startAt=1669398897&endAt=1701021297
+    uint32_t startTime = currentUnix - maxOffset - constants::SecondsOneDay;
+    String rtn;
+    rtn.reserve(112);
+
+    rtn += "https://api.kucoin.com/api/v1/market/candles?type=1day&symbol=";
+    rtn += crypto;
+    rtn += "-";
+    rtn += (fiat == "USD") ? "USDT" : fiat; // KuCoin candles use USDT as symbol
+    rtn += "&startAt=";
+    rtn += startTime;
+    rtn += "&endAt=";
+    rtn += currentUnix;
+
+    return rtn;
+}
+
+bool RequestKuCoin::priceHistory(Stream& content, const PriceSampleCallback& onSample)
+{
+    // candles are in the same format as priceAtTime, newest first, use the start time and open price of each
+    // {"code":"200000","data":[["1702598400","32372.62",...],["1702512000","32210.01",...]]}
+    //                            ^^^^^^^^^^   ^^^^^^^^
+
+    if (!content.find("\"data\":["))
+    {
+        log_w("No data in content, returning");
+        return false;
+    }
+
+    StaticJsonDocument<384> doc; // one candle at a time
+    do
+    {
+        if (deserializeJson(doc, content))
+            break;
+
+        JsonArray candle = doc.as<JsonArray>();
+        Price price;
+        if (candle.size() == 7 && jsonPrice(candle[1], price))
+            onSample(strtoul(candle[0].as<const char*>(), nullptr, 10), price);
+    }
+    while (content.findUntil(",", "]"));
+
+    return true;
+}
+
 #endif
@@ -0,0 +1,172 @@
+#include "SourceScoreboard.h"
+#include "Constants.h"
+#include "Utils.h"
+
+#include <algorithm>
+
+namespace
+{
+    constexpr int MaxResults = 16; // bits in ScoreSlot::results
+
+    struct ScoreSlot
+    {
+        uint32_t key;           // 0 = empty
+        uint32_t lastUsed;      // for picking a slot to replace
+        uint32_t cooldownUntil; // epoch seconds
+        uint16_t results;       // most recent result in the lowest bit, 1 = success
+        uint8_t resultCount;
+        uint8_t consecutiveFailures;
+        uint16_t latencies[constants::SourceScoreboardLatencySamples]; // millis, 0 = no sample
+        uint8_t nextLatency;
+    };
+
+    RTC_DATA_ATTR ScoreSlot scoreSlots[constants::SourceScoreboardSlots];
+    RTC_DATA_ATTR uint32_t scoreUseCounter = 0;
+    static_assert(sizeof(scoreSlots) + sizeof(scoreUseCounter) <= constants::RtcBytesSourceScoreboard,
+                  "fewer SourceScoreboardSlots fit in RTC memory");
+
+    uint32_t comboKey(SourceId source, const String& crypto, const String& fiat, long unixOffset)
+    {
+        uint32_t h = utils::hash(crypto);
+        h = utils::hash(fiat, h);
+        h = utils::hash(&unixOffset, sizeof(unixOffset), h);
+        h = utils::hash(&source, sizeof(source), h);
+        return h == 0 ? 1 : h; // 0 marks an empty slot
+    }
+
+    ScoreSlot* findSlot(uint32_t key)
+    {
+        for (auto& slot : scoreSlots)
+        {
+            if (slot.key == key)
+                return &slot;
+        }
+        return nullptr;
+    }
+
+    ScoreSlot* slotToReplace()
+    {
+        ScoreSlot* oldest = &scoreSlots[0];
+        for (auto& slot : scoreSlots)
+        {
+            if (slot.key == 0)
+                return &slot;
+            if (slot.lastUsed < oldest->lastUsed)
+                oldest = &slot;
+        }
+        return oldest;
+    }
+
+    uint32_t medianLatency(const ScoreSlot& slot)
+    {
+        uint16_t samples[constants::SourceScoreboardLatencySamples];
+        int count = 0;
+        for (auto latency : slot.latencies)
+        {
+            if (latency > 0)
+                samples[count++] = latency;
+        }
+        if (count == 0)
+            return 0;
+
+        std::sort(samples, samples + count);
+        return samples[count / 2];
+    }
+
+    uint32_t now()
+    {
+        return time(nullptr);
+    }
+}
+
+void SourceScoreboard::record(SourceId source, const String& crypto, const String& fiat, long unixOffset, bool success,
+                              uint32_t latencyMillis)
+{
+    uint32_t key = comboKey(source, crypto, fiat, unixOffset);
+    ScoreSlot* slot = findSlot(key);
+    if (slot == nullptr)
+    {
+        slot = slotToReplace();
+        *slot = ScoreSlot{};
+        slot->key = key;
+    }
+    slot->lastUsed = ++scoreUseCounter;
+
+    slot->results = (slot->results << 1) | (success ? 1 : 0);
+    if (slot->resultCount < MaxResults)
+        slot->resultCount++;
+
+    if (success)
+    {
+        slot->consecutiveFailures = 0;
+        slot->cooldownUntil = 0;
+        // only successful requests count for latency, failures are often timeouts
+        slot->latencies[slot->nextLatency] = std::max<uint32_t>(1, std::min<uint32_t>(latencyMillis, UINT16_MAX));
+        slot->nextLatency = (slot->nextLatency + 1) % constants::SourceScoreboardLatencySamples;
+    }
+    else
+    {
+        if (slot->consecutiveFailures < UINT8_MAX)
+            slot->consecutiveFailures++;
+        int extraFailures = slot->consecutiveFailures - constants::SourceFailuresBeforeCooldown;
+        if (extraFailures >= 0)
+        {
+            long cooldown = constants::SourceCooldownBaseSeconds << std::min(extraFailures, 8);
+            cooldown = std::min(cooldown, constants::SourceCooldownMaxSeconds);
+            slot->cooldownUntil = now() + cooldown;
+            log_d("Source %d failed %d times in a row for %s/%s offset %ld, cooling down for %ld seconds",
+                  (int)source, slot->consecutiveFailures, crypto.c_str(), fiat.c_str(), unixOffset, cooldown);
+        }
+    }
+}
+
+SourceScore SourceScoreboard::getScore(SourceId source, const String& crypto, const String& fiat, long unixOffset)
+{
+    const ScoreSlot* slot = findSlot(comboKey(source, crypto, fiat, unixOffset));
+    if (slot == nullptr || slot->resultCount == 0)
+        return SourceScore{0, 1.0f, 0, 0, false};
+
+    uint16_t mask = slot->resultCount >= MaxResults ? 0xFFFF : (1 << slot->resultCount) - 1;
+    int successes = __builtin_popcount(slot->results & mask);
+
+    SourceScore score;
+    score.samples = slot->resultCount;
+    score.successRate = (float)successes / slot->resultCount;
+    score.medianLatencyMillis = medianLatency(*slot);
+    score.consecutiveFailures = slot->consecutiveFailures;
+    score.coolingDown = slot->cooldownUntil > now();
+    return score;
+}
+
+bool SourceScoreboard::isCoolingDown(SourceId source, const String& crypto, const String& fiat, long unixOffset)
+{
+    return getScore(source, crypto, fiat, unixOffset).coolingDown;
+}
+
+float SourceScoreboard::sourceScore(SourceId source, const String& crypto, const String& fiat, TimeframeSet timeframes)
+{
+    // mostly the success rate, then the latency to choose between sources that are about as reliable
+    // e.g. 100% at 800ms = 9200, 90% at 300ms = 8700
+    if (timeframes.empty())
+        return 0;
+
+    float total = 0;
+    bool allCoolingDown = true;
+    for (Timeframe timeframe : timeframes)
+    {
+        SourceScore score = getScore(source, crypto, fiat, timeframeSeconds(timeframe));
+        uint32_t latency = score.medianLatencyMillis > 0 ? score.medianLatencyMillis : constants::SourceUnknownLatencyMillis;
+        total += (score.successRate * 10000) - latency;
+        allCoolingDown &= score.coolingDown;
+    }
+
+    float average = total / timeframes.size();
+    return allCoolingDown ? average - 100000 : average;
+}
+
+void SourceScoreboard::reset()
+{
+    for (auto& slot : scoreSlots)
+        slot = ScoreSlot{};
+    scoreUseCounter = 0;
+}
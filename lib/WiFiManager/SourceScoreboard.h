@@ -0,0 +1,38 @@
+#ifndef SOURCESCOREBOARD_H
+#define SOURCESCOREBOARD_H
+
+#include <Arduino.h>
+
+#include "RequestBase.h"
+
+// keeps how well each data source has done for each (crypto, fiat, unix offset) across deep sleep, so the
+// sources can be tried best first and a combination that keeps failing on a source can be skipped for a while
+// kept in RTC memory, when it is full the combination used least recently is replaced
+
+struct SourceScore
+{
+    int samples;                  // results kept, 0 if the combination hasn't been tried
+    float successRate;            // of the recent results
+    uint32_t medianLatencyMillis; // of the recent requests, 0 if none
+    int consecutiveFailures;
+    bool coolingDown;             // failed enough times in a row that it shouldn't be tried yet
+};
+
+class SourceScoreboard
+{
+public:
+    // records the result of a request for a price, latency is how long the request took
+    static void record(SourceId source, const String& crypto, const String& fiat, long unixOffset, bool success,
+                       uint32_t latencyMillis);
+
+    static SourceScore getScore(SourceId source, const String& crypto, const String& fiat, long unixOffset);
+    static bool isCoolingDown(SourceId source, const String& crypto, const String& fiat, long unixOffset);
+
+    // higher is better, for ordering the sources to get the prices of these timeframes from
+    // a source where every combination is cooling down is always scored below any other
+    static float sourceScore(SourceId source, const String& crypto, const String& fiat, TimeframeSet timeframes);
+
+    static void reset();
+};
+
+#endif
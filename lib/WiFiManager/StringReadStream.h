@@ -0,0 +1,46 @@
+#ifndef STRINGREADSTREAM_H
+#define STRINGREADSTREAM_H
+
+#include <Arduino.h>
+
+// read only Stream over a String that is already in memory
+// lets content be given to a parser that reads from a Stream without copying it first
+class StringReadStream : public Stream
+{
+public:
+    explicit StringReadStream(const String& str) :
+        m_str(str)
+    {
+        setTimeout(0); // all content is already here, never wait for more
+    }
+
+    int available() override
+    {
+        return m_str.length() - m_pos;
+    }
+
+    int read() override
+    {
+        if (m_pos >= m_str.length())
+            return -1;
+        return m_str.charAt(m_pos++);
+    }
+
+    int peek() override
+    {
+        if (m_pos >= m_str.length())
+            return -1;
+        return m_str.charAt(m_pos);
+    }
+
+    size_t write(uint8_t) override
+    {
+        return 0;
+    }
+
+private:
+    const String& m_str;
+    unsigned int m_pos = 0;
+};
+
+#endif
@@ -0,0 +1,151 @@
+#include "SymbolCatalog.h"
+
+#include <array>
+#include <string.h>
+
+namespace
+{
+    constexpr uint8_t U = FiatBit::USD;
+    constexpr uint8_t UE = FiatBit::USD | FiatBit::EUR;
+
+    // by market cap, which is the order the config webpage lists them in
+    // binance and kucoin listings are as of writing, a pair that has since been delisted or renamed (MATIC is now
+    // POL and RNDR is RENDER on both) is left as 0 so it is never requested, coingecko still has the old ids
+    constexpr CryptoSymbol Catalog[] = {
+        {"BTC", "bitcoin", UE, U, 0},
+        {"ETH", "ethereum", UE, U, 0},
+        {"BNB", "binancecoin", UE, U, 0},
+        {"SOL", "solana", UE, U, 0},
+        {"XRP", "ripple", UE, U, 0},
+        {"ADA", "cardano", UE, U, 0},
+        {"AVAX", "avalanche-2", UE, U, 0},
+        {"DOGE", "dogecoin", UE, U, 0},
+        {"TRX", "tron", U, U, 0},
+        {"DOT", "polkadot", UE, U, 0},
+        {"MATIC", "matic-network", 0, 0, 0},
+        {"LINK", "chainlink", UE, U, 0},
+        {"TON", "the-open-network", U, U, 0},
+        {"ICP", "internet-computer", U, U, 0},
+        {"SHIB", "shiba-inu", UE, U, 0},
+        {"DAI", "dai", 0, U, 0},
+        {"LTC", "litecoin", UE, U, 0},
+        {"BCH", "bitcoin-cash", U, U, 0},
+        {"ETC", "ethereum-classic", U, U, 0},
+        {"ATOM", "cosmos", U, U, 0},
+        {"UNI", "uniswap", U, U, 0},
+        {"LEO", "leo-token", 0, 0, 0},
+        {"OP", "optimism", U, U, 1654041600},
+        {"NEAR", "near", U, U, 0},
+        {"APT", "aptos", U, U, 1664582400},
+        {"XLM", "stellar", U, U, 0},
+        {"OKB", "okb", 0, 0, 0},
+        {"INJ", "injective-protocol", U, U, 0},
+        {"FIL", "filecoin", U, U, 0},
+        {"LDO", "lido-dao", U, U, 0},
+        {"IMX", "immutable-xeckoid", U, U, 0},
+        {"XMR", "monero", 0, U, 0},
+        {"TIA", "celestia", U, U, 1696118400},
+        {"ARB", "arbitrum", U, U, 1677628800},
+        {"HBAR", "hedera-hashgraph", U, U, 0},
+        {"KAS", "kaspa", 0, U, 0},
+        {"STX", "blockstack", U, U, 0},
+        {"MNT", "mantle", 0, U, 1688169600},
+        {"VET", "vechain", U, U, 0},
+        {"CRO", "crypto-com-chain", 0, U, 0},
+        {"MKR", "maker", U, U, 0},
+        {"BSV", "bitcoin-cash-sv", 0, U, 0},
+        {"SEI", "sei-network", U, U, 1690848000},
+        {"GRT", "the-graph", U, U, 0},
+        {"RUNE", "thorchain", U, U, 0},
+        {"AAVE", "aave", U, U, 0},
+        {"ALGO", "algorand", U, U, 0},
+        {"ORDI", "ordinals", U, U, 1677628800},
+        {"QNT", "quant-network", U, U, 0},
+        {"RNDR", "render-token", 0, 0, 0},
+        {"EGLD", "elrond-erd-2", U, U, 0},
+        {"SUI", "sui", U, U, 1682899200},
+        {"MINA", "mina-protocol", U, U, 0},
+    };
+    constexpr size_t CatalogSize = sizeof(Catalog) / sizeof(Catalog[0]);
+    static_assert(CatalogSize <= UINT8_MAX, "indexes are kept in a byte");
+
+    constexpr int compare(const char* a, const char* b)
+    {
+        while (*a != '\0' && *a == *b)
+        {
+            a++;
+            b++;
+        }
+        return (unsigned char)*a - (unsigned char)*b;
+    }
+
+    // indexes into Catalog in symbol order, sorted when compiling so the list above can stay by market cap
+    constexpr std::array<uint8_t, CatalogSize> sortBySymbol()
+    {
+        std::array<uint8_t, CatalogSize> order{};
+        for (size_t i = 0; i < CatalogSize; i++)
+        {
+            size_t j = i;
+            for (; j > 0 && compare(Catalog[order[j - 1]].symbol, Catalog[i].symbol) > 0; j--)
+                order[j] = order[j - 1];
+            order[j] = i;
+        }
+        return order;
+    }
+    constexpr std::array<uint8_t, CatalogSize> BySymbol = sortBySymbol();
+
+    constexpr bool symbolsAreUnique()
+    {
+        for (size_t i = 1; i < CatalogSize; i++)
+        {
+            if (compare(Catalog[BySymbol[i - 1]].symbol, Catalog[BySymbol[i]].symbol) == 0)
+                return false;
+        }
+        return true;
+    }
+    static_assert(symbolsAreUnique(), "a symbol is in the catalog twice");
+}
+
+uint8_t fiatBit(const char* fiat)
+{
+    if (strcmp(fiat, "USD") == 0)
+        return FiatBit::USD;
+    if (strcmp(fiat, "EUR") == 0)
+        return FiatBit::EUR;
+    if (strcmp(fiat, "GBP") == 0)
+        return FiatBit::GBP;
+    return 0;
+}
+
+const CryptoSymbol* SymbolCatalog::find(const char* symbol)
+{
+    size_t low = 0, high = CatalogSize;
+    while (low < high)
+    {
+        size_t mid = (low + high) / 2;
+        const CryptoSymbol& entry = Catalog[BySymbol[mid]];
+        int order = strcmp(entry.symbol, symbol);
+        if (order == 0)
+            return &entry;
+        if (order < 0)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return nullptr;
+}
+
+const CryptoSymbol* SymbolCatalog::begin()
+{
+    return Catalog;
+}
+
+const CryptoSymbol* SymbolCatalog::end()
+{
+    return Catalog + CatalogSize;
+}
+
+size_t SymbolCatalog::size()
+{
+    return CatalogSize;
+}
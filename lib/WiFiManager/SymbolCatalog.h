@@ -0,0 +1,43 @@
+#ifndef SYMBOLCATALOG_H
+#define SYMBOLCATALOG_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// a bit for each fiat the ticker can show, so the fiats a symbol is listed in on an exchange fit in a byte
+namespace FiatBit
+{
+    inline constexpr uint8_t USD = 1 << 0;
+    inline constexpr uint8_t EUR = 1 << 1;
+    inline constexpr uint8_t GBP = 1 << 2;
+    inline constexpr uint8_t All = USD | EUR | GBP;
+}
+
+// bit of a fiat such as "USD", 0 if it isn't one the ticker can show
+uint8_t fiatBit(const char* fiat);
+
+// everything the data sources need to know about a crypto symbol
+struct CryptoSymbol
+{
+    const char* symbol;       // as in the config, e.g. "BTC"
+    const char* coinGeckoId;  // the coingecko api can't be called with the symbol, it has its own ids, e.g. "bitcoin"
+    uint8_t binanceFiats;     // FiatBits the binance pair, the symbol then the fiat (USDT for USD), is listed for
+    uint8_t kuCoinFiats;      // as above for the kucoin pair, the symbol, "-", then the fiat
+    uint32_t historyFromUnix; // first price coingecko has, 0 if before the longest timeframe the ticker shows
+};
+
+// the one list of the cryptos the ticker can show, the config webpage offers the same ones
+// kept in flash as a constexpr table, nothing is built on the heap at boot
+class SymbolCatalog
+{
+public:
+    // the entry for symbol, found by binary search, nullptr if it isn't in the catalog
+    static const CryptoSymbol* find(const char* symbol);
+
+    // every entry in the order the config webpage lists them, by market cap
+    static const CryptoSymbol* begin();
+    static const CryptoSymbol* end();
+    static size_t size();
+};
+
+#endif
@@ -0,0 +1,300 @@
+#include "TlsClient.h"
+#include "TlsSessionCache.h"
+#include "Constants.h"
+#include "WakeTimer.h"
+
+#include <WiFi.h>
+#include <lwip/sockets.h>
+#include <mbedtls/net_sockets.h>
+
+TlsClient::~TlsClient()
+{
+    stop();
+}
+
+int TlsClient::connect(IPAddress ip, uint16_t port)
+{
+    stop();
+    if (!connectSocket(ip, port) || !handshake(nullptr))
+    {
+        stop();
+        return 0;
+    }
+    return 1;
+}
+
+int TlsClient::connect(const char* host, uint16_t port)
+{
+    stop();
+
+    IPAddress ip;
+    PhaseTimer dnsTimer(WakePhase::DNS_LOOKUP);
+    bool resolved = WiFi.hostByName(host, ip);
+    dnsTimer.stop();
+    if (!resolved)
+    {
+        log_w("DNS lookup failed for %s", host);
+        return 0;
+    }
+
+    if (!connectSocket(ip, port) || !handshake(host))
+    {
+        stop();
+        return 0;
+    }
+    return 1;
+}
+
+bool TlsClient::connectSocket(IPAddress ip, uint16_t port)
+{
+    m_socket = lwip_socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (m_socket < 0)
+    {
+        log_w("Could not create socket");
+        return false;
+    }
+
+    // connect without blocking so it can time out, the socket is left non-blocking for mbedtls
+    fcntl(m_socket, F_SETFL, fcntl(m_socket, F_GETFL, 0) | O_NONBLOCK);
+
+    struct sockaddr_in serverAddr{};
+    serverAddr.sin_family = AF_INET;
+    serverAddr.sin_addr.s_addr = (uint32_t)ip;
+    serverAddr.sin_port = htons(port);
+
+    int res = lwip_connect(m_socket, (struct sockaddr*)&serverAddr, sizeof(serverAddr));
+    if (res < 0 && errno != EINPROGRESS)
+    {
+        log_w("Socket connect failed, errno=%d", errno);
+        return false;
+    }
+
+    fd_set fdset;
+    FD_ZERO(&fdset);
+    FD_SET(m_socket, &fdset);
+    struct timeval tv;
+    tv.tv_sec = constants::TlsConnectTimeoutMillis / 1000;
+    tv.tv_usec = (constants::TlsConnectTimeoutMillis % 1000) * 1000;
+
+    res = select(m_socket + 1, nullptr, &fdset, nullptr, &tv);
+    int sockErr = 0;
+    socklen_t len = sizeof(sockErr);
+    if (res <= 0 || getsockopt(m_socket, SOL_SOCKET, SO_ERROR, &sockErr, &len) < 0 || sockErr != 0)
+    {
+        log_w("Socket connect timed out or failed, res=%d, error=%d", res, sockErr);
+        return false;
+    }
+
+    int enable = 1;
+    setsockopt(m_socket, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+    return true;
+}
+
+bool TlsClient::handshake(const char* host)
+{
+    mbedtls_ssl_init(&m_ssl);
+    mbedtls_ssl_config_init(&m_conf);
+    mbedtls_ctr_drbg_init(&m_drbg);
+    mbedtls_entropy_init(&m_entropy);
+    m_tlsInitialised = true;
+
+    if (mbedtls_ctr_drbg_seed(&m_drbg, mbedtls_entropy_func, &m_entropy, nullptr, 0) != 0 ||
+        mbedtls_ssl_config_defaults(&m_conf, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM,
+                                    MBEDTLS_SSL_PRESET_DEFAULT) != 0)
+    {
+        log_w("TLS setup failed");
+        return false;
+    }
+
+    mbedtls_ssl_conf_authmode(&m_conf, MBEDTLS_SSL_VERIFY_NONE); // as setInsecure() on WiFiClientSecure
+    mbedtls_ssl_conf_rng(&m_conf, mbedtls_ctr_drbg_random, &m_drbg);
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+    mbedtls_ssl_conf_session_tickets(&m_conf, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+#endif
+
+    if (mbedtls_ssl_setup(&m_ssl, &m_conf) != 0 || (host && mbedtls_ssl_set_hostname(&m_ssl, host) != 0))
+    {
+        log_w("TLS setup failed");
+        return false;
+    }
+    mbedtls_ssl_set_bio(&m_ssl, &m_socket, mbedtls_net_send, mbedtls_net_recv, nullptr);
+
+    mbedtls_ssl_session cached;
+    mbedtls_ssl_session_init(&cached);
+    bool offered = host && TlsSessionCache::load(host, cached) && mbedtls_ssl_set_session(&m_ssl, &cached) == 0;
+
+    uint32_t start = millis();
+    PhaseTimer handshakeTimer(WakePhase::TLS_HANDSHAKE);
+    int ret;
+    while ((ret = mbedtls_ssl_handshake(&m_ssl)) != 0)
+    {
+        if ((ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) ||
+            millis() - start > constants::TlsHandshakeTimeoutMillis)
+        {
+            log_w("TLS handshake failed, error=-0x%x", -ret);
+            mbedtls_ssl_session_free(&cached);
+            return false;
+        }
+        delay(1);
+    }
+
+    mbedtls_ssl_session current;
+    mbedtls_ssl_session_init(&current);
+    bool haveSession = mbedtls_ssl_get_session(&m_ssl, &current) == 0;
+
+#if defined(MBEDTLS_HAVE_TIME)
+    // a new session gets a new start time, a resumed one keeps the start time of the session it resumed
+    m_resumed = offered && haveSession && current.start == cached.start;
+#else
+    m_resumed = false;
+#endif
+    mbedtls_ssl_session_free(&cached);
+    handshakeTimer.stop();
+    log_d("TLS handshake took %d ms, resumed=%d", millis() - start, m_resumed);
+
+    if (host)
+    {
+        TlsSessionCache::recordHandshake(m_resumed);
+        if (haveSession)
+            TlsSessionCache::save(host, current);
+    }
+    mbedtls_ssl_session_free(&current);
+
+    m_connected = true;
+    return true;
+}
+
+size_t TlsClient::write(uint8_t b)
+{
+    return write(&b, 1);
+}
+
+size_t TlsClient::write(const uint8_t* buf, size_t size)
+{
+    if (!m_connected)
+        return 0;
+
+    size_t written = 0;
+    uint32_t lastProgress = millis();
+    while (written < size)
+    {
+        int ret = mbedtls_ssl_write(&m_ssl, buf + written, size - written);
+        if (ret > 0)
+        {
+            written += ret;
+            lastProgress = millis();
+        }
+        else if ((ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) ||
+                 millis() - lastProgress > constants::HttpReadTimeoutMillis)
+        {
+            log_w("TLS write failed, error=-0x%x", -ret);
+            stop();
+            break;
+        }
+        else
+            delay(1);
+    }
+    return written;
+}
+
+int TlsClient::available()
+{
+    if (!m_connected)
+        return 0;
+
+    int peeked = m_peeked >= 0 ? 1 : 0;
+    if (!m_peerClosed)
+    {
+        // a zero length read processes any record that has arrived so its bytes are counted
+        int ret = mbedtls_ssl_read(&m_ssl, nullptr, 0);
+        if (ret == MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY ||
+            (ret < 0 && ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE))
+            m_peerClosed = true;
+    }
+    return peeked + mbedtls_ssl_get_bytes_avail(&m_ssl);
+}
+
+int TlsClient::read()
+{
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+}
+
+int TlsClient::read(uint8_t* buf, size_t size)
+{
+    if (!m_connected || size == 0)
+        return -1;
+
+    size_t count = 0;
+    if (m_peeked >= 0)
+    {
+        buf[count++] = m_peeked;
+        m_peeked = -1;
+    }
+
+    if (count < size && !m_peerClosed)
+    {
+        int ret = mbedtls_ssl_read(&m_ssl, buf + count, size - count);
+        if (ret > 0)
+            count += ret;
+        else if (ret == 0 || ret == MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY ||
+                 (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE))
+            m_peerClosed = true;
+    }
+
+    return count > 0 ? count : -1;
+}
+
+int TlsClient::peek()
+{
+    if (m_peeked < 0)
+    {
+        uint8_t c;
+        if (read(&c, 1) == 1)
+            m_peeked = c;
+    }
+    return m_peeked;
+}
+
+uint8_t TlsClient::connected()
+{
+    if (!m_connected)
+        return 0;
+
+    // anything already received can still be read even if the server has since closed
+    if (m_peeked >= 0 || mbedtls_ssl_get_bytes_avail(&m_ssl) > 0)
+        return 1;
+    if (m_peerClosed)
+        return 0;
+
+    uint8_t dummy;
+    int res = recv(m_socket, &dummy, 1, MSG_DONTWAIT | MSG_PEEK);
+    if (res == 0 || (res < 0 && errno != EAGAIN && errno != EWOULDBLOCK))
+    {
+        m_peerClosed = true;
+        return 0;
+    }
+    return 1;
+}
+
+void TlsClient::stop()
+{
+    if (m_tlsInitialised)
+    {
+        if (m_connected && !m_peerClosed)
+            mbedtls_ssl_close_notify(&m_ssl);
+        mbedtls_ssl_free(&m_ssl);
+        mbedtls_ssl_config_free(&m_conf);
+        mbedtls_ctr_drbg_free(&m_drbg);
+        mbedtls_entropy_free(&m_entropy);
+        m_tlsInitialised = false;
+    }
+    if (m_socket >= 0)
+    {
+        lwip_close(m_socket);
+        m_socket = -1;
+    }
+    m_connected = false;
+    m_peerClosed = false;
+    m_peeked = -1;
+}
@@ -0,0 +1,58 @@
+#ifndef TLSCLIENT_H
+#define TLSCLIENT_H
+
+#include <Arduino.h>
+#include <Client.h>
+
+#include <mbedtls/ssl.h>
+#include <mbedtls/entropy.h>
+#include <mbedtls/ctr_drbg.h>
+
+// TLS client used for the data source requests
+// does the same as WiFiClientSecure with setInsecure() (no certificate verification), but also offers the
+// session cached in TlsSessionCache for the server when connecting by host name, which WiFiClientSecure has
+// no way to do, so most wakes only need an abbreviated handshake
+class TlsClient : public Client
+{
+public:
+    TlsClient() = default;
+    ~TlsClient();
+
+    TlsClient(const TlsClient&) = delete;
+    TlsClient& operator=(const TlsClient&) = delete;
+
+    int connect(IPAddress ip, uint16_t port) override; // no host name, so no session is cached or resumed
+    int connect(const char* host, uint16_t port) override;
+
+    size_t write(uint8_t b) override;
+    size_t write(const uint8_t* buf, size_t size) override;
+    int available() override;
+    int read() override;
+    int read(uint8_t* buf, size_t size) override;
+    int peek() override;
+    void flush() override {}
+    void stop() override;
+    uint8_t connected() override;
+    operator bool() override { return connected(); }
+
+    // whether the last handshake resumed a cached session
+    bool resumedSession() const { return m_resumed; }
+
+private:
+    bool connectSocket(IPAddress ip, uint16_t port);
+    bool handshake(const char* host);
+
+    int m_socket = -1;
+    bool m_tlsInitialised = false;
+    bool m_connected = false;
+    bool m_peerClosed = false;
+    bool m_resumed = false;
+    int m_peeked = -1; // byte read by peek() but not yet returned by read()
+
+    mbedtls_ssl_context m_ssl;
+    mbedtls_ssl_config m_conf;
+    mbedtls_ctr_drbg_context m_drbg;
+    mbedtls_entropy_context m_entropy;
+};
+
+#endif
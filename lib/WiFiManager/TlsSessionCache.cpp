@@ -0,0 +1,189 @@
+#include "TlsSessionCache.h"
+#include "Constants.h"
+#include "Utils.h"
+
+#include "SPIFFS.h"
+#include <mbedtls/platform.h>
+#include <vector>
+
+namespace
+{
+    // length value for a session that was saved to SPIFFS instead of its slot
+    constexpr uint16_t SessionInFlash = 0xFFFF;
+
+    struct SessionSlot
+    {
+        uint32_t hostHash; // 0 = empty
+        uint32_t dataHash; // of the serialised session, avoids rewriting one that hasn't changed
+        uint32_t lastUsed; // for picking a slot to replace
+        uint16_t length;
+        uint8_t data[constants::TlsSessionRtcSlotBytes];
+    };
+
+    RTC_DATA_ATTR SessionSlot sessionSlots[constants::TlsSessionCacheSlots];
+    RTC_DATA_ATTR uint32_t sessionUseCounter = 0;
+    RTC_DATA_ATTR TlsSessionStats sessionStats = {0, 0};
+    static_assert(sizeof(sessionSlots) + sizeof(sessionUseCounter) + sizeof(sessionStats) <=
+                      constants::RtcBytesTlsSessions,
+                  "fewer or smaller session slots fit in RTC memory");
+
+    uint32_t hostHash(const char* host)
+    {
+        uint32_t h = utils::hash(host, strlen(host));
+        return h == 0 ? 1 : h; // 0 marks an empty slot
+    }
+
+    String flashFileName(uint32_t hash)
+    {
+        char name[20];
+        snprintf(name, sizeof(name), "/tls_%08x.bin", hash);
+        return String(name);
+    }
+
+    SessionSlot* findSlot(uint32_t hash)
+    {
+        for (auto& slot : sessionSlots)
+        {
+            if (slot.hostHash == hash)
+                return &slot;
+        }
+        return nullptr;
+    }
+
+    SessionSlot* slotToReplace()
+    {
+        SessionSlot* oldest = &sessionSlots[0];
+        for (auto& slot : sessionSlots)
+        {
+            if (slot.hostHash == 0)
+                return &slot;
+            if (slot.lastUsed < oldest->lastUsed)
+                oldest = &slot;
+        }
+        return oldest;
+    }
+}
+
+bool TlsSessionCache::load(const char* host, mbedtls_ssl_session& session_out)
+{
+    uint32_t hash = hostHash(host);
+    SessionSlot* slot = findSlot(hash);
+    if (slot == nullptr || slot->length == 0)
+    {
+        log_d("No cached TLS session for %s", host);
+        return false;
+    }
+    slot->lastUsed = ++sessionUseCounter;
+
+    int ret;
+    if (slot->length == SessionInFlash)
+    {
+        File file = SPIFFS.open(flashFileName(hash), FILE_READ);
+        if (!file)
+        {
+            log_w("Cached TLS session for %s is missing from SPIFFS", host);
+            slot->length = 0;
+            return false;
+        }
+        std::vector<uint8_t> data(file.size());
+        file.read(data.data(), data.size());
+        file.close();
+        ret = mbedtls_ssl_session_load(&session_out, data.data(), data.size());
+    }
+    else
+        ret = mbedtls_ssl_session_load(&session_out, slot->data, slot->length);
+
+    if (ret != 0)
+    {
+        // e.g. saved by a firmware built with different mbedtls options
+        log_w("Could not load cached TLS session for %s, error=%d", host, ret);
+        slot->length = 0;
+        return false;
+    }
+
+    log_d("Loaded cached TLS session for %s", host);
+    return true;
+}
+
+void TlsSessionCache::save(const char* host, mbedtls_ssl_session& session)
+{
+#if defined(MBEDTLS_SSL_KEEP_PEER_CERTIFICATE)
+    if (session.peer_cert != nullptr)
+    {
+        mbedtls_x509_crt_free(session.peer_cert);
+        mbedtls_free(session.peer_cert);
+        session.peer_cert = nullptr;
+    }
+#endif
+
+    size_t length = 0;
+    mbedtls_ssl_session_save(&session, nullptr, 0, &length); // just gets the length needed
+    if (length == 0)
+    {
+        log_w("Could not serialise TLS session for %s", host);
+        return;
+    }
+
+    std::vector<uint8_t> data(length);
+    if (mbedtls_ssl_session_save(&session, data.data(), data.size(), &length) != 0)
+    {
+        log_w("Could not serialise TLS session for %s", host);
+        return;
+    }
+
+    uint32_t hash = hostHash(host);
+    uint32_t dataHash = utils::hash(data.data(), length);
+    SessionSlot* slot = findSlot(hash);
+    if (slot != nullptr && slot->length != 0 && slot->dataHash == dataHash)
+    {
+        log_d("TLS session for %s is unchanged", host);
+        return;
+    }
+    if (slot == nullptr)
+        slot = slotToReplace();
+    if (slot->hostHash != hash && slot->length == SessionInFlash)
+        SPIFFS.remove(flashFileName(slot->hostHash));
+
+    slot->hostHash = hash;
+    slot->dataHash = dataHash;
+    slot->lastUsed = ++sessionUseCounter;
+
+    if (length <= sizeof(slot->data))
+    {
+        if (slot->length == SessionInFlash)
+            SPIFFS.remove(flashFileName(hash));
+        memcpy(slot->data, data.data(), length);
+        slot->length = length;
+        log_d("Cached TLS session for %s in RTC memory (%d bytes)", host, length);
+        return;
+    }
+
+    File file = SPIFFS.open(flashFileName(hash), FILE_WRITE);
+    if (!file || file.write(data.data(), length) != length)
+    {
+        log_w("Failed to save TLS session for %s to SPIFFS", host);
+        slot->length = 0;
+    }
+    else
+    {
+        slot->length = SessionInFlash;
+        log_d("Cached TLS session for %s in SPIFFS (%d bytes)", host, length);
+    }
+    file.close();
+}
+
+void TlsSessionCache::recordHandshake(bool resumed)
+{
+    if (resumed)
+        sessionStats.hits++;
+    else
+        sessionStats.misses++;
+
+    uint32_t total = sessionStats.hits + sessionStats.misses;
+    log_i("TLS session %s, hit rate %d/%d", resumed ? "resumed" : "not resumed", sessionStats.hits, total);
+}
+
+TlsSessionStats TlsSessionCache::getStats()
+{
+    return sessionStats;
+}
@@ -0,0 +1,31 @@
+#ifndef TLSSESSIONCACHE_H
+#define TLSSESSIONCACHE_H
+
+#include <Arduino.h>
+#include <mbedtls/ssl.h>
+
+// keeps the TLS session (id and ticket) of each server across deep sleep, so the next connection can use
+// an abbreviated handshake instead of a full one
+// sessions are kept in RTC memory, or in SPIFFS if one is too big for its RTC slot
+
+struct TlsSessionStats
+{
+    uint32_t hits;   // handshakes that resumed a cached session
+    uint32_t misses; // full handshakes, either no session was cached or the server didn't accept it
+};
+
+class TlsSessionCache
+{
+public:
+    // fills session_out with the cached session for host, returns false if there isn't one
+    static bool load(const char* host, mbedtls_ssl_session& session_out);
+
+    // caches the session of a completed handshake, the peer certificate is dropped first as it isn't
+    // needed to resume and is most of the size
+    static void save(const char* host, mbedtls_ssl_session& session);
+
+    static void recordHandshake(bool resumed);
+    static TlsSessionStats getStats();
+};
+
+#endif
@@ -1,11 +1,18 @@
 #include "WiFiManager.h"
 #include <ArduinoJson.h>
 #include "Constants.h"
+#include "HttpBodyStream.h"
+#include "TimeKeeper.h"
+#include "SourceScoreboard.h"
+#include "SymbolCatalog.h"
+#include "WakeTimer.h"
+#include "SleepSchedule.h"
 
 #include "AsyncElegantOTA.h"
 
+#include <algorithm>
+
 #include "SPIFFS.h"
-#include "esp_sntp.h"
 
 #include "configWebpage.h"
 #include "adminWebpage.h"
@@ -13,6 +20,56 @@
 namespace WiFiManagerLib
 {
 
+namespace
+{
+    constexpr EventBits_t WiFiConnectedBit = BIT0;
+    constexpr EventBits_t WiFiGotIpBit = BIT1;
+    constexpr EventBits_t WiFiDisconnectedBit = BIT2;
+
+    // everything needed to reconnect to the last network without scanning or DHCP
+    struct WiFiProfile
+    {
+        bool valid;
+        uint32_t credentialsHash; // of the ssid and password it was saved for
+        uint8_t bssid[6];
+        int32_t channel;
+        uint32_t ip;
+        uint32_t gateway;
+        uint32_t subnet;
+        uint32_t dns1;
+        uint32_t dns2;
+        int uses; // wakes the lease has been reused without DHCP
+    };
+
+    RTC_DATA_ATTR WiFiProfile wifiProfile{};
+    static_assert(sizeof(wifiProfile) <= constants::RtcBytesWiFiProfile, "over the wifi profile's RTC share");
+
+    // the timeframes the daily samples of the stored history can give, the samples are at 00:00 so can be up to
+    // 12 hours from the time wanted, which is only close enough for 30d and longer
+    TimeframeSet fromDailySamples(TimeframeSet timeframes)
+    {
+        TimeframeSet daily;
+        for (Timeframe timeframe : timeframes)
+        {
+            if (timeframeSeconds(timeframe) / constants::PriceHistoryMaxSampleErrorDivisor >= constants::SecondsOneDay / 2)
+                daily.insert(timeframe);
+        }
+        return daily;
+    }
+
+    // scores the result of a request for the price of timeframe, a failure only once a wake however many requests
+    // for the price fail, so one bad wake doesn't put the source into a long cooldown
+    void recordResult(SourceId source, const String& crypto, const String& fiat, Timeframe timeframe, bool success,
+                      uint32_t latencyMillis, TimeframeSet& scoredFailed)
+    {
+        if (!success && scoredFailed.has(timeframe))
+            return;
+        SourceScoreboard::record(source, crypto, fiat, timeframeSeconds(timeframe), success, latencyMillis);
+        if (!success)
+            scoredFailed.insert(timeframe);
+    }
+}
+
 WiFiStatus WiFiManager::initNormalMode(const CurrentConfig& cfg, bool waitForNtpSync, bool initAllDataSources)
 {
     m_ssid = cfg.ssid;
@@ -23,48 +80,44 @@ WiFiStatus WiFiManager::initNormalMode(const CurrentConfig& cfg, bool waitForNtp
         initAllAvailableDataSources();
 
     log_d("Connecting to known WiFi point %s", m_ssid.c_str());
-    WiFi.begin(m_ssid, m_password);
-    int retries = 0;
-    while ((WiFi.status() != WL_CONNECTED) && (retries < 15)) 
-    {
-        retries++;
-        delay(500);
-    }
+    uint32_t connectStart = millis();
+    connectToNetwork();
+    WakeTimer::record(WakePhase::WIFI_CONNECT, millis() - connectStart);
     if (WiFi.status() == WL_CONNECTED)
     {
-        log_i("Connected to %s", m_ssid.c_str());
+        log_i("Connected to %s in %d ms, fast=%d", m_ssid.c_str(), millis() - connectStart, m_usedFastReconnect);
 
-        const char* ntpServer = "pool.ntp.org";
-        log_d("Getting time from ntp");
-        configTime(0, 0, ntpServer);
+        // the time kept through deep sleep is used as it is if it should still be accurate enough, otherwise
+        // it is synced with NTP, after an overnight sleep it is always synced so the next wake is on time
+        if (waitForNtpSync || TimeKeeper::needsSync())
+        {
+            uint32_t timeout = waitForNtpSync ? constants::NtpResyncTimeoutSeconds * 1000 : constants::NtpSyncTimeoutMillis;
+            PhaseTimer ntpTimer(WakePhase::NTP_SYNC);
+            if (!TimeKeeper::sync(timeout))
+                log_w("Could not sync time with NTP, using the time kept through sleep");
+        }
+        else
+            TimeKeeper::applyDriftCorrection();
 
         log_d("Setting timezone to %s", cfg.tz.c_str());
         setenv("TZ", cfg.tz.c_str(), 1); // will be in config
         tzset();
 
-        bool gotTime = false;
-        int timeRetries = 0;
-
-        while (!gotTime && timeRetries < 10)
+        bool gotTime = TimeKeeper::hasValidTime() && getTime(m_timeinfo);
+        if (gotTime)
         {
-            gotTime = getTime(m_timeinfo, waitForNtpSync);
-            if (gotTime)
-            {
-                setTimeVars(m_timeinfo);
-                log_d("Time: %s %s", m_dayMonth.c_str(), m_time.c_str());
-                log_d("Epoch: %d", m_epoch);
-                m_status = WiFiStatus::OK;
-            }
-            else
-                delay(500);
-            timeRetries++;
-            
+            setTimeVars(m_timeinfo);
+            log_d("Time: %s %s", m_dayMonth.c_str(), m_time.c_str());
+            log_d("Epoch: %d", m_epoch);
+            m_status = WiFiStatus::OK;
         }
-        if (!gotTime)
+        else
         {
             // we can be confident the NTP pool server will not be down
-            // if we don't have an epoch time, we don't have an internet connection
+            // if we couldn't sync a time that was never set, we don't have an internet connection
             m_status = WiFiStatus::NO_INTERNET;
+            // the saved lease may be the cause, e.g. the router gave the address to another device
+            wifiProfile.valid = false;
         }
     }
     else
@@ -75,6 +128,100 @@ WiFiStatus WiFiManager::initNormalMode(const CurrentConfig& cfg, bool waitForNtp
     return m_status;
 }
 
+void WiFiManager::connectToNetwork()
+{
+    WiFi.persistent(false); // the credentials come from the config, no need to write them to flash every wake
+    WiFi.mode(WIFI_STA);
+
+    m_usedFastReconnect = false;
+    m_wifiEvents = xEventGroupCreate();
+    wifi_event_id_t eventId = WiFi.onEvent([this](arduino_event_id_t event, arduino_event_info_t info)
+    {
+        if (event == ARDUINO_EVENT_WIFI_STA_CONNECTED)
+            xEventGroupSetBits(m_wifiEvents, WiFiConnectedBit);
+        else if (event == ARDUINO_EVENT_WIFI_STA_GOT_IP)
+            xEventGroupSetBits(m_wifiEvents, WiFiGotIpBit);
+        else if (event == ARDUINO_EVENT_WIFI_STA_DISCONNECTED)
+            xEventGroupSetBits(m_wifiEvents, WiFiDisconnectedBit);
+    });
+
+    uint32_t credentialsHash = utils::hash(m_ssid + m_password);
+    bool haveProfile = wifiProfile.valid && wifiProfile.credentialsHash == credentialsHash;
+    if (haveProfile && connectFast())
+        m_usedFastReconnect = true;
+    else
+    {
+        if (haveProfile)
+        {
+            log_d("Fast reconnect failed, connecting normally");
+            WiFi.disconnect();
+            xEventGroupClearBits(m_wifiEvents, WiFiConnectedBit | WiFiGotIpBit | WiFiDisconnectedBit);
+        }
+        wifiProfile.valid = false;
+
+        WiFi.config(INADDR_NONE, INADDR_NONE, INADDR_NONE); // use DHCP
+        WiFi.begin(m_ssid.c_str(), m_password.c_str());
+        if (waitForWiFiEvent(WiFiGotIpBit, constants::WiFiFullConnectTimeoutMillis, false))
+            saveWiFiProfile(credentialsHash);
+    }
+
+    WiFi.removeEvent(eventId);
+    vEventGroupDelete(m_wifiEvents);
+    m_wifiEvents = nullptr;
+}
+
+bool WiFiManager::connectFast()
+{
+    // skip DHCP until the lease has been reused enough times that it should be checked again
+    bool useStaticIp = wifiProfile.uses < constants::WiFiStaticLeaseMaxUses;
+    log_d("Fast reconnect on channel %d, static ip=%d", wifiProfile.channel, useStaticIp);
+
+    if (useStaticIp)
+        WiFi.config(IPAddress(wifiProfile.ip), IPAddress(wifiProfile.gateway), IPAddress(wifiProfile.subnet),
+                    IPAddress(wifiProfile.dns1), IPAddress(wifiProfile.dns2));
+
+    // directed at the access point used last time, so no scan is needed
+    WiFi.begin(m_ssid.c_str(), m_password.c_str(), wifiProfile.channel, wifiProfile.bssid);
+
+    // give up as soon as it disconnects, the access point may have moved channel or gone
+    if (!waitForWiFiEvent(useStaticIp ? WiFiConnectedBit : WiFiGotIpBit, constants::WiFiFastConnectTimeoutMillis, true))
+        return false;
+
+    if (useStaticIp)
+        wifiProfile.uses++;
+    else
+        saveWiFiProfile(wifiProfile.credentialsHash);
+    return true;
+}
+
+bool WiFiManager::waitForWiFiEvent(EventBits_t bits, uint32_t timeoutMillis, bool stopOnDisconnect)
+{
+    // wakes as soon as the event arrives rather than polling the status
+    EventBits_t waitBits = stopOnDisconnect ? (bits | WiFiDisconnectedBit) : bits;
+    EventBits_t result = xEventGroupWaitBits(m_wifiEvents, waitBits, pdFALSE, pdFALSE, pdMS_TO_TICKS(timeoutMillis));
+    return (result & bits) && WiFi.status() == WL_CONNECTED;
+}
+
+void WiFiManager::saveWiFiProfile(uint32_t credentialsHash)
+{
+    wifiProfile.credentialsHash = credentialsHash;
+    memcpy(wifiProfile.bssid, WiFi.BSSID(), sizeof(wifiProfile.bssid));
+    wifiProfile.channel = WiFi.channel();
+    wifiProfile.ip = WiFi.localIP();
+    wifiProfile.gateway = WiFi.gatewayIP();
+    wifiProfile.subnet = WiFi.subnetMask();
+    wifiProfile.dns1 = WiFi.dnsIP(0);
+    wifiProfile.dns2 = WiFi.dnsIP(1);
+    wifiProfile.uses = 0;
+    wifiProfile.valid = true;
+    log_d("Saved WiFi profile: channel %d, ip %s", wifiProfile.channel, WiFi.localIP().toString().c_str());
+}
+
+bool WiFiManager::usedFastReconnect()
+{
+    return m_usedFastReconnect;
+}
+
 void WiFiManager::initConfigMode(const CurrentConfig& cfg, int port)
 {
     log_d("Creating access point for configuration");
@@ -208,35 +355,28 @@ void WiFiManager::resetAdminRequest()
     m_adminRequest = AdminRequest{};
 }
 
+void WiFiManager::setKeepAlive(bool keepAlive)
+{
+    m_keepAlive = keepAlive;
+    if (!keepAlive)
+        closeConnection();
+}
+
 void WiFiManager::disconnect()
 {
+    closeConnection();
     log_d("Disconnecting from WiFi");
     WiFi.disconnect(true);
     WiFi.mode(WIFI_OFF);
 }
 
-bool WiFiManager::getTime(tm& timeinfo, bool waitForNtpSync)
+bool WiFiManager::getTime(tm& timeinfo)
 {
     if(!getLocalTime(&timeinfo))
     {
         log_w("Failed to obtain time");
         return false;
     }
-    if (waitForNtpSync)
-    {
-        // wait until the ntp server has responded
-        uint32_t start = millis();
-        uint32_t end = start + (constants::NtpResyncTimeoutSeconds * 1000);
-        while (sntp_get_sync_status() != SNTP_SYNC_STATUS_COMPLETED && millis() < end)
-            delay(100);
-        if (millis() >= end)
-            log_w("Did not see a requested NTP sync after timeout of %d seconds", constants::NtpResyncTimeoutSeconds);
-        else
-        {
-            log_d("Successfully synced time with NTP");
-            getLocalTime(&timeinfo); // refresh our stored time with the sync
-        }
-    }
 
     return true;
 }
@@ -288,24 +428,14 @@ bool WiFiManager::isCurrentTimeDuringOvernightSleep(int sleepStartHour, int slee
     log_d("The current time is %d:%d:%d", m_timeinfo.tm_hour, m_timeinfo.tm_min, m_timeinfo.tm_sec);
     log_d("The overnight sleep should start at hour %d and last %d hours", sleepStartHour, sleepHoursLength);
 
-    for (int i = 0; i < sleepHoursLength; i++)
-    {
-        int compareHour = i + sleepStartHour; // could be over 23, i.e. 1am would be value of 25
-        if (compareHour >= 24) compareHour -= 24; // turn a value of e.g. 25 -> 1
-        if (compareHour == m_timeinfo.tm_hour)
-        {
-            log_d("The time is within the overnight sleep period");
-            // full hours left during sleep is length - (i+1)
-            // full time between now and end of sleep is that + the minutes left to next hour number
-            int fullHoursToSleepEnd = sleepHoursLength - (i + 1);
-            int minsToNextHour = 60 - m_timeinfo.tm_min;
-            secondsLeftOfSleep = ((fullHoursToSleepEnd*3600) + (minsToNextHour*60)) - m_timeinfo.tm_sec;
-            log_d("The sleep should last another %" PRIu64 " seconds from now", secondsLeftOfSleep);
-            return true;
-        }
-    }
-    log_d("The time is not within the overnight sleep period");
-    return false;
+    bool isDuringSleep = SleepSchedule::isDuringOvernightSleep(m_timeinfo, sleepStartHour, sleepHoursLength, 
+                                                               secondsLeftOfSleep);
+    if (isDuringSleep)
+        log_d("The time is within the overnight sleep period, it should last another %" PRIu64 " seconds from now", 
+              secondsLeftOfSleep);
+    else
+        log_d("The time is not within the overnight sleep period");
+    return isDuringSleep;
 }
 
 String WiFiManager::getDayMonthStr()
@@ -342,122 +472,455 @@ void WiFiManager::addDataSource(RequestBasePtr request)
     m_requests.push_back(std::move(request));
 }
 
-std::map<long, float> WiFiManager::getPriceData(const String& crypto, const String& fiat, std::set<long> unixOffsets)
+bool WiFiManager::getPriceData(const String& crypto, const String& fiat, TimeframeSet timeframes, Quotes& quotes_out)
 {
-    // try and get all data requested from a single data source
-    // if it fails, retry from start with next data source
+    // each price is taken from the first data source that can give it
+    // prices already found are kept, only the ones still missing are requested from the next data source
+    quotes_out.clear();
+    std::vector<TimeframeSet> plan = planRequests(crypto, fiat, timeframes);
+    std::vector<size_t> order = sourceOrder(crypto, fiat, timeframes);
+    // by index in m_requests, the timeframes already scored as failed on each source this wake
+    std::vector<TimeframeSet> scoredFailed(m_requests.size());
+
+    // historical prices come from the history kept on the device when it has them, the network is only
+    // needed to fill it up to the days that are wanted
+    // shorter timeframes such as 1d can only come from the recent samples or a request of their own, filling
+    // the daily history for them would be a request that can't give them
+    PriceHistoryStore store(crypto, fiat);
+    store.load();
+    getStoredPrices(store, timeframes, quotes_out);
+    if (!quotes_out.valid().contains(fromDailySamples(timeframes)))
+    {
+        fillPriceStore(store, crypto, fiat, timeframes, plan, order, scoredFailed);
+        getStoredPrices(store, timeframes, quotes_out);
+    }
 
-    // initialise a map with the required keys
-    std::map<long, float> successRtn;
-    for (const auto &i : unixOffsets)
+    // prices a source has been failing to give are skipped while it cools down, and only tried once
+    // every other source has been
+    std::vector<TimeframeSet> skipped(m_requests.size());
+    for (size_t i : order)
     {
-        successRtn[i];
+        const auto& request = m_requests[i];
+        TimeframeSet missing;
+        for (Timeframe timeframe : plan[i].without(quotes_out.valid()))
+        {
+            if (SourceScoreboard::isCoolingDown(request->getSourceId(), crypto, fiat, timeframeSeconds(timeframe)))
+                skipped[i].insert(timeframe);
+            else
+                missing.insert(timeframe);
+        }
+        getPricesFromSource(crypto, fiat, missing, quotes_out, request, scoredFailed[i]);
     }
 
-    for (const auto& request : m_requests)
+    for (size_t i : order)
     {
-        log_d("Starting requests for symbol=%s fiat=%s using source %s", crypto.c_str(), fiat.c_str(), request->getServer().c_str());
-        // for each data source, try and get price for each given unix offset
-        // if one fails, move on to next data source
+        TimeframeSet missing = skipped[i].without(quotes_out.valid());
+        if (!missing.empty())
+            log_d("No other source had %d prices, trying source %s while cooling down", missing.size(), m_requests[i]->getServer().c_str());
+        getPricesFromSource(crypto, fiat, missing, quotes_out, m_requests[i], scoredFailed[i]);
+    }
+
+    // kept for offsets too short for the daily prices on later wakes
+    if (quotes_out.has(Timeframe::NOW))
+        store.addCurrentPrice(m_epoch, quotes_out[Timeframe::NOW].price);
 
-        // make sure this crypto/fiat is allowed for the data source
-        if (!request->isValidRequest(crypto, fiat))
+    TimeframeSet found = quotes_out.valid();
+    if (!found.contains(timeframes))
+    {
+        // if we get here then some price was missing from every data source
+        log_d("Got %d of %d prices from all data sources", found.size(), timeframes.size());
+        return false;
+    }
+
+    for (Timeframe timeframe : timeframes)
+        log_d("Price with unix offset %ld came from source %d", timeframeSeconds(timeframe), (int)quotes_out[timeframe].source);
+    return true;
+}
+
+std::vector<size_t> WiFiManager::sourceOrder(const String& crypto, const String& fiat, TimeframeSet timeframes)
+{
+    // best first by how they did for these prices on earlier wakes, keeping the default order between sources that
+    // did as well as each other
+    std::vector<size_t> order(m_requests.size());
+    std::vector<float> scores(m_requests.size());
+    for (size_t i = 0; i < m_requests.size(); i++)
+    {
+        order[i] = i;
+        scores[i] = SourceScoreboard::sourceScore(m_requests[i]->getSourceId(), crypto, fiat, timeframes);
+    }
+    std::stable_sort(order.begin(), order.end(), [&scores](size_t a, size_t b) { return scores[a] > scores[b]; });
+    return order;
+}
+
+std::vector<TimeframeSet> WiFiManager::planRequests(const String& crypto, const String& fiat, TimeframeSet timeframes)
+{
+    // every request that can't succeed would cost a whole TLS handshake and response, so each source is only
+    // ever asked for the prices its capabilities say it has
+    std::vector<TimeframeSet> plan(m_requests.size());
+    TimeframeSet possible;
+    for (size_t i = 0; i < m_requests.size(); i++)
+    {
+        plan[i] = m_requests[i]->possibleTimeframes(crypto, fiat, m_epoch, timeframes);
+        possible = possible.with(plan[i]);
+        if (plan[i] != timeframes)
+            log_d("Source %s can give %d of %d prices for %s/%s", m_requests[i]->getServer().c_str(), plan[i].size(),
+                  timeframes.size(), crypto.c_str(), fiat.c_str());
+    }
+
+    TimeframeSet impossible = timeframes.without(possible);
+    if (!impossible.empty())
+        log_w("No data source can give %d of the prices for %s/%s", impossible.size(), crypto.c_str(), fiat.c_str());
+    return plan;
+}
+
+void WiFiManager::getStoredPrices(const PriceHistoryStore& store, TimeframeSet timeframes, Quotes& quotes_out)
+{
+    for (Timeframe timeframe : timeframes)
+    {
+        long offset = timeframeSeconds(timeframe);
+        Price price;
+        uint32_t sampleUnix = 0;
+        if (offset == 0 || quotes_out.has(timeframe))
+            continue;
+        // same closeness needed as for a sample from a history request
+        if (store.priceAt(m_epoch - offset, offset / constants::PriceHistoryMaxSampleErrorDivisor, price, &sampleUnix))
         {
-            log_d("Crypto/fiat combo is not valid for this data source, moving on");
+            log_d("Price with unix offset %d is %f from the stored history", offset, price.toDouble());
+            quotes_out.set(timeframe, price, sampleUnix, SourceId::STORE);
+        }
+    }
+}
+
+void WiFiManager::fillPriceStore(PriceHistoryStore& store, const String& crypto, const String& fiat,
+                                 TimeframeSet timeframes, const std::vector<TimeframeSet>& plan,
+                                 const std::vector<size_t>& order, std::vector<TimeframeSet>& scoredFailed)
+{
+    // one history request from the earliest day needed up until now, usually just the days since the last wake
+    uint32_t startUnix = 0;
+    TimeframeSet needed;
+    for (Timeframe timeframe : fromDailySamples(timeframes))
+    {
+        uint32_t from = store.fillFrom(m_epoch, m_epoch - timeframeSeconds(timeframe));
+        if (from == 0)
             continue;
-        } 
+        needed.insert(timeframe);
+        if (startUnix == 0 || from < startUnix)
+            startUnix = from;
+    }
+    if (needed.empty())
+        return;
 
-        bool fullSuccess = false;
-        for (auto& [key, value] : successRtn)
+    // sources are tried in the same order as for the prices themselves, one that is cooling down for every price
+    // it would fill only once every other source has been
+    // a source has to reach back to the oldest of them, as it would for a history request of the prices
+    std::vector<TimeframeSet> wanted(m_requests.size());
+    std::vector<size_t> fillOrder;
+    std::vector<size_t> coolingDown;
+    for (size_t i : order)
+    {
+        for (Timeframe timeframe : needed)
         {
-            bool iSuccess = false;
-            int retries = 0;
-            // try to get price with retry
-            while (!iSuccess && retries < 2)
+            if (plan[i].has(timeframe))
+                wanted[i].insert(timeframe);
+        }
+        if (wanted[i].empty() || !m_requests[i]->canRequestHistory(timeframeSeconds(wanted[i].longest())))
+            continue;
+
+        bool cooling = true;
+        for (Timeframe timeframe : wanted[i])
+            cooling &= SourceScoreboard::isCoolingDown(m_requests[i]->getSourceId(), crypto, fiat, timeframeSeconds(timeframe));
+        (cooling ? coolingDown : fillOrder).push_back(i);
+    }
+    fillOrder.insert(fillOrder.end(), coolingDown.begin(), coolingDown.end());
+
+    for (size_t i : fillOrder)
+    {
+        const auto& request = m_requests[i];
+        // days from before what the source serves are left out, the prices they are for have their own requests
+        uint32_t from = startUnix;
+        uint32_t maxOffset = request->maxHistoryOffset();
+        if (maxOffset != 0 && m_epoch - from > maxOffset)
+            from = m_epoch - maxOffset;
+
+        log_d("Filling stored price history from %d using source %s", from, request->getServer().c_str());
+        String url = request->urlPriceHistory(m_epoch, m_epoch - from, crypto, fiat);
+        bool success = false;
+        int retries = 0;
+        uint32_t latency = 0;
+        while (shouldRetry(success, retries))
+        {
+            uint32_t start = millis();
+            success = requestUrl(request->getServer(), url, [&](Stream& content)
             {
-                log_d("Requesting price with unix offset %d", key);
-                iSuccess = getPriceAtTime(crypto, fiat, key, value, request); // sets the value in successRtn for its unix offset
-                retries++;
-            }
-            
-            if (!iSuccess)
+                return request->priceHistory(content, [&](uint32_t sampleUnix, const Price& price)
+                {
+                    store.addHistorySample(sampleUnix, price);
+                });
+            });
+            latency = millis() - start;
+            retries++;
+        }
+        closeConnection();
+
+        for (Timeframe timeframe : wanted[i])
+            recordResult(request->getSourceId(), crypto, fiat, timeframe, success, latency, scoredFailed[i]);
+        if (success)
+            break;
+    }
+
+    log_d("Stored price history has %d days", store.numDailySamples());
+    store.save();
+}
+
+void WiFiManager::getPricesFromSource(const String& crypto, const String& fiat, TimeframeSet timeframes,
+                                      Quotes& quotes_out, const RequestBasePtr& request, TimeframeSet& scoredFailed)
+{
+    if (timeframes.empty())
+        return;
+
+    SourceId sourceId = request->getSourceId();
+    log_d("Requesting %d prices for symbol=%s fiat=%s using source %s", 
+          timeframes.size(), crypto.c_str(), fiat.c_str(), request->getServer().c_str());
+
+    // with several historical prices needed, get as many as possible from one history request
+    // any it couldn't give a close enough price for are requested individually below
+    TimeframeSet historyTimeframes = timeframes.without({Timeframe::NOW});
+    bool sourceResponded = false;
+    if (historyTimeframes.size() >= constants::PriceHistoryMinOffsets &&
+        request->canRequestHistory(timeframeSeconds(historyTimeframes.longest())))
+    {
+        bool historySuccess = false;
+        int retries = 0;
+        uint32_t latency = 0;
+        while (shouldRetry(historySuccess, retries))
+        {
+            log_d("Requesting price history for %d offsets", historyTimeframes.size());
+            uint32_t start = millis();
+            historySuccess = getPricesAtTimes(crypto, fiat, historyTimeframes, quotes_out, request);
+            latency = millis() - start;
+            retries++;
+        }
+
+        // offsets the history didn't have a close enough sample for are scored by their own request
+        for (Timeframe timeframe : historyTimeframes)
+        {
+            if (!historySuccess || quotes_out.has(timeframe))
+                recordResult(sourceId, crypto, fiat, timeframe, historySuccess, latency, scoredFailed);
+        }
+
+        sourceResponded = historySuccess;
+        timeframes = timeframes.without(quotes_out.valid());
+    }
+
+    for (Timeframe timeframe : timeframes)
+    {
+        long offset = timeframeSeconds(timeframe);
+        Price price;
+        bool success = false;
+        int retries = 0;
+        uint32_t latency = 0;
+        // try to get price with retry
+        while (shouldRetry(success, retries))
+        {
+            log_d("Requesting price with unix offset %d", offset);
+            uint32_t start = millis();
+            success = getPriceAtTime(crypto, fiat, offset, price, request);
+            latency = millis() - start;
+            retries++;
+        }
+        recordResult(sourceId, crypto, fiat, timeframe, success, latency, scoredFailed);
+
+        if (success)
+        {
+            quotes_out.set(timeframe, price, m_epoch - offset, sourceId);
+            sourceResponded = true;
+        }
+        else if (!sourceResponded)
+        {
+            // nothing has worked from this source yet so it is probably down, don't spend retries on the rest
+            log_d("Request failed, will try next data source");
+            break;
+        }
+        else
+            log_d("Request failed, will try next data source for this offset");
+    }
+    // finished with this source, don't leave its connection open while using the next one
+    closeConnection();
+}
+
+std::map<String, Price> WiFiManager::getCurrentPrices(const std::vector<String>& cryptos, const String& fiat)
+{
+    // ask each data source for all the prices still missing at once, only moving on to the next
+    // source for any it doesn't have
+    std::map<String, Price> prices;
+    for (const auto& request : m_requests)
+    {
+        // a source that can't give several at once would need a request for each, leave them to the next one
+        if (!request->capabilities().batchCurrentPrices)
+            continue;
+
+        std::vector<String> missing;
+        for (const auto& crypto : cryptos)
+        {
+            if (!prices.count(crypto) && request->possibleTimeframes(crypto, fiat, m_epoch, {Timeframe::NOW}).has(Timeframe::NOW))
+                missing.push_back(crypto);
+        }
+        if (missing.empty())
+            continue;
+
+        log_d("Requesting %d current prices using source %s", missing.size(), request->getServer().c_str());
+        String url = request->urlCurrentPrices(missing, fiat);
+        bool success = false;
+        int retries = 0;
+        while (shouldRetry(success, retries))
+        {
+            success = requestUrl(request->getServer(), url, [&](Stream& content)
             {
-                log_d("Request failed, will try next data source");
-                fullSuccess = false;
-                break;
-            }
-            fullSuccess = true;
-                
+                return request->currentPrices(content, missing, fiat, prices);
+            });
+            retries++;
         }
-        // if fullSuccess = true here then we have all price data from a single source successfully
-        if (fullSuccess)
-            return successRtn;
-        // else we carry on to next data source 
+        closeConnection();
+
+        if (prices.size() == cryptos.size())
+            break;
     }
-    // if we get here then we never got all data from a single data source, return empty map
-    return std::map<long, float>();
+
+    log_d("Got current prices for %d of %d cryptos", prices.size(), cryptos.size());
+    return prices;
 }
 
 bool WiFiManager::getPriceAtTime(const String& crypto, const String& fiat, time_t unixOffset, 
-                                 float& priceAtTime_out, const RequestBasePtr& request)
+                                 Price& priceAtTime_out, const RequestBasePtr& request)
 {        
     if (unixOffset == 0)
     {
         String url = request->urlCurrentPrice(crypto, fiat);
-        return request->currentPrice(getUrlContent(request->getServer(), url), crypto, fiat, priceAtTime_out);
+        return requestUrl(request->getServer(), url, [&](Stream& content)
+        {
+            return request->currentPrice(content, crypto, fiat, priceAtTime_out);
+        });
     }
 
     String url = request->urlPriceAtTime(m_epoch, unixOffset, crypto, fiat);
-    return request->priceAtTime(getUrlContent(request->getServer(), url), priceAtTime_out);
+    return requestUrl(request->getServer(), url, [&](Stream& content)
+    {
+        return request->priceAtTime(content, priceAtTime_out);
+    });
 }
 
-String WiFiManager::getUrlContent(const String& server, const String& url)
+bool WiFiManager::getPricesAtTimes(const String& crypto, const String& fiat, TimeframeSet timeframes, Quotes& quotes_out,
+                                   const RequestBasePtr& request)
 {
-    // check WL_CONNECTED as well as some time may have passed since initial connection 
-    if (m_status != WiFiStatus::OK || WiFi.status() != WL_CONNECTED) 
-        return "";
+    String url = request->urlPriceHistory(m_epoch, timeframeSeconds(timeframes.longest()), crypto, fiat);
+    return requestUrl(request->getServer(), url, [&](Stream& content)
+    {
+        return request->pricesAtTimes(content, m_epoch, timeframes, quotes_out);
+    });
+}
 
-    String content;
+bool WiFiManager::connectToServer(const String& server)
+{
+    // an open connection from an earlier request to the same server can be used again
+    if (m_keepAlive && m_connectedServer == server && m_client.connected())
+    {
+        log_d("Reusing connection to %s", server.c_str());
+        return true;
+    }
 
-    log_d("Starting connection to server with url %s", url.c_str());
-    m_client.setInsecure(); //skip verification - binance only accepts https but we don't need it secure
+    closeConnection();
 
+    log_d("Starting connection to server %s", server.c_str());
+    // m_client skips verification - binance only accepts https but we don't need it secure
+    // it will resume the TLS session from the last wake if the server still accepts it
     if (!m_client.connect(server.c_str(), 443))
-        log_w("Connection failed");
-    else 
     {
-        log_d("Connected to server, sending HTTP request");
-        // Make a HTTP request:
-        m_client.println("GET " + url + " HTTP/1.0");
-        m_client.println("Host: " + server);
-        m_client.println("Connection: close");
-        m_client.println();
+        log_w("Connection failed");
+        return false;
+    }
+
+    m_connectedServer = server;
+    return true;
+}
+
+void WiFiManager::closeConnection()
+{
+    if (!m_connectedServer.isEmpty())
+        log_d("Closing connection to %s", m_connectedServer.c_str());
+    m_client.stop();
+    m_connectedServer = "";
+}
 
-        while (m_client.connected()) 
+bool WiFiManager::requestUrl(const String& server, const String& url, const ContentParser& parse)
+{
+    m_rateLimited = false;
+    // check WL_CONNECTED as well as some time may have passed since initial connection 
+    if (m_status != WiFiStatus::OK || WiFi.status() != WL_CONNECTED) 
+        return false;
+
+    // a reused connection may have been closed by the server while idle, which only shows up once we
+    // try to use it, so allow one attempt on a fresh connection after that
+    for (int attempt = 0; attempt < 2; attempt++)
+    {
+        bool reusing = m_keepAlive && m_connectedServer == server && m_client.connected();
+        if (!connectToServer(server))
+            return false;
+
+        log_d("Sending HTTP request with url %s", url.c_str());
+        // build the whole request first so it goes out in a single TLS record
+        String httpRequest;
+        httpRequest.reserve(url.length() + server.length() + 64);
+        httpRequest += "GET ";
+        httpRequest += url;
+        httpRequest += " HTTP/1.1\r\nHost: ";
+        httpRequest += server;
+        httpRequest += m_keepAlive ? "\r\nConnection: keep-alive\r\n\r\n" : "\r\nConnection: close\r\n\r\n";
+        PhaseTimer firstByteTimer(WakePhase::FIRST_BYTE);
+        m_client.print(httpRequest);
+
+        HttpBodyStream body(m_client);
+        body.setTimeout(constants::HttpReadTimeoutMillis); // max wait for each byte while parsing
+        bool gotHeaders = body.readHeaders();
+        firstByteTimer.stop();
+        if (!gotHeaders)
         {
-            String line = m_client.readStringUntil('\n');
-            if (line == "\r") 
-            {
-                log_d("Headers received");
-                break;
-            }
+            closeConnection();
+            if (reusing)
+                continue;
+            return false;
         }
 
-        if (m_client.available())
+        // an error such as a 429 or 5xx is never given to the parser, its body is only read past below so the
+        // connection can still be used
+        bool success = false;
+        int status = body.statusCode();
+        m_rateLimited = status == 429;
+        if (status >= 200 && status < 300)
         {
-            while (m_client.available())
-            {
-                char c = m_client.read();
-                content.concat(c);
-            }
-            log_d("Received content");
-            return content;
+            // the body is parsed as it arrives, it is never held in memory as a whole
+            uint32_t start = millis();
+            success = parse(body);
+            WakeTimer::record(WakePhase::PARSE, millis() - start);
+            log_d("Parsed content in %d ms, success=%d", millis() - start, success);
         }
+        else
+            log_w("Request to %s failed with status %d", server.c_str(), status);
+
+        // whatever the parser didn't need has to be read past before the connection can be used again, which
+        // is only possible if the response ends where the server said it would
+        if (!m_keepAlive || !body.keepAlive() || !body.skipRemaining())
+            closeConnection();
 
-        m_client.stop();
+        return success;
     }
 
-    return "";
+    return false;
+}
+
+bool WiFiManager::shouldRetry(bool success, int attempts) const
+{
+    // a source that answered 429 would only refuse a request sent again straight away
+    return !success && attempts < constants::WiFiRequestRetries && !(attempts > 0 && m_rateLimited);
 }
 
 String WiFiManager::generateConfigJs(const CurrentConfig& cfg)
@@ -486,6 +949,13 @@ String WiFiManager::generateConfigJs(const CurrentConfig& cfg)
     configJs += cfg.overnightSleepLength;
     configJs += "\", simpleBattery: \"";
     configJs += cfg.showSimpleBattery;
+    configJs += "\", watchlist: \"";
+    for (size_t i = 0; i < cfg.watchlist.size(); i++)
+    {
+        if (i > 0)
+            configJs += ",";
+        configJs += cfg.watchlist[i];
+    }
     configJs += "\"};";
 
     // var wifis = ["WiFi 1","WiFi 2"];
@@ -498,6 +968,17 @@ String WiFiManager::generateConfigJs(const CurrentConfig& cfg)
     }
     configJs += "];";
 
+    // the cryptos the page offers come from the same catalog the data sources look them up in
+    // var cryptos = ["BTC","ETH"];
+    configJs += "var cryptos = [";
+    for (const CryptoSymbol* entry = SymbolCatalog::begin(); entry != SymbolCatalog::end(); entry++)
+    {
+        configJs += "\"";
+        configJs += entry->symbol;
+        configJs += "\",";
+    }
+    configJs += "];";
+
     configJs += "var deviceIdText = \"Device ID: ";
     configJs += utils::getDeviceID();
     configJs += "\";";
@@ -2,14 +2,17 @@
 #define WIFIMANAGER_H
 
 #include <Arduino.h>
-#include <WiFiClientSecure.h>
+#include <WiFi.h>
 #include <ESPAsyncWebServer.h>
 #include <AsyncTCP.h>
 #include "time.h"
 #include "Utils.h"
 
 #include "RequestBase.h"
+#include "TlsClient.h"
+#include "PriceHistoryStore.h"
 
+#include <functional>
 #include <memory>
 #include <map>
 #include <set>
@@ -50,9 +53,15 @@ public:
     void initConfigMode(const CurrentConfig& cfg, int port); // configures access point
     WiFiStatus initNormalMode(const CurrentConfig& cfg, bool waitForNtpSync = false, bool initAllDataSources = true); // connects to known network
 
-    // input set of unix offsets to get data for
-    // return map of unix offsets to price, or empty map if failed
-    std::map<long, float> getPriceData(const String& crypto, const String& fiat, std::set<long> unixOffsets);
+    // input set of timeframes to get data for
+    // quotes_out is given the price of each, with the data source and time of the sample it came from, as
+    // prices can come from different data sources
+    // returns false if any of the timeframes had no price, those found are still in quotes_out
+    bool getPriceData(const String& crypto, const String& fiat, TimeframeSet timeframes, Quotes& quotes_out);
+
+    // current prices of several cryptos, requested together in one request per data source
+    // return map of crypto to price, any that no data source had are left out
+    std::map<String, Price> getCurrentPrices(const std::vector<String>& cryptos, const String& fiat);
 
     String getDayMonthStr();
     String getTimeStr();
@@ -60,11 +69,18 @@ public:
     bool isCurrentTimeDuringOvernightSleep(int sleepStartHour, int sleepHoursLength, uint64_t& secondsLeftOfSleep);
     void refreshTime();
 
+    // whether the last initNormalMode connected using the network details saved by a previous wake
+    bool usedFastReconnect();
+
     String getSsid();
     String getAPIP();
 
     void disconnect();
 
+    // keep the connection to a data source open between requests, on by default
+    // it is closed when moving to the next data source or disconnecting
+    void setKeepAlive(bool keepAlive);
+
     void addDataSource(RequestBasePtr request);
 
     void setTimeInfo(int h, int m, int s);
@@ -73,11 +89,37 @@ public:
     void resetAdminRequest();
 
 private:
-    String getUrlContent(const String& server, const String& url);
+    // reads the body of the response as it arrives, returns whether the content was parsed successfully
+    using ContentParser = std::function<bool(Stream& content)>;
+    // returns false without parsing anything if the response isn't a 2xx
+    bool requestUrl(const String& server, const String& url, const ContentParser& parse);
+    // whether to send a request again after attempts tries, the last of them with this result
+    bool shouldRetry(bool success, int attempts) const;
+    bool connectToServer(const String& server);
+    void closeConnection();
     void initAllAvailableDataSources();
 
-    bool getPriceAtTime(const String& crypto, const String& fiat, time_t unixOffset, float& priceAtTime_out, const RequestBasePtr& request);
-    bool getTime(tm& timeinfo, bool waitForNtpSync = false);
+    void connectToNetwork();
+    bool connectFast();
+    bool waitForWiFiEvent(EventBits_t bits, uint32_t timeoutMillis, bool stopOnDisconnect);
+    void saveWiFiProfile(uint32_t credentialsHash);
+
+    // the timeframes each data source, by index in m_requests, is to be asked for, worked out from what each can
+    // give before any connection is made
+    std::vector<TimeframeSet> planRequests(const String& crypto, const String& fiat, TimeframeSet timeframes);
+    // indexes in m_requests in the order to try the sources for the prices of these timeframes
+    std::vector<size_t> sourceOrder(const String& crypto, const String& fiat, TimeframeSet timeframes);
+    void getStoredPrices(const PriceHistoryStore& store, TimeframeSet timeframes, Quotes& quotes_out);
+    // scoredFailed is by index in m_requests, the timeframes already scored as failed on each source this wake
+    void fillPriceStore(PriceHistoryStore& store, const String& crypto, const String& fiat, TimeframeSet timeframes,
+                        const std::vector<TimeframeSet>& plan, const std::vector<size_t>& order,
+                        std::vector<TimeframeSet>& scoredFailed);
+    void getPricesFromSource(const String& crypto, const String& fiat, TimeframeSet timeframes, Quotes& quotes_out,
+                             const RequestBasePtr& request, TimeframeSet& scoredFailed);
+    bool getPriceAtTime(const String& crypto, const String& fiat, time_t unixOffset, Price& priceAtTime_out, const RequestBasePtr& request);
+    bool getPricesAtTimes(const String& crypto, const String& fiat, TimeframeSet timeframes, Quotes& quotes_out,
+                          const RequestBasePtr& request);
+    bool getTime(tm& timeinfo);
     void setTimeVars(tm& timeinfo);
     String generateConfigJs(const CurrentConfig& cfg);
 
@@ -87,6 +129,8 @@ private:
     String m_password;
     std::vector<RequestBasePtr> m_requests;
     bool m_isAccessPoint = false;
+    bool m_usedFastReconnect = false;
+    EventGroupHandle_t m_wifiEvents = nullptr; // set by WiFi events while connecting
     std::set<String> m_scannedSsids;
 
     String m_dayMonth = "Error"; // e.g. "12 Oct"
@@ -95,7 +139,10 @@ private:
     bool m_is24Hour = true;
     struct tm m_timeinfo{};
 
-    WiFiClientSecure m_client;
+    TlsClient m_client;
+    String m_connectedServer; // server m_client is connected to, empty if none
+    bool m_keepAlive = true;
+    bool m_rateLimited = false; // the last request was answered with 429
     std::unique_ptr<AsyncWebServer> m_server;
 
     AdminRequest m_adminRequest;
@@ -1,5 +1,7 @@
 #include "TickerCoordinator.h"
 #include "Constants.h"
+#include "WakeTimer.h"
+#include "SleepSchedule.h"
 
 #include "SPIFFS.h"
 
@@ -10,11 +12,13 @@ TickerCoordinator::TickerCoordinator(const TickerInput& input) :
     m_numDataFailures(input.numConsecutiveDataFails),
     m_bootCount(input.bootCount),
     m_waitForNtpSync(input.waitForNtpSync),
+    m_watchlistPage(input.watchlistPage),
     m_alertTimer(input.alert_timer)
 {
     log_d("Created TickerCoordinator with input: batPercent=%d, shouldEnterConfig=%d, WifiFails=%d, DataFails=%d, "
-          "bootCount=%d, waitForNtpSync=%d", 
-           m_batPct, m_shouldEnterConfig, m_numWifiFailures, m_numDataFailures, m_bootCount, m_waitForNtpSync);
+          "bootCount=%d, waitForNtpSync=%d, watchlistPage=%d", 
+           m_batPct, m_shouldEnterConfig, m_numWifiFailures, m_numDataFailures, m_bootCount, m_waitForNtpSync,
+           m_watchlistPage);
 }
 
 TickerOutput TickerCoordinator::run()
@@ -65,7 +69,9 @@ TickerOutput TickerCoordinator::run()
     log_d("battery is ok, removing log file if it exists");
     SPIFFS.remove(constants::SpiffsBatLogFileName);
 
+    PhaseTimer configTimer(WakePhase::CONFIG_READ);
     utils::ConfigState cfgState = utils::readConfig(m_cfg);
+    configTimer.stop();
 
     if (m_shouldEnterConfig)
     {
@@ -97,43 +103,30 @@ TickerOutput TickerCoordinator::run()
 
     m_wifiManager.disconnect();
 
-    if (m_wifiStatus != WiFiStatus::OK)
+    // the battery simulator makes the same decisions through SleepSchedule
+    WakeOutcome outcome{m_refreshSeconds, m_wifiStatus != WiFiStatus::OK, m_dataFailed, m_secondsLeftOfSleep};
+    switch (SleepSchedule::finishWake(m_numWifiFailures, m_numDataFailures, m_bootCount, outcome))
     {
-        if (m_numWifiFailures > 0 || m_bootCount == 1) // don't draw on first fail, sleep smallest time and try again first
-                                                       // unless first boot, then do draw it
-        {
+        case EndOfWakeScreen::WIFI_FAILURE:
             if (m_wifiStatus == WiFiStatus::NO_CONNECTION)
                 m_displayManager.drawCannotConnectToWifi(m_cfg.ssid, m_cfg.pass);
             else if (m_wifiStatus == WiFiStatus::NO_INTERNET)
                 m_displayManager.drawWifiHasNoInternet();
-        }
-        m_numWifiFailures++;
-        log_d("Consecutive WiFi connection failure number %d", m_numWifiFailures);
-        int failLevel = min(m_numWifiFailures, constants::SleepSecondsAfterWiFiFailLevels);
-        m_refreshSeconds = constants::SleepSecondsAfterWiFiFail[failLevel-1];
-        log_d("Set sleep time to %d", m_refreshSeconds);
-    }
-    else if (m_dataFailed) // wifi fail takes priority so this is only if wifi was ok
-    {
-        if (m_numDataFailures > 0 || m_bootCount == 1) // don't draw on first fail, sleep smallest time and try again first
-                                                       // unless first boot, then do draw it
+            break;
+        case EndOfWakeScreen::DATA_FAILURE:
             m_displayManager.drawYesWifiNoCrypto(m_wifiManager.getDayMonthStr(), m_wifiManager.getTimeStr());
-
-        m_numDataFailures++;
-        log_d("Consecutive data retrieval failure number %d", m_numDataFailures);
-        int failLevel = min(m_numDataFailures, constants::SleepSecondsAfterDataFailLevels);
-        m_refreshSeconds = constants::SleepSecondsAfterDataFail[failLevel-1];
-        log_d("Set sleep time to %d", m_refreshSeconds);
-    }
-    else if (m_secondsLeftOfSleep > 0) // we should be in overnight sleep with this many seconds left
-    {
-        log_d("Should be in overnight sleep - updating display");
-        m_displayManager.drawOvernightSleep();
+            break;
+        case EndOfWakeScreen::OVERNIGHT_SLEEP:
+            m_displayManager.drawOvernightSleep();
+            break;
+        case EndOfWakeScreen::NONE:
+        default:
+            break;
     }
 
     m_displayManager.hibernate();
 
-    TickerOutput output{m_refreshSeconds, m_wifiStatus != WiFiStatus::OK, m_dataFailed, m_secondsLeftOfSleep};
+    TickerOutput output{outcome.refreshSeconds, outcome.wifiFailed, outcome.dataFailed, m_secondsLeftOfSleep, m_watchlistPage};
     return output;
 }
 
@@ -141,6 +134,8 @@ void TickerCoordinator::enterConfigMode()
 {
     timerAlarmWrite(m_alertTimer, constants::ConfigAlertTimeSeconds * constants::MicrosToSecondsFactor, true);
     timerAlarmEnable(m_alertTimer);
+    // the access point has to keep running while the display refreshes
+    m_displayManager.setLightSleepWhileBusy(false);
     log_d("Creating access point for config");
     m_wifiManager.initConfigMode(m_cfg, 80);
     m_displayManager.drawAccessPoint(m_wifiManager.getAPIP());
@@ -188,14 +183,8 @@ void TickerCoordinator::enterNormalMode()
 {
     timerAlarmWrite(m_alertTimer, constants::NormalAlertTimeSeconds * constants::MicrosToSecondsFactor, true);
     timerAlarmEnable(m_alertTimer);
-    m_refreshSeconds = m_cfg.refreshMins.toInt() * 60;
-
-    // in case of some kind of error - don't want this null
-    if (m_refreshSeconds < 60)
-    {
-        m_refreshSeconds = 300;
-        m_cfg.refreshMins = String(m_refreshSeconds);
-    }
+    m_refreshSeconds = SleepSchedule::refreshSeconds(m_cfg.refreshMins);
+    m_cfg.refreshMins = String(m_refreshSeconds / 60); // in case it wasn't valid
 
     log_d("Using config: ssid=%s, pass=%s, crypto=%s, fiat=%s, refresh mins=%s, timezone=%s, is24Hour=%d", 
            m_cfg.ssid, m_cfg.pass, m_cfg.crypto, m_cfg.fiat, m_cfg.refreshMins, m_cfg.tz.c_str(), m_cfg.is24Hour);
@@ -209,6 +198,9 @@ void TickerCoordinator::enterNormalMode()
     if (m_wifiStatus != WiFiStatus::OK)
         return;
 
+    // the display is drawn on nearly every wake that gets this far, so bring it up while the requests are made
+    m_displayManager.initInBackground();
+
     // check if we are supposed to be on an overnight sleep now that we have the time
     if (m_cfg.overnightSleepStart >= 0)
     {
@@ -219,13 +211,16 @@ void TickerCoordinator::enterNormalMode()
             return;
     }
 
-    std::set<long> unixOffsets;
-    if (m_cfg.displayMode == constants::ConfigDisplayModeSimple)
-        unixOffsets = {0, constants::SecondsOneDay};
-    else
-        unixOffsets = {0, constants::SecondsOneDay, constants::SecondsOneMonth, constants::SecondsOneYear};
-    
-    std::map<long, float> priceData = m_wifiManager.getPriceData(m_cfg.crypto, m_cfg.fiat, unixOffsets);
+    if (m_cfg.watchlist.size() > 1)
+    {
+        showWatchlist();
+        return;
+    }
+
+    TimeframeSet timeframes = m_cfg.displayMode == constants::ConfigDisplayModeSimple ? SimpleLayoutTimeframes
+                                                                                     : AdvancedLayoutTimeframes;
+    Quotes quotes;
+    bool gotPrices = m_wifiManager.getPriceData(m_cfg.crypto, m_cfg.fiat, timeframes, quotes);
     
     // can turn wifi off now - saves some power while updating display
     m_wifiManager.disconnect();
@@ -235,9 +230,9 @@ void TickerCoordinator::enterNormalMode()
     bool shouldDisplayBattery = (m_cfg.showSimpleBattery && m_cfg.displayMode == constants::ConfigDisplayModeSimple) ||
                                 m_cfg.displayMode == constants::ConfigDisplayModeAdvanced;
 
-    if (!priceData.empty())
+    if (gotPrices)
     {
-        m_displayManager.writeDisplay(m_cfg.crypto, m_cfg.fiat, priceData, 
+        m_displayManager.writeDisplay(m_cfg.crypto, m_cfg.fiat, quotes, 
                                       m_wifiManager.getDayMonthStr(), m_wifiManager.getTimeStr(), 
                                       shouldDisplayBattery ? m_batPct : 0);
     }
@@ -252,3 +247,32 @@ void TickerCoordinator::enterNormalMode()
     log_i("Normal mode is complete");
 }
 
+void TickerCoordinator::showWatchlist()
+{
+    // one page of the watchlist is shown each wake, moving on to the next page for the next wake
+    int numPages = (m_cfg.watchlist.size() + constants::WatchlistSymbolsPerPage - 1) / constants::WatchlistSymbolsPerPage;
+    int page = m_watchlistPage % numPages;
+    auto pageStart = m_cfg.watchlist.begin() + (page * constants::WatchlistSymbolsPerPage);
+    auto pageEnd = m_cfg.watchlist.end() - pageStart > constants::WatchlistSymbolsPerPage ? 
+                   pageStart + constants::WatchlistSymbolsPerPage : m_cfg.watchlist.end();
+    std::vector<String> cryptos(pageStart, pageEnd);
+    log_d("Showing watchlist page %d of %d with %d cryptos", page + 1, numPages, cryptos.size());
+
+    std::map<String, Price> prices = m_wifiManager.getCurrentPrices(cryptos, m_cfg.fiat);
+
+    m_wifiManager.disconnect();
+    m_wifiManager.refreshTime();
+
+    if (prices.empty())
+    {
+        log_d("Could not get any watchlist prices");
+        m_dataFailed = true;
+        return; // try the same page again next time
+    }
+
+    m_displayManager.writeWatchlist(cryptos, m_cfg.fiat, prices, page, numPages, 
+                                    m_wifiManager.getDayMonthStr(), m_wifiManager.getTimeStr());
+    m_watchlistPage = (page + 1) % numPages;
+
+    log_i("Normal mode is complete");
+}
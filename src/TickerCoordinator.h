@@ -16,6 +16,7 @@ struct TickerInput
     int numConsecutiveDataFails;
     int bootCount;
     bool waitForNtpSync;
+    int watchlistPage;
     hw_timer_t *alert_timer;
 };
 
@@ -25,6 +26,7 @@ struct TickerOutput
     bool wifiFailed;
     bool dataFailed;
     uint64_t secondsLeftOfSleep;
+    int watchlistPage; // page of the watchlist to show next wake
 };
 
 class TickerCoordinator
@@ -48,6 +50,7 @@ private:
     bool m_dataFailed = false; // default false as don't want to mark it failed if wifi failed
     int m_bootCount;
     bool m_waitForNtpSync;
+    int m_watchlistPage;
 
     uint64_t m_secondsLeftOfSleep = 0;
 
@@ -55,6 +58,7 @@ private:
 
     void enterConfigMode();
     void enterNormalMode();
+    void showWatchlist();
 };
 
 
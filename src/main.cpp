@@ -2,6 +2,8 @@
 #include "Constants.h"
 
 #include "TickerCoordinator.h"
+#include "SleepSchedule.h"
+#include "WakeTimer.h"
 
 #include "esp_sntp.h"
 
@@ -10,12 +12,10 @@
 SET_LOOP_TASK_STACK_SIZE(16*1024);
 
 RTC_DATA_ATTR int bootCount = 0;
-RTC_DATA_ATTR int wifiFails = 0;
-RTC_DATA_ATTR int dataFails = 0;
-
-RTC_DATA_ATTR int numberOfOvernightSleepPeriodsLeft = 0; // how many individual deep sleeps left in overnight sleep
-RTC_DATA_ATTR int overnightSleepPeriodLength = 0;        // length of each sleep during overnight sleep (seconds)
-RTC_DATA_ATTR bool waitForNtpSync = false;               // after a long sleep time we want to resync before using the time
+RTC_DATA_ATTR SleepState sleepState = {};  // failures and overnight sleeps, see SleepSchedule
+RTC_DATA_ATTR int watchlistPage = 0;       // page of the watchlist to show
+static_assert(sizeof(bootCount) + sizeof(sleepState) + sizeof(watchlistPage) <= constants::RtcBytesMain,
+              "over main's RTC share");
 
 hw_timer_t *alert_timer = NULL;
 
@@ -45,7 +45,9 @@ void setup()
 {
     Serial.begin(115200); 
     // must get battery as first thing
+    uint32_t batteryStart = millis();
     int batPct = utils::battery_percent(utils::battery_read());
+    uint32_t batteryMillis = millis() - batteryStart;
     ++bootCount;
 
     sntp_set_time_sync_notification_cb(time_sync_notification_cb);
@@ -55,23 +57,15 @@ void setup()
     // the display with the warning normally
     if (batPct >= constants::MinimumAllowedBatteryPercent)
     {
-        if (numberOfOvernightSleepPeriodsLeft > 0)
-        {
-            // perform another required sleep period
-            numberOfOvernightSleepPeriodsLeft--;
-            log_d("Overnight sleeping for %d seconds, with %d periods left after this", 
-                  overnightSleepPeriodLength, 
-                  numberOfOvernightSleepPeriodsLeft);
-            if (numberOfOvernightSleepPeriodsLeft == 0)
-            {
-                log_d("Ticker will wait for NTP on next reboot");
-                waitForNtpSync = true;
-            }
-            utils::ticker_deep_sleep((uint64_t)overnightSleepPeriodLength * constants::MicrosToSecondsFactor);
-        }
-        
+        uint64_t sleepSeconds = 0;
+        if (SleepSchedule::continueOvernightSleep(sleepState, sleepSeconds))
+            utils::ticker_deep_sleep(sleepSeconds * constants::MicrosToSecondsFactor);
     }
 
+    // the wakes during an overnight sleep only go back to sleep, so timings start here
+    WakeTimer::beginWake(bootCount);
+    WakeTimer::record(WakePhase::BATTERY_READ, batteryMillis);
+
     uint32_t startTime = millis();
     delay(200);
     
@@ -89,65 +83,27 @@ void setup()
     alert_timer = timerBegin(0, 80, true);
     timerAttachInterrupt(alert_timer, &onTimer, true); 
 
-    TickerInput tickerInput{batPct, shouldEnterConfig, wifiFails, dataFails, bootCount, waitForNtpSync, alert_timer};
-    if (waitForNtpSync)
-        waitForNtpSync = false; // only do it once
+    TickerInput tickerInput{batPct, shouldEnterConfig, sleepState.wifiFails, sleepState.dataFails, bootCount, 
+                            sleepState.waitForNtpSync, watchlistPage, alert_timer};
+    sleepState.waitForNtpSync = false; // only do it once
 
     TickerCoordinator ticker(tickerInput);
 
     TickerOutput tickerOutput = ticker.run();
+    WakeTimer::endWake();
 
-    if (tickerOutput.wifiFailed)
-        wifiFails++;
-    else
-        wifiFails = 0;
-
-    if (tickerOutput.dataFailed)
-        dataFails++;
-    else
-        dataFails = 0;
-
-    // if overnight sleep value returned, do an overnight sleep period
-    // max deep sleep time of ESP is ~1h10m (unsigned 32 bit number of microseconds)
-    // the internal clock of the ESP isn't great - can be out by ~20 seconds per hour
-    // fine for a single 1 hour sleep but to get it more accurate at the end of the sleep we will aim
-    // to finish a chain of sleeps with 10 minutes remaining, then after resyncing the time with NTP,
-    // the last sleep will be pretty close to the requested end time. 
-    // with a max of 1 hour individual sleep length, calculate minimum number required to get to 10 mins
-    // left of total sleep time, then divide them evenly
-    // E.g. for 100 mins overnight sleep, to get to 10 mins left we have 90 mins, need 2 sleeps of 45 mins
-    if (tickerOutput.secondsLeftOfSleep > 0)
-    {
-        // should either be many hours, or ~10 mins (call it under 1 hour)
-        log_d("Ticker should be in overnight sleep with %" PRIu64 " seconds left", tickerOutput.secondsLeftOfSleep);
-        if (tickerOutput.secondsLeftOfSleep < 3600) // 1 hour, can just sleep this then continue normally
-        {
-            log_d("Final sleep, resetting overnight sleeps");   
-            numberOfOvernightSleepPeriodsLeft = 0;
-            overnightSleepPeriodLength = 0;
-            utils::ticker_deep_sleep((uint64_t)tickerOutput.secondsLeftOfSleep * constants::MicrosToSecondsFactor);
-        }
-        
-        int secondsUntilTenMinutesRemaining = tickerOutput.secondsLeftOfSleep - 600;
-        int minNumberOfSleeps = secondsUntilTenMinutesRemaining / 3600;
-        if (secondsUntilTenMinutesRemaining % 3600 > 0)
-            minNumberOfSleeps++;
-
-        overnightSleepPeriodLength = secondsUntilTenMinutesRemaining / minNumberOfSleeps; // close enough
-        numberOfOvernightSleepPeriodsLeft = minNumberOfSleeps - 1; // -1 as we are about to do one of them
-
-        log_d("Overnight sleeping for %d seconds, with %d periods left after this", 
-              overnightSleepPeriodLength, 
-              numberOfOvernightSleepPeriodsLeft);
-        delay(100);
-        utils::ticker_deep_sleep((uint64_t)overnightSleepPeriodLength * constants::MicrosToSecondsFactor);
-    }
+    watchlistPage = tickerOutput.watchlistPage;
+
+    // counts the failures for the next wake, or starts the chain of overnight sleeps
+    WakeOutcome outcome{tickerOutput.refreshSeconds, tickerOutput.wifiFailed, tickerOutput.dataFailed, 
+                        tickerOutput.secondsLeftOfSleep};
+    uint64_t sleepSeconds = SleepSchedule::endWake(sleepState, outcome);
 
     log_i("Program awake time: %d", millis() - startTime);
     // start deep sleep
-    log_d("Starting deep sleep for %d seconds", tickerOutput.refreshSeconds);
+    log_d("Starting deep sleep for %" PRIu64 " seconds", sleepSeconds);
     Serial.flush();
-    utils::ticker_deep_sleep((uint64_t)tickerOutput.refreshSeconds * constants::MicrosToSecondsFactor);
+    utils::ticker_deep_sleep(sleepSeconds * constants::MicrosToSecondsFactor);
 }
 
 void loop() {}
@@ -0,0 +1,598 @@
+#include "Adafruit_GFX.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+// ------------------------------------------------------------------------
+// Ported from Adafruit_GFX.cpp of Adafruit GFX 1.11, BSD license,
+// Copyright (c) 2013 Adafruit Industries. The arithmetic of each routine
+// is upstream's line for line, only the PROGMEM reads, startWrite() and
+// endWrite(), and the text size and background (always 1 and transparent
+// here) are left out, so the frames drawn natively are the frames the
+// device draws. The glcdfont table of the built in font isn't ported, the
+// ticker sets a GFXfont before drawing any text and drawing without one
+// throws rather than leave pixels out.
+// ------------------------------------------------------------------------
+
+Adafruit_GFX::Adafruit_GFX(uint16_t width, uint16_t height) :
+    m_width(width), m_height(height)
+{
+}
+
+void Adafruit_GFX::writeLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color)
+{
+    int16_t steep = abs(y1 - y0) > abs(x1 - x0);
+    if (steep)
+    {
+        std::swap(x0, y0);
+        std::swap(x1, y1);
+    }
+
+    if (x0 > x1)
+    {
+        std::swap(x0, x1);
+        std::swap(y0, y1);
+    }
+
+    int16_t dx, dy;
+    dx = x1 - x0;
+    dy = abs(y1 - y0);
+
+    int16_t err = dx / 2;
+    int16_t ystep;
+
+    if (y0 < y1)
+        ystep = 1;
+    else
+        ystep = -1;
+
+    for (; x0 <= x1; x0++)
+    {
+        if (steep)
+            drawPixel(y0, x0, color);
+        else
+            drawPixel(x0, y0, color);
+        err -= dy;
+        if (err < 0)
+        {
+            y0 += ystep;
+            err += dx;
+        }
+    }
+}
+
+void Adafruit_GFX::drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color)
+{
+    writeLine(x, y, x, y + h - 1, color);
+}
+
+void Adafruit_GFX::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color)
+{
+    writeLine(x, y, x + w - 1, y, color);
+}
+
+void Adafruit_GFX::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+    for (int16_t i = x; i < x + w; i++)
+        drawFastVLine(i, y, h, color);
+}
+
+void Adafruit_GFX::drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color)
+{
+    if (x0 == x1)
+    {
+        if (y0 > y1)
+            std::swap(y0, y1);
+        drawFastVLine(x0, y0, y1 - y0 + 1, color);
+    }
+    else if (y0 == y1)
+    {
+        if (x0 > x1)
+            std::swap(x0, x1);
+        drawFastHLine(x0, y0, x1 - x0 + 1, color);
+    }
+    else
+        writeLine(x0, y0, x1, y1, color);
+}
+
+void Adafruit_GFX::drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+    drawFastHLine(x, y, w, color);
+    drawFastHLine(x, y + h - 1, w, color);
+    drawFastVLine(x, y, h, color);
+    drawFastVLine(x + w - 1, y, h, color);
+}
+
+void Adafruit_GFX::fillTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color)
+{
+    int16_t a, b, y, last;
+
+    // sort coordinates by Y order (y2 >= y1 >= y0)
+    if (y0 > y1)
+    {
+        std::swap(y0, y1);
+        std::swap(x0, x1);
+    }
+    if (y1 > y2)
+    {
+        std::swap(y2, y1);
+        std::swap(x2, x1);
+    }
+    if (y0 > y1)
+    {
+        std::swap(y0, y1);
+        std::swap(x0, x1);
+    }
+
+    if (y0 == y2) // all on the same line
+    {
+        a = b = x0;
+        if (x1 < a)
+            a = x1;
+        else if (x1 > b)
+            b = x1;
+        if (x2 < a)
+            a = x2;
+        else if (x2 > b)
+            b = x2;
+        drawFastHLine(a, y0, b - a + 1, color);
+        return;
+    }
+
+    int16_t dx01 = x1 - x0, dy01 = y1 - y0, dx02 = x2 - x0, dy02 = y2 - y0, dx12 = x2 - x1, dy12 = y2 - y1;
+    int32_t sa = 0, sb = 0;
+
+    // for the upper part, the scanline crossings of segments 0-1 and 0-2, the scanline y1 is included if the
+    // bottom is flat (and the second loop skipped), otherwise it is left to the second loop
+    if (y1 == y2)
+        last = y1;
+    else
+        last = y1 - 1;
+
+    for (y = y0; y <= last; y++)
+    {
+        a = x0 + sa / dy01;
+        b = x0 + sb / dy02;
+        sa += dx01;
+        sb += dx02;
+        if (a > b)
+            std::swap(a, b);
+        drawFastHLine(a, y, b - a + 1, color);
+    }
+
+    // for the lower part, segments 0-2 and 1-2, skipped if y1 == y2
+    sa = (int32_t)dx12 * (y - y1);
+    sb = (int32_t)dx02 * (y - y0);
+    for (; y <= y2; y++)
+    {
+        a = x1 + sa / dy12;
+        b = x0 + sb / dy02;
+        sa += dx12;
+        sb += dx02;
+        if (a > b)
+            std::swap(a, b);
+        drawFastHLine(a, y, b - a + 1, color);
+    }
+}
+
+void Adafruit_GFX::drawBitmap(int16_t x, int16_t y, const uint8_t* bitmap, int16_t w, int16_t h, uint16_t color)
+{
+    int16_t byteWidth = (w + 7) / 8; // bitmap scanline pad = whole byte
+    uint8_t b = 0;
+
+    for (int16_t j = 0; j < h; j++, y++)
+    {
+        for (int16_t i = 0; i < w; i++)
+        {
+            if (i & 7)
+                b <<= 1;
+            else
+                b = bitmap[j * byteWidth + i / 8];
+            if (b & 0x80)
+                drawPixel(x + i, y, color);
+        }
+    }
+}
+
+void Adafruit_GFX::charBounds(unsigned char c, int16_t* x, int16_t* y, int16_t* minx, int16_t* miny, int16_t* maxx,
+                              int16_t* maxy)
+{
+    if (m_font)
+    {
+        if (c == '\n')
+        {
+            *x = 0;
+            *y += m_font->yAdvance;
+        }
+        else if (c != '\r')
+        {
+            uint8_t first = m_font->first, last = m_font->last;
+            if ((c >= first) && (c <= last))
+            {
+                const GFXglyph* glyph = &m_font->glyph[c - first];
+                uint8_t gw = glyph->width, gh = glyph->height, xa = glyph->xAdvance;
+                int8_t xo = glyph->xOffset, yo = glyph->yOffset;
+                if (m_wrap && ((*x + ((int16_t)xo + gw)) > width()))
+                {
+                    *x = 0;
+                    *y += m_font->yAdvance;
+                }
+                int16_t x1 = *x + xo, y1 = *y + yo, x2 = x1 + gw - 1, y2 = y1 + gh - 1;
+                if (x1 < *minx)
+                    *minx = x1;
+                if (y1 < *miny)
+                    *miny = y1;
+                if (x2 > *maxx)
+                    *maxx = x2;
+                if (y2 > *maxy)
+                    *maxy = y2;
+                *x += xa;
+            }
+        }
+    }
+    else // built in font
+    {
+        if (c == '\n')
+        {
+            *x = 0;
+            *y += 8;
+            // min/max x/y unchanged, that waits for the next normal character
+        }
+        else if (c != '\r')
+        {
+            if (m_wrap && ((*x + 6) > width()))
+            {
+                *x = 0;
+                *y += 8;
+            }
+            int x2 = *x + 6 - 1, y2 = *y + 8 - 1;
+            if (x2 > *maxx)
+                *maxx = x2;
+            if (y2 > *maxy)
+                *maxy = y2;
+            if (*x < *minx)
+                *minx = *x;
+            if (*y < *miny)
+                *miny = *y;
+            *x += 6;
+        }
+    }
+}
+
+void Adafruit_GFX::getTextBounds(const char* str, int16_t x, int16_t y, int16_t* x1, int16_t* y1, uint16_t* w,
+                                 uint16_t* h)
+{
+    uint8_t c;
+    // intentionally inverted, so the first character sets it
+    int16_t minx = 0x7FFF, miny = 0x7FFF, maxx = -1, maxy = -1;
+
+    *x1 = x;
+    *y1 = y;
+    *w = *h = 0;
+
+    while ((c = *str++))
+        charBounds(c, &x, &y, &minx, &miny, &maxx, &maxy);
+
+    if (maxx >= minx)
+    {
+        *x1 = minx;
+        *w = maxx - minx + 1;
+    }
+    if (maxy >= miny)
+    {
+        *y1 = miny;
+        *h = maxy - miny + 1;
+    }
+}
+
+void Adafruit_GFX::drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color)
+{
+    if (!m_font)
+        throw std::logic_error("the built in font of Adafruit GFX isn't in the native build, set a GFXfont first");
+
+    c -= m_font->first;
+    const GFXglyph* glyph = &m_font->glyph[c];
+    const uint8_t* bitmap = m_font->bitmap;
+
+    uint16_t bo = glyph->bitmapOffset;
+    uint8_t w = glyph->width, h = glyph->height;
+    int8_t xo = glyph->xOffset, yo = glyph->yOffset;
+    uint8_t xx, yy, bits = 0, bit = 0;
+
+    for (yy = 0; yy < h; yy++)
+    {
+        for (xx = 0; xx < w; xx++)
+        {
+            if (!(bit++ & 7))
+                bits = bitmap[bo++];
+            if (bits & 0x80)
+                drawPixel(x + xo + xx, y + yo + yy, color);
+            bits <<= 1;
+        }
+    }
+}
+
+size_t Adafruit_GFX::write(uint8_t c)
+{
+    if (!m_font)
+    {
+        if (c == '\n')
+        {
+            m_cursorX = 0;
+            m_cursorY += 8;
+        }
+        else if (c != '\r')
+        {
+            if (m_wrap && ((m_cursorX + 6) > width()))
+            {
+                m_cursorX = 0;
+                m_cursorY += 8;
+            }
+            drawChar(m_cursorX, m_cursorY, c, m_textColor);
+            m_cursorX += 6;
+        }
+        return 1;
+    }
+
+    if (c == '\n')
+    {
+        m_cursorX = 0;
+        m_cursorY += m_font->yAdvance;
+    }
+    else if (c != '\r')
+    {
+        uint8_t first = m_font->first;
+        if ((c >= first) && (c <= (uint8_t)m_font->last))
+        {
+            const GFXglyph* glyph = &m_font->glyph[c - first];
+            uint8_t w = glyph->width, h = glyph->height;
+            if ((w > 0) && (h > 0)) // is there an associated bitmap?
+            {
+                int16_t xo = glyph->xOffset;
+                if (m_wrap && ((m_cursorX + (xo + w)) > width()))
+                {
+                    m_cursorX = 0;
+                    m_cursorY += m_font->yAdvance;
+                }
+                drawChar(m_cursorX, m_cursorY, c, m_textColor);
+            }
+            m_cursorX += glyph->xAdvance;
+        }
+    }
+    return 1;
+}
+
+// ------------------------------------------------------------------------
+// GFXcanvas1, from the same file, with its own fast lines as upstream
+// ------------------------------------------------------------------------
+
+GFXcanvas1::GFXcanvas1(uint16_t width, uint16_t height) :
+    Adafruit_GFX(width, height), m_buffer((size_t)(width + 7) / 8 * height, 0)
+{
+}
+
+bool GFXcanvas1::bufferPosition(int16_t& x, int16_t& y) const
+{
+    if (x < 0 || y < 0 || x >= width() || y >= height())
+        return false;
+
+    int16_t t;
+    switch (getRotation())
+    {
+        case 1:
+            t = x;
+            x = m_width - 1 - y;
+            y = t;
+            break;
+        case 2:
+            x = m_width - 1 - x;
+            y = m_height - 1 - y;
+            break;
+        case 3:
+            t = x;
+            x = y;
+            y = m_height - 1 - t;
+            break;
+    }
+    return true;
+}
+
+void GFXcanvas1::drawPixel(int16_t x, int16_t y, uint16_t color)
+{
+    if (!bufferPosition(x, y))
+        return;
+
+    uint8_t* ptr = &m_buffer[(x / 8) + y * ((m_width + 7) / 8)];
+    if (color)
+        *ptr |= 0x80 >> (x & 7);
+    else
+        *ptr &= ~(0x80 >> (x & 7));
+}
+
+bool GFXcanvas1::getPixel(int16_t x, int16_t y) const
+{
+    if (!bufferPosition(x, y))
+        return false;
+
+    return m_buffer[(x / 8) + y * ((m_width + 7) / 8)] & (0x80 >> (x & 7));
+}
+
+void GFXcanvas1::fillScreen(uint16_t color)
+{
+    std::fill(m_buffer.begin(), m_buffer.end(), color ? 0xFF : 0x00);
+}
+
+void GFXcanvas1::drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color)
+{
+    if (h < 0) // convert negative heights to the positive equivalent
+    {
+        h *= -1;
+        y -= h - 1;
+        if (y < 0)
+        {
+            h += y;
+            y = 0;
+        }
+    }
+
+    // edge rejection, no draw if totally off the canvas
+    if ((x < 0) || (x >= width()) || (y >= height()) || ((y + h - 1) < 0))
+        return;
+
+    if (y < 0) // clip top
+    {
+        h += y;
+        y = 0;
+    }
+    if (y + h > height()) // clip bottom
+        h = height() - y;
+
+    if (getRotation() == 0)
+        drawFastRawVLine(x, y, h, color);
+    else if (getRotation() == 1)
+    {
+        int16_t t = x;
+        x = m_width - 1 - y;
+        y = t;
+        x -= h - 1;
+        drawFastRawHLine(x, y, h, color);
+    }
+    else if (getRotation() == 2)
+    {
+        x = m_width - 1 - x;
+        y = m_height - 1 - y;
+
+        y -= h - 1;
+        drawFastRawVLine(x, y, h, color);
+    }
+    else if (getRotation() == 3)
+    {
+        int16_t t = x;
+        x = y;
+        y = m_height - 1 - t;
+        drawFastRawHLine(x, y, h, color);
+    }
+}
+
+void GFXcanvas1::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color)
+{
+    if (w < 0) // convert negative widths to the positive equivalent
+    {
+        w *= -1;
+        x -= w - 1;
+        if (x < 0)
+        {
+            w += x;
+            x = 0;
+        }
+    }
+
+    // edge rejection, no draw if totally off the canvas
+    if ((y < 0) || (y >= height()) || (x >= width()) || ((x + w - 1) < 0))
+        return;
+
+    if (x < 0) // clip left
+    {
+        w += x;
+        x = 0;
+    }
+    if (x + w >= width()) // clip right
+        w = width() - x;
+
+    if (getRotation() == 0)
+        drawFastRawHLine(x, y, w, color);
+    else if (getRotation() == 1)
+    {
+        int16_t t = x;
+        x = m_width - 1 - y;
+        y = t;
+        drawFastRawVLine(x, y, w, color);
+    }
+    else if (getRotation() == 2)
+    {
+        x = m_width - 1 - x;
+        y = m_height - 1 - y;
+
+        x -= w - 1;
+        drawFastRawHLine(x, y, w, color);
+    }
+    else if (getRotation() == 3)
+    {
+        int16_t t = x;
+        x = y;
+        y = m_height - 1 - t;
+        y -= w - 1;
+        drawFastRawVLine(x, y, w, color);
+    }
+}
+
+void GFXcanvas1::drawFastRawVLine(int16_t x, int16_t y, int16_t h, uint16_t color)
+{
+    int16_t rowBytes = ((m_width + 7) / 8);
+    uint8_t* ptr = &m_buffer[(x / 8) + y * rowBytes];
+
+    if (color > 0)
+    {
+        uint8_t bitMask = (0x80 >> (x & 7));
+        for (int16_t i = 0; i < h; i++)
+        {
+            *ptr |= bitMask;
+            ptr += rowBytes;
+        }
+    }
+    else
+    {
+        uint8_t bitMask = ~(0x80 >> (x & 7));
+        for (int16_t i = 0; i < h; i++)
+        {
+            *ptr &= bitMask;
+            ptr += rowBytes;
+        }
+    }
+}
+
+void GFXcanvas1::drawFastRawHLine(int16_t x, int16_t y, int16_t w, uint16_t color)
+{
+    int16_t rowBytes = ((m_width + 7) / 8);
+    uint8_t* ptr = &m_buffer[(x / 8) + y * rowBytes];
+    size_t remainingWidthBits = w;
+
+    // the first byte may only be partly filled
+    if ((x & 7) > 0)
+    {
+        uint8_t startByteBitMask = 0x00;
+        for (int8_t i = (x & 7); ((i < 8) && (remainingWidthBits > 0)); i++)
+        {
+            startByteBitMask |= (0x80 >> i);
+            remainingWidthBits--;
+        }
+        if (color > 0)
+            *ptr |= startByteBitMask;
+        else
+            *ptr &= ~startByteBitMask;
+
+        ptr++;
+    }
+
+    if (remainingWidthBits > 0)
+    {
+        size_t remainingWholeBytes = remainingWidthBits / 8;
+        size_t lastByteBits = remainingWidthBits % 8;
+        uint8_t wholeByteColor = color > 0 ? 0xFF : 0x00;
+
+        memset(ptr, wholeByteColor, remainingWholeBytes);
+
+        if (lastByteBits > 0)
+        {
+            uint8_t lastByteBitMask = 0x00;
+            for (size_t i = 0; i < lastByteBits; i++)
+                lastByteBitMask |= (0x80 >> i);
+            ptr += remainingWholeBytes;
+
+            if (color > 0)
+                *ptr |= lastByteBitMask;
+            else
+                *ptr &= ~lastByteBitMask;
+        }
+    }
+}
@@ -0,0 +1,96 @@
+#ifndef FAKE_ADAFRUIT_GFX_H
+#define FAKE_ADAFRUIT_GFX_H
+
+#include <Arduino.h>
+#include <vector>
+#include "gfxfont.h"
+
+// the drawing and text code of Adafruit GFX for the native build, the routines the ticker calls are ported from
+// Adafruit_GFX.cpp (1.11) so the pixels drawn are the ones drawn on the device, see Adafruit_GFX.cpp
+// the text size is always 1 and the text background transparent, as the ticker never sets them
+
+class Adafruit_GFX : public Print
+{
+public:
+    Adafruit_GFX(uint16_t width, uint16_t height);
+    virtual ~Adafruit_GFX() = default;
+
+    int16_t width() const { return (m_rotation & 1) ? m_height : m_width; }
+    int16_t height() const { return (m_rotation & 1) ? m_width : m_height; }
+    void setRotation(uint8_t rotation) { m_rotation = rotation & 3; }
+    uint8_t getRotation() const { return m_rotation; }
+
+    virtual void drawPixel(int16_t x, int16_t y, uint16_t color) = 0;
+    virtual void fillScreen(uint16_t color) { fillRect(0, 0, width(), height(), color); }
+    virtual void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
+    virtual void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color);
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+    void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+    void writeLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color);
+    void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color);
+    void fillTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color);
+    void drawBitmap(int16_t x, int16_t y, const uint8_t* bitmap, int16_t w, int16_t h, uint16_t color);
+
+    void setFont(const GFXfont* font) { m_font = font; }
+    void setCursor(int16_t x, int16_t y)
+    {
+        m_cursorX = x;
+        m_cursorY = y;
+    }
+    int16_t getCursorX() const { return m_cursorX; }
+    int16_t getCursorY() const { return m_cursorY; }
+    void setTextColor(uint16_t color) { m_textColor = color; }
+    void setTextWrap(bool wrap) { m_wrap = wrap; }
+    void getTextBounds(const char* str, int16_t x, int16_t y, int16_t* x1, int16_t* y1, uint16_t* w, uint16_t* h);
+    void getTextBounds(const String& str, int16_t x, int16_t y, int16_t* x1, int16_t* y1, uint16_t* w, uint16_t* h)
+    {
+        getTextBounds(str.c_str(), x, y, x1, y1, w, h);
+    }
+
+    using Print::write;
+    size_t write(uint8_t c) override;
+
+protected:
+    // before rotation
+    uint16_t m_width;
+    uint16_t m_height;
+
+private:
+    void charBounds(unsigned char c, int16_t* x, int16_t* y, int16_t* minx, int16_t* miny, int16_t* maxx,
+                    int16_t* maxy);
+    void drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color);
+
+    uint8_t m_rotation = 0;
+    const GFXfont* m_font = nullptr; // the built in 6x8 font, which the ticker doesn't draw with
+    int16_t m_cursorX = 0;
+    int16_t m_cursorY = 0;
+    uint16_t m_textColor = 0xFFFF;
+    bool m_wrap = true;
+};
+
+// 1 bit per pixel in memory, rows of whole bytes with the first pixel in the top bit, a set bit for any colour
+// but 0
+class GFXcanvas1 : public Adafruit_GFX
+{
+public:
+    GFXcanvas1(uint16_t width, uint16_t height);
+
+    void drawPixel(int16_t x, int16_t y, uint16_t color) override;
+    void fillScreen(uint16_t color) override;
+    void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) override;
+    void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) override;
+    // after rotation, as drawPixel
+    bool getPixel(int16_t x, int16_t y) const;
+    uint8_t* getBuffer() { return m_buffer.data(); }
+
+private:
+    // of the pixel in the buffer, false if it is off the canvas
+    bool bufferPosition(int16_t& x, int16_t& y) const;
+    // in buffer coordinates, already clipped
+    void drawFastRawVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
+    void drawFastRawHLine(int16_t x, int16_t y, int16_t w, uint16_t color);
+
+    std::vector<uint8_t> m_buffer;
+};
+
+#endif
@@ -0,0 +1,122 @@
+#ifndef FAKE_ARDUINO_H
+#define FAKE_ARDUINO_H
+
+// the parts of the ESP32 Arduino core the ticker uses, for building it natively on a workstation
+// everything runs on the virtual clock in FakeClock.h, and the device state (pins, sleep, restarts) is set
+// and checked through FakeDevice.h
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+#include <cmath>
+#include <algorithm>
+
+#include "WString.h"
+#include "Print.h"
+#include "Stream.h"
+#include "IPAddress.h"
+#include "FakeClock.h"
+#include "FakeDevice.h"
+#include "esp_sleep.h"
+#include "freertos/event_groups.h"
+#include "freertos/task.h"
+
+// gcc on linux predefines unix in the gnu modes, the xtensa toolchain doesn't and the code uses it as a name
+#undef unix
+
+using std::abs;
+using std::max;
+using std::min;
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+// memory attributes mean nothing natively, RTC variables just stay in memory between wakes run in one process
+#define RTC_DATA_ATTR
+#define IRAM_ATTR
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t*)(addr))
+#define pgm_read_word(addr) (*(const uint16_t*)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t*)(addr))
+#define pgm_read_ptr(addr) (*(void* const*)(addr))
+#define SET_LOOP_TASK_STACK_SIZE(size)
+
+#define log_e(format, ...) fake::device::log('E', __FILE__, __LINE__, format, ##__VA_ARGS__)
+#define log_w(format, ...) fake::device::log('W', __FILE__, __LINE__, format, ##__VA_ARGS__)
+#define log_i(format, ...) fake::device::log('I', __FILE__, __LINE__, format, ##__VA_ARGS__)
+#define log_d(format, ...) fake::device::log('D', __FILE__, __LINE__, format, ##__VA_ARGS__)
+#define log_v(format, ...) fake::device::log('V', __FILE__, __LINE__, format, ##__VA_ARGS__)
+
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+
+static const uint8_t SS = 5; // VSPI chip select, as in pins_arduino.h
+
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield();
+
+void pinMode(uint8_t pin, uint8_t mode);
+int digitalRead(uint8_t pin);
+void digitalWrite(uint8_t pin, uint8_t value);
+uint16_t analogRead(uint8_t pin);
+
+// time, the sync itself is faked in esp_sntp.h
+void configTime(long gmtOffsetSec, int daylightOffsetSec, const char* server1, const char* server2 = nullptr,
+                const char* server3 = nullptr);
+bool getLocalTime(struct tm* info, uint32_t ms = 5000);
+
+// hardware timer used as the alert, natively it fires from delay() once the alarm has passed
+struct hw_timer_t;
+hw_timer_t* timerBegin(uint8_t timer, uint16_t divider, bool countUp);
+void timerEnd(hw_timer_t* timer);
+void timerAttachInterrupt(hw_timer_t* timer, void (*fn)(void), bool edge);
+void timerAlarmWrite(hw_timer_t* timer, uint64_t alarmValue, bool autoreload);
+void timerAlarmEnable(hw_timer_t* timer);
+void timerAlarmDisable(hw_timer_t* timer);
+
+typedef enum
+{
+    ESP_MAC_WIFI_STA,
+    ESP_MAC_WIFI_SOFTAP,
+    ESP_MAC_BT,
+    ESP_MAC_ETH
+} esp_mac_type_t;
+typedef int esp_err_t;
+#define ESP_OK 0
+esp_err_t esp_read_mac(uint8_t* mac, esp_mac_type_t type);
+
+class HardwareSerial : public Stream
+{
+public:
+    void begin(unsigned long baud) { (void)baud; }
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+    using Print::write;
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    void flush() override;
+};
+extern HardwareSerial Serial;
+
+class EspClass
+{
+public:
+    [[noreturn]] void restart();
+    uint32_t getFreeHeap() { return 200000; }
+};
+extern EspClass ESP;
+
+// the sketch, so a wake can be run by calling setup()
+void setup();
+void loop();
+
+#endif
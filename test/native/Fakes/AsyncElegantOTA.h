@@ -0,0 +1,19 @@
+#ifndef FAKE_ASYNCELEGANTOTA_H
+#define FAKE_ASYNCELEGANTOTA_H
+
+#include <ESPAsyncWebServer.h>
+
+class AsyncElegantOtaClass
+{
+public:
+    void begin(AsyncWebServer* server, const char* username = "", const char* password = "")
+    {
+        (void)username;
+        (void)password;
+        server->on("/update", HTTP_GET, [](AsyncWebServerRequest* request) { request->send(200); });
+    }
+};
+
+inline AsyncElegantOtaClass AsyncElegantOTA;
+
+#endif
@@ -0,0 +1,6 @@
+#ifndef FAKE_ASYNCTCP_H
+#define FAKE_ASYNCTCP_H
+
+// nothing of AsyncTCP is used directly, ESPAsyncWebServer.h has the fake web server
+
+#endif
@@ -0,0 +1,123 @@
+#ifndef FAKE_ESPASYNCWEBSERVER_H
+#define FAKE_ESPASYNCWEBSERVER_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include <functional>
+#include <vector>
+
+// web server for config mode, nothing connects to it natively but handlers can be called with
+// AsyncWebServer::handle to act as the browser
+
+typedef enum
+{
+    HTTP_GET = 0b00000001,
+    HTTP_POST = 0b00000010
+} WebRequestMethod;
+
+class AsyncWebParameter
+{
+public:
+    AsyncWebParameter(const String& name, const String& value, bool post) :
+        m_name(name), m_value(value), m_post(post)
+    {
+    }
+
+    const String& name() const { return m_name; }
+    const String& value() const { return m_value; }
+    bool isPost() const { return m_post; }
+
+private:
+    String m_name;
+    String m_value;
+    bool m_post;
+};
+
+class AsyncWebServerRequest
+{
+public:
+    AsyncWebServerRequest(std::vector<AsyncWebParameter> params, bool authenticated) :
+        m_params(std::move(params)), m_authenticated(authenticated)
+    {
+    }
+
+    size_t params() const { return m_params.size(); }
+    AsyncWebParameter* getParam(size_t index) { return index < m_params.size() ? &m_params[index] : nullptr; }
+
+    bool authenticate(const char* username, const char* password)
+    {
+        (void)username;
+        (void)password;
+        return m_authenticated;
+    }
+    void requestAuthentication() { m_status = 401; }
+
+    void send(int code, const String& contentType = String(), const String& content = String())
+    {
+        (void)contentType;
+        m_status = code;
+        m_response = content;
+    }
+    void send_P(int code, const String& contentType, const char* content) { send(code, contentType, content); }
+
+    int status() const { return m_status; }
+    const String& response() const { return m_response; }
+
+private:
+    std::vector<AsyncWebParameter> m_params;
+    bool m_authenticated;
+    int m_status = 0;
+    String m_response;
+};
+
+using ArRequestHandlerFunction = std::function<void(AsyncWebServerRequest* request)>;
+
+class AsyncWebServer
+{
+public:
+    explicit AsyncWebServer(uint16_t port) : m_port(port) {}
+
+    void on(const char* uri, WebRequestMethod method, ArRequestHandlerFunction handler)
+    {
+        m_handlers.push_back({uri, method, handler});
+    }
+    void serveStatic(const char* uri, fs::FS& fs, const char* path)
+    {
+        (void)uri;
+        (void)fs;
+        (void)path;
+    }
+    void begin() { m_started = true; }
+    bool started() const { return m_started; }
+    uint16_t port() const { return m_port; }
+
+    // calls the handler for the request as if it came from a browser, the status is 404 if there is none
+    int handle(WebRequestMethod method, const String& uri, std::vector<AsyncWebParameter> params = {},
+               bool authenticated = true)
+    {
+        AsyncWebServerRequest request(std::move(params), authenticated);
+        for (auto& handler : m_handlers)
+        {
+            if (handler.method == method && uri == handler.uri)
+            {
+                handler.handler(&request);
+                return request.status();
+            }
+        }
+        return 404;
+    }
+
+private:
+    struct Handler
+    {
+        String uri;
+        WebRequestMethod method;
+        ArRequestHandlerFunction handler;
+    };
+
+    uint16_t m_port;
+    bool m_started = false;
+    std::vector<Handler> m_handlers;
+};
+
+#endif
@@ -0,0 +1,247 @@
+#include "FS.h"
+#include "SPIFFS.h"
+
+#include <map>
+#include <string>
+
+namespace
+{
+    std::map<std::string, std::vector<uint8_t>> files;
+    int writes = 0;
+    size_t written = 0;
+    bool mountShouldFail = false;
+}
+
+namespace fs
+{
+
+struct FileImpl
+{
+    ~FileImpl()
+    {
+        close();
+    }
+
+    void close()
+    {
+        if (writable && !closed)
+        {
+            files[path] = data;
+            writes++;
+            written += data.size();
+        }
+        closed = true;
+    }
+
+    std::string path;
+    bool directory = false;
+    bool writable = false;
+    bool closed = false;
+    std::vector<uint8_t> data;
+    size_t pos = 0;
+    std::vector<std::string> entries; // for a directory
+    size_t nextEntry = 0;
+};
+
+size_t File::write(uint8_t c)
+{
+    return write(&c, 1);
+}
+
+size_t File::write(const uint8_t* buf, size_t size)
+{
+    if (!m_impl || !m_impl->writable || m_impl->closed)
+        return 0;
+    m_impl->data.insert(m_impl->data.end(), buf, buf + size);
+    return size;
+}
+
+int File::available()
+{
+    if (!m_impl || m_impl->writable || m_impl->closed)
+        return 0;
+    return m_impl->data.size() - m_impl->pos;
+}
+
+int File::read()
+{
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+}
+
+int File::peek()
+{
+    if (available() <= 0)
+        return -1;
+    return m_impl->data[m_impl->pos];
+}
+
+size_t File::read(uint8_t* buf, size_t size)
+{
+    size_t count = std::min<size_t>(size, std::max(available(), 0));
+    if (count > 0)
+    {
+        memcpy(buf, m_impl->data.data() + m_impl->pos, count);
+        m_impl->pos += count;
+    }
+    return count;
+}
+
+bool File::seek(uint32_t pos)
+{
+    if (!m_impl || pos > m_impl->data.size())
+        return false;
+    m_impl->pos = pos;
+    return true;
+}
+
+size_t File::position() const
+{
+    return m_impl ? m_impl->pos : 0;
+}
+
+size_t File::size() const
+{
+    return m_impl ? m_impl->data.size() : 0;
+}
+
+void File::close()
+{
+    if (m_impl)
+        m_impl->close();
+}
+
+const char* File::path() const
+{
+    return m_impl ? m_impl->path.c_str() : "";
+}
+
+const char* File::name() const
+{
+    if (!m_impl)
+        return "";
+    size_t slash = m_impl->path.rfind('/');
+    return m_impl->path.c_str() + (slash == std::string::npos ? 0 : slash + 1);
+}
+
+bool File::isDirectory() const
+{
+    return m_impl && m_impl->directory;
+}
+
+File File::openNextFile(const char* mode)
+{
+    if (!m_impl || !m_impl->directory || m_impl->nextEntry >= m_impl->entries.size())
+        return File();
+    return SPIFFS.open(String(m_impl->entries[m_impl->nextEntry++].c_str()), mode);
+}
+
+File FS::open(const String& path, const char* mode)
+{
+    auto impl = std::make_shared<FileImpl>();
+    impl->path = path.c_str();
+
+    // SPIFFS has no real directories, every file is listed under "/"
+    if (impl->path == "/")
+    {
+        impl->directory = true;
+        for (const auto& [name, data] : files)
+            impl->entries.push_back(name);
+        return File(impl);
+    }
+
+    String openMode(mode);
+    if (openMode == FILE_READ)
+    {
+        auto it = files.find(impl->path);
+        if (it == files.end())
+            return File();
+        impl->data = it->second;
+    }
+    else
+    {
+        impl->writable = true;
+        if (openMode == FILE_APPEND && files.count(impl->path))
+            impl->data = files[impl->path];
+    }
+    return File(impl);
+}
+
+bool FS::exists(const String& path)
+{
+    return files.count(path.c_str()) > 0;
+}
+
+bool FS::remove(const String& path)
+{
+    return files.erase(path.c_str()) > 0;
+}
+
+bool FS::rename(const String& from, const String& to)
+{
+    auto it = files.find(from.c_str());
+    if (it == files.end())
+        return false;
+    files[to.c_str()] = it->second;
+    files.erase(from.c_str());
+    return true;
+}
+
+}
+
+SPIFFSFS SPIFFS;
+
+bool SPIFFSFS::begin(bool, const char*, uint8_t, const char*)
+{
+    return !mountShouldFail;
+}
+
+bool SPIFFSFS::format()
+{
+    files.clear();
+    return true;
+}
+
+size_t SPIFFSFS::usedBytes()
+{
+    size_t used = 0;
+    for (const auto& [name, data] : files)
+        used += data.size();
+    return used;
+}
+
+namespace fake
+{
+
+namespace spiffs
+{
+    void clear()
+    {
+        files.clear();
+        writes = 0;
+        written = 0;
+        mountShouldFail = false;
+    }
+
+    int writeCount()
+    {
+        return writes;
+    }
+
+    size_t bytesWritten()
+    {
+        return written;
+    }
+
+    void setMountFails(bool fails)
+    {
+        mountShouldFail = fails;
+    }
+
+    bool mountFails()
+    {
+        return mountShouldFail;
+    }
+}
+
+}
@@ -0,0 +1,78 @@
+#ifndef FAKE_FS_H
+#define FAKE_FS_H
+
+#include <Arduino.h>
+#include <memory>
+#include <vector>
+
+// in-memory filesystem with the same File/FS interface as the ESP32 core
+// files keep their contents between wakes, as they do in flash
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+#define FILE_APPEND "a"
+
+namespace fs
+{
+
+struct FileImpl;
+
+class File : public Stream
+{
+public:
+    File() = default;
+    explicit File(std::shared_ptr<FileImpl> impl) : m_impl(std::move(impl)) {}
+
+    using Print::write;
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buf, size_t size) override;
+    int available() override;
+    int read() override;
+    int peek() override;
+    void flush() override {}
+    size_t read(uint8_t* buf, size_t size);
+    bool seek(uint32_t pos);
+    size_t position() const;
+    size_t size() const;
+    void close();
+    operator bool() const { return m_impl != nullptr; }
+
+    const char* path() const;
+    const char* name() const; // without the leading "/" as in the 2.x core
+    bool isDirectory() const;
+    File openNextFile(const char* mode = FILE_READ);
+
+private:
+    std::shared_ptr<FileImpl> m_impl;
+};
+
+class FS
+{
+public:
+    File open(const String& path, const char* mode = FILE_READ);
+    File open(const char* path, const char* mode = FILE_READ) { return open(String(path), mode); }
+    bool exists(const String& path);
+    bool remove(const String& path);
+    bool rename(const String& from, const String& to);
+};
+
+}
+
+using fs::File;
+using fs::FS;
+
+namespace fake
+{
+
+namespace spiffs
+{
+    void clear();
+    int writeCount();        // files closed after being written, for flash wear
+    size_t bytesWritten();
+    void setMountFails(bool fails);
+    bool mountFails();
+}
+
+}
+
+#endif
@@ -0,0 +1,101 @@
+#include "FakeClock.h"
+
+#include <sys/time.h>
+
+namespace
+{
+    int64_t trueNow = fake::clock::DefaultStartMicros;
+    int64_t systemOffset = -fake::clock::DefaultStartMicros; // system time minus true time
+    int64_t bootTrue = fake::clock::DefaultStartMicros;
+    int32_t sleepDriftPpm = 0;
+}
+
+namespace fake
+{
+
+namespace clock
+{
+    void reset(int64_t startMicros)
+    {
+        trueNow = startMicros;
+        systemOffset = -startMicros;
+        bootTrue = startMicros;
+        sleepDriftPpm = 0;
+    }
+
+    void advanceMicros(uint64_t micros)
+    {
+        trueNow += micros;
+    }
+
+    void advanceMillis(uint32_t millis)
+    {
+        trueNow += (int64_t)millis * 1000;
+    }
+
+    uint64_t uptimeMicros()
+    {
+        return trueNow - bootTrue;
+    }
+
+    int64_t trueMicros()
+    {
+        return trueNow;
+    }
+
+    int64_t systemMicros()
+    {
+        return trueNow + systemOffset;
+    }
+
+    void setSystemMicros(int64_t micros)
+    {
+        systemOffset = micros - trueNow;
+    }
+
+    void syncSystemTime()
+    {
+        systemOffset = 0;
+    }
+
+    void setSleepDriftPpm(int32_t ppm)
+    {
+        sleepDriftPpm = ppm;
+    }
+
+    void deepSleep(uint64_t micros)
+    {
+        trueNow += micros;
+        systemOffset += (int64_t)micros * sleepDriftPpm / 1000000;
+        bootTrue = trueNow;
+    }
+}
+
+}
+
+// the system time functions are replaced for the whole program, so code using them directly
+// (TimeKeeper, the scoreboard cooldowns) sees the virtual clock
+extern "C"
+{
+    time_t time(time_t* t)
+    {
+        time_t now = fake::clock::systemMicros() / 1000000;
+        if (t)
+            *t = now;
+        return now;
+    }
+
+    int gettimeofday(struct timeval* tv, void*)
+    {
+        int64_t now = fake::clock::systemMicros();
+        tv->tv_sec = now / 1000000;
+        tv->tv_usec = now % 1000000;
+        return 0;
+    }
+
+    int settimeofday(const struct timeval* tv, const struct timezone*)
+    {
+        fake::clock::setSystemMicros((int64_t)tv->tv_sec * 1000000 + tv->tv_usec);
+        return 0;
+    }
+}
@@ -0,0 +1,47 @@
+#ifndef FAKECLOCK_H
+#define FAKECLOCK_H
+
+#include <stdint.h>
+#include <time.h>
+
+// virtual clock for the native build, nothing takes any real time
+// time only moves when the code waits (delay, a read timing out) or a fake says something took time, e.g.
+// a server responding or the display refreshing, so a whole wake runs in microseconds but reports the
+// time it would have taken on the device
+// the true time always moves at the right rate, the system time (time(), gettimeofday()) is what the device
+// believes and drifts from it during deep sleep like the RTC slow clock does
+
+namespace fake
+{
+
+namespace clock
+{
+    // true unix time in micros the clock starts from
+    constexpr int64_t DefaultStartMicros = 1701021297LL * 1000000; // 26 Nov 2023 17:54:57
+
+    // back to power on at startMicros, the system time is unset (counting from 0) as on the device
+    void reset(int64_t startMicros = DefaultStartMicros);
+
+    void advanceMicros(uint64_t micros);
+    void advanceMillis(uint32_t millis);
+
+    // since the last boot or wake, for millis() and micros()
+    uint64_t uptimeMicros();
+
+    int64_t trueMicros();
+    int64_t systemMicros();
+    void setSystemMicros(int64_t micros);
+
+    // sets the system time to the true time, as a completed NTP sync would
+    void syncSystemTime();
+
+    // the system time gains ppm/1e6 of the time spent in deep sleep, negative if it loses time
+    void setSleepDriftPpm(int32_t ppm);
+
+    // time spent in deep sleep, the uptime starts again from 0
+    void deepSleep(uint64_t micros);
+}
+
+}
+
+#endif
@@ -0,0 +1,467 @@
+#include "Arduino.h"
+#include "esp_sntp.h"
+#include "driver/gpio.h"
+
+#include <cstdarg>
+#include <map>
+
+struct hw_timer_t
+{
+    uint64_t alarm; // micros after it was enabled, the divider is always 80 so a tick is a micro
+    bool enabled;
+    uint64_t enabledAt; // uptime micros
+    void (*onAlarm)(void);
+};
+
+namespace
+{
+    std::map<uint8_t, int> digitalValues;
+    std::map<uint8_t, uint16_t> analogValues;
+
+    esp_sleep_wakeup_cause_t wakeupCause = ESP_SLEEP_WAKEUP_UNDEFINED;
+    uint64_t sleepTimer = 0;
+    int wakes = 0;
+    int lightSleeps = 0;
+    uint64_t gpioWakeupPins = 0; // bit per pin
+    bool gpioWakeup = false;
+
+    bool ntpReachable = true;
+    uint32_t ntpLatency = 40;
+    int ntpSyncs = 0;
+    bool ntpPending = false;
+    uint64_t ntpDoneAt = 0; // uptime micros
+    sntp_sync_status_t ntpStatus = SNTP_SYNC_STATUS_RESET;
+    sntp_sync_time_cb_t ntpCallback = nullptr;
+
+    hw_timer_t alertTimer{};
+
+    char logLevel = 'W';
+
+    // the interrupt runs once the code waits past the alarm, it can't cut into code that doesn't wait
+    void updateTimer()
+    {
+        if (!alertTimer.enabled || fake::clock::uptimeMicros() - alertTimer.enabledAt < alertTimer.alarm)
+            return;
+
+        alertTimer.enabled = false;
+        if (alertTimer.onAlarm)
+            alertTimer.onAlarm();
+    }
+
+    int levelRank(char level)
+    {
+        switch (level)
+        {
+            case 'E': return 1;
+            case 'W': return 2;
+            case 'I': return 3;
+            case 'D': return 4;
+            case 'V': return 5;
+            default: return 0;
+        }
+    }
+
+    void updateNtp()
+    {
+        if (!ntpPending || fake::clock::uptimeMicros() < ntpDoneAt)
+            return;
+
+        ntpPending = false;
+        fake::clock::syncSystemTime();
+        ntpStatus = SNTP_SYNC_STATUS_COMPLETED;
+        ntpSyncs++;
+        if (ntpCallback)
+        {
+            struct timeval tv;
+            gettimeofday(&tv, nullptr);
+            ntpCallback(&tv);
+        }
+    }
+}
+
+struct EventGroupDef_t
+{
+    EventBits_t bits;
+};
+
+const IPAddress INADDR_NONE(0, 0, 0, 0);
+HardwareSerial Serial;
+EspClass ESP;
+
+namespace fake
+{
+
+namespace device
+{
+    void reset()
+    {
+        clock::reset();
+        digitalValues.clear();
+        analogValues.clear();
+        wakeupCause = ESP_SLEEP_WAKEUP_UNDEFINED;
+        sleepTimer = 0;
+        wakes = 0;
+        lightSleeps = 0;
+        gpioWakeupPins = 0;
+        gpioWakeup = false;
+        ntpReachable = true;
+        ntpLatency = 40;
+        ntpSyncs = 0;
+        ntpPending = false;
+        ntpStatus = SNTP_SYNC_STATUS_RESET;
+        alertTimer = {};
+    }
+
+    uint64_t wake(const std::function<void()>& run)
+    {
+        wakes++;
+        sleepTimer = 0;
+        try
+        {
+            run();
+        }
+        catch (const DeepSleep& sleep)
+        {
+            if (sleep.micros == 0)
+                return 0;
+            clock::deepSleep(sleep.micros);
+            wakeupCause = ESP_SLEEP_WAKEUP_TIMER;
+            ntpPending = false; // nothing carries on through deep sleep
+            alertTimer = {};
+            return sleep.micros;
+        }
+        return 0;
+    }
+
+    int wakeCount()
+    {
+        return wakes;
+    }
+
+    void setDigitalRead(uint8_t pin, int value)
+    {
+        digitalValues[pin] = value;
+    }
+
+    void setAnalogRead(uint8_t pin, uint16_t value)
+    {
+        analogValues[pin] = value;
+    }
+
+    void setWakeupCause(esp_sleep_wakeup_cause_t cause)
+    {
+        wakeupCause = cause;
+    }
+
+    uint64_t sleepTimerMicros()
+    {
+        return sleepTimer;
+    }
+
+    int lightSleepCount()
+    {
+        return lightSleeps;
+    }
+
+    bool gpioWakeupEnabled()
+    {
+        return gpioWakeup || gpioWakeupPins != 0;
+    }
+
+    void setNtpReachable(bool reachable)
+    {
+        ntpReachable = reachable;
+    }
+
+    void setNtpLatencyMillis(uint32_t latencyMillis)
+    {
+        ntpLatency = latencyMillis;
+    }
+
+    int ntpSyncCount()
+    {
+        return ntpSyncs;
+    }
+
+    void setLogLevel(char level)
+    {
+        logLevel = level;
+    }
+
+    void log(char level, const char* file, int line, const char* format, ...)
+    {
+        if (levelRank(level) == 0 || levelRank(level) > levelRank(logLevel))
+            return;
+
+        const char* name = strrchr(file, '/');
+        fprintf(stderr, "[%8.3f][%c][%s:%d] ", fake::clock::uptimeMicros() / 1000.0, level, name ? name + 1 : file, line);
+        va_list args;
+        va_start(args, format);
+        vfprintf(stderr, format, args);
+        va_end(args);
+        fputc('\n', stderr);
+    }
+}
+
+}
+
+unsigned long millis()
+{
+    return fake::clock::uptimeMicros() / 1000;
+}
+
+unsigned long micros()
+{
+    return fake::clock::uptimeMicros();
+}
+
+void delay(uint32_t ms)
+{
+    fake::clock::advanceMillis(ms);
+    updateNtp();
+    updateTimer();
+}
+
+void delayMicroseconds(uint32_t us)
+{
+    fake::clock::advanceMicros(us);
+}
+
+void yield()
+{
+}
+
+void pinMode(uint8_t, uint8_t)
+{
+}
+
+int digitalRead(uint8_t pin)
+{
+    auto it = digitalValues.find(pin);
+    return it == digitalValues.end() ? HIGH : it->second;
+}
+
+void digitalWrite(uint8_t, uint8_t)
+{
+}
+
+uint16_t analogRead(uint8_t pin)
+{
+    // about 3.9V on the battery divider
+    auto it = analogValues.find(pin);
+    return it == analogValues.end() ? 2420 : it->second;
+}
+
+void configTime(long, int, const char*, const char*, const char*)
+{
+    ntpStatus = SNTP_SYNC_STATUS_RESET;
+    ntpPending = ntpReachable;
+    ntpDoneAt = fake::clock::uptimeMicros() + (uint64_t)ntpLatency * 1000;
+}
+
+bool getLocalTime(struct tm* info, uint32_t ms)
+{
+    uint32_t start = millis();
+    time_t now;
+    while ((millis() - start) <= ms)
+    {
+        time(&now);
+        localtime_r(&now, info);
+        if (info->tm_year > (2016 - 1900))
+            return true;
+        delay(10);
+    }
+    return false;
+}
+
+hw_timer_t* timerBegin(uint8_t, uint16_t, bool)
+{
+    return &alertTimer;
+}
+
+void timerEnd(hw_timer_t*)
+{
+}
+
+void timerAttachInterrupt(hw_timer_t* timer, void (*fn)(void), bool)
+{
+    timer->onAlarm = fn;
+}
+
+void timerAlarmWrite(hw_timer_t* timer, uint64_t alarmValue, bool)
+{
+    timer->alarm = alarmValue;
+}
+
+void timerAlarmEnable(hw_timer_t* timer)
+{
+    timer->enabled = true;
+    timer->enabledAt = fake::clock::uptimeMicros();
+}
+
+void timerAlarmDisable(hw_timer_t* timer)
+{
+    timer->enabled = false;
+}
+
+esp_err_t esp_read_mac(uint8_t* mac, esp_mac_type_t)
+{
+    const uint8_t fakeMac[6] = {0x24, 0x0a, 0xc4, 0x12, 0x34, 0x56};
+    memcpy(mac, fakeMac, sizeof(fakeMac));
+    return ESP_OK;
+}
+
+size_t HardwareSerial::write(uint8_t c)
+{
+    return fwrite(&c, 1, 1, stdout);
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size)
+{
+    return fwrite(buffer, 1, size, stdout);
+}
+
+void HardwareSerial::flush()
+{
+    fflush(stdout);
+}
+
+void EspClass::restart()
+{
+    throw fake::device::Restart{};
+}
+
+int esp_sleep_enable_timer_wakeup(uint64_t timeInUs)
+{
+    sleepTimer = timeInUs;
+    return ESP_OK;
+}
+
+int esp_sleep_disable_wakeup_source(esp_sleep_source_t source)
+{
+    if (source == ESP_SLEEP_WAKEUP_TIMER || source == ESP_SLEEP_WAKEUP_ALL)
+        sleepTimer = 0;
+    if (source == ESP_SLEEP_WAKEUP_GPIO || source == ESP_SLEEP_WAKEUP_ALL)
+        gpioWakeup = false;
+    return ESP_OK;
+}
+
+int esp_sleep_pd_config(esp_sleep_pd_domain_t, esp_sleep_pd_option_t)
+{
+    return ESP_OK;
+}
+
+int esp_sleep_enable_gpio_wakeup()
+{
+    gpioWakeup = true;
+    return ESP_OK;
+}
+
+int esp_light_sleep_start()
+{
+    lightSleeps++;
+    return ESP_OK;
+}
+
+int gpio_wakeup_enable(gpio_num_t gpio_num, gpio_int_type_t intr_type)
+{
+    (void)intr_type;
+    gpioWakeupPins |= 1ull << gpio_num;
+    return ESP_OK;
+}
+
+int gpio_wakeup_disable(gpio_num_t gpio_num)
+{
+    gpioWakeupPins &= ~(1ull << gpio_num);
+    return ESP_OK;
+}
+
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause()
+{
+    return wakeupCause;
+}
+
+void esp_deep_sleep_start()
+{
+    throw fake::device::DeepSleep{sleepTimer};
+}
+
+EventGroupHandle_t xEventGroupCreate()
+{
+    return new EventGroupDef_t{0};
+}
+
+void vEventGroupDelete(EventGroupHandle_t group)
+{
+    delete group;
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits)
+{
+    group->bits |= bits;
+    return group->bits;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits)
+{
+    EventBits_t before = group->bits;
+    group->bits &= ~bits;
+    return before;
+}
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t group)
+{
+    return group->bits;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits, BaseType_t clearOnExit,
+                                BaseType_t waitForAllBits, TickType_t ticksToWait)
+{
+    bool done = waitForAllBits ? (group->bits & bits) == bits : (group->bits & bits) != 0;
+    if (!done)
+        delay(ticksToWait);
+
+    EventBits_t result = group->bits;
+    if (done && clearOnExit)
+        group->bits &= ~bits;
+    return result;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t taskCode, const char* name, uint32_t stackDepth, void* parameters,
+                                   UBaseType_t priority, TaskHandle_t* createdTask, BaseType_t coreId)
+{
+    (void)name;
+    (void)stackDepth;
+    (void)priority;
+    (void)coreId;
+    if (createdTask)
+        *createdTask = nullptr;
+    taskCode(parameters);
+    return pdTRUE;
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    (void)task;
+}
+
+void sntp_set_sync_status(sntp_sync_status_t status)
+{
+    ntpStatus = status;
+}
+
+sntp_sync_status_t sntp_get_sync_status()
+{
+    updateNtp();
+    return ntpStatus;
+}
+
+void sntp_set_time_sync_notification_cb(sntp_sync_time_cb_t callback)
+{
+    ntpCallback = callback;
+}
+
+void sntp_stop()
+{
+    ntpPending = false;
+}
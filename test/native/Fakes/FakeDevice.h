@@ -0,0 +1,52 @@
+#ifndef FAKEDEVICE_H
+#define FAKEDEVICE_H
+
+#include <stdint.h>
+#include <functional>
+#include "esp_sleep.h"
+
+// state of the fake ESP32 outside of the network and filesystem
+
+namespace fake
+{
+
+namespace device
+{
+    // thrown by esp_deep_sleep_start(), micros is 0 when no timer wakeup was set (hibernate)
+    struct DeepSleep
+    {
+        uint64_t micros;
+    };
+
+    // thrown by ESP.restart()
+    struct Restart
+    {
+    };
+
+    // back to power on, also resets the clock
+    void reset();
+
+    // runs one wake, e.g. setup(), until it goes to deep sleep, then moves the clock through the sleep
+    // returns the sleep time in micros, or 0 if it hibernated or returned without sleeping
+    uint64_t wake(const std::function<void()>& run);
+    int wakeCount();
+
+    void setDigitalRead(uint8_t pin, int value); // HIGH by default, e.g. the config button not pressed
+    void setAnalogRead(uint8_t pin, uint16_t value);
+    void setWakeupCause(esp_sleep_wakeup_cause_t cause);
+    uint64_t sleepTimerMicros();
+    int lightSleepCount();
+    bool gpioWakeupEnabled(); // for any pin, left enabled it would also wake the next deep sleep
+
+    void setNtpReachable(bool reachable);
+    void setNtpLatencyMillis(uint32_t latencyMillis);
+    int ntpSyncCount();
+
+    // logs at or above this level are printed, as 'E', 'W', 'I', 'D' or 'V', or 0 for none
+    void setLogLevel(char level);
+    void log(char level, const char* file, int line, const char* format, ...);
+}
+
+}
+
+#endif
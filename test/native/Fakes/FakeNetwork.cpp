@@ -0,0 +1,717 @@
+#include "FakeNetwork.h"
+#include "FakeClock.h"
+#include "WiFi.h"
+
+#include <lwip/sockets.h>
+#include <mbedtls/ssl.h>
+#include <mbedtls/entropy.h>
+#include <mbedtls/ctr_drbg.h>
+#include <mbedtls/net_sockets.h>
+
+#include <deque>
+#include <map>
+#include <set>
+#include <string>
+
+namespace
+{
+    // time the ESP32 spends on the crypto of a handshake, a full one does ECDHE and checks the signature
+    constexpr uint32_t FullHandshakeMillis = 650;
+    constexpr uint32_t ResumedHandshakeMillis = 30;
+    constexpr size_t ChunkSize = 512; // of a chunked response
+    constexpr size_t PieceSize = 256; // a response arrives in pieces of this size
+    constexpr size_t SlowPieceSize = 8; // or a few bytes at a time when it is slow
+
+    fake::wifi::AccessPoint accessPoint;
+    bool haveAccessPoint = false;
+    int connects = 0;
+    int dhcps = 0;
+
+    struct Server
+    {
+        fake::network::Handler handler;
+        fake::network::ServerOptions options;
+        IPAddress ip;
+        bool down = false;
+        int requests = 0;
+        int handshakes = 0;
+        int resumedHandshakes = 0;
+        std::set<int64_t> sessions; // start times of the sessions it can resume
+    };
+
+    struct Chunk
+    {
+        uint64_t readyAt; // uptime micros
+        std::string data;
+    };
+
+    struct Connection
+    {
+        int peer = -1;      // other end of the socketpair, shut down when the server closes
+        std::string host;
+        std::string request; // received but not yet complete
+        std::deque<Chunk> response;
+        uint64_t lastActivity = 0;
+        bool closeAfterResponse = false;
+        bool closed = false;
+    };
+
+    std::map<std::string, Server> servers;
+    std::map<int, Connection> connections; // by socket
+    std::vector<fake::network::Request> requestLog;
+    int64_t lastSessionStart = 0;
+
+    Server* findServer(const std::string& host)
+    {
+        auto it = servers.find(host);
+        return it == servers.end() ? nullptr : &it->second;
+    }
+
+    Server* findServer(uint32_t ip)
+    {
+        for (auto& [host, server] : servers)
+            if ((uint32_t)server.ip == ip)
+                return &server;
+        return nullptr;
+    }
+
+    uint32_t hostHash(const std::string& host)
+    {
+        uint32_t h = 2166136261u;
+        for (char c : host)
+            h = (h ^ (uint8_t)c) * 16777619u;
+        return h == 0 ? 1 : h;
+    }
+
+    Connection* findConnection(const mbedtls_ssl_context* ssl)
+    {
+        auto it = connections.find(ssl->connection);
+        return it == connections.end() ? nullptr : &it->second;
+    }
+
+    void closeConnection(Connection& conn)
+    {
+        if (!conn.closed)
+        {
+            conn.closed = true;
+            shutdown(conn.peer, SHUT_WR);
+        }
+    }
+
+    // closes the connection once the last response asking for it has arrived, or after the keep alive time
+    void updateConnection(Connection& conn)
+    {
+        uint64_t now = fake::clock::uptimeMicros();
+        bool allArrived = conn.response.empty() || conn.response.back().readyAt <= now;
+        if (!allArrived)
+            return;
+
+        Server* server = findServer(conn.host);
+        uint64_t lastArrival = conn.response.empty() ? conn.lastActivity : conn.response.back().readyAt;
+        if (conn.closeAfterResponse || !server || server->down ||
+            now - lastArrival > (uint64_t)server->options.keepAliveMillis * 1000)
+            closeConnection(conn);
+    }
+
+    size_t bytesReady(const Connection& conn)
+    {
+        uint64_t now = fake::clock::uptimeMicros();
+        size_t ready = 0;
+        for (const auto& chunk : conn.response)
+        {
+            if (chunk.readyAt > now)
+                break;
+            ready += chunk.data.size();
+        }
+        return ready;
+    }
+
+    const char* reasonPhrase(int status)
+    {
+        switch (status)
+        {
+            case 200: return "OK";
+            case 400: return "Bad Request";
+            case 404: return "Not Found";
+            case 429: return "Too Many Requests";
+            case 500: return "Internal Server Error";
+            case 503: return "Service Unavailable";
+            default: return "Unknown";
+        }
+    }
+
+    std::string lowercase(std::string s)
+    {
+        for (char& c : s)
+            c = tolower(c);
+        return s;
+    }
+
+    void handleRequest(Connection& conn, Server& server, const std::string& head)
+    {
+        // "GET https://host/path HTTP/1.1" or "GET /path HTTP/1.1"
+        size_t start = head.find(' ');
+        size_t end = head.find(' ', start + 1);
+        std::string target = head.substr(start + 1, end - start - 1);
+        size_t scheme = target.find("://");
+        if (scheme != std::string::npos)
+        {
+            size_t slash = target.find('/', scheme + 3);
+            target = slash == std::string::npos ? "/" : target.substr(slash);
+        }
+
+        server.requests++;
+        requestLog.push_back({String(conn.host.c_str()), String(target.c_str())});
+        fake::network::Response response = server.handler(String(target.c_str()));
+
+        bool close = !response.keepAlive || lowercase(head).find("connection: close") != std::string::npos;
+        std::string body = response.body.c_str();
+
+        char header[256];
+        snprintf(header, sizeof(header), "HTTP/1.1 %d %s\r\nContent-Type: application/json\r\n", response.status,
+                 reasonPhrase(response.status));
+        std::string text = header;
+        if (response.chunked)
+            text += "Transfer-Encoding: chunked\r\n";
+        else
+            text += "Content-Length: " + std::to_string(body.size()) + "\r\n";
+        text += close ? "Connection: close\r\n\r\n" : "Connection: keep-alive\r\n\r\n";
+
+        std::string content;
+        if (response.chunked)
+        {
+            for (size_t pos = 0; pos < body.size(); pos += ChunkSize)
+            {
+                std::string chunk = body.substr(pos, ChunkSize);
+                snprintf(header, sizeof(header), "%zx\r\n", chunk.size());
+                content += header + chunk + "\r\n";
+            }
+            content += "0\r\n\r\n";
+        }
+        else
+            content = body;
+
+        bool truncated = response.truncateAt >= 0 && (size_t)response.truncateAt < content.size();
+        text += truncated ? content.substr(0, response.truncateAt) : content;
+
+        // the response arrives a piece at a time at the download speed, after the round trip and the server's
+        // latency, and responses on one connection arrive in order
+        double microsPerByte = response.bytesPerSecond > 0 ? 1e6 / response.bytesPerSecond
+                                                           : 1e3 / std::max<uint32_t>(server.options.bytesPerMilli, 1);
+        size_t pieceSize = response.bytesPerSecond > 0 ? SlowPieceSize : PieceSize;
+        uint64_t now = fake::clock::uptimeMicros();
+        uint64_t from = conn.response.empty() ? now : std::max(now, conn.response.back().readyAt);
+        from += ((uint64_t)server.options.roundTripMillis + response.latencyMillis) * 1000;
+        for (size_t pos = 0; pos < text.size(); pos += pieceSize)
+        {
+            std::string piece = text.substr(pos, pieceSize);
+            uint64_t readyAt = from + (uint64_t)((pos + piece.size()) * microsPerByte);
+            conn.response.push_back({readyAt, piece});
+        }
+        conn.closeAfterResponse = conn.closeAfterResponse || close || truncated;
+    }
+}
+
+WiFiClass WiFi;
+
+bool WiFiClass::mode(wifi_mode_t mode)
+{
+    m_mode = mode;
+    return true;
+}
+
+wifi_event_id_t WiFiClass::onEvent(WiFiEventFuncCb callback)
+{
+    m_callbacks.push_back(callback);
+    return m_callbacks.size() - 1;
+}
+
+void WiFiClass::removeEvent(wifi_event_id_t id)
+{
+    if (id < m_callbacks.size())
+        m_callbacks[id] = nullptr;
+}
+
+void WiFiClass::fire(arduino_event_id_t event)
+{
+    arduino_event_info_t info{0};
+    for (auto& callback : m_callbacks)
+        if (callback)
+            callback(event, info);
+}
+
+wl_status_t WiFiClass::begin(const char* ssid, const char* password, int32_t channel, const uint8_t* bssid,
+                             bool connect)
+{
+    if (!connect)
+        return m_status;
+
+    // blocks for the time the connection takes rather than running in the background, the events have
+    // all fired by the time it returns
+    fake::clock::advanceMillis(channel == 0 ? accessPoint.scanMillis : 0);
+    bool found = haveAccessPoint && accessPoint.inRange && accessPoint.ssid == ssid &&
+                 (channel == 0 || channel == accessPoint.channel) &&
+                 (bssid == nullptr || memcmp(bssid, accessPoint.bssid, sizeof(m_bssid)) == 0);
+    if (!found)
+    {
+        // a directed connection gives up after trying to associate, a full one after the scan
+        if (channel != 0)
+            fake::clock::advanceMillis(accessPoint.associateMillis);
+        m_status = WL_NO_SSID_AVAIL;
+        fire(ARDUINO_EVENT_WIFI_STA_DISCONNECTED);
+        return m_status;
+    }
+
+    fake::clock::advanceMillis(accessPoint.associateMillis);
+    if (accessPoint.password != (password ? password : ""))
+    {
+        m_status = WL_CONNECT_FAILED;
+        fire(ARDUINO_EVENT_WIFI_STA_DISCONNECTED);
+        return m_status;
+    }
+
+    connects++;
+    m_status = WL_CONNECTED;
+    m_channel = accessPoint.channel;
+    memcpy(m_bssid, accessPoint.bssid, sizeof(m_bssid));
+    fire(ARDUINO_EVENT_WIFI_STA_CONNECTED);
+
+    if (!m_staticIp)
+    {
+        fake::clock::advanceMillis(accessPoint.dhcpMillis);
+        dhcps++;
+        m_localIp = IPAddress(192, 168, 1, 23);
+        m_gateway = IPAddress(192, 168, 1, 1);
+        m_subnet = IPAddress(255, 255, 255, 0);
+        m_dns1 = IPAddress(192, 168, 1, 1);
+        m_dns2 = IPAddress(8, 8, 8, 8);
+    }
+    fire(ARDUINO_EVENT_WIFI_STA_GOT_IP);
+    return m_status;
+}
+
+bool WiFiClass::config(IPAddress localIp, IPAddress gateway, IPAddress subnet, IPAddress dns1, IPAddress dns2)
+{
+    m_staticIp = (uint32_t)localIp != 0;
+    if (m_staticIp)
+    {
+        m_localIp = localIp;
+        m_gateway = gateway;
+        m_subnet = subnet;
+        m_dns1 = dns1;
+        m_dns2 = dns2;
+    }
+    return true;
+}
+
+bool WiFiClass::disconnect(bool wifiOff)
+{
+    bool wasConnected = m_status == WL_CONNECTED;
+    m_status = WL_DISCONNECTED;
+    if (wasConnected)
+        fire(ARDUINO_EVENT_WIFI_STA_DISCONNECTED);
+    if (wifiOff)
+        m_mode = WIFI_OFF;
+    return true;
+}
+
+int WiFiClass::hostByName(const char* host, IPAddress& result)
+{
+    Server* server = findServer(host);
+    if (m_status != WL_CONNECTED || !server)
+        return 0;
+
+    fake::clock::advanceMillis(server->options.dnsMillis);
+    result = server->ip;
+    return 1;
+}
+
+int16_t WiFiClass::scanNetworks()
+{
+    fake::clock::advanceMillis(accessPoint.scanMillis);
+    return haveAccessPoint && accessPoint.inRange ? 1 : 0;
+}
+
+String WiFiClass::SSID(uint8_t index)
+{
+    return index == 0 && haveAccessPoint ? accessPoint.ssid : String();
+}
+
+int32_t WiFiClass::RSSI(uint8_t index)
+{
+    return index == 0 ? -62 : 0;
+}
+
+bool WiFiClass::softAP(const char* ssid, const char* password)
+{
+    (void)ssid;
+    (void)password;
+    m_mode = m_mode == WIFI_STA ? WIFI_AP_STA : WIFI_AP;
+    return true;
+}
+
+void WiFiClass::reset()
+{
+    *this = WiFiClass();
+}
+
+namespace fake
+{
+
+namespace wifi
+{
+    void setAccessPoint(const AccessPoint& newAccessPoint)
+    {
+        accessPoint = newAccessPoint;
+        haveAccessPoint = true;
+    }
+
+    void clear()
+    {
+        accessPoint = AccessPoint();
+        haveAccessPoint = false;
+        connects = 0;
+        dhcps = 0;
+        WiFi.reset();
+    }
+
+    int connectCount()
+    {
+        return connects;
+    }
+
+    int dhcpCount()
+    {
+        return dhcps;
+    }
+}
+
+namespace network
+{
+    void addServer(const String& host, Handler handler, const ServerOptions& options)
+    {
+        Server server;
+        server.handler = handler;
+        server.options = options;
+        server.ip = IPAddress(10, 0, 0, servers.size() + 1);
+        servers[host.c_str()] = server;
+    }
+
+    void setServerDown(const String& host, bool down)
+    {
+        if (Server* server = findServer(host.c_str()))
+            server->down = down;
+    }
+
+    void clear()
+    {
+        for (auto& [socket, conn] : connections)
+        {
+            close(socket);
+            close(conn.peer);
+        }
+        connections.clear();
+        servers.clear();
+        requestLog.clear();
+    }
+
+    const std::vector<Request>& requests()
+    {
+        return requestLog;
+    }
+
+    int requestCount(const String& host)
+    {
+        Server* server = findServer(host.c_str());
+        return server ? server->requests : 0;
+    }
+
+    int handshakeCount(const String& host)
+    {
+        Server* server = findServer(host.c_str());
+        return server ? server->handshakes : 0;
+    }
+
+    int resumedHandshakeCount(const String& host)
+    {
+        Server* server = findServer(host.c_str());
+        return server ? server->resumedHandshakes : 0;
+    }
+}
+
+}
+
+int lwip_socket(int, int, int)
+{
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0)
+        return -1;
+    connections[fds[0]].peer = fds[1];
+    return fds[0];
+}
+
+int lwip_connect(int socket, const struct sockaddr* name, socklen_t)
+{
+    auto it = connections.find(socket);
+    Server* server = findServer(((const struct sockaddr_in*)name)->sin_addr.s_addr);
+    if (it == connections.end() || !server || server->down)
+    {
+        errno = ECONNREFUSED;
+        return -1;
+    }
+
+    fake::clock::advanceMillis(server->options.roundTripMillis);
+    for (auto& [host, candidate] : servers)
+        if (&candidate == server)
+            it->second.host = host;
+    it->second.lastActivity = fake::clock::uptimeMicros();
+    return 0;
+}
+
+int lwip_close(int socket)
+{
+    auto it = connections.find(socket);
+    if (it != connections.end())
+    {
+        close(it->second.peer);
+        connections.erase(it);
+    }
+    return close(socket);
+}
+
+int mbedtls_net_send(void*, const unsigned char*, size_t len)
+{
+    return len;
+}
+
+int mbedtls_net_recv(void*, unsigned char*, size_t)
+{
+    return MBEDTLS_ERR_SSL_WANT_READ;
+}
+
+void mbedtls_entropy_init(mbedtls_entropy_context*) {}
+void mbedtls_entropy_free(mbedtls_entropy_context*) {}
+
+int mbedtls_entropy_func(void*, unsigned char* output, size_t len)
+{
+    memset(output, 0x5a, len);
+    return 0;
+}
+
+void mbedtls_ctr_drbg_init(mbedtls_ctr_drbg_context*) {}
+void mbedtls_ctr_drbg_free(mbedtls_ctr_drbg_context*) {}
+
+int mbedtls_ctr_drbg_seed(mbedtls_ctr_drbg_context*, int (*)(void*, unsigned char*, size_t), void*,
+                          const unsigned char*, size_t)
+{
+    return 0;
+}
+
+int mbedtls_ctr_drbg_random(void*, unsigned char* output, size_t len)
+{
+    memset(output, 0xa5, len);
+    return 0;
+}
+
+void mbedtls_ssl_init(mbedtls_ssl_context* ssl)
+{
+    memset(ssl, 0, sizeof(*ssl));
+    ssl->connection = -1;
+}
+
+void mbedtls_ssl_free(mbedtls_ssl_context* ssl)
+{
+    mbedtls_ssl_init(ssl);
+}
+
+void mbedtls_ssl_config_init(mbedtls_ssl_config* conf)
+{
+    memset(conf, 0, sizeof(*conf));
+}
+
+void mbedtls_ssl_config_free(mbedtls_ssl_config*) {}
+
+int mbedtls_ssl_config_defaults(mbedtls_ssl_config*, int, int, int)
+{
+    return 0;
+}
+
+void mbedtls_ssl_conf_authmode(mbedtls_ssl_config* conf, int authmode)
+{
+    conf->authmode = authmode;
+}
+
+void mbedtls_ssl_conf_rng(mbedtls_ssl_config*, int (*)(void*, unsigned char*, size_t), void*) {}
+void mbedtls_ssl_conf_session_tickets(mbedtls_ssl_config*, int) {}
+
+int mbedtls_ssl_setup(mbedtls_ssl_context*, const mbedtls_ssl_config*)
+{
+    return 0;
+}
+
+int mbedtls_ssl_set_hostname(mbedtls_ssl_context* ssl, const char* hostname)
+{
+    if (strlen(hostname) >= sizeof(ssl->hostname))
+        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    strcpy(ssl->hostname, hostname);
+    return 0;
+}
+
+void mbedtls_ssl_set_bio(mbedtls_ssl_context* ssl, void* bio, mbedtls_ssl_send_t*, mbedtls_ssl_recv_t*,
+                         mbedtls_ssl_recv_timeout_t*)
+{
+    ssl->bio = bio;
+}
+
+int mbedtls_ssl_handshake(mbedtls_ssl_context* ssl)
+{
+    if (ssl->connection < 0)
+    {
+        ssl->connection = *(int*)ssl->bio;
+        Connection* conn = findConnection(ssl);
+        Server* server = conn ? findServer(conn->host) : nullptr;
+        if (!server || server->down)
+            return MBEDTLS_ERR_SSL_HANDSHAKE_FAILURE;
+
+        // the server resumes a session it created if it was offered one and supports resumption
+        bool resumed = server->options.sessionResumption && ssl->offered.hostHash == hostHash(conn->host) &&
+                       server->sessions.count(ssl->offered.start) > 0;
+        server->handshakes++;
+        uint32_t rtt = server->options.roundTripMillis;
+        uint32_t millis;
+        if (resumed)
+        {
+            server->resumedHandshakes++;
+            ssl->session = ssl->offered;
+            millis = rtt + ResumedHandshakeMillis;
+        }
+        else
+        {
+            // sessions only need a unique start time, the real time makes them look like real ones
+            lastSessionStart = std::max(lastSessionStart + 1, fake::clock::trueMicros() / 1000000);
+            ssl->session.start = lastSessionStart;
+            ssl->session.hostHash = hostHash(conn->host);
+            server->sessions.insert(lastSessionStart);
+            millis = 2 * rtt + FullHandshakeMillis;
+        }
+        ssl->handshakeDone = fake::clock::uptimeMicros() + (uint64_t)millis * 1000;
+        return MBEDTLS_ERR_SSL_WANT_READ;
+    }
+
+    if ((int64_t)fake::clock::uptimeMicros() < ssl->handshakeDone)
+        return MBEDTLS_ERR_SSL_WANT_READ;
+    if (Connection* conn = findConnection(ssl))
+        conn->lastActivity = fake::clock::uptimeMicros();
+    return 0;
+}
+
+int mbedtls_ssl_write(mbedtls_ssl_context* ssl, const unsigned char* buf, size_t len)
+{
+    Connection* conn = findConnection(ssl);
+    if (!conn)
+        return MBEDTLS_ERR_NET_CONN_RESET;
+
+    // a write after the server closed is still accepted, the close only shows when reading
+    updateConnection(*conn);
+    if (conn->closed)
+        return len;
+
+    Server* server = findServer(conn->host);
+    conn->request.append((const char*)buf, len);
+    size_t end;
+    while ((end = conn->request.find("\r\n\r\n")) != std::string::npos)
+    {
+        std::string head = conn->request.substr(0, end);
+        conn->request.erase(0, end + 4);
+        handleRequest(*conn, *server, head);
+    }
+    conn->lastActivity = fake::clock::uptimeMicros();
+    return len;
+}
+
+int mbedtls_ssl_read(mbedtls_ssl_context* ssl, unsigned char* buf, size_t len)
+{
+    Connection* conn = findConnection(ssl);
+    if (!conn)
+        return MBEDTLS_ERR_NET_CONN_RESET;
+
+    size_t ready = bytesReady(*conn);
+    if (ready == 0)
+    {
+        updateConnection(*conn);
+        return conn->closed && conn->response.empty() ? MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY
+                                                      : MBEDTLS_ERR_SSL_WANT_READ;
+    }
+    if (len == 0)
+        return 0;
+
+    size_t count = 0;
+    uint64_t now = fake::clock::uptimeMicros();
+    while (count < len && !conn->response.empty() && conn->response.front().readyAt <= now)
+    {
+        std::string& data = conn->response.front().data;
+        size_t n = std::min(len - count, data.size());
+        memcpy(buf + count, data.data(), n);
+        data.erase(0, n);
+        count += n;
+        if (data.empty())
+            conn->response.pop_front();
+    }
+    conn->lastActivity = now;
+    return count;
+}
+
+size_t mbedtls_ssl_get_bytes_avail(const mbedtls_ssl_context* ssl)
+{
+    Connection* conn = findConnection(ssl);
+    return conn ? bytesReady(*conn) : 0;
+}
+
+int mbedtls_ssl_close_notify(mbedtls_ssl_context*)
+{
+    return 0;
+}
+
+void mbedtls_ssl_session_init(mbedtls_ssl_session* session)
+{
+    memset(session, 0, sizeof(*session));
+}
+
+void mbedtls_ssl_session_free(mbedtls_ssl_session* session)
+{
+    mbedtls_ssl_session_init(session);
+}
+
+int mbedtls_ssl_set_session(mbedtls_ssl_context* ssl, const mbedtls_ssl_session* session)
+{
+    ssl->offered = *session;
+    return 0;
+}
+
+int mbedtls_ssl_get_session(const mbedtls_ssl_context* ssl, mbedtls_ssl_session* session)
+{
+    if (ssl->session.hostHash == 0)
+        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    *session = ssl->session;
+    return 0;
+}
+
+int mbedtls_ssl_session_save(const mbedtls_ssl_session* session, unsigned char* buf, size_t bufLen, size_t* olen)
+{
+    // a real ticket is a couple of hundred bytes, padded so the RTC slot size still matters
+    constexpr size_t SavedBytes = 180;
+    *olen = SavedBytes;
+    if (buf == nullptr || bufLen < SavedBytes)
+        return MBEDTLS_ERR_SSL_BUFFER_TOO_SMALL;
+    memset(buf, 0, SavedBytes);
+    memcpy(buf, session, sizeof(*session));
+    return 0;
+}
+
+int mbedtls_ssl_session_load(mbedtls_ssl_session* session, const unsigned char* buf, size_t len)
+{
+    if (len < sizeof(*session))
+        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    memcpy(session, buf, sizeof(*session));
+    return 0;
+}
@@ -0,0 +1,78 @@
+#ifndef FAKENETWORK_H
+#define FAKENETWORK_H
+
+#include <Arduino.h>
+#include <functional>
+#include <vector>
+
+// fake WiFi access point and HTTPS servers for the native build
+// TlsClient runs unchanged on top of the fake mbedtls and lwip functions, which pass the requests it sends
+// to the handler of the server it connected to and give back the response after the server's latency on
+// the virtual clock
+
+namespace fake
+{
+
+namespace wifi
+{
+    struct AccessPoint
+    {
+        String ssid;
+        String password;
+        int32_t channel = 6;
+        uint8_t bssid[6] = {0x10, 0x20, 0x30, 0x40, 0x50, 0x60};
+        uint32_t scanMillis = 1200;     // finding the access point when the channel isn't given
+        uint32_t associateMillis = 250; // authenticating and associating once it is found
+        uint32_t dhcpMillis = 600;
+        bool inRange = true;
+    };
+
+    void setAccessPoint(const AccessPoint& accessPoint);
+    void clear();
+    int connectCount();
+    int dhcpCount(); // connections that needed DHCP, the rest used a static ip
+}
+
+namespace network
+{
+    struct Response
+    {
+        int status = 200;
+        String body;
+        bool keepAlive = true;
+        bool chunked = false;
+        uint32_t latencyMillis = 0; // time for the server to produce the response, on top of the round trip
+        uint32_t bytesPerSecond = 0; // download speed of just this response, e.g. a slow loris, 0 for the server's
+        int truncateAt = -1;         // bytes of the body sent before the server drops the connection, -1 for all
+    };
+
+    using Handler = std::function<Response(const String& path)>;
+
+    struct ServerOptions
+    {
+        uint32_t dnsMillis = 20;
+        uint32_t roundTripMillis = 40;
+        uint32_t bytesPerMilli = 100;   // download speed
+        bool sessionResumption = true;  // accepts a session from an earlier handshake
+        uint32_t keepAliveMillis = 5000; // idle time before the server closes a kept alive connection
+    };
+
+    struct Request
+    {
+        String host;
+        String path;
+    };
+
+    void addServer(const String& host, Handler handler, const ServerOptions& options = ServerOptions());
+    void setServerDown(const String& host, bool down);
+    void clear();
+
+    const std::vector<Request>& requests();
+    int requestCount(const String& host);
+    int handshakeCount(const String& host);
+    int resumedHandshakeCount(const String& host);
+}
+
+}
+
+#endif
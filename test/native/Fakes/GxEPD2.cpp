@@ -0,0 +1,208 @@
+#include "GxEPD2_BW.h"
+
+#include <algorithm>
+
+namespace
+{
+    uint16_t panelWidth = 0;
+    uint16_t panelHeight = 0;
+    std::vector<bool> lastFrame;
+    int fullRefreshes = 0;
+    int partialRefreshes = 0;
+    bool isHibernating = false;
+    size_t written = 0;
+
+    // the controller's memory is rows of whole bytes, a set bit is white
+    inline size_t memoryIndex(int16_t x, int16_t y)
+    {
+        return (size_t)y * (GxEPD2_213_BN::WIDTH / 8) + x / 8;
+    }
+}
+
+namespace fake
+{
+
+namespace display
+{
+    void reset()
+    {
+        lastFrame.assign(lastFrame.size(), false);
+        fullRefreshes = 0;
+        partialRefreshes = 0;
+        isHibernating = false;
+        written = 0;
+    }
+
+    int refreshCount()
+    {
+        return fullRefreshes + partialRefreshes;
+    }
+
+    int fullRefreshCount()
+    {
+        return fullRefreshes;
+    }
+
+    int partialRefreshCount()
+    {
+        return partialRefreshes;
+    }
+
+    bool hibernating()
+    {
+        return isHibernating;
+    }
+
+    size_t bytesWritten()
+    {
+        return written;
+    }
+
+    bool pixel(int16_t x, int16_t y)
+    {
+        if (x < 0 || y < 0 || x >= panelWidth || y >= panelHeight || lastFrame.empty())
+            return false;
+        return lastFrame[y * panelWidth + x];
+    }
+
+    size_t blackPixels()
+    {
+        return std::count(lastFrame.begin(), lastFrame.end(), true);
+    }
+
+    void panelSize(uint16_t width, uint16_t height)
+    {
+        panelWidth = width;
+        panelHeight = height;
+        lastFrame.resize((size_t)width * height);
+    }
+
+    void write(size_t bytes)
+    {
+        written += bytes;
+    }
+
+    void refresh(const std::vector<uint8_t>& memory, bool partial, uint32_t refreshMillis)
+    {
+        fake::clock::advanceMillis(refreshMillis);
+        for (int16_t y = 0; y < panelHeight; y++)
+            for (int16_t x = 0; x < panelWidth; x++)
+                lastFrame[y * panelWidth + x] = !(memory[memoryIndex(x, y)] & (0x80 >> (x & 7)));
+        (partial ? partialRefreshes : fullRefreshes)++;
+    }
+
+    void setHibernating(bool hibernating)
+    {
+        isHibernating = hibernating;
+    }
+}
+
+}
+
+GxEPD2_213_BN::GxEPD2_213_BN(int16_t cs, int16_t dc, int16_t rst, int16_t busy) :
+    m_memory((size_t)WIDTH / 8 * HEIGHT, 0xFF)
+{
+    (void)cs;
+    (void)dc;
+    (void)rst;
+    (void)busy;
+    fake::display::panelSize(WIDTH_VISIBLE, HEIGHT);
+}
+
+void GxEPD2_213_BN::init(uint32_t serial_diag_bitrate, bool initial, uint16_t reset_duration, bool pulldown_rst_mode)
+{
+    (void)serial_diag_bitrate;
+    (void)reset_duration;
+    (void)pulldown_rst_mode;
+    m_initialRefresh = initial;
+    fake::display::setHibernating(false);
+}
+
+void GxEPD2_213_BN::writeImage(const uint8_t bitmap[], int16_t x, int16_t y, int16_t w, int16_t h, bool invert,
+                               bool mirror_y, bool pgm)
+{
+    writeImagePart(bitmap, 0, 0, w, h, x, y, w, h, invert, mirror_y, pgm);
+}
+
+void GxEPD2_213_BN::writeImagePart(const uint8_t bitmap[], int16_t x_part, int16_t y_part, int16_t w_bitmap,
+                                   int16_t h_bitmap, int16_t x, int16_t y, int16_t w, int16_t h, bool invert,
+                                   bool mirror_y, bool pgm)
+{
+    (void)h_bitmap;
+    (void)mirror_y;
+    (void)pgm;
+    // the driver only writes whole bytes
+    int16_t bitmapBytesPerRow = (w_bitmap + 7) / 8;
+    int16_t bytes = (w + 7) / 8;
+    for (int16_t row = 0; row < h; row++)
+    {
+        if (y + row < 0 || y + row >= HEIGHT)
+            continue;
+        for (int16_t i = 0; i < bytes; i++)
+        {
+            if (x / 8 + i < 0 || x / 8 + i >= WIDTH / 8)
+                continue;
+            uint8_t data = bitmap[(y_part + row) * bitmapBytesPerRow + x_part / 8 + i];
+            m_memory[memoryIndex(x + i * 8, y + row)] = invert ? ~data : data;
+        }
+    }
+    fake::display::write((size_t)bytes * h);
+}
+
+void GxEPD2_213_BN::writeImageForFullRefresh(const uint8_t bitmap[], int16_t x, int16_t y, int16_t w, int16_t h,
+                                             bool invert, bool mirror_y, bool pgm)
+{
+    // into both of the controller's memories
+    writeImage(bitmap, x, y, w, h, invert, mirror_y, pgm);
+    fake::display::write((size_t)(w + 7) / 8 * h);
+}
+
+void GxEPD2_213_BN::writeImageAgain(const uint8_t bitmap[], int16_t x, int16_t y, int16_t w, int16_t h, bool invert,
+                                    bool mirror_y, bool pgm)
+{
+    writeImage(bitmap, x, y, w, h, invert, mirror_y, pgm);
+}
+
+void GxEPD2_213_BN::writeImagePartAgain(const uint8_t bitmap[], int16_t x_part, int16_t y_part, int16_t w_bitmap,
+                                        int16_t h_bitmap, int16_t x, int16_t y, int16_t w, int16_t h, bool invert,
+                                        bool mirror_y, bool pgm)
+{
+    writeImagePart(bitmap, x_part, y_part, w_bitmap, h_bitmap, x, y, w, h, invert, mirror_y, pgm);
+}
+
+void GxEPD2_213_BN::refresh(bool partial_update_mode)
+{
+    bool partial = partial_update_mode && !m_initialRefresh;
+    m_initialRefresh = false;
+    fake::display::setHibernating(false);
+    waitWhileBusy();
+    fake::display::refresh(m_memory, partial, power_on_time + (partial ? partial_refresh_time : full_refresh_time));
+}
+
+void GxEPD2_213_BN::refresh(int16_t x, int16_t y, int16_t w, int16_t h)
+{
+    (void)x;
+    (void)y;
+    (void)w;
+    (void)h;
+    refresh(true);
+}
+
+void GxEPD2_213_BN::powerOff()
+{
+    waitWhileBusy();
+    fake::clock::advanceMillis(power_off_time);
+}
+
+void GxEPD2_213_BN::hibernate()
+{
+    powerOff();
+    fake::display::setHibernating(true);
+}
+
+void GxEPD2_213_BN::waitWhileBusy()
+{
+    // once, the fake panel is only busy for as long as the clock is moved on for the refresh
+    if (m_busyCallback)
+        m_busyCallback(m_busyCallbackParameter);
+}
@@ -0,0 +1,97 @@
+#ifndef FAKE_GXEPD2_BW_H
+#define FAKE_GXEPD2_BW_H
+
+#include <Arduino.h>
+#include <vector>
+#include "Adafruit_GFX.h"
+
+// e-paper panel driver for the native build, as the GxEPD2 driver class behind GxEPD2_BW
+// images are written into the controller's memory and a refresh shows it, taking the panel's refresh time on
+// the virtual clock, and each one is counted in fake::display along with the bytes written
+
+#define GxEPD_BLACK 0x0000
+#define GxEPD_WHITE 0xFFFF
+
+class GxEPD2_213_BN
+{
+public:
+    static constexpr uint16_t WIDTH = 128; // of the controller's memory, in whole bytes
+    static constexpr uint16_t WIDTH_VISIBLE = 122;
+    static constexpr uint16_t HEIGHT = 250;
+    static constexpr bool hasFastPartialUpdate = true;
+    static constexpr uint32_t full_refresh_time = 4000; // ms, from the GxEPD2 driver
+    static constexpr uint32_t partial_refresh_time = 800;
+    static constexpr uint32_t power_on_time = 100;
+    static constexpr uint32_t power_off_time = 150;
+
+    GxEPD2_213_BN(int16_t cs, int16_t dc, int16_t rst, int16_t busy);
+
+    void init(uint32_t serial_diag_bitrate, bool initial, uint16_t reset_duration = 10,
+              bool pulldown_rst_mode = false);
+
+    // part of a bitmap of w_bitmap x h_bitmap pixels (rows of whole bytes) into the controller's memory at x, y
+    void writeImage(const uint8_t bitmap[], int16_t x, int16_t y, int16_t w, int16_t h, bool invert = false,
+                    bool mirror_y = false, bool pgm = false);
+    void writeImagePart(const uint8_t bitmap[], int16_t x_part, int16_t y_part, int16_t w_bitmap, int16_t h_bitmap,
+                        int16_t x, int16_t y, int16_t w, int16_t h, bool invert = false, bool mirror_y = false,
+                        bool pgm = false);
+    // the full refresh also sets the memory the next partial refresh compares with
+    void writeImageForFullRefresh(const uint8_t bitmap[], int16_t x, int16_t y, int16_t w, int16_t h,
+                                  bool invert = false, bool mirror_y = false, bool pgm = false);
+    // after a refresh, so the memory the next partial refresh compares with is what is shown
+    void writeImageAgain(const uint8_t bitmap[], int16_t x, int16_t y, int16_t w, int16_t h, bool invert = false,
+                         bool mirror_y = false, bool pgm = false);
+    void writeImagePartAgain(const uint8_t bitmap[], int16_t x_part, int16_t y_part, int16_t w_bitmap,
+                             int16_t h_bitmap, int16_t x, int16_t y, int16_t w, int16_t h, bool invert = false,
+                             bool mirror_y = false, bool pgm = false);
+
+    // called while waiting for the panel to finish a refresh or power off, instead of polling BUSY every ms
+    void setBusyCallback(void (*busyCallback)(const void*), const void* busy_callback_parameter = 0)
+    {
+        m_busyCallback = busyCallback;
+        m_busyCallbackParameter = busy_callback_parameter;
+    }
+
+    void refresh(bool partial_update_mode = false);
+    // the first refresh after an initial init is always full, as the driver does, so the panel starts from a
+    // known state
+    void refresh(int16_t x, int16_t y, int16_t w, int16_t h);
+    void powerOff();
+    void hibernate();
+
+private:
+    void waitWhileBusy();
+
+    std::vector<uint8_t> m_memory;
+    bool m_initialRefresh = true;
+    void (*m_busyCallback)(const void*) = nullptr;
+    const void* m_busyCallbackParameter = nullptr;
+};
+
+namespace fake
+{
+
+namespace display
+{
+    void reset();
+    int refreshCount();
+    int fullRefreshCount();
+    int partialRefreshCount();
+    bool hibernating();
+    // written into the controller's memory since the reset, including the writes after a refresh
+    size_t bytesWritten();
+
+    // of the last refresh, in panel coordinates (before rotation), true is black
+    bool pixel(int16_t x, int16_t y);
+    size_t blackPixels();
+
+    // used by the driver
+    void panelSize(uint16_t width, uint16_t height);
+    void write(size_t bytes);
+    void refresh(const std::vector<uint8_t>& memory, bool partial, uint32_t refreshMillis);
+    void setHibernating(bool hibernating);
+}
+
+}
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef FAKE_IPADDRESS_H
+#define FAKE_IPADDRESS_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "WString.h"
+
+class IPAddress
+{
+public:
+    IPAddress() = default;
+    IPAddress(uint32_t address) : m_address(address) {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) :
+        m_address(a | (b << 8) | (c << 16) | ((uint32_t)d << 24))
+    {
+    }
+
+    operator uint32_t() const { return m_address; }
+    bool operator==(const IPAddress& rhs) const { return m_address == rhs.m_address; }
+    uint8_t operator[](int index) const { return (m_address >> (8 * index)) & 0xFF; }
+
+    String toString() const
+    {
+        char buf[16];
+        snprintf(buf, sizeof(buf), "%u.%u.%u.%u", (*this)[0], (*this)[1], (*this)[2], (*this)[3]);
+        return String(buf);
+    }
+
+private:
+    uint32_t m_address = 0; // first octet in the lowest byte, as lwip stores it
+};
+
+extern const IPAddress INADDR_NONE;
+
+#endif
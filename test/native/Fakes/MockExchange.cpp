@@ -0,0 +1,446 @@
+#include "MockExchange.h"
+
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    constexpr uint32_t SecondsOneMinute = 60;
+    constexpr uint32_t SecondsOneHour = 3600;
+    constexpr uint32_t SecondsOneDay = 86400;
+    constexpr uint32_t CurvePeriodSeconds = 30 * SecondsOneDay;
+    constexpr float CurveAmplitude = 0.1f;
+
+    // ids coingecko uses instead of symbols, only the common ones
+    const std::map<String, String> coinGeckoIds = {{"BTC", "bitcoin"}, {"ETH", "ethereum"}, {"BNB", "binancecoin"},
+                                                   {"SOL", "solana"},  {"XRP", "ripple"},   {"ADA", "cardano"},
+                                                   {"DOGE", "dogecoin"}, {"DOT", "polkadot"}, {"LTC", "litecoin"}};
+
+    fake::exchange::Options options;
+    std::map<String, fake::exchange::Faults> faults; // by host, "" for the default
+    std::map<String, float> basePrices;              // by "crypto/fiat"
+    std::vector<std::pair<String, String>> recorded;  // path prefix and body
+    fake::exchange::Stats counts{};
+    std::mt19937 faultRandom;
+
+    uint32_t nowUnix()
+    {
+        return fake::clock::trueMicros() / 1000000;
+    }
+
+    float curve(uint32_t unix)
+    {
+        return 1 + CurveAmplitude * sinf(2 * M_PI * (unix % CurvePeriodSeconds) / CurvePeriodSeconds);
+    }
+
+    String key(const String& crypto, String fiat)
+    {
+        fiat.toUpperCase();
+        if (fiat == "USDT")
+            fiat = "USD";
+        return crypto + "/" + fiat;
+    }
+
+    bool havePrice(const String& crypto, const String& fiat)
+    {
+        return basePrices.count(key(crypto, fiat)) > 0;
+    }
+
+    String query(const String& path, const String& name)
+    {
+        int start = path.indexOf('?');
+        while (start >= 0)
+        {
+            int end = path.indexOf('&', start + 1);
+            String param = path.substring(start + 1, end < 0 ? path.length() : end);
+            if (param.startsWith(name + "="))
+                return param.substring(name.length() + 1);
+            start = end;
+        }
+        return String();
+    }
+
+    std::vector<String> split(const String& list, const String& separator)
+    {
+        std::vector<String> items;
+        int start = 0;
+        while (start <= (int)list.length())
+        {
+            int end = list.indexOf(separator, start);
+            if (end < 0)
+                end = list.length();
+            if (end > start)
+                items.push_back(list.substring(start, end));
+            start = end + separator.length();
+        }
+        return items;
+    }
+
+    String number(float value, int decimals)
+    {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%.*f", decimals, value);
+        return buf;
+    }
+
+    // samples from start to end at the interval, aligned to it as the apis do
+    std::vector<uint32_t> sampleTimes(uint32_t start, uint32_t end, uint32_t interval, size_t limit)
+    {
+        std::vector<uint32_t> times;
+        for (uint32_t t = (start + interval - 1) / interval * interval; t <= end && times.size() < limit; t += interval)
+            times.push_back(t);
+        return times;
+    }
+
+    // splits a binance symbol such as BTCUSDT into its crypto and fiat
+    bool splitBinanceSymbol(const String& symbol, String& crypto_out, String& fiat_out)
+    {
+        for (const char* quote : {"USDT", "GBP", "EUR", "USD"})
+        {
+            if (symbol.endsWith(quote) && symbol.length() > strlen(quote))
+            {
+                crypto_out = symbol.substring(0, symbol.length() - strlen(quote));
+                fiat_out = quote;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    fake::network::Response notFound(const String& body, int status = 200)
+    {
+        counts.notFound++;
+        fake::network::Response response;
+        response.status = status;
+        response.body = body;
+        return response;
+    }
+
+    fake::network::Response coinGecko(const String& path)
+    {
+        fake::network::Response response;
+        response.latencyMillis = options.latencyMillis;
+
+        auto symbolOf = [](const String& id)
+        {
+            for (const auto& [symbol, candidate] : coinGeckoIds)
+                if (candidate == id)
+                    return symbol;
+            return String();
+        };
+
+        if (path.startsWith("/api/v3/simple/price"))
+        {
+            // {"bitcoin":{"gbp":33357.5612},"ethereum":{"gbp":1650.1234}}
+            String fiat = query(path, "vs_currencies");
+            fiat.toLowerCase();
+            String body = "{";
+            for (const auto& id : split(query(path, "ids"), ","))
+            {
+                String crypto = symbolOf(id);
+                if (!havePrice(crypto, fiat))
+                    continue;
+                if (body.length() > 1)
+                    body += ",";
+                body += "\"" + id + "\":{\"" + fiat + "\":" + number(fake::exchange::priceAt(crypto, fiat, nowUnix()), 4) + "}";
+            }
+            body += "}";
+            if (body == "{}")
+                return notFound(body);
+            response.body = body;
+            return response;
+        }
+
+        if (path.startsWith("/api/v3/coins/") && path.indexOf("/market_chart/range") > 0)
+        {
+            // {"prices":[[1701021346883,29585.3912]],"market_caps":[...],"total_volumes":[...]}
+            String crypto = symbolOf(path.substring(strlen("/api/v3/coins/"), path.indexOf("/market_chart")));
+            String fiat = query(path, "vs_currency");
+            if (!havePrice(crypto, fiat))
+                return notFound("{\"error\":\"coin not found\"}", 404);
+
+            uint32_t from = query(path, "from").toInt();
+            uint32_t to = query(path, "to").toInt();
+            uint32_t range = to - from;
+            // the public API refuses anything from before the last 365 days
+            if (from + 365 * SecondsOneDay < nowUnix())
+            {
+                response.status = 401;
+                response.body = "{\"error\":{\"status\":{\"error_code\":10012,\"error_message\":\"Your request exceeds "
+                                "the allowed time range. Public API users are limited to querying historical data "
+                                "within the past 365 days.\"}}}";
+                return response;
+            }
+            uint32_t interval = range <= SecondsOneDay ? 5 * SecondsOneMinute
+                              : range <= 90 * SecondsOneDay ? SecondsOneHour : SecondsOneDay;
+
+            String prices;
+            String caps;
+            for (uint32_t t : sampleTimes(from, to, interval, SIZE_MAX))
+            {
+                String sep = prices.isEmpty() ? "" : ",";
+                float price = fake::exchange::priceAt(crypto, fiat, t);
+                prices += sep + "[" + String((uint64_t)t * 1000) + "," + number(price, 4) + "]";
+                caps += sep + "[" + String((uint64_t)t * 1000) + "," + number(price * 19e6f, 1) + "]";
+            }
+            response.body = "{\"prices\":[" + prices + "],\"market_caps\":[" + caps + "],\"total_volumes\":[" + caps + "]}";
+            response.latencyMillis = range > SecondsOneDay ? options.historyLatencyMillis : options.latencyMillis;
+            if (range > SecondsOneDay)
+                counts.historyRequests++;
+            return response;
+        }
+
+        return notFound("{\"error\":\"Incorrect path\"}", 404);
+    }
+
+    fake::network::Response kuCoin(const String& path)
+    {
+        fake::network::Response response;
+        response.latencyMillis = options.latencyMillis;
+
+        if (path.startsWith("/api/v1/prices"))
+        {
+            // {"code":"200000","data":{"BTC":"33388.8675121283881416","ETH":"1650.1234"}}
+            String fiat = query(path, "base");
+            String data;
+            for (const auto& crypto : split(query(path, "currencies"), ","))
+            {
+                if (!havePrice(crypto, fiat))
+                    continue;
+                data += (data.isEmpty() ? "\"" : ",\"") + crypto + "\":\"" +
+                        number(fake::exchange::priceAt(crypto, fiat, nowUnix()), 8) + "\"";
+            }
+            if (data.isEmpty())
+                return notFound("{\"code\":\"200000\",\"data\":{}}");
+            response.body = "{\"code\":\"200000\",\"data\":{" + data + "}}";
+            return response;
+        }
+
+        if (path.startsWith("/api/v1/market/candles"))
+        {
+            // {"code":"200000","data":[["1702653780","32372.62","32372.62","32372.62","32372.62","0","0"]]}
+            // newest first
+            String symbol = query(path, "symbol");
+            int dash = symbol.indexOf('-');
+            String crypto = symbol.substring(0, dash);
+            String fiat = symbol.substring(dash + 1);
+            if (dash < 0 || !havePrice(crypto, fiat))
+                return notFound("{\"code\":\"400100\",\"msg\":\"This pair is not provided at present\"}");
+
+            String type = query(path, "type");
+            uint32_t interval = type == "1day" ? SecondsOneDay : type == "1hour" ? SecondsOneHour : SecondsOneMinute;
+            std::vector<uint32_t> times = sampleTimes(query(path, "startAt").toInt(), query(path, "endAt").toInt(),
+                                                      interval, 1500);
+            String data;
+            for (auto it = times.rbegin(); it != times.rend(); ++it)
+            {
+                String price = "\"" + number(fake::exchange::priceAt(crypto, fiat, *it), 2) + "\"";
+                data += (data.isEmpty() ? "[\"" : ",[\"") + String(*it) + "\"," + price + "," + price + "," + price +
+                        "," + price + ",\"0\",\"0\"]";
+            }
+            response.body = "{\"code\":\"200000\",\"data\":[" + data + "]}";
+            response.latencyMillis = interval == SecondsOneDay ? options.historyLatencyMillis : options.latencyMillis;
+            if (interval == SecondsOneDay)
+                counts.historyRequests++;
+            return response;
+        }
+
+        return notFound("{\"code\":\"404000\",\"msg\":\"Not Found\"}", 404);
+    }
+
+    fake::network::Response binance(const String& path)
+    {
+        fake::network::Response response;
+        response.latencyMillis = options.latencyMillis;
+        const String invalidSymbol = "{\"code\":-1121,\"msg\":\"Invalid symbol.\"}";
+
+        if (path.startsWith("/api/v3/ticker/price"))
+        {
+            String symbols = query(path, "symbols");
+            if (symbols.isEmpty())
+            {
+                // {"symbol":"BTCUSDT","price":"37500.30000000"}
+                String symbol = query(path, "symbol");
+                String crypto, fiat;
+                if (!splitBinanceSymbol(symbol, crypto, fiat) || !havePrice(crypto, fiat))
+                    return notFound(invalidSymbol, 400);
+                response.body = "{\"symbol\":\"" + symbol + "\",\"price\":\"" +
+                                number(fake::exchange::priceAt(crypto, fiat, nowUnix()), 8) + "\"}";
+                return response;
+            }
+
+            // ["BTCUSDT","ETHUSDT"] url encoded, the whole request fails if any symbol is invalid
+            symbols.replace("%5B", "");
+            symbols.replace("%5D", "");
+            symbols.replace("%22", "");
+            String body;
+            for (const auto& symbol : split(symbols, ","))
+            {
+                String crypto, fiat;
+                if (!splitBinanceSymbol(symbol, crypto, fiat) || !havePrice(crypto, fiat))
+                    return notFound(invalidSymbol, 400);
+                body += (body.isEmpty() ? "[" : ",") + String("{\"symbol\":\"") + symbol + "\",\"price\":\"" +
+                        number(fake::exchange::priceAt(crypto, fiat, nowUnix()), 8) + "\"}";
+            }
+            response.body = body + "]";
+            return response;
+        }
+
+        if (path.startsWith("/api/v3/klines"))
+        {
+            // [[1697382420000,"22138.72000000","22138.72000000","22138.72000000","22138.72000000","0.00000000",
+            //   1697382479999,"0.00000000",0,"0.00000000","0.00000000","0"]]
+            String symbol = query(path, "symbol");
+            String crypto, fiat;
+            if (!splitBinanceSymbol(symbol, crypto, fiat) || !havePrice(crypto, fiat))
+                return notFound(invalidSymbol, 400);
+
+            String intervalName = query(path, "interval");
+            uint32_t interval = intervalName == "1d" ? SecondsOneDay : intervalName == "1h" ? SecondsOneHour : SecondsOneMinute;
+            String limit = query(path, "limit");
+            std::vector<uint32_t> times = sampleTimes(atoll(query(path, "startTime").c_str()) / 1000,
+                                                      atoll(query(path, "endTime").c_str()) / 1000, interval,
+                                                      limit.isEmpty() ? 500 : limit.toInt());
+            String body = "[";
+            for (uint32_t t : times)
+            {
+                String price = "\"" + number(fake::exchange::priceAt(crypto, fiat, t), 8) + "\"";
+                body += (body.length() > 1 ? ",[" : "[") + String((uint64_t)t * 1000) + "," + price + "," + price + "," +
+                        price + "," + price + ",\"0.00000000\"," + String((uint64_t)(t + interval) * 1000 - 1) +
+                        ",\"0.00000000\",0,\"0.00000000\",\"0.00000000\",\"0\"]";
+            }
+            response.body = body + "]";
+            response.latencyMillis = interval == SecondsOneDay ? options.historyLatencyMillis : options.latencyMillis;
+            if (interval == SecondsOneDay)
+                counts.historyRequests++;
+            return response;
+        }
+
+        return notFound("", 404);
+    }
+
+    // coingecko and binance both use /api/v3, but none of their paths overlap
+    fake::network::Response anyExchange(const String& path)
+    {
+        if (path.startsWith("/api/v1/"))
+            return kuCoin(path);
+        if (path.startsWith("/api/v3/ticker") || path.startsWith("/api/v3/klines"))
+            return binance(path);
+        return coinGecko(path);
+    }
+
+    bool roll(float rate)
+    {
+        return rate > 0 && std::uniform_real_distribution<float>(0, 1)(faultRandom) < rate;
+    }
+
+    fake::network::Handler withFaults(const String& host, fake::network::Response (*answer)(const String& path))
+    {
+        return [host, answer](const String& path)
+        {
+            counts.requests++;
+            const fake::exchange::Faults& f = faults.count(host) ? faults[host] : faults[""];
+
+            fake::network::Response response;
+            response.latencyMillis = options.latencyMillis;
+            if (roll(f.rateLimitRate))
+            {
+                counts.rateLimited++;
+                response.status = 429;
+                response.body = "{\"status\":{\"error_code\":429,\"error_message\":\"You've exceeded the Rate Limit\"}}";
+                return response;
+            }
+            if (roll(f.serverErrorRate))
+            {
+                counts.serverErrors++;
+                response.status = counts.serverErrors % 2 ? 503 : 500;
+                response.body = "{\"error\":\"upstream unavailable\"}";
+                return response;
+            }
+
+            response = answer(path);
+            for (const auto& [prefix, body] : recorded)
+            {
+                if (path.startsWith(prefix))
+                {
+                    response.status = 200;
+                    response.body = body;
+                    break;
+                }
+            }
+
+            if (roll(f.truncateRate))
+            {
+                counts.truncated++;
+                response.truncateAt = response.body.length() / 2;
+            }
+            else if (roll(f.slowLorisRate))
+            {
+                counts.slowLoris++;
+                response.bytesPerSecond = f.slowLorisBytesPerSecond;
+            }
+            return response;
+        };
+    }
+}
+
+namespace fake
+{
+
+namespace exchange
+{
+    void install(const Options& newOptions, const String& host)
+    {
+        options = newOptions;
+        faultRandom.seed(options.seed);
+        if (host.isEmpty())
+        {
+            network::addServer("api.coingecko.com", withFaults("api.coingecko.com", coinGecko), options.network);
+            network::addServer("api.kucoin.com", withFaults("api.kucoin.com", kuCoin), options.network);
+            network::addServer("api.binance.com", withFaults("api.binance.com", binance), options.network);
+        }
+        else
+            network::addServer(host, withFaults(host, anyExchange), options.network);
+    }
+
+    void setFaults(const Faults& newFaults, const String& host)
+    {
+        if (host.isEmpty())
+            faults.clear();
+        faults[host] = newFaults;
+    }
+
+    void setPrice(const String& crypto, const String& fiat, float price)
+    {
+        basePrices[key(crypto, fiat)] = price / curve(nowUnix());
+    }
+
+    float priceAt(const String& crypto, const String& fiat, uint32_t unix)
+    {
+        auto it = basePrices.find(key(crypto, fiat));
+        return it == basePrices.end() ? 0 : it->second * curve(unix);
+    }
+
+    void setRecordedResponse(const String& pathPrefix, const String& body)
+    {
+        recorded.emplace_back(pathPrefix, body);
+    }
+
+    Stats stats()
+    {
+        return counts;
+    }
+
+    void clear()
+    {
+        options = Options();
+        faults.clear();
+        basePrices.clear();
+        recorded.clear();
+        counts = Stats{};
+    }
+}
+
+}
@@ -0,0 +1,65 @@
+#ifndef MOCKEXCHANGE_H
+#define MOCKEXCHANGE_H
+
+#include "FakeNetwork.h"
+
+// stand in for the CoinGecko, KuCoin and Binance APIs on the fake network
+// answers the current price, price at time, watchlist and history requests of each data source in the same
+// format as the real API, from prices set in the test, and can be made slow or unreliable to see what the
+// retries and fallback between data sources cost in awake time
+
+namespace fake
+{
+
+namespace exchange
+{
+    struct Faults
+    {
+        float rateLimitRate = 0;   // chance of a request getting a 429
+        float serverErrorRate = 0; // chance of a 500 or 503
+        float truncateRate = 0;    // chance of the connection dropping half way through the body
+        float slowLorisRate = 0;   // chance of the body trickling in at slowLorisBytesPerSecond
+        uint32_t slowLorisBytesPerSecond = 20;
+    };
+
+    struct Options
+    {
+        network::ServerOptions network;
+        uint32_t latencyMillis = 150;        // time for the api to answer, on top of the round trip
+        uint32_t historyLatencyMillis = 400; // for a history request, which is a lot slower
+        uint32_t seed = 1;                   // faults are random but the same on every run with the same seed
+    };
+
+    // adds api.coingecko.com, api.kucoin.com and api.binance.com to the fake network, or a single server
+    // answering for all of them if host is given, for use with RequestBase::setServerOverride
+    void install(const Options& options = Options(), const String& host = String());
+
+    // faults of one of the servers, or of all of them if host is empty
+    void setFaults(const Faults& faults, const String& host = String());
+
+    // current price, the history before now follows a slow made up curve from it so every source agrees
+    void setPrice(const String& crypto, const String& fiat, float price);
+    float priceAt(const String& crypto, const String& fiat, uint32_t unix);
+
+    // body to answer with instead of the generated one for any request whose path starts with pathPrefix, e.g. a
+    // response saved from the real API
+    void setRecordedResponse(const String& pathPrefix, const String& body);
+
+    struct Stats
+    {
+        int requests;
+        int rateLimited;
+        int serverErrors;
+        int truncated;
+        int slowLoris;
+        int notFound; // requests for a crypto or path the exchange doesn't have
+        int historyRequests; // answered requests for a range of daily or hourly samples rather than a single price
+    };
+    Stats stats();
+
+    void clear();
+}
+
+}
+
+#endif
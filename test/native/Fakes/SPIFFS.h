@@ -0,0 +1,19 @@
+#ifndef FAKE_SPIFFS_H
+#define FAKE_SPIFFS_H
+
+#include "FS.h"
+
+class SPIFFSFS : public fs::FS
+{
+public:
+    bool begin(bool formatOnFail = false, const char* basePath = "/spiffs", uint8_t maxOpenFiles = 10,
+               const char* partitionLabel = nullptr);
+    bool format();
+    size_t totalBytes() { return 1408 * 1024; }
+    size_t usedBytes();
+    void end() {}
+};
+
+extern SPIFFSFS SPIFFS;
+
+#endif
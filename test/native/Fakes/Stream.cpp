@@ -0,0 +1,132 @@
+#include "Stream.h"
+#include "FakeClock.h"
+
+#include <cstring>
+#include <vector>
+
+namespace
+{
+    // how far into the target a match has got after each prefix, so a mismatch doesn't lose a partial match
+    std::vector<size_t> prefixTable(const char* target, size_t length)
+    {
+        std::vector<size_t> table(length, 0);
+        for (size_t i = 1, k = 0; i < length; i++)
+        {
+            while (k > 0 && target[i] != target[k])
+                k = table[k - 1];
+            if (target[i] == target[k])
+                k++;
+            table[i] = k;
+        }
+        return table;
+    }
+
+    struct Matcher
+    {
+        Matcher(const char* t) : target(t), length(t ? strlen(t) : 0), table(prefixTable(t, length)) {}
+
+        // true once the whole target has been seen
+        bool next(char c)
+        {
+            while (matched > 0 && c != target[matched])
+                matched = table[matched - 1];
+            if (c == target[matched])
+                matched++;
+            return matched == length;
+        }
+
+        const char* target;
+        size_t length;
+        std::vector<size_t> table;
+        size_t matched = 0;
+    };
+}
+
+int Stream::timedRead()
+{
+    uint64_t start = fake::clock::uptimeMicros();
+    do
+    {
+        int c = read();
+        if (c >= 0)
+            return c;
+        fake::clock::advanceMillis(1);
+    }
+    while (fake::clock::uptimeMicros() - start < (uint64_t)m_timeout * 1000);
+    return -1;
+}
+
+int Stream::timedPeek()
+{
+    uint64_t start = fake::clock::uptimeMicros();
+    do
+    {
+        int c = peek();
+        if (c >= 0)
+            return c;
+        fake::clock::advanceMillis(1);
+    }
+    while (fake::clock::uptimeMicros() - start < (uint64_t)m_timeout * 1000);
+    return -1;
+}
+
+bool Stream::find(const char* target)
+{
+    return findUntil(target, nullptr);
+}
+
+bool Stream::find(char target)
+{
+    char str[2] = {target, 0};
+    return find(str);
+}
+
+bool Stream::findUntil(const char* target, const char* terminator)
+{
+    Matcher targetMatch(target);
+    if (targetMatch.length == 0)
+        return true;
+    Matcher terminatorMatch(terminator);
+    bool useTerminator = terminatorMatch.length > 0;
+
+    int c;
+    while ((c = timedRead()) >= 0)
+    {
+        if (targetMatch.next(c))
+            return true;
+        if (useTerminator && terminatorMatch.next(c))
+            return false;
+    }
+    return false;
+}
+
+size_t Stream::readBytes(char* buffer, size_t length)
+{
+    size_t count = 0;
+    while (count < length)
+    {
+        int c = timedRead();
+        if (c < 0)
+            break;
+        buffer[count++] = (char)c;
+    }
+    return count;
+}
+
+String Stream::readString()
+{
+    String rtn;
+    int c;
+    while ((c = timedRead()) >= 0)
+        rtn += (char)c;
+    return rtn;
+}
+
+String Stream::readStringUntil(char terminator)
+{
+    String rtn;
+    int c;
+    while ((c = timedRead()) >= 0 && c != terminator)
+        rtn += (char)c;
+    return rtn;
+}
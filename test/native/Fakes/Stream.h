@@ -0,0 +1,34 @@
+#ifndef FAKE_STREAM_H
+#define FAKE_STREAM_H
+
+#include "Print.h"
+
+// Arduino Stream for the native build
+// waiting for a byte moves the virtual clock on, so a read timing out takes its timeout of virtual time
+class Stream : public Print
+{
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+
+    void setTimeout(unsigned long timeout) { m_timeout = timeout; }
+    unsigned long getTimeout() const { return m_timeout; }
+
+    bool find(const char* target);
+    bool find(char target);
+    bool findUntil(const char* target, const char* terminator);
+
+    size_t readBytes(char* buffer, size_t length);
+    size_t readBytes(uint8_t* buffer, size_t length) { return readBytes((char*)buffer, length); }
+    String readString();
+    String readStringUntil(char terminator);
+
+protected:
+    int timedRead();
+    int timedPeek();
+
+    unsigned long m_timeout = 1000;
+};
+
+#endif
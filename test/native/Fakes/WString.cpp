@@ -0,0 +1,242 @@
+#include "WString.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+
+namespace
+{
+    template <typename T>
+    std::string toBase(T value, unsigned char base)
+    {
+        if (base == 10)
+            return std::to_string(value);
+
+        bool negative = value < 0;
+        unsigned long long magnitude = negative ? -(long long)value : (unsigned long long)value;
+        std::string digits;
+        do
+        {
+            int digit = magnitude % base;
+            digits += (char)(digit < 10 ? '0' + digit : 'a' + digit - 10);
+            magnitude /= base;
+        }
+        while (magnitude > 0);
+        if (negative)
+            digits += '-';
+        std::reverse(digits.begin(), digits.end());
+        return digits;
+    }
+
+    std::string toDecimals(double value, unsigned int decimalPlaces)
+    {
+        char buf[64];
+        snprintf(buf, sizeof(buf), "%.*f", decimalPlaces, value);
+        return buf;
+    }
+}
+
+String::String(const char* str) : m_str(str ? str : "") {}
+String::String(char c) : m_str(1, c) {}
+String::String(int value, unsigned char base) : m_str(toBase(value, base)) {}
+String::String(unsigned int value, unsigned char base) : m_str(toBase(value, base)) {}
+String::String(long value, unsigned char base) : m_str(toBase(value, base)) {}
+String::String(unsigned long value, unsigned char base) : m_str(toBase(value, base)) {}
+String::String(long long value, unsigned char base) : m_str(toBase(value, base)) {}
+String::String(unsigned long long value, unsigned char base) : m_str(toBase(value, base)) {}
+String::String(float value, unsigned int decimalPlaces) : m_str(toDecimals(value, decimalPlaces)) {}
+String::String(double value, unsigned int decimalPlaces) : m_str(toDecimals(value, decimalPlaces)) {}
+
+bool String::reserve(unsigned int size)
+{
+    m_str.reserve(size);
+    return true;
+}
+
+bool String::concat(const String& str) { m_str += str.m_str; return true; }
+bool String::concat(const char* str) { if (!str) return false; m_str += str; return true; }
+bool String::concat(const char* str, unsigned int length) { if (!str) return false; m_str.append(str, length); return true; }
+bool String::concat(char c) { m_str += c; return true; }
+bool String::concat(unsigned char value) { return concat(String((unsigned int)value)); }
+bool String::concat(int value) { return concat(String(value)); }
+bool String::concat(unsigned int value) { return concat(String(value)); }
+bool String::concat(long value) { return concat(String(value)); }
+bool String::concat(unsigned long value) { return concat(String(value)); }
+bool String::concat(long long value) { return concat(String(value)); }
+bool String::concat(unsigned long long value) { return concat(String(value)); }
+bool String::concat(float value) { return concat(String(value)); }
+bool String::concat(double value) { return concat(String(value)); }
+
+char String::charAt(unsigned int index) const
+{
+    return index < m_str.length() ? m_str[index] : 0;
+}
+
+void String::setCharAt(unsigned int index, char c)
+{
+    if (index < m_str.length())
+        m_str[index] = c;
+}
+
+char& String::operator[](unsigned int index)
+{
+    static char dummy;
+    if (index >= m_str.length())
+    {
+        dummy = 0;
+        return dummy;
+    }
+    return m_str[index];
+}
+
+int String::indexOf(char c, unsigned int fromIndex) const
+{
+    size_t pos = m_str.find(c, fromIndex);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+int String::indexOf(const String& str, unsigned int fromIndex) const
+{
+    size_t pos = m_str.find(str.m_str, fromIndex);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+int String::lastIndexOf(char c) const
+{
+    size_t pos = m_str.rfind(c);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+int String::lastIndexOf(const String& str) const
+{
+    size_t pos = m_str.rfind(str.m_str);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+String String::substring(unsigned int beginIndex) const
+{
+    return substring(beginIndex, m_str.length());
+}
+
+String String::substring(unsigned int beginIndex, unsigned int endIndex) const
+{
+    if (beginIndex > endIndex)
+        std::swap(beginIndex, endIndex);
+    if (beginIndex >= m_str.length())
+        return String();
+    endIndex = std::min<unsigned int>(endIndex, m_str.length());
+    return String(m_str.substr(beginIndex, endIndex - beginIndex));
+}
+
+bool String::equalsIgnoreCase(const String& str) const
+{
+    return m_str.size() == str.m_str.size() &&
+           std::equal(m_str.begin(), m_str.end(), str.m_str.begin(),
+                      [](char a, char b) { return tolower(a) == tolower(b); });
+}
+
+bool String::startsWith(const String& prefix) const
+{
+    return m_str.compare(0, prefix.m_str.length(), prefix.m_str) == 0;
+}
+
+bool String::endsWith(const String& suffix) const
+{
+    return m_str.length() >= suffix.m_str.length() &&
+           m_str.compare(m_str.length() - suffix.m_str.length(), suffix.m_str.length(), suffix.m_str) == 0;
+}
+
+void String::replace(char find, char replace)
+{
+    std::replace(m_str.begin(), m_str.end(), find, replace);
+}
+
+void String::replace(const String& find, const String& replace)
+{
+    if (find.isEmpty())
+        return;
+    size_t pos = 0;
+    while ((pos = m_str.find(find.m_str, pos)) != std::string::npos)
+    {
+        m_str.replace(pos, find.m_str.length(), replace.m_str);
+        pos += replace.m_str.length();
+    }
+}
+
+void String::remove(unsigned int index)
+{
+    if (index < m_str.length())
+        m_str.erase(index);
+}
+
+void String::remove(unsigned int index, unsigned int count)
+{
+    if (index < m_str.length())
+        m_str.erase(index, count);
+}
+
+void String::toLowerCase()
+{
+    std::transform(m_str.begin(), m_str.end(), m_str.begin(), [](unsigned char c) { return tolower(c); });
+}
+
+void String::toUpperCase()
+{
+    std::transform(m_str.begin(), m_str.end(), m_str.begin(), [](unsigned char c) { return toupper(c); });
+}
+
+void String::trim()
+{
+    size_t begin = m_str.find_first_not_of(" \t\r\n");
+    if (begin == std::string::npos)
+    {
+        m_str.clear();
+        return;
+    }
+    size_t end = m_str.find_last_not_of(" \t\r\n");
+    m_str = m_str.substr(begin, end - begin + 1);
+}
+
+long String::toInt() const
+{
+    return strtol(m_str.c_str(), nullptr, 10);
+}
+
+float String::toFloat() const
+{
+    return strtof(m_str.c_str(), nullptr);
+}
+
+double String::toDouble() const
+{
+    return strtod(m_str.c_str(), nullptr);
+}
+
+String operator+(const String& lhs, const String& rhs)
+{
+    String rtn(lhs);
+    rtn.concat(rhs);
+    return rtn;
+}
+
+String operator+(const String& lhs, const char* rhs)
+{
+    String rtn(lhs);
+    rtn.concat(rhs);
+    return rtn;
+}
+
+String operator+(const char* lhs, const String& rhs)
+{
+    String rtn(lhs);
+    rtn.concat(rhs);
+    return rtn;
+}
+
+String operator+(const String& lhs, char rhs)
+{
+    String rtn(lhs);
+    rtn.concat(rhs);
+    return rtn;
+}
@@ -0,0 +1,95 @@
+#ifndef FAKE_WSTRING_H
+#define FAKE_WSTRING_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+
+// Arduino String for the native build, only what the ticker uses
+class String
+{
+public:
+    String(const char* str = "");
+    String(const std::string& str) : m_str(str) {}
+    String(char c);
+    String(int value, unsigned char base = 10);
+    String(unsigned int value, unsigned char base = 10);
+    String(long value, unsigned char base = 10);
+    String(unsigned long value, unsigned char base = 10);
+    String(long long value, unsigned char base = 10);
+    String(unsigned long long value, unsigned char base = 10);
+    String(float value, unsigned int decimalPlaces = 2);
+    String(double value, unsigned int decimalPlaces = 2);
+
+    const char* c_str() const { return m_str.c_str(); }
+    unsigned int length() const { return m_str.length(); }
+    bool isEmpty() const { return m_str.empty(); }
+    bool reserve(unsigned int size);
+
+    bool concat(const String& str);
+    bool concat(const char* str);
+    bool concat(const char* str, unsigned int length);
+    bool concat(char c);
+    bool concat(unsigned char value);
+    bool concat(int value);
+    bool concat(unsigned int value);
+    bool concat(long value);
+    bool concat(unsigned long value);
+    bool concat(long long value);
+    bool concat(unsigned long long value);
+    bool concat(float value);
+    bool concat(double value);
+
+    template <typename T>
+    String& operator+=(const T& value)
+    {
+        concat(value);
+        return *this;
+    }
+
+    char charAt(unsigned int index) const;
+    void setCharAt(unsigned int index, char c);
+    char operator[](unsigned int index) const { return charAt(index); }
+    char& operator[](unsigned int index);
+
+    int indexOf(char c, unsigned int fromIndex = 0) const;
+    int indexOf(const String& str, unsigned int fromIndex = 0) const;
+    int lastIndexOf(char c) const;
+    int lastIndexOf(const String& str) const;
+    String substring(unsigned int beginIndex) const;
+    String substring(unsigned int beginIndex, unsigned int endIndex) const;
+
+    bool equals(const String& str) const { return m_str == str.m_str; }
+    bool equalsIgnoreCase(const String& str) const;
+    bool startsWith(const String& prefix) const;
+    bool endsWith(const String& suffix) const;
+
+    void replace(char find, char replace);
+    void replace(const String& find, const String& replace);
+    void remove(unsigned int index);
+    void remove(unsigned int index, unsigned int count);
+    void toLowerCase();
+    void toUpperCase();
+    void trim();
+
+    long toInt() const;
+    float toFloat() const;
+    double toDouble() const;
+
+    bool operator==(const String& rhs) const { return m_str == rhs.m_str; }
+    bool operator==(const char* rhs) const { return m_str == rhs; }
+    bool operator!=(const String& rhs) const { return m_str != rhs.m_str; }
+    bool operator!=(const char* rhs) const { return m_str != rhs; }
+    bool operator<(const String& rhs) const { return m_str < rhs.m_str; }
+    bool operator>(const String& rhs) const { return m_str > rhs.m_str; }
+
+private:
+    std::string m_str;
+};
+
+String operator+(const String& lhs, const String& rhs);
+String operator+(const String& lhs, const char* rhs);
+String operator+(const char* lhs, const String& rhs);
+String operator+(const String& lhs, char rhs);
+
+#endif
@@ -0,0 +1,97 @@
+#ifndef FAKE_WIFI_H
+#define FAKE_WIFI_H
+
+#include <Arduino.h>
+#include <functional>
+#include "FakeNetwork.h"
+
+// WiFi for the native build, connects to the access point set with fake::wifi::setAccessPoint
+
+typedef enum
+{
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL = 1,
+    WL_SCAN_COMPLETED = 2,
+    WL_CONNECTED = 3,
+    WL_CONNECT_FAILED = 4,
+    WL_CONNECTION_LOST = 5,
+    WL_DISCONNECTED = 6
+} wl_status_t;
+
+typedef enum
+{
+    WIFI_OFF = 0,
+    WIFI_STA = 1,
+    WIFI_AP = 2,
+    WIFI_AP_STA = 3
+} wifi_mode_t;
+
+typedef enum
+{
+    ARDUINO_EVENT_WIFI_STA_START,
+    ARDUINO_EVENT_WIFI_STA_CONNECTED,
+    ARDUINO_EVENT_WIFI_STA_DISCONNECTED,
+    ARDUINO_EVENT_WIFI_STA_GOT_IP
+} arduino_event_id_t;
+
+typedef struct
+{
+    int reason;
+} arduino_event_info_t;
+
+typedef size_t wifi_event_id_t;
+using WiFiEventFuncCb = std::function<void(arduino_event_id_t event, arduino_event_info_t info)>;
+
+class WiFiClass
+{
+public:
+    void persistent(bool persistent) { (void)persistent; }
+    bool mode(wifi_mode_t mode);
+    wifi_mode_t getMode() { return m_mode; }
+
+    wifi_event_id_t onEvent(WiFiEventFuncCb callback);
+    void removeEvent(wifi_event_id_t id);
+
+    wl_status_t begin(const char* ssid, const char* password = nullptr, int32_t channel = 0,
+                      const uint8_t* bssid = nullptr, bool connect = true);
+    bool config(IPAddress localIp, IPAddress gateway, IPAddress subnet, IPAddress dns1 = (uint32_t)0,
+                IPAddress dns2 = (uint32_t)0);
+    bool disconnect(bool wifiOff = false);
+    wl_status_t status() { return m_status; }
+
+    uint8_t* BSSID() { return m_bssid; }
+    int32_t channel() { return m_channel; }
+    IPAddress localIP() { return m_localIp; }
+    IPAddress gatewayIP() { return m_gateway; }
+    IPAddress subnetMask() { return m_subnet; }
+    IPAddress dnsIP(uint8_t index = 0) { return index == 0 ? m_dns1 : m_dns2; }
+
+    int hostByName(const char* host, IPAddress& result);
+
+    int16_t scanNetworks();
+    String SSID(uint8_t index);
+    int32_t RSSI(uint8_t index);
+    bool softAP(const char* ssid, const char* password = nullptr);
+    IPAddress softAPIP() { return IPAddress(192, 168, 4, 1); }
+
+    void reset(); // back to power on
+
+private:
+    void fire(arduino_event_id_t event);
+
+    wifi_mode_t m_mode = WIFI_OFF;
+    wl_status_t m_status = WL_IDLE_STATUS;
+    std::vector<WiFiEventFuncCb> m_callbacks; // index is the id, removed ones are left empty
+    uint8_t m_bssid[6] = {};
+    int32_t m_channel = 0;
+    bool m_staticIp = false;
+    IPAddress m_localIp;
+    IPAddress m_gateway;
+    IPAddress m_subnet;
+    IPAddress m_dns1;
+    IPAddress m_dns2;
+};
+
+extern WiFiClass WiFi;
+
+#endif
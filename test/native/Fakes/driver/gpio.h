@@ -0,0 +1,29 @@
+#ifndef FAKE_DRIVER_GPIO_H
+#define FAKE_DRIVER_GPIO_H
+
+#include <stdint.h>
+
+// the GPIO wakeup from light sleep, which the fake light sleep doesn't wait on
+
+typedef enum
+{
+    GPIO_NUM_0 = 0,
+    GPIO_NUM_4 = 4,
+    GPIO_NUM_16 = 16,
+    GPIO_NUM_17 = 17,
+} gpio_num_t;
+
+typedef enum
+{
+    GPIO_INTR_DISABLE,
+    GPIO_INTR_POSEDGE,
+    GPIO_INTR_NEGEDGE,
+    GPIO_INTR_ANYEDGE,
+    GPIO_INTR_LOW_LEVEL,
+    GPIO_INTR_HIGH_LEVEL
+} gpio_int_type_t;
+
+int gpio_wakeup_enable(gpio_num_t gpio_num, gpio_int_type_t intr_type);
+int gpio_wakeup_disable(gpio_num_t gpio_num);
+
+#endif
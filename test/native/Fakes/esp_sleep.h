@@ -0,0 +1,46 @@
+#ifndef FAKE_ESP_SLEEP_H
+#define FAKE_ESP_SLEEP_H
+
+#include <stdint.h>
+
+typedef enum
+{
+    ESP_SLEEP_WAKEUP_UNDEFINED,
+    ESP_SLEEP_WAKEUP_ALL,
+    ESP_SLEEP_WAKEUP_EXT0,
+    ESP_SLEEP_WAKEUP_EXT1,
+    ESP_SLEEP_WAKEUP_TIMER,
+    ESP_SLEEP_WAKEUP_TOUCHPAD,
+    ESP_SLEEP_WAKEUP_ULP,
+    ESP_SLEEP_WAKEUP_GPIO
+} esp_sleep_source_t;
+typedef esp_sleep_source_t esp_sleep_wakeup_cause_t;
+
+typedef enum
+{
+    ESP_PD_DOMAIN_RTC_PERIPH,
+    ESP_PD_DOMAIN_RTC_SLOW_MEM,
+    ESP_PD_DOMAIN_RTC_FAST_MEM,
+    ESP_PD_DOMAIN_XTAL
+} esp_sleep_pd_domain_t;
+
+typedef enum
+{
+    ESP_PD_OPTION_OFF,
+    ESP_PD_OPTION_ON,
+    ESP_PD_OPTION_AUTO
+} esp_sleep_pd_option_t;
+
+int esp_sleep_enable_timer_wakeup(uint64_t timeInUs);
+int esp_sleep_disable_wakeup_source(esp_sleep_source_t source);
+int esp_sleep_pd_config(esp_sleep_pd_domain_t domain, esp_sleep_pd_option_t option);
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause();
+
+// light sleep returns straight away, the time asleep is whatever the code waiting on it moves the clock by
+int esp_sleep_enable_gpio_wakeup();
+int esp_light_sleep_start();
+
+// throws fake::device::DeepSleep, which the code running the wake catches to start the next one
+[[noreturn]] void esp_deep_sleep_start();
+
+#endif
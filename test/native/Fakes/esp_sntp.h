@@ -0,0 +1,23 @@
+#ifndef FAKE_ESP_SNTP_H
+#define FAKE_ESP_SNTP_H
+
+#include <sys/time.h>
+
+// configTime() starts a sync that completes fake::device::ntpLatencyMillis later on the virtual clock, as
+// long as NTP is reachable, setting the system time to the true time
+
+typedef enum
+{
+    SNTP_SYNC_STATUS_RESET,
+    SNTP_SYNC_STATUS_COMPLETED,
+    SNTP_SYNC_STATUS_IN_PROGRESS
+} sntp_sync_status_t;
+
+typedef void (*sntp_sync_time_cb_t)(struct timeval* tv);
+
+void sntp_set_sync_status(sntp_sync_status_t status);
+sntp_sync_status_t sntp_get_sync_status();
+void sntp_set_time_sync_notification_cb(sntp_sync_time_cb_t callback);
+void sntp_stop();
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef FAKE_EVENT_GROUPS_H
+#define FAKE_EVENT_GROUPS_H
+
+#include <stdint.h>
+
+// event groups with only the one task, bits are set from inside the fake WiFi calls before anything waits
+// on them, so waiting for bits that aren't set just lets the timeout pass on the virtual clock
+
+typedef uint32_t EventBits_t;
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+struct EventGroupDef_t;
+typedef EventGroupDef_t* EventGroupHandle_t;
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define portMAX_DELAY 0xFFFFFFFF
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms)) // 1 tick per ms as configured for the ESP32 Arduino core
+
+#define BIT0 0x00000001
+#define BIT1 0x00000002
+#define BIT2 0x00000004
+#define BIT3 0x00000008
+
+EventGroupHandle_t xEventGroupCreate();
+void vEventGroupDelete(EventGroupHandle_t group);
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits);
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits);
+EventBits_t xEventGroupGetBits(EventGroupHandle_t group);
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits, BaseType_t clearOnExit,
+                                BaseType_t waitForAllBits, TickType_t ticksToWait);
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef FAKE_TASK_H
+#define FAKE_TASK_H
+
+#include "event_groups.h"
+
+// tasks with only the one real task, a new task runs to completion inside xTaskCreatePinnedToCore, so whatever
+// it does is done before the code that created it carries on
+
+typedef unsigned int UBaseType_t;
+struct TaskDef_t;
+typedef TaskDef_t* TaskHandle_t;
+typedef void (*TaskFunction_t)(void*);
+
+#define tskNO_AFFINITY 0x7FFFFFFF
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t taskCode, const char* name, uint32_t stackDepth, void* parameters,
+                                   UBaseType_t priority, TaskHandle_t* createdTask, BaseType_t coreId);
+// only a task deleting itself at the end of its function
+void vTaskDelete(TaskHandle_t task);
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef _GFXFONT_H_
+#define _GFXFONT_H_
+
+// same layout as Adafruit GFX, so its fonts and the edited ones in the tree can be used unchanged
+
+#include <stdint.h>
+
+typedef struct
+{
+    uint16_t bitmapOffset;
+    uint8_t width;
+    uint8_t height;
+    uint8_t xAdvance;
+    int8_t xOffset;
+    int8_t yOffset;
+} GFXglyph;
+
+typedef struct
+{
+    uint8_t* bitmap;
+    GFXglyph* glyph;
+    uint16_t first;
+    uint16_t last;
+    uint8_t yAdvance;
+} GFXfont;
+
+#endif
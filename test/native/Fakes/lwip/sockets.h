@@ -0,0 +1,20 @@
+#ifndef FAKE_LWIP_SOCKETS_H
+#define FAKE_LWIP_SOCKETS_H
+
+// sockets are real (a socketpair per connection) so select, fcntl and recv work on them unchanged, but
+// connecting only checks the fake server is up, the data goes through the fake mbedtls functions
+
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+int lwip_socket(int domain, int type, int protocol);
+int lwip_connect(int socket, const struct sockaddr* name, socklen_t namelen);
+int lwip_close(int socket);
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef FAKE_MBEDTLS_ENTROPY_H
+#define FAKE_MBEDTLS_ENTROPY_H
+
+#include <stddef.h>
+
+typedef struct
+{
+    int unused;
+} mbedtls_entropy_context;
+
+void mbedtls_entropy_init(mbedtls_entropy_context* ctx);
+void mbedtls_entropy_free(mbedtls_entropy_context* ctx);
+int mbedtls_entropy_func(void* data, unsigned char* output, size_t len);
+
+#endif
@@ -0,0 +1,9 @@
+#ifndef FAKE_MBEDTLS_NET_SOCKETS_H
+#define FAKE_MBEDTLS_NET_SOCKETS_H
+
+#include <stddef.h>
+
+int mbedtls_net_send(void* ctx, const unsigned char* buf, size_t len);
+int mbedtls_net_recv(void* ctx, unsigned char* buf, size_t len);
+
+#endif
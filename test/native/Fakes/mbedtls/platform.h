@@ -0,0 +1,9 @@
+#ifndef FAKE_MBEDTLS_PLATFORM_H
+#define FAKE_MBEDTLS_PLATFORM_H
+
+#include <stdlib.h>
+
+#define mbedtls_free free
+#define mbedtls_calloc calloc
+
+#endif
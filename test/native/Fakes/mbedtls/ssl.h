@@ -0,0 +1,77 @@
+#ifndef FAKE_MBEDTLS_SSL_H
+#define FAKE_MBEDTLS_SSL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// just enough of mbedtls for TlsClient and TlsSessionCache, implemented in FakeNetwork.cpp
+// there is no encryption, the handshake only takes the time a real one would
+
+#define MBEDTLS_HAVE_TIME
+#define MBEDTLS_SSL_SESSION_TICKETS
+
+#define MBEDTLS_ERR_SSL_WANT_READ -0x6900
+#define MBEDTLS_ERR_SSL_WANT_WRITE -0x6880
+#define MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY -0x7880
+#define MBEDTLS_ERR_SSL_BUFFER_TOO_SMALL -0x6A00
+#define MBEDTLS_ERR_SSL_BAD_INPUT_DATA -0x7100
+#define MBEDTLS_ERR_SSL_HANDSHAKE_FAILURE -0x7780
+#define MBEDTLS_ERR_NET_CONN_RESET -0x0050
+
+#define MBEDTLS_SSL_IS_CLIENT 0
+#define MBEDTLS_SSL_TRANSPORT_STREAM 0
+#define MBEDTLS_SSL_PRESET_DEFAULT 0
+#define MBEDTLS_SSL_VERIFY_NONE 0
+#define MBEDTLS_SSL_SESSION_TICKETS_ENABLED 1
+
+typedef int mbedtls_ssl_send_t(void* ctx, const unsigned char* buf, size_t len);
+typedef int mbedtls_ssl_recv_t(void* ctx, unsigned char* buf, size_t len);
+typedef int mbedtls_ssl_recv_timeout_t(void* ctx, unsigned char* buf, size_t len, uint32_t timeout);
+
+typedef struct
+{
+    int64_t start;     // time the session was created, kept when it is resumed
+    uint32_t hostHash; // server it was created with, 0 if none
+} mbedtls_ssl_session;
+
+typedef struct
+{
+    int authmode;
+} mbedtls_ssl_config;
+
+typedef struct
+{
+    char hostname[128];
+    int connection;         // id of the fake connection, 0 before the handshake starts
+    int64_t handshakeDone;  // uptime micros the handshake completes at
+    mbedtls_ssl_session offered;
+    mbedtls_ssl_session session;
+    void* bio;
+} mbedtls_ssl_context;
+
+void mbedtls_ssl_init(mbedtls_ssl_context* ssl);
+void mbedtls_ssl_free(mbedtls_ssl_context* ssl);
+void mbedtls_ssl_config_init(mbedtls_ssl_config* conf);
+void mbedtls_ssl_config_free(mbedtls_ssl_config* conf);
+int mbedtls_ssl_config_defaults(mbedtls_ssl_config* conf, int endpoint, int transport, int preset);
+void mbedtls_ssl_conf_authmode(mbedtls_ssl_config* conf, int authmode);
+void mbedtls_ssl_conf_rng(mbedtls_ssl_config* conf, int (*rng)(void*, unsigned char*, size_t), void* rngCtx);
+void mbedtls_ssl_conf_session_tickets(mbedtls_ssl_config* conf, int useTickets);
+int mbedtls_ssl_setup(mbedtls_ssl_context* ssl, const mbedtls_ssl_config* conf);
+int mbedtls_ssl_set_hostname(mbedtls_ssl_context* ssl, const char* hostname);
+void mbedtls_ssl_set_bio(mbedtls_ssl_context* ssl, void* bio, mbedtls_ssl_send_t* send, mbedtls_ssl_recv_t* recv,
+                         mbedtls_ssl_recv_timeout_t* recvTimeout);
+int mbedtls_ssl_handshake(mbedtls_ssl_context* ssl);
+int mbedtls_ssl_write(mbedtls_ssl_context* ssl, const unsigned char* buf, size_t len);
+int mbedtls_ssl_read(mbedtls_ssl_context* ssl, unsigned char* buf, size_t len);
+size_t mbedtls_ssl_get_bytes_avail(const mbedtls_ssl_context* ssl);
+int mbedtls_ssl_close_notify(mbedtls_ssl_context* ssl);
+
+void mbedtls_ssl_session_init(mbedtls_ssl_session* session);
+void mbedtls_ssl_session_free(mbedtls_ssl_session* session);
+int mbedtls_ssl_set_session(mbedtls_ssl_context* ssl, const mbedtls_ssl_session* session);
+int mbedtls_ssl_get_session(const mbedtls_ssl_context* ssl, mbedtls_ssl_session* session);
+int mbedtls_ssl_session_save(const mbedtls_ssl_session* session, unsigned char* buf, size_t bufLen, size_t* olen);
+int mbedtls_ssl_session_load(mbedtls_ssl_session* session, const unsigned char* buf, size_t len);
+
+#endif
@@ -0,0 +1,243 @@
+#include "BatterySimulator.h"
+#include "SleepSchedule.h"
+#include "TimeKeeper.h"
+
+#include <Arduino.h>
+#include <random>
+
+namespace
+{
+    constexpr double MicrosPerDay = 86400.0 * 1000000;
+
+    // one simulated device, the state that lives in RTC memory on the real one is kept here between wakes
+    class Device
+    {
+    public:
+        Device(const utils::CurrentConfig& cfg, const simulator::CurrentModel& model,
+               const simulator::FailureProfile& failures) :
+            m_cfg(cfg),
+            m_model(model),
+            m_failures(failures),
+            m_random(failures.seed)
+        {
+        }
+
+        // one wake from power on or deep sleep, returns how long it sleeps for
+        uint64_t wake()
+        {
+            m_bootCount++;
+            m_result.wakes++;
+
+            // as setup()
+            uint64_t sleepSeconds = 0;
+            if (SleepSchedule::continueOvernightSleep(m_sleepState, sleepSeconds))
+            {
+                spend(m_model.cpuMilliamps, m_model.overnightWakeMillis);
+                return sleepSeconds;
+            }
+
+            m_result.normalWakes++;
+            spend(m_model.cpuMilliamps, m_model.bootMillis);
+            bool waitForNtpSync = m_sleepState.waitForNtpSync;
+            m_sleepState.waitForNtpSync = false;
+
+            WakeOutcome outcome = runTicker(waitForNtpSync);
+            if (SleepSchedule::finishWake(m_sleepState.wifiFails, m_sleepState.dataFails, m_bootCount, outcome) !=
+                EndOfWakeScreen::NONE)
+                draw();
+            return SleepSchedule::endWake(m_sleepState, outcome);
+        }
+
+        void sleep(uint64_t seconds)
+        {
+            m_result.milliampHours += m_model.deepSleepMilliamps * seconds / 3600.0;
+            fake::clock::deepSleep(seconds * constants::MicrosToSecondsFactor);
+        }
+
+        simulator::Result& result()
+        {
+            return m_result;
+        }
+
+    private:
+        // TickerCoordinator::run() in normal mode up to what it found, the backoff and what is drawn after a
+        // failure or for the overnight sleep are decided by SleepSchedule::finishWake() as on the device
+        WakeOutcome runTicker(bool waitForNtpSync)
+        {
+            WakeOutcome outcome{SleepSchedule::refreshSeconds(m_cfg.refreshMins), false, false, 0};
+
+            // the config is only drawn when it wasn't a timer wakeup
+            if (m_bootCount == 1)
+                draw();
+
+            if (!connect(waitForNtpSync))
+            {
+                m_result.wifiFails++;
+                outcome.wifiFailed = true;
+                return outcome;
+            }
+
+            if (m_cfg.overnightSleepStart >= 0)
+            {
+                struct tm timeinfo;
+                time_t now = time(nullptr);
+                localtime_r(&now, &timeinfo);
+                if (SleepSchedule::isDuringOvernightSleep(timeinfo, m_cfg.overnightSleepStart,
+                                                          m_cfg.overnightSleepLength, outcome.secondsLeftOfSleep))
+                    return outcome;
+            }
+
+            if (chance(m_failures.dataFailRate))
+            {
+                spend(m_model.wifiMilliamps, m_model.dataFailMillis);
+                m_result.dataFails++;
+                outcome.dataFailed = true;
+                return outcome;
+            }
+
+            spend(m_model.wifiMilliamps, m_model.requestMillis + m_model.historyRequestMillis * historyRequests());
+            draw();
+            return outcome;
+        }
+
+        // as WiFiManager::initNormalMode(), the time is only synced when TimeKeeper says it needs it
+        bool connect(bool waitForNtpSync)
+        {
+            if (chance(m_failures.wifiFailRate))
+            {
+                spend(m_model.wifiMilliamps, m_model.wifiFailMillis);
+                return false;
+            }
+            spend(m_model.wifiMilliamps, m_model.wifiConnectMillis);
+
+            if (waitForNtpSync || TimeKeeper::needsSync())
+            {
+                fake::device::setNtpReachable(!chance(m_failures.ntpFailRate));
+                uint32_t timeout = waitForNtpSync ? constants::NtpResyncTimeoutSeconds * 1000 : constants::NtpSyncTimeoutMillis;
+                uint32_t start = millis();
+                if (TimeKeeper::sync(timeout))
+                    m_result.ntpSyncs++;
+                charge(m_model.wifiMilliamps, millis() - start);
+            }
+            else
+                TimeKeeper::applyDriftCorrection();
+
+            // a time that was never set means there is no internet
+            return TimeKeeper::hasValidTime();
+        }
+
+        // history requests on top of the one for the current prices, as WiFiManager::getPriceData() plans them:
+        // the price a day ago until the current prices kept in RTC memory go back that far, and for the advanced
+        // layout a fill of the daily samples in SPIFFS, then a top up each time 30 days ago passes the newest
+        int historyRequests()
+        {
+            if (m_cfg.watchlist.size() > 1)
+                return 0;
+
+            uint32_t now = time(nullptr);
+            if (m_firstPriceUnix == 0)
+                m_firstPriceUnix = now;
+
+            // a day ago is close enough once the oldest is within the error allowed for 1d
+            constexpr long RecentCoverDaySeconds =
+                constants::SecondsOneDay - constants::SecondsOneDay / constants::PriceHistoryMaxSampleErrorDivisor;
+            int requests = 0;
+            if (now - m_firstPriceUnix < RecentCoverDaySeconds)
+                requests++;
+
+            if (m_cfg.displayMode != constants::ConfigDisplayModeSimple &&
+                (m_dailySamplesToUnix == 0 || now - constants::SecondsOneMonth > m_dailySamplesToUnix))
+            {
+                m_dailySamplesToUnix = now;
+                requests++;
+            }
+            m_result.historyRequests += requests;
+            return requests;
+        }
+
+        void draw()
+        {
+            m_result.draws++;
+            spend(m_model.displayMilliamps, m_model.displayMillis);
+        }
+
+        bool chance(float rate)
+        {
+            return rate > 0 && std::uniform_real_distribution<float>(0, 1)(m_random) < rate;
+        }
+
+        // the phase moves the clock on
+        void spend(float milliamps, uint32_t millis)
+        {
+            fake::clock::advanceMillis(millis);
+            charge(milliamps, millis);
+        }
+
+        // for a phase that has already moved the clock on
+        void charge(float milliamps, uint32_t millis)
+        {
+            m_result.milliampHours += milliamps * millis / 3600000.0;
+            m_result.awakeSeconds += millis / 1000.0;
+        }
+
+        const utils::CurrentConfig& m_cfg;
+        const simulator::CurrentModel& m_model;
+        const simulator::FailureProfile& m_failures;
+        std::mt19937 m_random;
+
+        int m_bootCount = 0;
+        uint32_t m_firstPriceUnix = 0;     // of the oldest current price kept in RTC memory
+        uint32_t m_dailySamplesToUnix = 0; // of the newest daily sample kept in SPIFFS
+        SleepState m_sleepState{};
+        simulator::Result m_result{};
+    };
+}
+
+namespace simulator
+{
+    double Result::wakesPerDay() const
+    {
+        return days > 0 ? wakes / days : 0;
+    }
+
+    double Result::milliampHoursPerDay() const
+    {
+        return days > 0 ? milliampHours / days : 0;
+    }
+
+    double Result::batteryDays(float capacityMilliampHours) const
+    {
+        double perDay = milliampHoursPerDay();
+        return perDay > 0 ? capacityMilliampHours / perDay : 0;
+    }
+
+    Result run(const utils::CurrentConfig& cfg, int days, const CurrentModel& model, const FailureProfile& failures,
+               int64_t startMicros)
+    {
+        fake::device::reset();
+        fake::clock::reset(startMicros);
+        fake::clock::setSleepDriftPpm(failures.sleepDriftPpm);
+        TimeKeeper::reset();
+        setenv("TZ", cfg.tz.c_str(), 1);
+        tzset();
+
+        Device device(cfg, model, failures);
+        int64_t end = startMicros + (int64_t)days * MicrosPerDay;
+        while (fake::clock::trueMicros() < end)
+            device.sleep(device.wake());
+
+        Result& result = device.result();
+        result.days = (fake::clock::trueMicros() - startMicros) / MicrosPerDay;
+        TimeKeeper::reset();
+        return result;
+    }
+
+    void printReport(const char* name, const Result& result, float capacityMilliampHours)
+    {
+        printf("%-28s %6.1f days  %6.1f wakes/day  %5.1f draws/day  %5.1f s awake/day  %6.2f mAh/day  "
+               "%5.1f days on %.0f mAh%s\n",
+               name, result.days, result.wakesPerDay(), result.draws / result.days, result.awakeSeconds / result.days,
+               result.milliampHoursPerDay(), result.batteryDays(capacityMilliampHours), capacityMilliampHours,
+               result.batteryDays(capacityMilliampHours) >= 30 ? "" : "  (under 1 month)");
+    }
+}
@@ -0,0 +1,73 @@
+#ifndef BATTERYSIMULATOR_H
+#define BATTERYSIMULATOR_H
+
+#include "Utils.h"
+#include "Constants.h"
+#include "FakeClock.h"
+
+// predicts the battery life of a config by running its wakes over weeks or months of virtual time
+// every wake makes the same decisions as setup() and the TickerCoordinator - the chain of overnight sleeps,
+// backing off after WiFi and data failures, when to draw and the refresh time from the config - through the
+// same calls to SleepSchedule and the real TimeKeeper on the fake clock, so the NTP syncs follow the drift of the RTC
+// only the phases of a wake are modelled, each costing the time and current set in the CurrentModel
+
+namespace simulator
+{
+    // assumed for the 1 month battery life in the README
+    constexpr float DefaultBatteryMilliampHours = 1000;
+
+    // current drawn in each phase of a wake and how long it takes, roughly a TTGO T5 with the 2.13" panel
+    struct CurrentModel
+    {
+        float deepSleepMilliamps = 0.15f;    // ESP32 deep sleep plus the regulator and battery divider
+        float cpuMilliamps = 45;             // CPU at full clock with the radio off
+        uint32_t bootMillis = 450;           // boot, battery read and the wait at the start of setup()
+        uint32_t overnightWakeMillis = 250;  // boot and battery read, then straight back to sleep
+        float wifiMilliamps = 120;           // radio on, connecting and requesting
+        uint32_t wifiConnectMillis = 1200;
+        uint32_t wifiFailMillis = constants::WiFiFastConnectTimeoutMillis + constants::WiFiFullConnectTimeoutMillis;
+        uint32_t requestMillis = 900;        // the current prices from a data source, including the TLS handshake
+        uint32_t historyRequestMillis = 1300; // a range of past prices, which the apis are slower to answer
+        uint32_t dataFailMillis = 8000;      // trying every data source and retry before giving up
+        float displayMilliamps = 30;         // CPU plus the panel while drawing and refreshing
+        uint32_t displayMillis = 3000;       // drawing and a full refresh
+    };
+
+    // how often the network lets the ticker down, each wake is drawn at random from these
+    struct FailureProfile
+    {
+        float wifiFailRate = 0;       // chance of not connecting to the WiFi
+        float ntpFailRate = 0;        // chance of NTP not answering when the time needs a sync
+        float dataFailRate = 0;       // chance of no data source answering once connected
+        int32_t sleepDriftPpm = 5500; // RTC slow clock gains ~20 seconds an hour in deep sleep
+        uint32_t seed = 1;            // the same failures on every run with the same seed
+    };
+
+    struct Result
+    {
+        double days;
+        int wakes;          // including the wakes in the chain of overnight sleeps
+        int normalWakes;
+        int wifiFails;
+        int dataFails;
+        int draws;          // full refreshes of the display
+        int ntpSyncs;
+        int historyRequests;
+        double awakeSeconds;
+        double milliampHours;
+
+        double wakesPerDay() const;
+        double milliampHoursPerDay() const;
+        double batteryDays(float capacityMilliampHours = DefaultBatteryMilliampHours) const;
+    };
+
+    // runs days of wakes of a ticker that has just been given the config, from startMicros true unix time
+    Result run(const utils::CurrentConfig& cfg, int days, const CurrentModel& model = CurrentModel(),
+               const FailureProfile& failures = FailureProfile(),
+               int64_t startMicros = fake::clock::DefaultStartMicros);
+
+    void printReport(const char* name, const Result& result,
+                     float capacityMilliampHours = DefaultBatteryMilliampHours);
+}
+
+#endif
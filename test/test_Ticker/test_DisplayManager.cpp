@@ -1,6 +1,8 @@
 #include "DisplayManagerImpl.h"
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
+#include "Constants.h"
+#include "WakeTimer.h"
 
 class DisplayManagerTest : public ::testing::Test
 {
@@ -17,25 +19,153 @@ protected:
 TEST_F(DisplayManagerTest, formatPrice)
 {
     DisplayManagerImpl dmImpl;
-    EXPECT_EQ(dmImpl.formatPriceString(1234567.12345), "1,234,567");
-    EXPECT_EQ(dmImpl.formatPriceString(123456.12345), "123,456");
-    EXPECT_EQ(dmImpl.formatPriceString(12345.12345), "12,345");
-    EXPECT_EQ(dmImpl.formatPriceString(1234.12345), "1,234");
-    EXPECT_EQ(dmImpl.formatPriceString(123.12345), "123.12");
-    EXPECT_EQ(dmImpl.formatPriceString(12.12345), "12.12");
-    EXPECT_EQ(dmImpl.formatPriceString(1.12345), "1.123");
-    EXPECT_EQ(dmImpl.formatPriceString(0.12345), "0.1235");
-    EXPECT_EQ(dmImpl.formatPriceString(0.1), "0.1000");
+    auto format = [&](const Price& price)
+    {
+        char buf[DisplayManagerImpl::PriceStringBytes];
+        dmImpl.formatPriceString(price, buf);
+        return String(buf);
+    };
+    EXPECT_EQ(format(Price(123456712345, 5)), "1,234,567");
+    EXPECT_EQ(format(Price(12345612345, 5)), "123,456");
+    EXPECT_EQ(format(Price(1234512345, 5)), "12,345");
+    EXPECT_EQ(format(Price(123412345, 5)), "1,234");
+    EXPECT_EQ(format(Price(12312345, 5)), "123.12");
+    EXPECT_EQ(format(Price(1212345, 5)), "12.12");
+    EXPECT_EQ(format(Price(112345, 5)), "1.123");
+    EXPECT_EQ(format(Price(12345, 5)), "0.1235");
+    EXPECT_EQ(format(Price(1, 1)), "0.1000");
+    // digits a float would have lost
+    EXPECT_EQ(format(Price(123456789, 2)), "1,234,568");
+    EXPECT_EQ(format(Price(812345, 11)), "0.0000");
 }
 
 TEST_F(DisplayManagerTest, formatPriceChange)
 {
     DisplayManagerImpl dmImpl;
-    EXPECT_EQ(dmImpl.formatPriceChangeString(0.1234,  "1d"), "1d: +0.12%");
-    EXPECT_EQ(dmImpl.formatPriceChangeString(12.345,  "1M"), "1M: +12.3%");
-    EXPECT_EQ(dmImpl.formatPriceChangeString(123.456, "1Y"), "1Y: + 123%");
-    EXPECT_EQ(dmImpl.formatPriceChangeString(0, "1Y"), "1Y: +0.00%");
-    EXPECT_EQ(dmImpl.formatPriceChangeString(-0.1234,  "1d"), "1d: -0.12%");
-    EXPECT_EQ(dmImpl.formatPriceChangeString(-12.345,  "1M"), "1M: -12.3%");
+    auto format = [&](const Price& percentChange, const char* timeframe)
+    {
+        char buf[DisplayManagerImpl::PriceChangeStringBytes];
+        dmImpl.formatPriceChangeString(percentChange, timeframe, buf);
+        return String(buf);
+    };
+    EXPECT_EQ(format(Price(1234, 4),  "1d"), "1d: +0.12%");
+    EXPECT_EQ(format(Price(12345, 3),  "1M"), "1M: +12.3%");
+    EXPECT_EQ(format(Price(123456, 3), "1Y"), "1Y: + 123%");
+    EXPECT_EQ(format(Price(0), "1Y"), "1Y: +0.00%");
+    EXPECT_EQ(format(Price(-1234, 4),  "1d"), "1d: -0.12%");
+    EXPECT_EQ(format(Price(-12345, 3),  "1M"), "1M: -12.3%");
+    EXPECT_EQ(format(Price(123456, 2), "1 day"), "1 day: +1235%");
+}
+
+TEST_F(DisplayManagerTest, skipsUnchangedFrame)
+{
+    DisplayManagerImpl dmImpl;
+    dmImpl.fillScreen(); // the panel could be showing anything before this
+    constexpr int Refresh = static_cast<int>(WakePhase::PANEL_REFRESH);
+
+    Quotes quotes;
+    quotes.set(Timeframe::NOW, Price(375123, 1));
+    quotes.set(Timeframe::ONE_DAY, Price(36000));
+    WakeTimer::beginWake(1);
+    dmImpl.writeDisplay("BTC", "USD", quotes, "12 Oct", "12:34", 80);
+    EXPECT_EQ(WakeTimer::recentCycles().back().phaseCounts[Refresh], 1);
+
+    // formats the same
+    quotes.set(Timeframe::NOW, Price(375119, 1));
+    dmImpl.writeDisplay("BTC", "USD", quotes, "12 Oct", "12:34", 80);
+    EXPECT_EQ(WakeTimer::recentCycles().back().phaseCounts[Refresh], 1);
+
+    dmImpl.writeDisplay("BTC", "USD", quotes, "12 Oct", "12:35", 80);
+    EXPECT_EQ(WakeTimer::recentCycles().back().phaseCounts[Refresh], 2);
+
+    // the panel shows something else in between
+    dmImpl.drawOvernightSleep();
+    dmImpl.writeDisplay("BTC", "USD", quotes, "12 Oct", "12:35", 80);
+    EXPECT_EQ(WakeTimer::recentCycles().back().phaseCounts[Refresh], 4);
+    WakeTimer::endWake();
+    WakeTimer::reset();
+}
+
+TEST_F(DisplayManagerTest, partialRefreshOfChangedRegions)
+{
+    DisplayManagerImpl dmImpl;
+    dmImpl.fillScreen();
+
+    Quotes quotes;
+    quotes.set(Timeframe::NOW, Price(375123, 1));
+    quotes.set(Timeframe::ONE_DAY, Price(36000));
+    dmImpl.writeDisplay("BTC", "USD", quotes, "12 Oct", "12:34", 80);
+    EXPECT_EQ(dmImpl.partialRefreshesSinceFull(), 0);
+
+    // only the time changed
+    dmImpl.writeDisplay("BTC", "USD", quotes, "12 Oct", "12:35", 80);
+    EXPECT_EQ(dmImpl.partialRefreshesSinceFull(), 1);
+
+    // full refresh once enough partial ones have built up
+    for (int i = 1; i < constants::DisplayPartialRefreshesBeforeFull; i++)
+    {
+        quotes.set(Timeframe::NOW, Price(quotes[Timeframe::NOW].price.mantissa() + 100, 1));
+        dmImpl.writeDisplay("BTC", "USD", quotes, "12 Oct", "12:35", 80);
+    }
+    EXPECT_EQ(dmImpl.partialRefreshesSinceFull(), constants::DisplayPartialRefreshesBeforeFull);
+    quotes.set(Timeframe::NOW, Price(quotes[Timeframe::NOW].price.mantissa() + 100, 1));
+    dmImpl.writeDisplay("BTC", "USD", quotes, "12 Oct", "12:35", 80);
+    EXPECT_EQ(dmImpl.partialRefreshesSinceFull(), 0);
+
+    // a different crypto moves the layout
+    dmImpl.writeDisplay("BTC", "USD", quotes, "12 Oct", "12:36", 80);
+    EXPECT_EQ(dmImpl.partialRefreshesSinceFull(), 1);
+    dmImpl.writeDisplay("DOGE", "USD", quotes, "12 Oct", "12:36", 80);
+    EXPECT_EQ(dmImpl.partialRefreshesSinceFull(), 0);
+
+    // as does any other screen
+    dmImpl.writeDisplay("DOGE", "USD", quotes, "12 Oct", "12:37", 80);
+    dmImpl.drawOvernightSleep();
+    dmImpl.writeDisplay("DOGE", "USD", quotes, "12 Oct", "12:38", 80);
+    EXPECT_EQ(dmImpl.partialRefreshesSinceFull(), 0);
 }
 
+TEST_F(DisplayManagerTest, initialisesPanelOnFirstDraw)
+{
+    constexpr int Init = static_cast<int>(WakePhase::DISPLAY_INIT);
+    constexpr int Refresh = static_cast<int>(WakePhase::PANEL_REFRESH);
+    Quotes quotes;
+    quotes.set(Timeframe::NOW, Price(375123, 1));
+    quotes.set(Timeframe::ONE_DAY, Price(36000));
+    {
+        DisplayManagerImpl dmImpl;
+        dmImpl.writeDisplay("BTC", "USD", quotes, "12 Oct", "12:34", 80);
+        dmImpl.hibernate();
+    }
+
+    // nothing to draw, the panel is left alone
+    WakeTimer::beginWake(1);
+    {
+        DisplayManagerImpl dmImpl;
+        dmImpl.writeDisplay("BTC", "USD", quotes, "12 Oct", "12:34", 80);
+        dmImpl.hibernate();
+    }
+    EXPECT_EQ(WakeTimer::recentCycles().back().phaseCounts[Init], 0);
+
+    // brought up once, on the first frame
+    {
+        DisplayManagerImpl dmImpl;
+        dmImpl.writeDisplay("BTC", "USD", quotes, "12 Oct", "12:35", 80);
+        dmImpl.writeDisplay("BTC", "USD", quotes, "12 Oct", "12:36", 80);
+        dmImpl.hibernate();
+    }
+    EXPECT_EQ(WakeTimer::recentCycles().back().phaseCounts[Init], 1);
+    EXPECT_EQ(WakeTimer::recentCycles().back().phaseCounts[Refresh], 2);
+
+    // or in the background, then waited for on the first frame
+    {
+        DisplayManagerImpl dmImpl;
+        dmImpl.initInBackground();
+        dmImpl.writeDisplay("BTC", "USD", quotes, "12 Oct", "12:37", 80);
+        dmImpl.hibernate();
+    }
+    EXPECT_EQ(WakeTimer::recentCycles().back().phaseCounts[Init], 2);
+    EXPECT_EQ(WakeTimer::recentCycles().back().phaseCounts[Refresh], 3);
+    WakeTimer::endWake();
+    WakeTimer::reset();
+}
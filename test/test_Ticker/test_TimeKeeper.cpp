@@ -0,0 +1,104 @@
+#include "TimeKeeper.h"
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include "compile_time.h"
+#include "Constants.h"
+
+#include <sys/time.h>
+
+class TimeKeeperTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        // Serial output required - see note in main
+        // new line also helps with test formatting in serial monitor
+        Serial.println();
+        TimeKeeper::reset();
+        setTime(UNIX_TIMESTAMP);
+    }
+
+    void TearDown() override
+    {
+        TimeKeeper::reset();
+    }
+
+    static void setTime(time_t t)
+    {
+        struct timeval tv{t, 0};
+        settimeofday(&tv, nullptr);
+    }
+
+    static constexpr int64_t MicrosPerHour = 3600LL * 1000000;
+};
+
+TEST_F(TimeKeeperTest, needsSyncUntilSynced)
+{
+    EXPECT_TRUE(TimeKeeper::needsSync());
+    EXPECT_FLOAT_EQ(TimeKeeper::predictedErrorSeconds(), constants::SecondsOneDay);
+
+    int64_t now = (int64_t)UNIX_TIMESTAMP * 1000000;
+    TimeKeeper::learnFromSync(now, 0);
+    EXPECT_FALSE(TimeKeeper::needsSync());
+    EXPECT_EQ(TimeKeeper::getState().driftSamples, 0);
+
+    // with the default uncertainty of 20s/h the bound of 30s is reached after 1.5h
+    EXPECT_LT(TimeKeeper::predictedErrorSeconds(3600), constants::TimeMaxPredictedErrorSeconds);
+    EXPECT_GT(TimeKeeper::predictedErrorSeconds(2 * 3600), constants::TimeMaxPredictedErrorSeconds);
+}
+
+TEST_F(TimeKeeperTest, learnsDrift)
+{
+    int64_t now = (int64_t)UNIX_TIMESTAMP * 1000000;
+    TimeKeeper::learnFromSync(now, 0);
+
+    // clock lost 12 seconds over an hour
+    now += MicrosPerHour;
+    TimeKeeper::learnFromSync(now, 12 * 1000000);
+    TimeKeeperState state = TimeKeeper::getState();
+    EXPECT_EQ(state.driftSamples, 1);
+    EXPECT_NEAR(state.driftSecondsPerHour, 12, 0.01);
+    EXPECT_NEAR(state.uncertaintySecondsPerHour, constants::RtcDriftDefaultUncertaintySecondsPerHour / 2, 0.01);
+
+    // after correcting for the drift, the error is small so the uncertainty keeps dropping
+    now += MicrosPerHour;
+    TimeKeeper::learnFromSync(now, 500000);
+    state = TimeKeeper::getState();
+    EXPECT_EQ(state.driftSamples, 2);
+    EXPECT_NEAR(state.uncertaintySecondsPerHour, constants::RtcDriftDefaultUncertaintySecondsPerHour / 4, 0.01);
+
+    // a big error makes it sync sooner
+    now += MicrosPerHour;
+    TimeKeeper::learnFromSync(now, 8 * 1000000);
+    EXPECT_NEAR(TimeKeeper::getState().uncertaintySecondsPerHour, 16, 0.01);
+}
+
+TEST_F(TimeKeeperTest, ignoresShortAndImplausibleGaps)
+{
+    int64_t now = (int64_t)UNIX_TIMESTAMP * 1000000;
+    TimeKeeper::learnFromSync(now, 0);
+
+    now += (constants::RtcDriftLearnMinSeconds / 2) * 1000000LL;
+    TimeKeeper::learnFromSync(now, 5 * 1000000);
+    EXPECT_EQ(TimeKeeper::getState().driftSamples, 0);
+
+    now += MicrosPerHour;
+    TimeKeeper::learnFromSync(now, 3600LL * 1000000); // out by an hour, time was changed not drifted
+    EXPECT_EQ(TimeKeeper::getState().driftSamples, 0);
+}
+
+TEST_F(TimeKeeperTest, appliesDriftCorrection)
+{
+    int64_t now = (int64_t)UNIX_TIMESTAMP * 1000000;
+    TimeKeeper::learnFromSync(now - 2 * MicrosPerHour, 0);
+    TimeKeeper::learnFromSync(now - MicrosPerHour, 36 * 1000000); // 36s/h slow
+
+    // an hour after the last sync it should be put forward 36 seconds
+    TimeKeeper::applyDriftCorrection();
+    EXPECT_NEAR(time(nullptr), UNIX_TIMESTAMP + 36, 1);
+    EXPECT_NEAR(TimeKeeper::getState().correctedMicros, 36 * 1000000, 100000);
+
+    // nothing more to correct straight after
+    TimeKeeper::applyDriftCorrection();
+    EXPECT_NEAR(time(nullptr), UNIX_TIMESTAMP + 36, 1);
+}
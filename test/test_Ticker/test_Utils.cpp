@@ -30,6 +30,18 @@ TEST_F(UtilsTest, batteryPercent)
     EXPECT_GT(utils::battery_percent(utils::battery_read()), 0); // it will actually read 100 becasue of plugged in voltage
 }
 
+TEST_F(UtilsTest, parseWatchlist)
+{
+    EXPECT_TRUE(utils::parseWatchlist("").empty());
+    EXPECT_EQ(utils::parseWatchlist("BTC"), std::vector<String>({"BTC"}));
+    EXPECT_EQ(utils::parseWatchlist("btc, ETH ,,sol,"), std::vector<String>({"BTC", "ETH", "SOL"}));
+    EXPECT_EQ(utils::parseWatchlist("BTC,ETH,btc"), std::vector<String>({"BTC", "ETH"}));
+
+    auto watchlist = utils::parseWatchlist("A,B,C,D,E,F,G,H,I,J,K,L");
+    EXPECT_EQ(watchlist.size(), constants::WatchlistMaxSymbols);
+    EXPECT_EQ(watchlist.back(), "J");
+}
+
 TEST_F(UtilsTest, DISABLED_formatSpiffs)
 {
     // can be enabled to format the spiffs partition, i.e. delete everything stored there
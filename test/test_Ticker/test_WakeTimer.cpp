@@ -0,0 +1,123 @@
+#include "WakeTimer.h"
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include "Constants.h"
+
+#include "SPIFFS.h"
+
+class WakeTimerTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        // Serial output required - see note in main
+        // new line also helps with test formatting in serial monitor
+        Serial.println();
+        ASSERT_TRUE(SPIFFS.begin(true));
+        WakeTimer::reset();
+    }
+
+    void TearDown() override
+    {
+        WakeTimer::reset();
+    }
+
+    static void runWake(uint32_t bootCount)
+    {
+        WakeTimer::beginWake(bootCount);
+        WakeTimer::record(WakePhase::DNS_LOOKUP, 30);
+        WakeTimer::record(WakePhase::DNS_LOOKUP, 20);
+        WakeTimer::record(WakePhase::TLS_HANDSHAKE, 700);
+        WakeTimer::endWake();
+    }
+
+    static constexpr int Dns = static_cast<int>(WakePhase::DNS_LOOKUP);
+    static constexpr int Tls = static_cast<int>(WakePhase::TLS_HANDSHAKE);
+};
+
+TEST_F(WakeTimerTest, recordsPhasesOfWake)
+{
+    runWake(1);
+
+    std::vector<WakeCycle> cycles = WakeTimer::recentCycles();
+    ASSERT_EQ(cycles.size(), 1);
+    EXPECT_EQ(cycles[0].bootCount, 1);
+    EXPECT_GT(cycles[0].awakeMillis, 0);
+    EXPECT_EQ(cycles[0].phaseMillis[Dns], 50);
+    EXPECT_EQ(cycles[0].phaseCounts[Dns], 2);
+    EXPECT_EQ(cycles[0].phaseMillis[Tls], 700);
+    EXPECT_EQ(cycles[0].phaseCounts[Tls], 1);
+    EXPECT_EQ(cycles[0].phaseCounts[static_cast<int>(WakePhase::NTP_SYNC)], 0);
+}
+
+TEST_F(WakeTimerTest, phaseTimerRecordsOnce)
+{
+    WakeTimer::beginWake(1);
+    {
+        PhaseTimer timer(WakePhase::PARSE);
+        delay(20);
+        timer.stop();
+        delay(20);
+    }
+    WakeTimer::endWake();
+
+    WakeCycle cycle = WakeTimer::recentCycles().back();
+    EXPECT_EQ(cycle.phaseCounts[static_cast<int>(WakePhase::PARSE)], 1);
+    EXPECT_GE(cycle.phaseMillis[static_cast<int>(WakePhase::PARSE)], 20);
+    EXPECT_LT(cycle.phaseMillis[static_cast<int>(WakePhase::PARSE)], 40);
+
+    // nothing is recorded outside a wake
+    WakeTimer::record(WakePhase::PARSE, 100);
+    EXPECT_EQ(WakeTimer::recentCycles().back().phaseCounts[static_cast<int>(WakePhase::PARSE)], 1);
+}
+
+TEST_F(WakeTimerTest, unfinishedWakeIsKept)
+{
+    WakeTimer::beginWake(1);
+    WakeTimer::record(WakePhase::WIFI_CONNECT, 4000);
+    // e.g. the failsafe timer went off
+    runWake(2);
+
+    std::vector<WakeCycle> cycles = WakeTimer::recentCycles();
+    ASSERT_EQ(cycles.size(), 2);
+    EXPECT_EQ(cycles[0].bootCount, 1);
+    EXPECT_EQ(cycles[0].awakeMillis, 0);
+    EXPECT_EQ(cycles[0].phaseMillis[static_cast<int>(WakePhase::WIFI_CONNECT)], 4000);
+    EXPECT_GT(cycles[1].awakeMillis, 0);
+}
+
+TEST_F(WakeTimerTest, ringBufferKeepsLastCycles)
+{
+    for (int i = 1; i <= constants::WakeTimingCycles + 5; i++)
+    {
+        WakeTimer::beginWake(i);
+        WakeTimer::endWake();
+    }
+
+    std::vector<WakeCycle> cycles = WakeTimer::recentCycles();
+    ASSERT_EQ(cycles.size(), constants::WakeTimingCycles);
+    EXPECT_EQ(cycles.front().bootCount, 6);
+    EXPECT_EQ(cycles.back().bootCount, constants::WakeTimingCycles + 5);
+}
+
+TEST_F(WakeTimerTest, flushesEveryFewWakes)
+{
+    for (int i = 1; i < constants::WakeTimingFlushCycles; i++)
+        runWake(i);
+    EXPECT_TRUE(WakeTimer::readLog().empty());
+
+    runWake(constants::WakeTimingFlushCycles);
+    std::vector<WakeCycle> logged = WakeTimer::readLog();
+    ASSERT_EQ(logged.size(), constants::WakeTimingFlushCycles);
+    EXPECT_EQ(logged.front().bootCount, 1);
+    EXPECT_EQ(logged.back().bootCount, constants::WakeTimingFlushCycles);
+    EXPECT_EQ(logged.back().phaseMillis[Tls], 700);
+
+    // only the wakes since are added next time, the current wake isn't written until it has finished
+    runWake(100);
+    WakeTimer::beginWake(101);
+    ASSERT_TRUE(WakeTimer::flush());
+    logged = WakeTimer::readLog();
+    ASSERT_EQ(logged.size(), constants::WakeTimingFlushCycles + 1);
+    EXPECT_EQ(logged.back().bootCount, 100);
+}
@@ -5,6 +5,13 @@
 #include "Login.h"
 #include "compile_time.h"
 #include "Constants.h"
+#include "StringReadStream.h"
+#include "TlsClient.h"
+#include "TlsSessionCache.h"
+#include "TimeKeeper.h"
+#include "SourceScoreboard.h"
+#include "PriceHistoryStore.h"
+#include "SPIFFS.h"
 
 namespace WiFiManagerLib
 {
@@ -25,7 +32,8 @@ protected:
 class MockRequest : public RequestBase
 {
 public:
-    MOCK_METHOD(String, getServer, (), (override));
+    MOCK_METHOD(String, defaultServer, (), (override));
+    MOCK_METHOD(SourceId, getSourceId, (), (override));
 
     MOCK_METHOD(String, urlCurrentPrice, 
                 (const String& crypto, const String& fiat), (override));
@@ -34,10 +42,23 @@ public:
                 (override));
 
     MOCK_METHOD(bool, currentPrice, 
-                (const String& content, const String& crypto, const String& fiat, float& price_out), 
+                (Stream& content, const String& crypto, const String& fiat, Price& price_out), 
                 (override));
     MOCK_METHOD(bool, priceAtTime, 
-                (const String& content, float& priceAtTime_out), (override));
+                (Stream& content, Price& priceAtTime_out), (override));
+
+    MOCK_METHOD(String, urlCurrentPrices, 
+                (const std::vector<String>& cryptos, const String& fiat), (override));
+    MOCK_METHOD(bool, currentPrices, 
+                (Stream& content, const std::vector<String>& cryptos, const String& fiat, 
+                 (std::map<String, Price>& prices_out)), (override));
+
+    MOCK_METHOD(String, urlPriceHistory, 
+                (uint32_t currentUnix, uint32_t maxOffset, const String& crypto, const String& fiat), (override));
+    MOCK_METHOD(bool, priceHistory, 
+                (Stream& content, const PriceSampleCallback& onSample), (override));
+
+    MOCK_METHOD(SourceCapabilities, capabilities, (), (override));
 };
 
 TEST_F(WiFiManagerTest, badDetails)
@@ -63,6 +84,49 @@ TEST_F(WiFiManagerTest, connect)
     EXPECT_LT(wm.getEpoch(), UNIX_TIMESTAMP+SEC_PER_DAY);
 }
 
+TEST_F(WiFiManagerTest, skipsNtpWhenTimeIsAccurate)
+{
+    TimeKeeper::reset();
+    WiFiManager wm;
+    ASSERT_EQ(wm.initNormalMode(cfg, false, false), WiFiStatus::OK);
+    int64_t lastSync = TimeKeeper::getState().lastSyncMicros;
+    EXPECT_GT(lastSync, 0);
+    wm.disconnect();
+
+    // just synced, so the time can be used as it is
+    ASSERT_EQ(wm.initNormalMode(cfg, false, false), WiFiStatus::OK);
+    EXPECT_EQ(TimeKeeper::getState().lastSyncMicros, lastSync);
+    wm.disconnect();
+
+    // unless a sync is asked for
+    ASSERT_EQ(wm.initNormalMode(cfg, true, false), WiFiStatus::OK);
+    EXPECT_GT(TimeKeeper::getState().lastSyncMicros, lastSync);
+    EXPECT_GT(wm.getEpoch(), UNIX_TIMESTAMP-SEC_PER_DAY);
+    EXPECT_LT(wm.getEpoch(), UNIX_TIMESTAMP+SEC_PER_DAY);
+    wm.disconnect();
+}
+
+TEST_F(WiFiManagerTest, fastReconnect)
+{
+    {
+        WiFiManager wm;
+        ASSERT_EQ(wm.initNormalMode(cfg, false, false), WiFiStatus::OK);
+        wm.disconnect();
+    }
+
+    // the second connection can use the access point and lease saved by the first
+    WiFiManager wm;
+    EXPECT_EQ(wm.initNormalMode(cfg, false, false), WiFiStatus::OK);
+    EXPECT_TRUE(wm.usedFastReconnect());
+    wm.disconnect();
+
+    // saved details are only used for the network they were saved for
+    CurrentConfig badCfg = cfg;
+    badCfg.pass = "wrong";
+    EXPECT_EQ(wm.initNormalMode(badCfg, false, false), WiFiStatus::NO_CONNECTION);
+    EXPECT_FALSE(wm.usedFastReconnect());
+}
+
 TEST_F(WiFiManagerTest, requests)
 {
     std::vector<RequestBasePtr> rfs;
@@ -71,6 +135,13 @@ TEST_F(WiFiManagerTest, requests)
 
     EXPECT_EQ(rfs.at(0)->getServer(), "api.binance.com");
     EXPECT_EQ(rfs.at(1)->getServer(), "api.coingecko.com");
+
+    // every source goes to the override while it is set
+    RequestBase::setServerOverride("192.168.1.50");
+    EXPECT_EQ(rfs.at(0)->getServer(), "192.168.1.50");
+    EXPECT_EQ(rfs.at(1)->getServer(), "192.168.1.50");
+    RequestBase::setServerOverride("");
+    EXPECT_EQ(rfs.at(0)->getServer(), "api.binance.com");
 }
 
 TEST_F(WiFiManagerTest, testBinance)
@@ -78,8 +149,16 @@ TEST_F(WiFiManagerTest, testBinance)
     RequestBasePtr binance(new RequestBinance());
     const String currentPriceContent = "{\"symbol\":\"BTCGBP\",\"price\":\"29396.32000000\"}";
     const String priceAtTimeContent = "[[1697382420000,\"22138.72000000\",\"22238.72000000\",\"22338.72000000\",\"22438.72000000\",\"0.00000000\",1697382479999,\"0.00000000\",0,\"0.00000000\",\"0.00000000\",\"0\"]]";
-    float currentPrice_out;
-    float timePrice_out;
+    Price currentPrice_out;
+    Price timePrice_out;
+
+    // only the pairs in the symbol catalog, up to 1000 days of history in a request
+    TimeframeSet all{Timeframe::NOW, Timeframe::ONE_DAY, Timeframe::THIRTY_DAYS, Timeframe::ONE_YEAR};
+    EXPECT_EQ(binance->possibleTimeframes("BTC", "EUR", 1701021297, all), all);
+    EXPECT_TRUE(binance->possibleTimeframes("BTC", "GBP", 1701021297, all).empty());
+    EXPECT_TRUE(binance->possibleTimeframes("LEO", "USD", 1701021297, all).empty());
+    EXPECT_TRUE(binance->canRequestHistory(constants::SecondsOneYear));
+    EXPECT_FALSE(binance->canRequestHistory(3 * constants::SecondsOneYear));
 
     EXPECT_EQ(binance->urlCurrentPrice("BTC", "GBP"), "https://api.binance.com/api/v3/ticker/price?symbol=BTCGBP");
     EXPECT_EQ(binance->urlCurrentPrice("BTC", "USD"), "https://api.binance.com/api/v3/ticker/price?symbol=BTCUSDT");
@@ -87,23 +166,48 @@ TEST_F(WiFiManagerTest, testBinance)
                   "https://api.binance.com/api/v3/klines?symbol=BTCGBP&interval=1m&startTime=1700934897000&endTime=1700934957000&limit=1");
 
     EXPECT_TRUE(binance->currentPrice(currentPriceContent, "BTC", "GBP", currentPrice_out));
-    EXPECT_NEAR(currentPrice_out, 29396.32, 0.1);
+    EXPECT_EQ(currentPrice_out, Price(2939632, 2)); // exactly the string sent
 
     EXPECT_TRUE(binance->priceAtTime(priceAtTimeContent, timePrice_out));
-    EXPECT_NEAR(timePrice_out, 22138.72, 0.1);
+    EXPECT_NEAR(timePrice_out.toDouble(), 22138.72, 0.1);
+
+    EXPECT_EQ(binance->urlCurrentPrices({"BTC", "ETH"}, "USD"), 
+                  "https://api.binance.com/api/v3/ticker/price?symbols=%5B%22BTCUSDT%22,%22ETHUSDT%22%5D");
+    const String currentPricesContent = "[{\"symbol\":\"BTCUSDT\",\"price\":\"37500.30000000\"},{\"symbol\":\"ETHUSDT\",\"price\":\"2050.10000000\"}]";
+    StringReadStream currentPricesStream(currentPricesContent);
+    std::map<String, Price> currentPrices;
+    EXPECT_TRUE(binance->currentPrices(currentPricesStream, {"BTC", "ETH", "SOL"}, "USD", currentPrices));
+    EXPECT_EQ(currentPrices.size(), 2);
+    EXPECT_NEAR(currentPrices["BTC"].toDouble(), 37500.3, 0.1);
+    EXPECT_NEAR(currentPrices["ETH"].toDouble(), 2050.1, 0.1);
+
+    EXPECT_EQ(binance->urlPriceHistory(1701021297, constants::SecondsOneYear, "BTC", "USD"),
+                  "https://api.binance.com/api/v3/klines?symbol=BTCUSDT&interval=1d&startTime=1669398897000&endTime=1701021297000&limit=1000");
+
+    // daily samples are close enough for 1M and 1Y but not 1d
+    const String priceHistoryContent = "[[1669507200000,\"16500.10000000\",\"0\",\"0\",\"0\",\"0\",1669593599999,\"0\",0,\"0\",\"0\",\"0\"],"
+                                        "[1698451200000,\"34000.20000000\",\"0\",\"0\",\"0\",\"0\",1698537599999,\"0\",0,\"0\",\"0\",\"0\"],"
+                                        "[1700956800000,\"37500.30000000\",\"0\",\"0\",\"0\",\"0\",1701043199999,\"0\",0,\"0\",\"0\",\"0\"]]";
+    StringReadStream historyStream(priceHistoryContent);
+    Quotes historyPrices;
+    EXPECT_TRUE(binance->pricesAtTimes(historyStream, 1701021297, 
+                                       {Timeframe::ONE_DAY, Timeframe::THIRTY_DAYS, Timeframe::ONE_YEAR}, 
+                                       historyPrices));
+    EXPECT_EQ(historyPrices.valid(), TimeframeSet({Timeframe::THIRTY_DAYS, Timeframe::ONE_YEAR}));
+    EXPECT_NEAR(historyPrices[Timeframe::THIRTY_DAYS].price.toDouble(), 34000.2, 0.1);
+    EXPECT_NEAR(historyPrices[Timeframe::ONE_YEAR].price.toDouble(), 16500.1, 0.1);
 
     WiFiManager wm;
     auto status = wm.initNormalMode(cfg, false, false);
     ASSERT_EQ(status, WiFiStatus::OK);
     wm.addDataSource(std::move(binance));
 
-    std::set<long> unixOffsets{0, constants::SecondsOneDay, constants::SecondsOneMonth, constants::SecondsOneYear};
-    std::map<long, float> priceData = wm.getPriceData(cfg.crypto, cfg.fiat, unixOffsets);
-
-    EXPECT_FALSE(priceData.empty());
-    for (const auto& [key, value] : priceData)
+    TimeframeSet timeframes{Timeframe::NOW, Timeframe::ONE_DAY, Timeframe::THIRTY_DAYS, Timeframe::ONE_YEAR};
+    Quotes quotes;
+    EXPECT_TRUE(wm.getPriceData(cfg.crypto, cfg.fiat, timeframes, quotes));
+    for (Timeframe timeframe : timeframes)
     {
-        EXPECT_GT(value, 0);
+        EXPECT_TRUE(quotes[timeframe].price.isPositive());
     }
 
 }
@@ -113,8 +217,16 @@ TEST_F(WiFiManagerTest, testCoinGecko)
     RequestBasePtr coingecko(new RequestCoinGecko());
     const String currentPriceContent = "{\"bitcoin\":{\"gbp\":29319.1767}}";
     const String priceAtTimeContent = "{\"prices\":[[1701021346883,29585.3913]],\"market_caps\":[[1701021346883,578750969047.6592]],\"total_volumes\":[[1701021346883,8726978835.980974]]}";
-    float currentPrice_out;
-    float timePrice_out;
+    Price currentPrice_out;
+    Price timePrice_out;
+
+    // any fiat, but nothing from before a crypto was listed, TIA was a month before this
+    TimeframeSet all{Timeframe::NOW, Timeframe::ONE_DAY, Timeframe::THIRTY_DAYS, Timeframe::ONE_YEAR};
+    EXPECT_EQ(coingecko->possibleTimeframes("LEO", "GBP", 1701021297, all), all);
+    EXPECT_TRUE(coingecko->possibleTimeframes("NOTACOIN", "USD", 1701021297, all).empty());
+    EXPECT_EQ(coingecko->possibleTimeframes("TIA", "USD", 1701021297, all), 
+              TimeframeSet({Timeframe::NOW, Timeframe::ONE_DAY, Timeframe::THIRTY_DAYS}));
+    EXPECT_TRUE(coingecko->canRequestHistory(3 * constants::SecondsOneYear));
 
     EXPECT_EQ(coingecko->urlCurrentPrice("BTC", "GBP"), "https://api.coingecko.com/api/v3/simple/price?ids=bitcoin&vs_currencies=GBP&precision=4");
     EXPECT_EQ(coingecko->urlCurrentPrice("BTC", "USD"), "https://api.coingecko.com/api/v3/simple/price?ids=bitcoin&vs_currencies=USD&precision=4");
@@ -122,23 +234,55 @@ TEST_F(WiFiManagerTest, testCoinGecko)
                   "https://api.coingecko.com/api/v3/coins/bitcoin/market_chart/range?vs_currency=GBP&from=1700934897&to=1700935497&precision=4");
 
     EXPECT_TRUE(coingecko->currentPrice(currentPriceContent, "BTC", "GBP", currentPrice_out));
-    EXPECT_NEAR(currentPrice_out, 29319.18, 0.1);
+    EXPECT_NEAR(currentPrice_out.toDouble(), 29319.18, 0.1);
+    EXPECT_EQ(currentPrice_out, Price(293191767, 4));
 
     EXPECT_TRUE(coingecko->priceAtTime(priceAtTimeContent, timePrice_out));
-    EXPECT_NEAR(timePrice_out, 29585.39, 0.1);
+    EXPECT_NEAR(timePrice_out.toDouble(), 29585.39, 0.1);
+
+    EXPECT_EQ(coingecko->urlCurrentPrices({"BTC", "ETH"}, "GBP"), 
+                  "https://api.coingecko.com/api/v3/simple/price?ids=bitcoin,ethereum&vs_currencies=GBP&precision=4");
+    const String currentPricesContent = "{\"bitcoin\":{\"gbp\":29319.1767},\"ethereum\":{\"gbp\":1650.1234}}";
+    StringReadStream currentPricesStream(currentPricesContent);
+    std::map<String, Price> currentPrices;
+    EXPECT_TRUE(coingecko->currentPrices(currentPricesStream, {"BTC", "ETH", "SOL"}, "GBP", currentPrices));
+    EXPECT_EQ(currentPrices.size(), 2);
+    EXPECT_NEAR(currentPrices["BTC"].toDouble(), 29319.18, 0.1);
+    EXPECT_NEAR(currentPrices["ETH"].toDouble(), 1650.12, 0.1);
+
+    EXPECT_EQ(coingecko->urlPriceHistory(1701021297, constants::SecondsOneYear, "BTC", "GBP"),
+                  "https://api.coingecko.com/api/v3/coins/bitcoin/market_chart/range?vs_currency=GBP&from=1669398897&to=1701021297&precision=4");
+
+    // daily samples are close enough for 1M and 1Y but not 1d
+    const String priceHistoryContent = "{\"prices\":[[1669507200000,13500.1234],[1698451200000,28000.5678],[1700956800000,30000.1234]],"
+                                        "\"market_caps\":[[1669507200000,259000000000.1234]],\"total_volumes\":[[1669507200000,12000000000.1234]]}";
+    StringReadStream historyStream(priceHistoryContent);
+    Quotes historyPrices;
+    EXPECT_TRUE(coingecko->pricesAtTimes(historyStream, 1701021297, 
+                                         {Timeframe::ONE_DAY, Timeframe::THIRTY_DAYS, Timeframe::ONE_YEAR}, 
+                                         historyPrices));
+    EXPECT_EQ(historyPrices.valid(), TimeframeSet({Timeframe::THIRTY_DAYS, Timeframe::ONE_YEAR}));
+    EXPECT_NEAR(historyPrices[Timeframe::THIRTY_DAYS].price.toDouble(), 28000.57, 0.1);
+    EXPECT_NEAR(historyPrices[Timeframe::ONE_YEAR].price.toDouble(), 13500.12, 0.1);
 
     WiFiManager wm;
     auto status = wm.initNormalMode(cfg, false, false);
     ASSERT_EQ(status, WiFiStatus::OK);
     wm.addDataSource(std::move(coingecko));
 
-    std::set<long> unixOffsets{0, constants::SecondsOneDay, constants::SecondsOneMonth, constants::SecondsOneYear};
-    std::map<long, float> priceData = wm.getPriceData(cfg.crypto, cfg.fiat, unixOffsets);
+    TimeframeSet timeframes{Timeframe::NOW, Timeframe::ONE_DAY, Timeframe::THIRTY_DAYS, Timeframe::ONE_YEAR};
+    Quotes quotes;
+    EXPECT_TRUE(wm.getPriceData(cfg.crypto, cfg.fiat, timeframes, quotes));
+    for (Timeframe timeframe : timeframes)
+    {
+        EXPECT_TRUE(quotes[timeframe].price.isPositive());
+    }
 
-    EXPECT_FALSE(priceData.empty());
-    for (const auto& [key, value] : priceData)
+    std::map<String, Price> watchlistPrices = wm.getCurrentPrices({"BTC", "ETH", "SOL"}, cfg.fiat);
+    EXPECT_EQ(watchlistPrices.size(), 3);
+    for (const auto& [key, value] : watchlistPrices)
     {
-        EXPECT_GT(value, 0);
+        EXPECT_TRUE(value.isPositive());
     }
 }
 
@@ -147,8 +291,14 @@ TEST_F(WiFiManagerTest, testKuCoin)
     RequestBasePtr kucoin(new RequestKuCoin());
     const String currentPriceContent = "{\"code\":\"200000\",\"data\":{\"BTC\":\"33399.5113799741158231\"}}";
     const String priceAtTimeContent = "{\"code\":\"200000\",\"data\":[[\"1702653780\",\"32372.62\",\"32472.62\",\"32572.62\",\"32672.62\",\"0\",\"0\"]]}";
-    float currentPrice_out;
-    float timePrice_out;
+    Price currentPrice_out;
+    Price timePrice_out;
+
+    TimeframeSet all{Timeframe::NOW, Timeframe::ONE_DAY, Timeframe::THIRTY_DAYS, Timeframe::ONE_YEAR};
+    EXPECT_EQ(kucoin->possibleTimeframes("BTC", "USD", 1701021297, all), all);
+    EXPECT_TRUE(kucoin->possibleTimeframes("BTC", "EUR", 1701021297, all).empty());
+    EXPECT_TRUE(kucoin->possibleTimeframes("OKB", "USD", 1701021297, all).empty());
+    EXPECT_TRUE(kucoin->canRequestHistory(3 * constants::SecondsOneYear));
 
     EXPECT_EQ(kucoin->urlCurrentPrice("BTC", "GBP"), "https://api.kucoin.com/api/v1/prices?base=GBP&currencies=BTC");
     EXPECT_EQ(kucoin->urlCurrentPrice("BTC", "USD"), "https://api.kucoin.com/api/v1/prices?base=USD&currencies=BTC");
@@ -156,24 +306,246 @@ TEST_F(WiFiManagerTest, testKuCoin)
                   "https://api.kucoin.com/api/v1/market/candles?type=1min&symbol=BTC-GBP&startAt=1700934897&endAt=1700934957");
 
     EXPECT_TRUE(kucoin->currentPrice(currentPriceContent, "BTC", "GBP", currentPrice_out));
-    EXPECT_NEAR(currentPrice_out, 33399.51, 0.1);
+    EXPECT_NEAR(currentPrice_out.toDouble(), 33399.51, 0.1);
+    EXPECT_EQ(currentPrice_out, Price(33399511379974116LL, 12)); // rounded to 17 significant digits
+    EXPECT_FALSE(kucoin->currentPrice(currentPriceContent, "ETH", "GBP", currentPrice_out)); // filtered out
+    EXPECT_FALSE(kucoin->currentPrice("{\"code\":\"200000\",\"da", "BTC", "GBP", currentPrice_out)); // cut short
 
     EXPECT_TRUE(kucoin->priceAtTime(priceAtTimeContent, timePrice_out));
-    EXPECT_NEAR(timePrice_out, 32372.62, 0.1);
+    EXPECT_NEAR(timePrice_out.toDouble(), 32372.62, 0.1);
+
+    EXPECT_EQ(kucoin->urlCurrentPrices({"BTC", "ETH"}, "USD"), "https://api.kucoin.com/api/v1/prices?base=USD&currencies=BTC,ETH");
+    const String currentPricesContent = "{\"code\":\"200000\",\"data\":{\"BTC\":\"33399.5113799741158231\",\"ETH\":\"1650.1234\"}}";
+    StringReadStream currentPricesStream(currentPricesContent);
+    std::map<String, Price> currentPrices;
+    EXPECT_TRUE(kucoin->currentPrices(currentPricesStream, {"BTC", "ETH", "SOL"}, "USD", currentPrices));
+    EXPECT_EQ(currentPrices.size(), 2);
+    EXPECT_NEAR(currentPrices["BTC"].toDouble(), 33399.51, 0.1);
+    EXPECT_NEAR(currentPrices["ETH"].toDouble(), 1650.12, 0.1);
+
+    EXPECT_EQ(kucoin->urlPriceHistory(1701021297, constants::SecondsOneYear, "BTC", "USD"), 
+                  "https://api.kucoin.com/api/v1/market/candles?type=1day&symbol=BTC-USDT&startAt=1669398897&endAt=1701021297");
+
+    // newest first, daily samples are close enough for 1M and 1Y but not 1d
+    const String priceHistoryContent = "{\"code\":\"200000\",\"data\":[[\"1700956800\",\"37500.3\",\"0\",\"0\",\"0\",\"0\",\"0\"],"
+                                        "[\"1698451200\",\"34000.2\",\"0\",\"0\",\"0\",\"0\",\"0\"],"
+                                        "[\"1669507200\",\"16500.1\",\"0\",\"0\",\"0\",\"0\",\"0\"]]}";
+    StringReadStream historyStream(priceHistoryContent);
+    Quotes historyPrices;
+    EXPECT_TRUE(kucoin->pricesAtTimes(historyStream, 1701021297, 
+                                      {Timeframe::ONE_DAY, Timeframe::THIRTY_DAYS, Timeframe::ONE_YEAR}, 
+                                      historyPrices));
+    EXPECT_EQ(historyPrices.valid(), TimeframeSet({Timeframe::THIRTY_DAYS, Timeframe::ONE_YEAR}));
+    EXPECT_NEAR(historyPrices[Timeframe::THIRTY_DAYS].price.toDouble(), 34000.2, 0.1);
+    EXPECT_NEAR(historyPrices[Timeframe::ONE_YEAR].price.toDouble(), 16500.1, 0.1);
 
     WiFiManager wm;
     auto status = wm.initNormalMode(cfg, false, false);
     ASSERT_EQ(status, WiFiStatus::OK);
     wm.addDataSource(std::move(kucoin));
 
-    std::set<long> unixOffsets{0, constants::SecondsOneDay, constants::SecondsOneMonth, constants::SecondsOneYear};
-    std::map<long, float> priceData = wm.getPriceData(cfg.crypto, cfg.fiat, unixOffsets);
+    TimeframeSet timeframes{Timeframe::NOW, Timeframe::ONE_DAY, Timeframe::THIRTY_DAYS, Timeframe::ONE_YEAR};
+    Quotes quotes;
+    EXPECT_TRUE(wm.getPriceData(cfg.crypto, cfg.fiat, timeframes, quotes));
+    for (Timeframe timeframe : timeframes)
+    {
+        EXPECT_TRUE(quotes[timeframe].price.isPositive());
+    }
+}
+
+TEST_F(WiFiManagerTest, mixedSourceFallback)
+{
+    // first source can give the current price but not the 1d price, which should come from the next source
+    // while keeping the current price from the first
+    SourceScoreboard::reset();
+    PriceHistoryStore::clear();
+    RequestCoinGecko coingecko;
+    auto mock = std::make_unique<testing::NiceMock<MockRequest>>();
+    ON_CALL(*mock, defaultServer()).WillByDefault(testing::Return("api.coingecko.com"));
+    ON_CALL(*mock, getSourceId()).WillByDefault(testing::Return(SourceId::NONE));
+    ON_CALL(*mock, capabilities).WillByDefault(testing::Return(coingecko.capabilities()));
+    ON_CALL(*mock, urlCurrentPrice).WillByDefault([&](const String& crypto, const String& fiat)
+    {
+        return coingecko.urlCurrentPrice(crypto, fiat);
+    });
+    ON_CALL(*mock, currentPrice).WillByDefault([&](Stream& content, const String& crypto, const String& fiat, Price& price_out)
+    {
+        return coingecko.currentPrice(content, crypto, fiat, price_out);
+    });
+    ON_CALL(*mock, urlPriceAtTime).WillByDefault([&](uint32_t currentUnix, uint32_t unixOffset, const String& crypto, const String& fiat)
+    {
+        return coingecko.urlPriceAtTime(currentUnix, unixOffset, crypto, fiat);
+    });
+    ON_CALL(*mock, priceAtTime).WillByDefault(testing::Return(false));
+    EXPECT_CALL(*mock, currentPrice).Times(1);
+    EXPECT_CALL(*mock, priceAtTime).Times(constants::WiFiRequestRetries);
+
+    WiFiManager wm;
+    auto status = wm.initNormalMode(cfg, false, false);
+    ASSERT_EQ(status, WiFiStatus::OK);
+    wm.addDataSource(std::move(mock));
+    wm.addDataSource(std::make_unique<RequestKuCoin>());
+
+    Quotes quotes;
+    ASSERT_TRUE(wm.getPriceData(cfg.crypto, cfg.fiat, {Timeframe::NOW, Timeframe::ONE_DAY}, quotes));
+    EXPECT_TRUE(quotes[Timeframe::NOW].price.isPositive());
+    EXPECT_TRUE(quotes[Timeframe::ONE_DAY].price.isPositive());
+    EXPECT_EQ(quotes[Timeframe::NOW].source, SourceId::NONE);
+    EXPECT_EQ(quotes[Timeframe::ONE_DAY].source, SourceId::KUCOIN);
+}
 
-    EXPECT_FALSE(priceData.empty());
-    for (const auto& [key, value] : priceData)
+TEST_F(WiFiManagerTest, sourceScoreboard)
+{
+    SourceScoreboard::reset();
+    const String crypto = "bitcoin";
+    const String fiat = "usd";
+    const long day = constants::SecondsOneDay;
+
+    // nothing known yet
+    SourceScore score = SourceScoreboard::getScore(SourceId::COINGECKO, crypto, fiat, day);
+    EXPECT_EQ(score.samples, 0);
+    EXPECT_FALSE(score.coolingDown);
+
+    // median of the successful latencies only
+    SourceScoreboard::record(SourceId::KUCOIN, crypto, fiat, day, true, 300);
+    SourceScoreboard::record(SourceId::KUCOIN, crypto, fiat, day, true, 900);
+    SourceScoreboard::record(SourceId::KUCOIN, crypto, fiat, day, false, 5000);
+    SourceScoreboard::record(SourceId::KUCOIN, crypto, fiat, day, true, 400);
+    score = SourceScoreboard::getScore(SourceId::KUCOIN, crypto, fiat, day);
+    EXPECT_EQ(score.samples, 4);
+    EXPECT_FLOAT_EQ(score.successRate, 0.75f);
+    EXPECT_EQ(score.medianLatencyMillis, 400);
+    EXPECT_EQ(score.consecutiveFailures, 0);
+    EXPECT_FALSE(score.coolingDown);
+
+    // cools down after failing enough times in a row, for this combination only
+    for (int i = 0; i < constants::SourceFailuresBeforeCooldown; i++)
     {
-        EXPECT_GT(value, 0);
+        EXPECT_FALSE(SourceScoreboard::isCoolingDown(SourceId::COINGECKO, crypto, fiat, day));
+        SourceScoreboard::record(SourceId::COINGECKO, crypto, fiat, day, false, 100);
     }
+    EXPECT_TRUE(SourceScoreboard::isCoolingDown(SourceId::COINGECKO, crypto, fiat, day));
+    EXPECT_FALSE(SourceScoreboard::isCoolingDown(SourceId::COINGECKO, crypto, fiat, 0));
+    EXPECT_FALSE(SourceScoreboard::isCoolingDown(SourceId::COINGECKO, crypto, "eur", day));
+
+    // the source cooling down for every price is scored below one that hasn't been tried
+    TimeframeSet timeframes = {Timeframe::ONE_DAY};
+    EXPECT_GT(SourceScoreboard::sourceScore(SourceId::KUCOIN, crypto, fiat, timeframes),
+              SourceScoreboard::sourceScore(SourceId::BINANCE, crypto, fiat, timeframes));
+    EXPECT_GT(SourceScoreboard::sourceScore(SourceId::BINANCE, crypto, fiat, timeframes),
+              SourceScoreboard::sourceScore(SourceId::COINGECKO, crypto, fiat, timeframes));
+
+    // a success ends the cooldown
+    SourceScoreboard::record(SourceId::COINGECKO, crypto, fiat, day, true, 100);
+    EXPECT_FALSE(SourceScoreboard::isCoolingDown(SourceId::COINGECKO, crypto, fiat, day));
+    SourceScoreboard::reset();
+}
+
+TEST_F(WiFiManagerTest, priceHistoryStore)
+{
+    ASSERT_TRUE(SPIFFS.begin(true));
+    PriceHistoryStore::clear();
+    const uint32_t day = constants::SecondsOneDay;
+    const uint32_t now = 1701021297; // 26 Nov 2023 17:54:57
+    const uint32_t today = now - now % day;
+
+    PriceHistoryStore store("BTC", "USD");
+    EXPECT_FALSE(store.load());
+    EXPECT_EQ(store.fillFrom(now, now - constants::SecondsOneYear), today - (constants::PriceStoreMaxDays - 1) * day);
+
+    // newest first as from KuCoin, with an hourly sample that shouldn't replace the start of the day
+    store.addHistorySample(today, 300);
+    store.addHistorySample(today - day + 3600, 201);
+    store.addHistorySample(today - day, 200);
+    store.addHistorySample(today - 30 * day, 100);
+    EXPECT_EQ(store.numDailySamples(), 3);
+
+    Price price;
+    EXPECT_TRUE(store.priceAt(now - 30 * day, 30 * day / constants::PriceHistoryMaxSampleErrorDivisor, price));
+    EXPECT_EQ(price, Price(100));
+    EXPECT_TRUE(store.priceAt(today - day + 600, 3600, price));
+    EXPECT_EQ(price, Price(200));
+    EXPECT_FALSE(store.priceAt(now - day, day / constants::PriceHistoryMaxSampleErrorDivisor, price));
+
+    // only days before the oldest or after the newest are worth filling
+    EXPECT_EQ(store.fillFrom(now + day, now + day), today);
+    EXPECT_EQ(store.fillFrom(now, now - 10 * day), 0);
+    EXPECT_EQ(store.fillFrom(now, now - 2 * constants::SecondsOneYear), 0);
+
+    // saved and loaded again
+    ASSERT_TRUE(store.save());
+    PriceHistoryStore loaded("BTC", "USD");
+    ASSERT_TRUE(loaded.load());
+    EXPECT_EQ(loaded.numDailySamples(), 3);
+    EXPECT_TRUE(loaded.priceAt(today - 30 * day, 0, price));
+    EXPECT_EQ(price, Price(100));
+    PriceHistoryStore other("ETH", "USD");
+    EXPECT_FALSE(other.load());
+
+    // days older than the newest by more than the max are dropped
+    loaded.addHistorySample(today + (constants::PriceStoreMaxDays - 1) * day, 400);
+    EXPECT_EQ(loaded.numDailySamples(), 2);
+
+    // current prices answer offsets too short for the daily ones, one kept before the newest is replaced
+    // while it is closer than the spacing to the one before it
+    store.addCurrentPrice(now - day, 250);
+    store.addCurrentPrice(now - day + 60, 251);
+    store.addCurrentPrice(now - day + 120, 252);
+    store.addCurrentPrice(now, 260);
+    EXPECT_TRUE(store.priceAt(now - day, day / constants::PriceHistoryMaxSampleErrorDivisor, price));
+    EXPECT_EQ(price, Price(250));
+    EXPECT_TRUE(store.priceAt(now, 0, price));
+    EXPECT_EQ(price, Price(260));
+    EXPECT_FALSE(store.priceAt(now - day + 60, 0, price));
+    EXPECT_FALSE(store.priceAt(now - day + 120, 0, price));
+    EXPECT_FALSE(other.priceAt(now, 60, price));
+
+    PriceHistoryStore::clear();
+}
+
+TEST_F(WiFiManagerTest, priceHistoryFromStore)
+{
+    // the second time the 1M and 1Y prices should come from the history kept on the device
+    PriceHistoryStore::clear();
+    WiFiManager wm;
+    auto status = wm.initNormalMode(cfg, false, false);
+    ASSERT_EQ(status, WiFiStatus::OK);
+    ASSERT_TRUE(SPIFFS.begin(true));
+
+    TimeframeSet timeframes = {Timeframe::NOW, Timeframe::THIRTY_DAYS, Timeframe::ONE_YEAR};
+    Quotes first;
+    ASSERT_TRUE(wm.getPriceData(cfg.crypto, cfg.fiat, timeframes, first));
+
+    Quotes second;
+    ASSERT_TRUE(wm.getPriceData(cfg.crypto, cfg.fiat, timeframes, second));
+    EXPECT_NE(second[Timeframe::NOW].source, SourceId::STORE);
+    EXPECT_EQ(second[Timeframe::THIRTY_DAYS].source, SourceId::STORE);
+    EXPECT_EQ(second[Timeframe::ONE_YEAR].source, SourceId::STORE);
+    EXPECT_EQ(second[Timeframe::ONE_YEAR].price, first[Timeframe::ONE_YEAR].price);
+    EXPECT_EQ(second[Timeframe::ONE_YEAR].sampleUnix, first[Timeframe::ONE_YEAR].sampleUnix);
+
+    PriceHistoryStore::clear();
+}
+
+TEST_F(WiFiManagerTest, tlsSessionResumption)
+{
+    WiFiManager wm;
+    auto status = wm.initNormalMode(cfg, false, false);
+    ASSERT_EQ(status, WiFiStatus::OK);
+
+    // first connection caches the session, the second should resume it
+    TlsClient client;
+    ASSERT_TRUE(client.connect("api.binance.com", 443));
+    client.stop();
+
+    TlsSessionStats before = TlsSessionCache::getStats();
+    ASSERT_TRUE(client.connect("api.binance.com", 443));
+    EXPECT_TRUE(client.resumedSession());
+    client.stop();
+
+    TlsSessionStats after = TlsSessionCache::getStats();
+    EXPECT_EQ(after.hits, before.hits + 1);
+    EXPECT_EQ(after.misses, before.misses);
 }
 
 TEST_F(WiFiManagerTest, testOvernightSleepCalc)
@@ -0,0 +1,328 @@
+#include "DisplayManagerImpl.h"
+#include "Constants.h"
+#include "Utils.h"
+#include <gtest/gtest.h>
+
+// the same fonts and bitmaps the screens are drawn with, only to fingerprint them
+#include "bitmaps.h"
+#include "FreeSansBold24pt7b_edit.h"
+#include <Fonts/FreeSans12pt7b.h>
+#include <Fonts/FreeSansBold12pt7b.h>
+#include <Fonts/FreeSans9pt7b.h>
+#include <Fonts/FreeSansBold9pt7b.h>
+#include <Fonts/FreeMonoBold12pt7b.h>
+#include <Fonts/FreeMono9pt7b.h>
+#include <Fonts/Org_01.h>
+
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+#include <string.h>
+
+// ------------------------------------------------------------------------
+// Each screen is drawn into the framebuffer and compared pixel for pixel
+// with its golden image in golden/, a binary PBM any image viewer opens.
+// The fonts and bitmaps aren't in the tree, so the golden images are only
+// compared against when golden/assets.fingerprint says they were recorded
+// with the same ones as this build, otherwise the screens are skipped.
+// With a matching fingerprint a screen without a golden image fails, so
+// one that was never recorded can't pass unnoticed. Run with
+// UPDATE_GOLDEN_IMAGES=1 to record them and the fingerprint, or to replace
+// them once a change to the layout has been checked by eye in the
+// .actual.pbm written next to the golden image.
+// ------------------------------------------------------------------------
+
+namespace
+{
+    class BytePrint : public Print
+    {
+    public:
+        using Print::write;
+        size_t write(uint8_t c) override
+        {
+            bytes.push_back(c);
+            return 1;
+        }
+
+        std::vector<uint8_t> bytes;
+    };
+
+    std::string goldenPath(const std::string& name, const char* suffix = ".pbm")
+    {
+        std::string file = __FILE__;
+        return file.substr(0, file.find_last_of("/\\") + 1) + "golden/" + name + suffix;
+    }
+
+    bool readFile(const std::string& path, std::vector<uint8_t>& bytes)
+    {
+        std::ifstream in(path, std::ios::binary);
+        if (!in)
+            return false;
+        bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        return true;
+    }
+
+    bool writeFile(const std::string& path, const std::vector<uint8_t>& bytes)
+    {
+        std::ofstream out(path, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+        return out.good();
+    }
+
+    // of every font and bitmap drawn, as hex
+    std::string assetsFingerprint()
+    {
+        uint32_t hash = 2166136261u; // the default seed of utils::hash
+        for (const GFXfont* font : {&FreeSans9pt7b, &FreeSans12pt7b, &FreeSans18pt7b, &FreeSansBold9pt7b,
+                                    &FreeSansBold12pt7b, &FreeSansBold24pt7b, &FreeMono9pt7b, &FreeMonoBold12pt7b,
+                                    &Org_01})
+        {
+            size_t glyphs = font->last - font->first + 1;
+            size_t bitmapBytes = 0;
+            for (size_t i = 0; i < glyphs; i++)
+            {
+                const GFXglyph& glyph = font->glyph[i];
+                bitmapBytes = std::max<size_t>(bitmapBytes, glyph.bitmapOffset + (glyph.width * glyph.height + 7) / 8);
+            }
+            hash = utils::hash(font->glyph, glyphs * sizeof(GFXglyph), hash);
+            hash = utils::hash(font->bitmap, bitmapBytes, hash);
+        }
+
+        const std::pair<const unsigned char*, size_t> bitmaps[] = {
+            {epd_bitmap_access_point, sizeof(epd_bitmap_access_point)},
+            {epd_bitmap_loading_config_mode, sizeof(epd_bitmap_loading_config_mode)},
+            {epd_bitmap_low_battery, sizeof(epd_bitmap_low_battery)},
+            {epd_bitmap_no_wifi, sizeof(epd_bitmap_no_wifi)},
+            {epd_bitmap_overnight_sleep, sizeof(epd_bitmap_overnight_sleep)},
+            {epd_bitmap_wifi_warn, sizeof(epd_bitmap_wifi_warn)},
+            {epd_bitmap_yes_wifi_no_crypto, sizeof(epd_bitmap_yes_wifi_no_crypto)},
+        };
+        for (const auto& [bitmap, bytes] : bitmaps)
+            hash = utils::hash(bitmap, bytes, hash);
+
+        char hex[9];
+        snprintf(hex, sizeof(hex), "%08x", (unsigned int)hash);
+        return hex;
+    }
+
+    // of two PBM images the same size, -1 if they aren't
+    long differentPixels(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b)
+    {
+        if (a.size() != b.size())
+            return -1;
+        long count = 0;
+        for (size_t i = 0; i < a.size(); i++)
+            count += __builtin_popcount(a[i] ^ b[i]);
+        return count;
+    }
+}
+
+class NativeDisplayFramesTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        m_simplePrices.set(Timeframe::NOW, Price(375123, 1));
+        m_simplePrices.set(Timeframe::ONE_DAY, Price(36000));
+        m_advancedPrices.set(Timeframe::NOW, Price(123456, 2));
+        m_advancedPrices.set(Timeframe::ONE_DAY, Price(1250));
+        m_advancedPrices.set(Timeframe::THIRTY_DAYS, Price(1100));
+        m_advancedPrices.set(Timeframe::ONE_YEAR, Price(2400));
+    }
+
+    void expectMatchesGolden(const std::string& name)
+    {
+        BytePrint frame;
+        m_display.writePbm(frame);
+
+        std::string path = goldenPath(name);
+        std::vector<uint8_t> golden;
+        std::string fingerprint = assetsFingerprint();
+        std::string fingerprintPath = goldenPath("assets", ".fingerprint");
+        const char* update = getenv("UPDATE_GOLDEN_IMAGES");
+        if (update != nullptr && strcmp(update, "1") == 0)
+        {
+            ASSERT_TRUE(writeFile(path, frame.bytes)) << "cannot write " << path;
+            ASSERT_TRUE(writeFile(fingerprintPath, std::vector<uint8_t>(fingerprint.begin(), fingerprint.end())))
+                << "cannot write " << fingerprintPath;
+            GTEST_SKIP() << "recorded the golden image " << path;
+        }
+
+        std::vector<uint8_t> recorded;
+        if (!readFile(fingerprintPath, recorded) || std::string(recorded.begin(), recorded.end()) != fingerprint)
+        {
+            GTEST_SKIP() << "the golden images weren't recorded with the fonts and bitmaps of this build ("
+                         << fingerprint << "), run with UPDATE_GOLDEN_IMAGES=1 to record them";
+        }
+        if (!readFile(path, golden))
+        {
+            writeFile(goldenPath(name, ".actual.pbm"), frame.bytes);
+            FAIL() << "no golden image for " << name << " at " << path << ", drawn into "
+                   << goldenPath(name, ".actual.pbm") << ", run with UPDATE_GOLDEN_IMAGES=1 to record it";
+        }
+
+        long different = differentPixels(golden, frame.bytes);
+        if (different != 0)
+        {
+            writeFile(goldenPath(name, ".actual.pbm"), frame.bytes);
+            ADD_FAILURE() << name << " is not its golden image, " << different << " pixels differ (-1 is a different "
+                          << "size), drawn into " << goldenPath(name, ".actual.pbm");
+        }
+    }
+
+    DisplayManagerImpl m_display{1, DisplayTarget::FRAMEBUFFER};
+    Quotes m_simplePrices;
+    Quotes m_advancedPrices;
+};
+
+TEST_F(NativeDisplayFramesTest, writeDisplaySimple)
+{
+    m_display.writeDisplay("BTC", "USD", m_simplePrices, "12 Oct", "12:34", 80);
+    expectMatchesGolden("simple");
+}
+
+TEST_F(NativeDisplayFramesTest, writeDisplaySimpleFalling)
+{
+    m_simplePrices.set(Timeframe::NOW, Price(12345, 5));
+    m_simplePrices.set(Timeframe::ONE_DAY, Price(2, 1));
+    m_display.writeDisplay("DOGE", "GBP", m_simplePrices, "1 Jan", "09:05", 5);
+    expectMatchesGolden("simple_falling");
+}
+
+TEST_F(NativeDisplayFramesTest, writeDisplayAdvanced)
+{
+    m_display.writeDisplay("ETH", "EUR", m_advancedPrices, "12 Oct", "12:34", 80);
+    expectMatchesGolden("advanced");
+}
+
+TEST_F(NativeDisplayFramesTest, writeDisplayAdvancedLongSymbol)
+{
+    // takes a smaller font for the crypto box
+    m_display.writeDisplay("MATICUSD", "USD", m_advancedPrices, "28 Sep", "23:59", 100);
+    expectMatchesGolden("advanced_long_symbol");
+}
+
+TEST_F(NativeDisplayFramesTest, writeDisplayWithoutEveryTimeframe)
+{
+    // a day ago is in both layouts
+    Quotes quotes;
+    quotes.set(Timeframe::NOW, Price(375123, 1));
+    quotes.set(Timeframe::THIRTY_DAYS, Price(1100));
+    quotes.set(Timeframe::ONE_YEAR, Price(2400));
+    m_display.writeDisplay("BTC", "USD", quotes, "12 Oct", "12:34", 80);
+    expectMatchesGolden("generic_text");
+}
+
+TEST_F(NativeDisplayFramesTest, writeWatchlist)
+{
+    std::map<String, Price> prices = {{"BTC", Price(375123, 1)}, {"ETH", Price(123456, 2)}, {"DOGE", Price(12345, 5)},
+                                      {"ADA", Price(25, 1)}};
+    m_display.writeWatchlist({"BTC", "ETH", "DOGE", "ADA"}, "USD", prices, 1, 2, "12 Oct", "12:34");
+    expectMatchesGolden("watchlist");
+}
+
+TEST_F(NativeDisplayFramesTest, writeGenericText)
+{
+    m_display.writeGenericText("Unsupported data times requested");
+    expectMatchesGolden("generic_text");
+}
+
+TEST_F(NativeDisplayFramesTest, drawCannotConnectToWifi)
+{
+    m_display.drawCannotConnectToWifi("HomeNetwork", "password123");
+    expectMatchesGolden("cannot_connect_to_wifi");
+}
+
+TEST_F(NativeDisplayFramesTest, drawWifiHasNoInternet)
+{
+    m_display.drawWifiHasNoInternet();
+    expectMatchesGolden("wifi_has_no_internet");
+}
+
+TEST_F(NativeDisplayFramesTest, drawLowBattery)
+{
+    m_display.drawLowBattery();
+    expectMatchesGolden("low_battery");
+}
+
+TEST_F(NativeDisplayFramesTest, drawYesWifiNoCrypto)
+{
+    m_display.drawYesWifiNoCrypto("12 Oct", "12:34");
+    expectMatchesGolden("yes_wifi_no_crypto");
+}
+
+TEST_F(NativeDisplayFramesTest, drawConfig)
+{
+    m_display.drawConfig("HomeNetwork", "password123", "BTC", "USD", 5);
+    expectMatchesGolden("config");
+}
+
+TEST_F(NativeDisplayFramesTest, drawAccessPoint)
+{
+    m_display.drawAccessPoint("192.168.4.1");
+    expectMatchesGolden("access_point");
+}
+
+TEST_F(NativeDisplayFramesTest, drawOvernightSleep)
+{
+    m_display.drawOvernightSleep();
+    expectMatchesGolden("overnight_sleep");
+}
+
+TEST_F(NativeDisplayFramesTest, drawStartingConfigMode)
+{
+    m_display.drawStartingConfigMode();
+    expectMatchesGolden("starting_config_mode");
+}
+
+TEST_F(NativeDisplayFramesTest, framebufferLeavesThePanelAlone)
+{
+    fake::display::reset();
+    m_display.initInBackground();
+    m_display.writeDisplay("BTC", "USD", m_simplePrices, "12 Oct", "12:34", 80);
+    m_display.writeDisplay("BTC", "USD", m_simplePrices, "12 Oct", "12:34", 80);
+    m_display.hibernate();
+    EXPECT_EQ(fake::display::refreshCount(), 0);
+    EXPECT_EQ(fake::display::bytesWritten(), 0u);
+
+    // and draws every frame, as it doesn't know what the panel shows
+    m_display.fillScreen();
+    EXPECT_TRUE(m_display.isBlack(0, 0));
+    m_display.writeDisplay("BTC", "USD", m_simplePrices, "12 Oct", "12:34", 80);
+    EXPECT_FALSE(m_display.isBlack(m_display.width() - 1, m_display.height() - 1));
+}
+
+// not a check, how long each screen takes to draw on the host, to compare changes to the layout code with
+TEST_F(NativeDisplayFramesTest, benchmarkRender)
+{
+    constexpr int Iterations = 200;
+    struct Screen
+    {
+        const char* name;
+        std::function<void()> draw;
+    };
+    std::map<String, Price> prices = {{"BTC", Price(375123, 1)}, {"ETH", Price(123456, 2)}, {"DOGE", Price(12345, 5)},
+                                      {"ADA", Price(25, 1)}};
+    const Screen screens[] = {
+        {"simple", [&] { m_display.writeDisplay("BTC", "USD", m_simplePrices, "12 Oct", "12:34", 80); }},
+        {"advanced", [&] { m_display.writeDisplay("ETH", "EUR", m_advancedPrices, "12 Oct", "12:34", 80); }},
+        {"watchlist", [&] { m_display.writeWatchlist({"BTC", "ETH", "DOGE", "ADA"}, "USD", prices, 1, 2, "12 Oct",
+                                                     "12:34"); }},
+        {"config", [&] { m_display.drawConfig("HomeNetwork", "password123", "BTC", "USD", 5); }},
+        {"low battery", [&] { m_display.drawLowBattery(); }},
+    };
+
+    for (const Screen& screen : screens)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < Iterations; i++)
+            screen.draw();
+        auto end = std::chrono::steady_clock::now();
+        double microsEach = std::chrono::duration<double, std::micro>(end - start).count() / Iterations;
+        printf("%-12s %8.1f us\n", screen.name, microsEach);
+    }
+}
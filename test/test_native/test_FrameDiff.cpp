@@ -0,0 +1,242 @@
+#include "FrameDiff.h"
+#include "Constants.h"
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <random>
+#include <vector>
+
+namespace
+{
+    // as the controller's memory of the 2.13" panel
+    constexpr uint16_t BytesPerRow = 16;
+    constexpr uint16_t Rows = 250;
+    constexpr size_t MaxRects = constants::DisplayMaxDirtyRects;
+
+    bool covered(const DirtyRect* rects, size_t numRects, uint16_t x, uint16_t y)
+    {
+        for (size_t i = 0; i < numRects; i++)
+            if (x >= rects[i].x && x < rects[i].x + rects[i].w && y >= rects[i].y && y < rects[i].y + rects[i].h)
+                return true;
+        return false;
+    }
+
+    // a white frame with some text-like blocks drawn on it
+    std::vector<uint8_t> drawnFrame(uint32_t seed)
+    {
+        std::vector<uint8_t> frame(BytesPerRow * Rows, 0xFF);
+        std::mt19937 random(seed);
+        for (int block = 0; block < 12; block++)
+        {
+            int x = random() % (BytesPerRow - 3), y = random() % (Rows - 30);
+            for (int row = y; row < y + 30; row++)
+                for (int i = x; i < x + 3; i++)
+                    frame[row * BytesPerRow + i] = random();
+        }
+        return frame;
+    }
+}
+
+class NativeFrameDiffTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        m_previous = drawnFrame(1);
+        m_next = m_previous;
+    }
+
+    size_t diff()
+    {
+        return FrameDiff::diff(m_previous.data(), m_next.data(), BytesPerRow, Rows, m_rects, MaxRects);
+    }
+
+    // every byte that differs is in a rectangle and none of them overlap
+    void expectCoversChanges(size_t numRects)
+    {
+        for (uint16_t y = 0; y < Rows; y++)
+        {
+            for (uint16_t x = 0; x < BytesPerRow; x++)
+            {
+                if (m_previous[y * BytesPerRow + x] != m_next[y * BytesPerRow + x])
+                {
+                    ASSERT_TRUE(covered(m_rects, numRects, x, y)) << "byte " << x << " of row " << y;
+                }
+            }
+        }
+
+        for (size_t i = 0; i < numRects; i++)
+        {
+            EXPECT_LE(m_rects[i].x + m_rects[i].w, BytesPerRow);
+            EXPECT_LE(m_rects[i].y + m_rects[i].h, Rows);
+            for (size_t j = i + 1; j < numRects; j++)
+            {
+                bool overlap = m_rects[i].x < m_rects[j].x + m_rects[j].w && m_rects[j].x < m_rects[i].x + m_rects[i].w &&
+                               m_rects[i].y < m_rects[j].y + m_rects[j].h && m_rects[j].y < m_rects[i].y + m_rects[i].h;
+                EXPECT_FALSE(overlap) << "rects " << i << " and " << j;
+            }
+        }
+    }
+
+    std::vector<uint8_t> m_previous;
+    std::vector<uint8_t> m_next;
+    DirtyRect m_rects[MaxRects];
+};
+
+TEST_F(NativeFrameDiffTest, sameFrame)
+{
+    EXPECT_EQ(diff(), 0u);
+}
+
+TEST_F(NativeFrameDiffTest, singleByte)
+{
+    m_next[37 * BytesPerRow + 6] ^= 0x10;
+    ASSERT_EQ(diff(), 1u);
+    EXPECT_EQ(m_rects[0].x, 6);
+    EXPECT_EQ(m_rects[0].y, 37);
+    EXPECT_EQ(m_rects[0].w, 1);
+    EXPECT_EQ(m_rects[0].h, 1);
+
+    // the last byte of a row, and the last row
+    m_next = m_previous;
+    m_next[Rows * BytesPerRow - 1] ^= 0x01;
+    ASSERT_EQ(diff(), 1u);
+    EXPECT_EQ(m_rects[0].x, BytesPerRow - 1);
+    EXPECT_EQ(m_rects[0].y, Rows - 1);
+}
+
+TEST_F(NativeFrameDiffTest, changeOverRowsIsOneRect)
+{
+    // a digit of the time, drawn across rows as the panel is rotated
+    for (int y = 100; y < 118; y++)
+        for (int x = 3; x < 6; x++)
+            m_next[y * BytesPerRow + x] ^= (y + x) | 1;
+
+    ASSERT_EQ(diff(), 1u);
+    EXPECT_EQ(m_rects[0].x, 3);
+    EXPECT_EQ(m_rects[0].y, 100);
+    EXPECT_EQ(m_rects[0].w, 3);
+    EXPECT_EQ(m_rects[0].h, 18);
+}
+
+TEST_F(NativeFrameDiffTest, separateChangesKeptApart)
+{
+    // the time at one end of the panel and the price change at the other
+    for (int y = 10; y < 20; y++)
+        m_next[y * BytesPerRow + 1] ^= 0xFF;
+    for (int y = 200; y < 230; y++)
+        m_next[y * BytesPerRow + 12] ^= 0xFF;
+    // and in the same rows, a word apart
+    for (int y = 50; y < 60; y++)
+    {
+        m_next[y * BytesPerRow + 0] ^= 0xFF;
+        m_next[y * BytesPerRow + 15] ^= 0xFF;
+    }
+
+    size_t numRects = diff();
+    EXPECT_EQ(numRects, 4u);
+    EXPECT_EQ(FrameDiff::area(m_rects, numRects), 10u + 30 + 20);
+    expectCoversChanges(numRects);
+
+    DirtyRect all = FrameDiff::bounds(m_rects, numRects);
+    EXPECT_EQ(all.x, 0);
+    EXPECT_EQ(all.y, 10);
+    EXPECT_EQ(all.w, BytesPerRow);
+    EXPECT_EQ(all.h, 220);
+}
+
+TEST_F(NativeFrameDiffTest, joinsClosestPastMax)
+{
+    // more separate changes than rects allowed, stepping down the panel
+    for (int i = 0; i < 20; i++)
+        m_next[(i * 12) * BytesPerRow + (i % 2) * 12] ^= 0xFF;
+
+    size_t numRects = diff();
+    EXPECT_EQ(numRects, MaxRects);
+    expectCoversChanges(numRects);
+    // joining the neighbours down the panel, not one rect around everything
+    EXPECT_LT(FrameDiff::area(m_rects, numRects), (size_t)BytesPerRow * Rows / 2);
+}
+
+TEST_F(NativeFrameDiffTest, coversRandomChanges)
+{
+    std::mt19937 random(7);
+    for (int frame = 0; frame < 200; frame++)
+    {
+        m_next = m_previous;
+        int changes = random() % 40;
+        for (int i = 0; i < changes; i++)
+            m_next[random() % m_next.size()] ^= 1 << (random() % 8);
+
+        size_t numRects = diff();
+        EXPECT_LE(numRects, MaxRects);
+        EXPECT_EQ(numRects == 0, m_next == m_previous);
+        expectCoversChanges(numRects);
+    }
+}
+
+TEST_F(NativeFrameDiffTest, unalignedRowLength)
+{
+    // rows that aren't a whole number of words, the end of each is still compared
+    constexpr uint16_t OddBytesPerRow = 15;
+    std::vector<uint8_t> previous(OddBytesPerRow * 10, 0xFF), next = previous;
+    next[3 * OddBytesPerRow + 14] = 0;
+    next[4 * OddBytesPerRow + 13] = 0;
+
+    ASSERT_EQ(FrameDiff::diff(previous.data(), next.data(), OddBytesPerRow, 10, m_rects, MaxRects), 1u);
+    EXPECT_EQ(m_rects[0].x, 13);
+    EXPECT_EQ(m_rects[0].y, 3);
+    EXPECT_EQ(m_rects[0].w, 2);
+    EXPECT_EQ(m_rects[0].h, 2);
+}
+
+// times the diff on the host for a few kinds of frame, as a guide to how it compares between changes rather
+// than what the ESP32 takes
+TEST_F(NativeFrameDiffTest, benchmark)
+{
+    struct Case
+    {
+        const char* name;
+        std::vector<uint8_t> next;
+    };
+    std::vector<Case> cases;
+    cases.push_back({"same frame", m_previous});
+
+    // the time and a digit of the price
+    std::vector<uint8_t> typical = m_previous;
+    for (int y = 0; y < 40; y++)
+        for (int x = 1; x < 3; x++)
+            typical[(160 + y) * BytesPerRow + x] ^= 0x3C;
+    for (int y = 0; y < 20; y++)
+        typical[(30 + y) * BytesPerRow + 9] ^= 0x7E;
+    cases.push_back({"typical", typical});
+
+    // a different screen, every byte changed
+    std::vector<uint8_t> everyByte = m_previous;
+    for (uint8_t& byte : everyByte)
+        byte = ~byte;
+    cases.push_back({"every byte", everyByte});
+
+    // the most separate changes, every other word in rows that alternate, then joined down to the max
+    std::vector<uint8_t> scattered = m_previous;
+    for (int y = 0; y < Rows; y += 2)
+        for (int x = (y / 2) % 2 * 4; x < BytesPerRow; x += 8)
+            scattered[y * BytesPerRow + x] ^= 0x01;
+    cases.push_back({"scattered (worst case)", scattered});
+
+    constexpr int Iterations = 2000;
+    for (const Case& c : cases)
+    {
+        size_t numRects = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < Iterations; i++)
+            numRects = FrameDiff::diff(m_previous.data(), c.next.data(), BytesPerRow, Rows, m_rects, MaxRects);
+        auto end = std::chrono::steady_clock::now();
+        double microsEach = std::chrono::duration<double, std::micro>(end - start).count() / Iterations;
+
+        m_next = c.next;
+        expectCoversChanges(numRects);
+        printf("%-24s %8.2f us  %zu rects  %4zu of %d bytes\n", c.name, microsEach, numRects,
+               FrameDiff::area(m_rects, numRects), BytesPerRow * Rows);
+    }
+}
@@ -0,0 +1,171 @@
+#include "Price.h"
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <math.h>
+#include <stdlib.h>
+#include <string>
+
+namespace
+{
+    Price price(const char* text)
+    {
+        Price parsed;
+        EXPECT_TRUE(Price::parse(text, parsed)) << text;
+        return parsed;
+    }
+
+    std::string format(const Price& value, uint8_t decimals)
+    {
+        char buf[32];
+        value.format(buf, sizeof(buf), decimals);
+        return buf;
+    }
+}
+
+TEST(NativePriceTest, parsesDecimalStrings)
+{
+    EXPECT_EQ(price("29396.32000000").mantissa(), 2939632);
+    EXPECT_EQ(price("29396.32000000").scale(), 2);
+    EXPECT_EQ(price("0.00000812").mantissa(), 812);
+    EXPECT_EQ(price("0.00000812").scale(), 8);
+    EXPECT_EQ(price("-1.5"), Price(-15, 1));
+    EXPECT_EQ(price("+42"), Price(42));
+    EXPECT_EQ(price("0"), Price());
+    EXPECT_EQ(price("0.000"), Price());
+    EXPECT_EQ(price(".5"), Price(5, 1));
+    EXPECT_EQ(price("7."), Price(7));
+}
+
+TEST(NativePriceTest, parsesExponents)
+{
+    EXPECT_EQ(price("8.12e-06"), Price(812, 8));
+    EXPECT_EQ(price("1.5E3"), Price(1500));
+    EXPECT_EQ(price("2e+2"), Price(200));
+    EXPECT_EQ(price("1e-30"), Price());
+}
+
+TEST(NativePriceTest, rejectsWhatIsNotANumber)
+{
+    Price parsed;
+    for (const char* text : {"", "-", ".", "abc", "1.2.3", "12a", "1e", "1e-", " 1", "1 ", "123456789012345678901"})
+        EXPECT_FALSE(Price::parse(text, parsed)) << "'" << text << "'";
+    EXPECT_FALSE(Price::parse(nullptr, parsed));
+    EXPECT_TRUE(Price::parse("12a", 2, parsed));
+    EXPECT_EQ(parsed, Price(12));
+}
+
+TEST(NativePriceTest, roundsDigitsPastWhatIsKept)
+{
+    // 17 significant digits are kept
+    EXPECT_EQ(price("1.23456789012345678"), Price(12345678901234568LL, 16));
+    EXPECT_EQ(price("0.0000000000000000014"), Price(1, 18));
+    EXPECT_EQ(price("0.0000000000000000015"), Price(2, 18));
+}
+
+TEST(NativePriceTest, keepsWhatAFloatLoses)
+{
+    // a float is out by more than a cent at this price, and has no more than 7 significant digits
+    const char* btc = "1234567.89";
+    EXPECT_NE((double)strtof(btc, nullptr), 1234567.89);
+    EXPECT_EQ(format(price(btc), 2), btc);
+
+    const char* shib = "0.0000081234567";
+    EXPECT_EQ(format(price(shib), 13), shib);
+}
+
+TEST(NativePriceTest, fromDoubleIsTheDecimalInTheJson)
+{
+    Price converted;
+    ASSERT_TRUE(Price::fromDouble(33357.5612, converted));
+    EXPECT_EQ(converted, Price(333575612, 4));
+    ASSERT_TRUE(Price::fromDouble(0.0000081234, converted));
+    EXPECT_EQ(converted, Price(81234, 10));
+    ASSERT_TRUE(Price::fromDouble(29585.391271772718, converted));
+    EXPECT_EQ(converted, Price(295853912717727LL, 10));
+    EXPECT_FALSE(Price::fromDouble(NAN, converted));
+}
+
+TEST(NativePriceTest, comparesAcrossScales)
+{
+    EXPECT_EQ(Price(15, 1), Price(150, 2));
+    EXPECT_LT(Price(149, 2), Price(15, 1));
+    EXPECT_GT(Price(1000), Price(99999, 2));
+    EXPECT_LT(Price(-1), Price(1, 18));
+    EXPECT_LT(Price(-2), Price(-15, 1));
+    EXPECT_GT(Price(-149, 2), Price(-15, 1));
+    EXPECT_LT(Price(12345678901234567LL, 0), Price(12345678901234568LL, 0));
+}
+
+TEST(NativePriceTest, roundsHalfAwayFromZero)
+{
+    EXPECT_EQ(Price(12345, 5).roundedTo(4), 1235);
+    EXPECT_EQ(Price(-12345, 5).roundedTo(4), -1235);
+    EXPECT_EQ(Price(12344, 5).roundedTo(4), 1234);
+    EXPECT_EQ(Price(5, 1).roundedTo(0), 1);
+    EXPECT_EQ(Price(12).roundedTo(3), 12000);
+}
+
+TEST(NativePriceTest, formatsToDecimals)
+{
+    EXPECT_EQ(format(Price(12345, 5), 4), "0.1235");
+    EXPECT_EQ(format(Price(1), 4), "1.0000");
+    EXPECT_EQ(format(Price(-12345, 3), 1), "-12.3");
+    EXPECT_EQ(format(Price(1234567), 0), "1234567");
+    EXPECT_EQ(format(Price(-4, 3), 2), "0.00");
+
+    // cut short like snprintf
+    char buf[4];
+    EXPECT_EQ(Price(12345, 2).format(buf, sizeof(buf), 2), 6u);
+    EXPECT_STREQ(buf, "123");
+}
+
+TEST(NativePriceTest, percentChangeIsExact)
+{
+    EXPECT_EQ(price("110").percentChangeFrom(price("100")), price("10"));
+    EXPECT_EQ(price("90").percentChangeFrom(price("100")), price("-10"));
+    EXPECT_EQ(price("100").percentChangeFrom(price("100")), Price());
+    // 1/3 is rounded at the last place
+    EXPECT_EQ(price("4").percentChangeFrom(price("3")), Price(33333333, Price::PercentScale));
+    EXPECT_EQ(price("2").percentChangeFrom(price("3")), Price(-33333333, Price::PercentScale));
+    // a change far smaller than a float can see at this price
+    EXPECT_EQ(price("37512.31").percentChangeFrom(price("37512.30")), Price(27, Price::PercentScale));
+    EXPECT_EQ(price("0.0000081235").percentChangeFrom(price("0.0000081234")), Price(1231, Price::PercentScale));
+    // prices at very different scales
+    EXPECT_EQ(price("2").percentChangeFrom(price("0.0000001")), price("1999999900"));
+    EXPECT_EQ(price("1").percentChangeFrom(Price()), Price());
+}
+
+// not a check, times reading, comparing and formatting a price as a float against as a Price
+TEST(NativePriceTest, benchmarkPrice)
+{
+    constexpr int Iterations = 200000;
+    const char* current = "37512.31000000";
+    const char* dayAgo = "36000.00000000";
+    char buf[32];
+    volatile size_t sink = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < Iterations; i++)
+    {
+        float now = strtof(current, nullptr), then = strtof(dayAgo, nullptr);
+        float change = ((now - then) / then) * 100;
+        sink += snprintf(buf, sizeof(buf), "%.2f", change);
+    }
+    auto end = std::chrono::steady_clock::now();
+    double floatMicros = std::chrono::duration<double, std::micro>(end - start).count() / Iterations;
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < Iterations; i++)
+    {
+        Price now, then;
+        Price::parse(current, now);
+        Price::parse(dayAgo, then);
+        sink += now.percentChangeFrom(then).format(buf, sizeof(buf), 2);
+    }
+    end = std::chrono::steady_clock::now();
+    double priceMicros = std::chrono::duration<double, std::micro>(end - start).count() / Iterations;
+
+    EXPECT_STREQ(buf, "4.20");
+    printf("float %6.3f us  Price %6.3f us\n", floatMicros, priceMicros);
+}
@@ -0,0 +1,95 @@
+#include "Quotes.h"
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <map>
+#include <vector>
+
+namespace
+{
+    constexpr TimeframeSet DayAndYear = {Timeframe::ONE_DAY, Timeframe::ONE_YEAR};
+    static_assert(DayAndYear.has(Timeframe::ONE_YEAR) && !DayAndYear.has(Timeframe::NOW), "a bit per timeframe");
+    static_assert(DayAndYear.without({Timeframe::ONE_DAY}) == TimeframeSet({Timeframe::ONE_YEAR}), "");
+    static_assert(DayAndYear.with({Timeframe::NOW}).contains({Timeframe::NOW, Timeframe::ONE_YEAR}), "");
+    static_assert(timeframeSeconds(Timeframe::THIRTY_DAYS) == constants::SecondsOneMonth, "as the offsets before");
+    static_assert(sizeof(TimeframeSet) == 1, "");
+}
+
+TEST(NativeQuotesTest, timeframeSetIteratesShortestFirst)
+{
+    TimeframeSet timeframes = {Timeframe::ONE_YEAR, Timeframe::NOW, Timeframe::SEVEN_DAYS};
+    std::vector<Timeframe> order;
+    for (Timeframe timeframe : timeframes)
+        order.push_back(timeframe);
+    EXPECT_EQ(order, std::vector<Timeframe>({Timeframe::NOW, Timeframe::SEVEN_DAYS, Timeframe::ONE_YEAR}));
+    EXPECT_EQ(timeframes.size(), 3);
+    EXPECT_EQ(timeframes.longest(), Timeframe::ONE_YEAR);
+
+    timeframes.erase(Timeframe::ONE_YEAR);
+    timeframes.insert(Timeframe::ONE_HOUR);
+    EXPECT_EQ(timeframes.longest(), Timeframe::SEVEN_DAYS);
+    EXPECT_TRUE(timeframes.contains({Timeframe::NOW, Timeframe::ONE_HOUR}));
+    EXPECT_FALSE(timeframes.contains(DayAndYear));
+
+    TimeframeSet none;
+    EXPECT_TRUE(none.empty());
+    EXPECT_EQ(none.begin() != none.end(), false);
+    EXPECT_EQ(none.longest(), Timeframe::NOW);
+}
+
+TEST(NativeQuotesTest, quotesKeepWhereEachPriceCameFrom)
+{
+    Quotes quotes;
+    EXPECT_TRUE(quotes.valid().empty());
+    EXPECT_FALSE(quotes.has(Timeframe::NOW));
+
+    quotes.set(Timeframe::NOW, Price(375123, 1), 1701021297, SourceId::COINGECKO);
+    quotes.set(Timeframe::ONE_DAY, Price(36000), 1700934400, SourceId::STORE);
+    EXPECT_EQ(quotes.valid(), TimeframeSet({Timeframe::NOW, Timeframe::ONE_DAY}));
+    EXPECT_EQ(quotes[Timeframe::NOW].price, Price(375123, 1));
+    EXPECT_EQ(quotes[Timeframe::NOW].source, SourceId::COINGECKO);
+    EXPECT_EQ(quotes[Timeframe::ONE_DAY].sampleUnix, 1700934400u);
+    EXPECT_FALSE(quotes[Timeframe::ONE_YEAR].valid);
+
+    quotes.clear();
+    EXPECT_TRUE(quotes.valid().empty());
+}
+
+// not a check, times filling and reading the prices of a wake in the advanced layout as a map against as Quotes
+TEST(NativeQuotesTest, benchmarkQuotes)
+{
+    constexpr int Iterations = 200000;
+    const long offsets[] = {0, constants::SecondsOneDay, constants::SecondsOneMonth, constants::SecondsOneYear};
+    const Timeframe timeframes[] = {Timeframe::NOW, Timeframe::ONE_DAY, Timeframe::THIRTY_DAYS, Timeframe::ONE_YEAR};
+    volatile int64_t sink = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < Iterations; i++)
+    {
+        std::map<long, Price> prices;
+        std::map<long, SourceId> sources;
+        for (long offset : offsets)
+        {
+            prices[offset] = Price(i + offset, 2);
+            sources[offset] = SourceId::STORE;
+        }
+        if (prices.size() == 4)
+            sink += prices[0].mantissa() + prices[constants::SecondsOneYear].mantissa();
+    }
+    auto end = std::chrono::steady_clock::now();
+    double mapMicros = std::chrono::duration<double, std::micro>(end - start).count() / Iterations;
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < Iterations; i++)
+    {
+        Quotes quotes;
+        for (Timeframe timeframe : timeframes)
+            quotes.set(timeframe, Price(i + timeframeSeconds(timeframe), 2), 0, SourceId::STORE);
+        if (quotes.valid().contains({Timeframe::NOW, Timeframe::ONE_YEAR}))
+            sink += quotes[Timeframe::NOW].price.mantissa() + quotes[Timeframe::ONE_YEAR].price.mantissa();
+    }
+    end = std::chrono::steady_clock::now();
+    double quotesMicros = std::chrono::duration<double, std::micro>(end - start).count() / Iterations;
+
+    printf("map %6.3f us  Quotes %6.3f us\n", mapMicros, quotesMicros);
+}
@@ -0,0 +1,109 @@
+#include "SleepSchedule.h"
+#include "TimeKeeper.h"
+#include "Constants.h"
+#include <gtest/gtest.h>
+
+class NativeSleepScheduleTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        fake::device::reset();
+        TimeKeeper::reset();
+    }
+
+    void TearDown() override
+    {
+        TimeKeeper::reset();
+    }
+
+    SleepState m_state{};
+};
+
+TEST_F(NativeSleepScheduleTest, refreshFromConfig)
+{
+    EXPECT_EQ(SleepSchedule::refreshSeconds("15"), 900);
+    EXPECT_EQ(SleepSchedule::refreshSeconds("0"), 300);
+    EXPECT_EQ(SleepSchedule::refreshSeconds("abc"), 300);
+}
+
+TEST_F(NativeSleepScheduleTest, backsOffAfterFailures)
+{
+    EXPECT_EQ(SleepSchedule::secondsAfterWiFiFail(1), 60);
+    EXPECT_EQ(SleepSchedule::secondsAfterWiFiFail(3), 300);
+    EXPECT_EQ(SleepSchedule::secondsAfterWiFiFail(50), 3600);
+    EXPECT_EQ(SleepSchedule::secondsAfterDataFail(50), 600);
+
+    WakeOutcome failed{60, true, false, 0};
+    EXPECT_EQ(SleepSchedule::endWake(m_state, failed), 60u);
+    EXPECT_EQ(SleepSchedule::endWake(m_state, failed), 60u);
+    EXPECT_EQ(m_state.wifiFails, 2);
+
+    WakeOutcome ok{300, false, false, 0};
+    EXPECT_EQ(SleepSchedule::endWake(m_state, ok), 300u);
+    EXPECT_EQ(m_state.wifiFails, 0);
+}
+
+TEST_F(NativeSleepScheduleTest, finishWakeDrawsFailuresFromTheSecond)
+{
+    // the first failure is only retried, unless it is the first boot with nothing else on the screen
+    WakeOutcome wifi{300, true, false, 0};
+    EXPECT_EQ(SleepSchedule::finishWake(0, 0, 2, wifi), EndOfWakeScreen::NONE);
+    EXPECT_EQ(wifi.refreshSeconds, SleepSchedule::secondsAfterWiFiFail(1));
+    EXPECT_EQ(SleepSchedule::finishWake(0, 0, 1, wifi), EndOfWakeScreen::WIFI_FAILURE);
+    EXPECT_EQ(SleepSchedule::finishWake(2, 0, 5, wifi), EndOfWakeScreen::WIFI_FAILURE);
+    EXPECT_EQ(wifi.refreshSeconds, SleepSchedule::secondsAfterWiFiFail(3));
+
+    WakeOutcome data{300, false, true, 0};
+    EXPECT_EQ(SleepSchedule::finishWake(3, 0, 5, data), EndOfWakeScreen::NONE);
+    EXPECT_EQ(SleepSchedule::finishWake(3, 1, 5, data), EndOfWakeScreen::DATA_FAILURE);
+    EXPECT_EQ(data.refreshSeconds, SleepSchedule::secondsAfterDataFail(2));
+
+    WakeOutcome night{300, false, false, 3600};
+    EXPECT_EQ(SleepSchedule::finishWake(0, 0, 5, night), EndOfWakeScreen::OVERNIGHT_SLEEP);
+    EXPECT_EQ(night.refreshSeconds, 300);
+
+    WakeOutcome ok{300, false, false, 0};
+    EXPECT_EQ(SleepSchedule::finishWake(0, 0, 1, ok), EndOfWakeScreen::NONE);
+}
+
+TEST_F(NativeSleepScheduleTest, chainsOvernightSleep)
+{
+    // never synced, so the time could be out by any amount and the most time is kept back
+    WakeOutcome night{300, false, false, 8 * 3600};
+    uint64_t first = SleepSchedule::endWake(m_state, night);
+    EXPECT_EQ(m_state.overnightSleepPeriodsLeft, 7);
+    EXPECT_EQ(first, (8 * 3600 - constants::OvernightSleepMaxReserveSeconds) / 8u);
+
+    uint64_t total = first;
+    uint64_t sleepSeconds = 0;
+    int wakes = 0;
+    while (SleepSchedule::continueOvernightSleep(m_state, sleepSeconds))
+    {
+        total += sleepSeconds;
+        wakes++;
+    }
+    EXPECT_EQ(wakes, 7);
+    EXPECT_TRUE(m_state.waitForNtpSync);
+    EXPECT_NEAR(total, 8 * 3600 - constants::OvernightSleepMaxReserveSeconds, 8);
+
+    // the wake after the chain finds the last few minutes left and sleeps them in one go
+    WakeOutcome reserve{300, false, false, 500};
+    EXPECT_EQ(SleepSchedule::endWake(m_state, reserve), 500u);
+    EXPECT_FALSE(SleepSchedule::continueOvernightSleep(m_state, sleepSeconds));
+}
+
+TEST_F(NativeSleepScheduleTest, findsOvernightSleep)
+{
+    struct tm timeinfo{};
+    uint64_t secondsLeft = 0;
+
+    timeinfo.tm_hour = 0;
+    timeinfo.tm_min = 20;
+    timeinfo.tm_sec = 30;
+    EXPECT_TRUE(SleepSchedule::isDuringOvernightSleep(timeinfo, 23, 2, secondsLeft));
+    EXPECT_EQ(secondsLeft, 2370u);
+
+    timeinfo.tm_hour = 1;
+    EXPECT_FALSE(SleepSchedule::isDuringOvernightSleep(timeinfo, 23, 2, secondsLeft));
+}
@@ -0,0 +1,79 @@
+#include "SymbolCatalog.h"
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <map>
+#include <set>
+#include <string>
+
+TEST(NativeSymbolCatalogTest, findsEverySymbolInTheList)
+{
+    std::set<std::string> symbols;
+    for (const CryptoSymbol* entry = SymbolCatalog::begin(); entry != SymbolCatalog::end(); entry++)
+    {
+        EXPECT_EQ(SymbolCatalog::find(entry->symbol), entry) << entry->symbol;
+        EXPECT_STRNE(entry->coinGeckoId, "") << entry->symbol;
+        symbols.insert(entry->symbol);
+    }
+    EXPECT_EQ(symbols.size(), SymbolCatalog::size());
+    EXPECT_EQ(SymbolCatalog::size(), 53u);
+    // listed by market cap, not by symbol
+    EXPECT_STREQ(SymbolCatalog::begin()->symbol, "BTC");
+}
+
+TEST(NativeSymbolCatalogTest, mapsSymbolsToEachSource)
+{
+    const CryptoSymbol* btc = SymbolCatalog::find("BTC");
+    ASSERT_NE(btc, nullptr);
+    EXPECT_STREQ(btc->coinGeckoId, "bitcoin");
+    EXPECT_TRUE(btc->binanceFiats & FiatBit::EUR);
+    EXPECT_FALSE(btc->binanceFiats & FiatBit::GBP);
+    EXPECT_EQ(btc->kuCoinFiats, FiatBit::USD);
+
+    const CryptoSymbol* leo = SymbolCatalog::find("LEO");
+    ASSERT_NE(leo, nullptr);
+    EXPECT_STREQ(leo->coinGeckoId, "leo-token");
+    EXPECT_EQ(leo->binanceFiats | leo->kuCoinFiats, 0);
+
+    EXPECT_GT(SymbolCatalog::find("TIA")->historyFromUnix, 0u);
+}
+
+TEST(NativeSymbolCatalogTest, rejectsWhatIsNotInIt)
+{
+    for (const char* symbol : {"", "btc", "BT", "BTCC", "AAA", "ZZZ", "bitcoin"})
+        EXPECT_EQ(SymbolCatalog::find(symbol), nullptr) << "'" << symbol << "'";
+
+    EXPECT_EQ(fiatBit("GBP"), FiatBit::GBP);
+    EXPECT_EQ(fiatBit("usd"), 0);
+    EXPECT_EQ(fiatBit("JPY"), 0);
+}
+
+// not a check, times building the map of ids as at boot and looking up each symbol in it against the catalog
+TEST(NativeSymbolCatalogTest, benchmarkLookup)
+{
+    constexpr int Iterations = 2000;
+    volatile size_t sink = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < Iterations; i++)
+    {
+        std::map<std::string, std::string> symbolToId;
+        for (const CryptoSymbol* entry = SymbolCatalog::begin(); entry != SymbolCatalog::end(); entry++)
+            symbolToId[entry->symbol] = entry->coinGeckoId;
+        for (const CryptoSymbol* entry = SymbolCatalog::begin(); entry != SymbolCatalog::end(); entry++)
+            sink += symbolToId[entry->symbol].size();
+    }
+    auto end = std::chrono::steady_clock::now();
+    double mapMicros = std::chrono::duration<double, std::micro>(end - start).count() / Iterations;
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < Iterations; i++)
+    {
+        for (const CryptoSymbol* entry = SymbolCatalog::begin(); entry != SymbolCatalog::end(); entry++)
+            sink += SymbolCatalog::find(entry->symbol)->coinGeckoId[0];
+    }
+    end = std::chrono::steady_clock::now();
+    double catalogMicros = std::chrono::duration<double, std::micro>(end - start).count() / Iterations;
+
+    printf("map %6.3f us  catalog %6.3f us\n", mapMicros, catalogMicros);
+}
@@ -0,0 +1,228 @@
+#include "TextLayout.h"
+#include <Adafruit_GFX.h>
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <random>
+#include <vector>
+
+namespace
+{
+    // a small font whose glyphs are all different, enough to tell the bounds apart, that can be measured at
+    // compile time
+    constexpr GFXglyph SmallGlyphs[] = {
+        {0, 0, 0, 4, 0, 1},    // ' '
+        {0, 2, 9, 4, 1, -9},   // '!'
+        {0, 6, 4, 7, 0, -9},   // '"'
+        {0, 8, 10, 9, -1, -10} // '#', reaches left of the cursor
+    };
+    constexpr GFXfont SmallFont = {nullptr, const_cast<GFXglyph*>(SmallGlyphs), ' ', '#', 12};
+
+    static_assert(TextLayout::bounds(SmallFont, "").w == 0, "nothing drawn has no width");
+    static_assert(TextLayout::bounds(SmallFont, "!").x == 1 && TextLayout::bounds(SmallFont, "!").w == 2,
+                  "one glyph is its own box");
+    static_assert(TextLayout::bounds(SmallFont, "!#").w == 10 && TextLayout::bounds(SmallFont, "!#").h == 10,
+                  "glyphs are placed by the advance of those before");
+    static_assert(TextLayout::bounds(SmallFont, "#!\n!").h == 22, "a new line moves down by the line's advance");
+
+    // a font of every printable character with made up metrics in the range of a FreeSans font of this size
+    struct GeneratedFont
+    {
+        GeneratedFont(uint8_t size, uint32_t seed) : glyphs('~' - ' ' + 1)
+        {
+            std::mt19937 random(seed);
+            for (auto& glyph : glyphs)
+            {
+                glyph.width = 1 + random() % size;
+                glyph.height = 1 + random() % (size + size / 2);
+                glyph.xOffset = (int8_t)(random() % 3) - 1;
+                glyph.yOffset = -(int8_t)(random() % (size + size / 2)) + 1;
+                glyph.xAdvance = glyph.width + glyph.xOffset + 1 + random() % 3;
+            }
+            glyphs[0] = {0, 0, 0, (uint8_t)(size / 3), 0, 1};
+            font = {nullptr, glyphs.data(), ' ', '~', (uint8_t)(size * 2)};
+        }
+
+        std::vector<GFXglyph> glyphs;
+        GFXfont font;
+    };
+
+    const GeneratedFont Sans18(18, 18), Sans12(12, 12), Sans9(9, 9);
+    const GFXfont* const CryptoFonts[] = {&Sans18.font, &Sans12.font, &Sans9.font};
+    constexpr size_t NumCryptoFonts = sizeof(CryptoFonts) / sizeof(CryptoFonts[0]);
+
+    // as the display manager's crypto box
+    constexpr uint16_t Padding = 6;
+    constexpr uint16_t DateBoxX1 = 15;
+    constexpr uint16_t MinWidth = 89;
+    constexpr uint16_t MaxWidth = 102;
+
+    CryptoBoxLayout cryptoBox(const char* crypto, const char* dayMonth = "Mon 1 Jan", const char* time = "12:00")
+    {
+        return TextLayout::cryptoBox(crypto, dayMonth, time, CryptoFonts, NumCryptoFonts, Sans9.font, Padding,
+                                     Padding, DateBoxX1, MinWidth, MaxWidth);
+    }
+
+    // how the display manager chose the font before, setting each one on the canvas in turn and asking it for the
+    // bounds of the symbol, the date and the time
+    void setCryptoBoxWidthWithCanvas(GFXcanvas1& canvas, const String& crypto, const String& dayMonth,
+                                     const String& time, const GFXfont*& font, uint16_t& width)
+    {
+        canvas.setFont(font);
+        int16_t tbx, tby; uint16_t tbw, tbh;
+        canvas.getTextBounds(crypto, 0, 0, &tbx, &tby, &tbw, &tbh);
+        uint16_t cryptoWidth = (2 * Padding) + tbw;
+
+        canvas.setFont(&Sans9.font);
+        canvas.getTextBounds(dayMonth, 0, 0, &tbx, &tby, &tbw, &tbh);
+        uint16_t dateWidth = (2 * Padding) + tbw;
+        canvas.getTextBounds(time, 0, 0, &tbx, &tby, &tbw, &tbh);
+        if (((2 * Padding) + tbw) > dateWidth)
+            dateWidth = (2 * Padding) + tbw;
+        dateWidth += DateBoxX1;
+        uint16_t maxWidth = cryptoWidth > dateWidth ? cryptoWidth : dateWidth;
+
+        if (maxWidth > MaxWidth && font == CryptoFonts[0])
+        {
+            font = CryptoFonts[1];
+            setCryptoBoxWidthWithCanvas(canvas, crypto, dayMonth, time, font, width);
+            return;
+        }
+        else if (maxWidth > MaxWidth && font != CryptoFonts[2])
+        {
+            font = CryptoFonts[2];
+            setCryptoBoxWidthWithCanvas(canvas, crypto, dayMonth, time, font, width);
+            return;
+        }
+
+        if (maxWidth < MinWidth)
+            width = MinWidth;
+        else if (maxWidth > MaxWidth)
+            width = MaxWidth;
+        else
+            width = maxWidth;
+    }
+}
+
+TEST(NativeTextLayoutTest, boundsAreTheSameAsTheCanvas)
+{
+    GFXcanvas1 canvas(250, 122);
+    canvas.setTextWrap(false);
+    std::mt19937 random(1);
+    for (const GFXfont* font : {&SmallFont, &Sans18.font, &Sans12.font, &Sans9.font})
+    {
+        canvas.setFont(font);
+        for (int i = 0; i < 200; i++)
+        {
+            // mostly characters in the font, with a few new lines and some outside it
+            String text;
+            int length = random() % 12;
+            for (int c = 0; c < length; c++)
+            {
+                int r = random() % 40;
+                text += r == 0 ? '\n' : r == 1 ? '\r' : r == 2 ? (char)0x7F : (char)(' ' + random() % 95);
+            }
+
+            int16_t tbx, tby; uint16_t tbw, tbh;
+            canvas.getTextBounds(text, 0, 0, &tbx, &tby, &tbw, &tbh);
+            TextBounds bounds = TextLayout::bounds(*font, text.c_str());
+            EXPECT_EQ(tbx, bounds.x) << "'" << text.c_str() << "'";
+            EXPECT_EQ(tby, bounds.y) << "'" << text.c_str() << "'";
+            EXPECT_EQ(tbw, bounds.w) << "'" << text.c_str() << "'";
+            EXPECT_EQ(tbh, bounds.h) << "'" << text.c_str() << "'";
+        }
+    }
+}
+
+TEST(NativeTextLayoutTest, shortSymbolUsesLargestFont)
+{
+    CryptoBoxLayout layout = cryptoBox("BTC");
+    EXPECT_EQ(&Sans18.font, layout.font);
+    EXPECT_TRUE(layout.fits);
+    EXPECT_GE(layout.width, MinWidth);
+    EXPECT_LE(layout.width, MaxWidth);
+}
+
+TEST(NativeTextLayoutTest, boxIsAtLeastTheMinimumWidth)
+{
+    CryptoBoxLayout layout = cryptoBox("", "", "");
+    EXPECT_EQ(&Sans18.font, layout.font);
+    EXPECT_EQ(MinWidth, layout.width);
+}
+
+TEST(NativeTextLayoutTest, longerSymbolsUseSmallerFonts)
+{
+    // the first font each fits in, measured one font at a time
+    for (const char* crypto : {"BTC", "DOGE", "MATIC", "SHIB", "AVAXUSD", "WWWWWWW", "WWWWWWWWWWWWWWWWWW"})
+    {
+        const GFXfont* expected = CryptoFonts[NumCryptoFonts-1];
+        for (const GFXfont* font : CryptoFonts)
+        {
+            if ((2 * Padding) + TextLayout::width(*font, crypto) <= MaxWidth)
+            {
+                expected = font;
+                break;
+            }
+        }
+        EXPECT_EQ(expected, cryptoBox(crypto).font) << crypto;
+    }
+}
+
+TEST(NativeTextLayoutTest, symbolTooLongForEveryFontIsTheMaximumWidth)
+{
+    CryptoBoxLayout layout = cryptoBox("ABCDEFGHIJKLMNOPQRSTUVWXYZ");
+    EXPECT_EQ(&Sans9.font, layout.font);
+    EXPECT_FALSE(layout.fits);
+    EXPECT_EQ(MaxWidth, layout.width);
+}
+
+TEST(NativeTextLayoutTest, layoutIsTheSameAsMeasuringOnTheCanvas)
+{
+    GFXcanvas1 canvas(250, 122);
+    for (const char* crypto : {"BTC", "DOGE", "MATIC", "SHIB", "AVAXUSD", "WWWWWWW", "WWWWWWWWWWWWWWWWWW"})
+    {
+        const GFXfont* font = CryptoFonts[0];
+        uint16_t width = 0;
+        setCryptoBoxWidthWithCanvas(canvas, crypto, "Mon 1 Jan", "12:00", font, width);
+
+        CryptoBoxLayout layout = cryptoBox(crypto);
+        EXPECT_EQ(font, layout.font) << crypto;
+        EXPECT_EQ(width, layout.width) << crypto;
+    }
+}
+
+// not a check, times choosing the crypto box's font and width by measuring on the canvas against the layout engine
+TEST(NativeTextLayoutTest, benchmarkCryptoBox)
+{
+    constexpr int Iterations = 20000;
+    GFXcanvas1 canvas(250, 122);
+    for (const char* crypto : {"BTC", "AVAXUSD", "WWWWWWWWWWWWWWWWWW"})
+    {
+        String cryptoString(crypto), dayMonth("Mon 1 Jan"), time("12:00");
+        const GFXfont* font = nullptr;
+        uint16_t width = 0;
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < Iterations; i++)
+        {
+            font = CryptoFonts[0];
+            setCryptoBoxWidthWithCanvas(canvas, cryptoString, dayMonth, time, font, width);
+        }
+        auto end = std::chrono::steady_clock::now();
+        double canvasMicros = std::chrono::duration<double, std::micro>(end - start).count() / Iterations;
+
+        CryptoBoxLayout layout = {};
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < Iterations; i++)
+        {
+            layout = cryptoBox(cryptoString.c_str(), dayMonth.c_str(), time.c_str());
+            asm volatile("" : : "r"(layout.font) : "memory"); // keep every call
+        }
+        end = std::chrono::steady_clock::now();
+        double layoutMicros = std::chrono::duration<double, std::micro>(end - start).count() / Iterations;
+
+        EXPECT_EQ(font, layout.font);
+        EXPECT_EQ(width, layout.width);
+        printf("%-20s canvas %6.2f us  layout %6.2f us\n", crypto, canvasMicros, layoutMicros);
+    }
+}
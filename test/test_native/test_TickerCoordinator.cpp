@@ -0,0 +1,172 @@
+#include "TickerCoordinator.h"
+#include "PriceHistoryStore.h"
+#include "SourceScoreboard.h"
+#include "SleepSchedule.h"
+#include "TimeKeeper.h"
+#include "Constants.h"
+#include <gtest/gtest.h>
+#include <GxEPD2_BW.h>
+#include <MockExchange.h>
+#include <SPIFFS.h>
+#include <WiFi.h>
+
+// ------------------------------------------------------------------------
+// The whole of a wake after setup() has read the battery and the button,
+// the config read from the fake SPIFFS, the connection to the fake access
+// point and the prices from the mock exchange, run on the virtual clock.
+// ------------------------------------------------------------------------
+
+namespace
+{
+    const char* const SimpleConfig = R"({"s":"home","p":"secret","c":"BTC","f":"USD","r":"5","t":"GMT0",)"
+                                     R"("d":"simple","w":"eth, btc,ETH"})";
+
+    // as the alert set up by setup()
+    void onAlert()
+    {
+        utils::ticker_deep_sleep(30 * constants::MicrosToSecondsFactor);
+    }
+
+    void writeConfig(const char* json)
+    {
+        File file = SPIFFS.open(constants::SpiffsConfigFileName, FILE_WRITE);
+        file.print(json);
+        file.close();
+    }
+}
+
+class NativeTickerCoordinatorTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        fake::device::reset();
+        fake::display::reset();
+        fake::spiffs::clear();
+        fake::wifi::clear();
+        fake::network::clear();
+        fake::exchange::clear();
+        SourceScoreboard::reset();
+        PriceHistoryStore::clear();
+        TimeKeeper::reset();
+
+        fake::wifi::AccessPoint accessPoint;
+        accessPoint.ssid = "home";
+        accessPoint.password = "secret";
+        fake::wifi::setAccessPoint(accessPoint);
+        fake::exchange::setPrice("BTC", "USD", 30000);
+
+        m_input = TickerInput{80, false, 0, 0, 1, false, 0, timerBegin(0, 80, true)};
+        timerAttachInterrupt(m_input.alert_timer, &onAlert, true);
+    }
+
+    void TearDown() override
+    {
+        fake::exchange::clear();
+        fake::network::clear();
+        fake::wifi::clear();
+        TimeKeeper::reset();
+    }
+
+    // returns the deep sleep the wake ended in, in micros, 0 if it hibernated or returned
+    uint64_t runWake()
+    {
+        return fake::device::wake([this]() { m_output = TickerCoordinator(m_input).run(); });
+    }
+
+    TickerInput m_input;
+    TickerOutput m_output{};
+};
+
+TEST_F(NativeTickerCoordinatorTest, readConfigFromSpiffs)
+{
+    writeConfig(SimpleConfig);
+
+    CurrentConfig cfg;
+    ASSERT_EQ(utils::readConfig(cfg), utils::ConfigState::CONFIG_OK);
+    EXPECT_EQ(cfg.ssid, "home");
+    EXPECT_EQ(cfg.pass, "secret");
+    EXPECT_EQ(cfg.crypto, "BTC");
+    EXPECT_EQ(cfg.refreshMins, "5");
+    EXPECT_EQ(cfg.displayMode, constants::ConfigDisplayModeSimple);
+    EXPECT_TRUE(cfg.is24Hour);
+    EXPECT_EQ(cfg.overnightSleepStart, -1);
+    EXPECT_EQ(cfg.watchlist, std::vector<String>({"ETH", "BTC"}));
+}
+
+TEST_F(NativeTickerCoordinatorTest, readConfigStates)
+{
+    CurrentConfig cfg;
+    EXPECT_EQ(utils::readConfig(cfg), utils::ConfigState::CONFIG_NO_FILE);
+
+    writeConfig(R"({"p":"secret","c":"BTC","f":"USD","r":"5","t":"GMT0","d":"simple"})");
+    EXPECT_EQ(utils::readConfig(cfg), utils::ConfigState::CONFIG_NO_SSID);
+
+    writeConfig(R"({"s":"home","p":"secret","f":"USD","r":"5","t":"GMT0","d":"simple"})");
+    EXPECT_EQ(utils::readConfig(cfg), utils::ConfigState::CONFIG_FAIL);
+
+    fake::spiffs::setMountFails(true);
+    EXPECT_EQ(utils::readConfig(cfg), utils::ConfigState::CONFIG_SPIFFS_ERROR);
+}
+
+TEST_F(NativeTickerCoordinatorTest, wakeShowsPricesUntilRefresh)
+{
+    writeConfig(R"({"s":"home","p":"secret","c":"BTC","f":"USD","r":"5","t":"GMT0","d":"simple"})");
+    fake::exchange::install();
+
+    EXPECT_EQ(runWake(), 0u);
+    EXPECT_EQ(m_output.refreshSeconds, 300);
+    EXPECT_FALSE(m_output.wifiFailed);
+    EXPECT_FALSE(m_output.dataFailed);
+    EXPECT_EQ(m_output.secondsLeftOfSleep, 0u);
+    EXPECT_GT(fake::display::refreshCount(), 0);
+    EXPECT_TRUE(fake::display::hibernating());
+}
+
+TEST_F(NativeTickerCoordinatorTest, wakeWithWrongPasswordBacksOff)
+{
+    writeConfig(R"({"s":"home","p":"wrong","c":"BTC","f":"USD","r":"5","t":"GMT0","d":"simple"})");
+    fake::exchange::install();
+    m_input.bootCount = 2;
+
+    runWake();
+    EXPECT_TRUE(m_output.wifiFailed);
+    EXPECT_EQ(m_output.refreshSeconds, SleepSchedule::secondsAfterWiFiFail(1));
+}
+
+TEST_F(NativeTickerCoordinatorTest, wakeWithoutDataSourcesBacksOff)
+{
+    writeConfig(R"({"s":"home","p":"secret","c":"BTC","f":"USD","r":"5","t":"GMT0","d":"simple"})");
+    m_input.numConsecutiveDataFails = 1;
+
+    runWake();
+    EXPECT_FALSE(m_output.wifiFailed);
+    EXPECT_TRUE(m_output.dataFailed);
+    EXPECT_EQ(m_output.refreshSeconds, SleepSchedule::secondsAfterDataFail(2));
+}
+
+TEST_F(NativeTickerCoordinatorTest, lowBatteryIsDrawnOnceThenHibernates)
+{
+    writeConfig(SimpleConfig);
+    m_input.batPercent = constants::MinimumAllowedBatteryPercent - 1;
+
+    EXPECT_EQ(runWake(), 0u);
+    EXPECT_TRUE(SPIFFS.exists(constants::SpiffsBatLogFileName));
+    int refreshes = fake::display::refreshCount();
+
+    EXPECT_EQ(runWake(), 0u);
+    EXPECT_EQ(fake::display::refreshCount(), refreshes);
+
+    m_input.batPercent = 50;
+    fake::exchange::install();
+    runWake();
+    EXPECT_FALSE(SPIFFS.exists(constants::SpiffsBatLogFileName));
+}
+
+TEST_F(NativeTickerCoordinatorTest, configModeWithoutConfigUntilTheAlert)
+{
+    EXPECT_EQ(runWake(), 30u * constants::MicrosToSecondsFactor);
+    EXPECT_EQ(WiFi.getMode(), WIFI_AP_STA);
+    EXPECT_GE(fake::clock::trueMicros() - fake::clock::DefaultStartMicros,
+              (int64_t)constants::ConfigAlertTimeSeconds * constants::MicrosToSecondsFactor);
+}
@@ -0,0 +1,58 @@
+#include "TimeKeeper.h"
+#include <gtest/gtest.h>
+
+class NativeTimeKeeperTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        fake::device::reset();
+        TimeKeeper::reset();
+    }
+
+    void TearDown() override
+    {
+        TimeKeeper::reset();
+    }
+
+    static constexpr uint64_t MicrosPerHour = 3600ULL * 1000000;
+};
+
+TEST_F(NativeTimeKeeperTest, syncSetsTimeAfterPowerOn)
+{
+    EXPECT_FALSE(TimeKeeper::hasValidTime());
+    ASSERT_TRUE(TimeKeeper::sync(5000));
+    EXPECT_TRUE(TimeKeeper::hasValidTime());
+    EXPECT_EQ(fake::device::ntpSyncCount(), 1);
+    EXPECT_EQ(fake::clock::systemMicros(), fake::clock::trueMicros());
+}
+
+TEST_F(NativeTimeKeeperTest, syncTimesOutWithoutNtp)
+{
+    fake::device::setNtpReachable(false);
+    uint32_t start = millis();
+    EXPECT_FALSE(TimeKeeper::sync(2000));
+    EXPECT_FALSE(TimeKeeper::hasValidTime());
+    EXPECT_GE(millis() - start, 2000u);
+}
+
+TEST_F(NativeTimeKeeperTest, learnsDriftAcrossDeepSleep)
+{
+    // gains 7.2 seconds an hour in deep sleep
+    fake::clock::setSleepDriftPpm(2000);
+    ASSERT_TRUE(TimeKeeper::sync(5000));
+
+    fake::clock::deepSleep(2 * MicrosPerHour);
+    EXPECT_NEAR((fake::clock::systemMicros() - fake::clock::trueMicros()) / 1e6, 14.4, 0.01);
+
+    ASSERT_TRUE(TimeKeeper::sync(5000));
+    TimeKeeperState state = TimeKeeper::getState();
+    EXPECT_EQ(state.driftSamples, 1);
+    EXPECT_NEAR(state.driftSecondsPerHour, -7.2, 0.05);
+
+    // the next wake is corrected without syncing
+    fake::clock::deepSleep(MicrosPerHour);
+    TimeKeeper::applyDriftCorrection();
+    EXPECT_NEAR((fake::clock::systemMicros() - fake::clock::trueMicros()) / 1e6, 0, 0.1);
+    EXPECT_EQ(fake::device::ntpSyncCount(), 2);
+}
@@ -0,0 +1,122 @@
+#include "TlsClient.h"
+#include "HttpBodyStream.h"
+#include "TlsSessionCache.h"
+#include <gtest/gtest.h>
+#include <WiFi.h>
+#include <SPIFFS.h>
+
+class NativeTlsClientTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        fake::device::reset();
+        fake::spiffs::clear();
+        fake::wifi::clear();
+        fake::network::clear();
+
+        fake::wifi::AccessPoint accessPoint;
+        accessPoint.ssid = "home";
+        accessPoint.password = "secret";
+        fake::wifi::setAccessPoint(accessPoint);
+        WiFi.mode(WIFI_STA);
+        ASSERT_EQ(WiFi.begin("home", "secret"), WL_CONNECTED);
+
+        fake::network::addServer(Host, [](const String& path)
+        {
+            fake::network::Response response;
+            response.body = "{\"path\":\"" + path + "\"}";
+            response.chunked = path.startsWith("/chunked");
+            response.latencyMillis = 100;
+            return response;
+        });
+    }
+
+    void TearDown() override
+    {
+        fake::network::clear();
+        fake::wifi::clear();
+    }
+
+    static String get(TlsClient& client, const String& path)
+    {
+        client.print("GET " + path + " HTTP/1.1\r\nHost: " + Host + "\r\n\r\n");
+        HttpBodyStream body(client);
+        if (!body.readHeaders() || body.statusCode() != 200)
+            return String();
+        return body.readString();
+    }
+
+    static constexpr const char* Host = "api.example.com";
+};
+
+TEST_F(NativeTlsClientTest, requestTakesNetworkTime)
+{
+    TlsClient client;
+    uint32_t start = millis();
+    ASSERT_TRUE(client.connect(Host, 443));
+    EXPECT_EQ(get(client, "/api/price"), "{\"path\":\"/api/price\"}");
+
+    // dns + tcp + full handshake + request, all on the virtual clock
+    uint32_t elapsed = millis() - start;
+    EXPECT_GE(elapsed, 20u + 40 + 2 * 40 + 40 + 100);
+    EXPECT_LT(elapsed, 2000u);
+    EXPECT_EQ(fake::network::handshakeCount(Host), 1);
+    EXPECT_EQ(fake::network::requestCount(Host), 1);
+    EXPECT_FALSE(client.resumedSession());
+}
+
+TEST_F(NativeTlsClientTest, keepAliveReusesConnection)
+{
+    TlsClient client;
+    ASSERT_TRUE(client.connect(Host, 443));
+    EXPECT_EQ(get(client, "/first"), "{\"path\":\"/first\"}");
+    EXPECT_TRUE(client.connected());
+    EXPECT_EQ(get(client, "/chunked/second"), "{\"path\":\"/chunked/second\"}");
+
+    EXPECT_EQ(fake::network::handshakeCount(Host), 1);
+    ASSERT_EQ(fake::network::requests().size(), 2u);
+    EXPECT_EQ(fake::network::requests()[1].path, "/chunked/second");
+}
+
+TEST_F(NativeTlsClientTest, serverClosesIdleConnection)
+{
+    TlsClient client;
+    ASSERT_TRUE(client.connect(Host, 443));
+    EXPECT_EQ(get(client, "/first"), "{\"path\":\"/first\"}");
+
+    delay(fake::network::ServerOptions().keepAliveMillis + 1);
+    client.available();
+    EXPECT_FALSE(client.connected());
+}
+
+TEST_F(NativeTlsClientTest, resumesSessionOnNextWake)
+{
+    TlsSessionStats before = TlsSessionCache::getStats();
+    {
+        TlsClient client;
+        ASSERT_TRUE(client.connect(Host, 443));
+        EXPECT_FALSE(client.resumedSession());
+    }
+
+    fake::clock::deepSleep(15 * 60 * 1000000ULL);
+    uint32_t start = millis();
+    TlsClient client;
+    ASSERT_TRUE(client.connect(Host, 443));
+    EXPECT_TRUE(client.resumedSession());
+    EXPECT_LT(millis() - start, 200u);
+
+    EXPECT_EQ(fake::network::handshakeCount(Host), 2);
+    EXPECT_EQ(fake::network::resumedHandshakeCount(Host), 1);
+    EXPECT_EQ(TlsSessionCache::getStats().hits, before.hits + 1);
+    EXPECT_EQ(TlsSessionCache::getStats().misses, before.misses + 1);
+}
+
+TEST_F(NativeTlsClientTest, serverDownFailsToConnect)
+{
+    fake::network::setServerDown(Host, true);
+    TlsClient client;
+    EXPECT_FALSE(client.connect(Host, 443));
+    EXPECT_FALSE(client.connect("unknown.example.com", 443));
+    EXPECT_EQ(fake::network::requestCount(Host), 0);
+}
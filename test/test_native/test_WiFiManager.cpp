@@ -0,0 +1,210 @@
+#include "WiFiManager.h"
+#include "PriceHistoryStore.h"
+#include "SourceScoreboard.h"
+#include "TimeKeeper.h"
+#include "Constants.h"
+#include <gtest/gtest.h>
+#include <MockExchange.h>
+#include <SPIFFS.h>
+
+namespace WiFiManagerLib
+{
+
+class NativeWiFiManagerTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        fake::device::reset();
+        fake::spiffs::clear();
+        fake::wifi::clear();
+        fake::network::clear();
+        fake::exchange::clear();
+        SourceScoreboard::reset();
+        PriceHistoryStore::clear();
+        TimeKeeper::reset();
+
+        fake::wifi::AccessPoint accessPoint;
+        accessPoint.ssid = "home";
+        accessPoint.password = "secret";
+        fake::wifi::setAccessPoint(accessPoint);
+    }
+
+    void TearDown() override
+    {
+        RequestBase::setServerOverride(String());
+        fake::exchange::clear();
+        fake::network::clear();
+        fake::wifi::clear();
+        TimeKeeper::reset();
+    }
+
+    // connects and gets the current price and the price a day ago, as a wake in simple mode does
+    // return the millis the requests took
+    uint32_t getPrices(Quotes& quotes_out, const String& fiat = "USD",
+                       TimeframeSet timeframes = {Timeframe::NOW, Timeframe::ONE_DAY})
+    {
+        fake::exchange::setPrice("BTC", fiat, 30000);
+        CurrentConfig cfg;
+        cfg.ssid = "home";
+        cfg.pass = "secret";
+        cfg.crypto = "BTC";
+        cfg.fiat = fiat;
+        cfg.refreshMins = "5";
+        cfg.tz = "GMT0";
+        EXPECT_EQ(m_wifiManager.initNormalMode(cfg, false, !m_sourcesAdded), WiFiStatus::OK);
+        m_sourcesAdded = true;
+
+        uint32_t start = millis();
+        m_wifiManager.getPriceData("BTC", fiat, timeframes, quotes_out);
+        uint32_t elapsed = millis() - start;
+        RecordProperty("awake_millis", static_cast<int>(elapsed));
+        return elapsed;
+    }
+
+    float expectedPrice(long unixOffset)
+    {
+        return fake::exchange::priceAt("BTC", "USD", m_wifiManager.getEpoch() - unixOffset);
+    }
+
+    WiFiManager m_wifiManager;
+    bool m_sourcesAdded = false;
+};
+
+TEST_F(NativeWiFiManagerTest, getsPricesFromMockExchange)
+{
+    fake::exchange::install();
+    Quotes quotes;
+    uint32_t elapsed = getPrices(quotes);
+
+    ASSERT_EQ(quotes.valid(), TimeframeSet({Timeframe::NOW, Timeframe::ONE_DAY}));
+    EXPECT_NEAR(quotes[Timeframe::NOW].price.toDouble(), expectedPrice(0), expectedPrice(0) * 0.01);
+    EXPECT_NEAR(quotes[Timeframe::ONE_DAY].price.toDouble(), expectedPrice(constants::SecondsOneDay), expectedPrice(0) * 0.01);
+    EXPECT_EQ(quotes[Timeframe::NOW].source, SourceId::COINGECKO);
+    // the stored daily samples are never close enough for 1d, so it has its own request and no history is filled
+    EXPECT_EQ(quotes[Timeframe::ONE_DAY].source, SourceId::COINGECKO);
+    EXPECT_EQ(fake::exchange::stats().historyRequests, 0);
+    EXPECT_LT(elapsed, 5000u);
+    EXPECT_EQ(fake::exchange::stats().rateLimited, 0);
+}
+
+TEST_F(NativeWiFiManagerTest, rateLimitedSourceFallsBack)
+{
+    fake::exchange::install();
+    fake::exchange::Faults faults;
+    faults.rateLimitRate = 1;
+    fake::exchange::setFaults(faults, "api.coingecko.com");
+
+    Quotes quotes;
+    getPrices(quotes);
+
+    ASSERT_EQ(quotes.valid(), TimeframeSet({Timeframe::NOW, Timeframe::ONE_DAY}));
+    EXPECT_EQ(quotes[Timeframe::NOW].source, SourceId::KUCOIN);
+    EXPECT_NEAR(quotes[Timeframe::NOW].price.toDouble(), expectedPrice(0), expectedPrice(0) * 0.01);
+    // a 429 isn't retried straight away, and the rest aren't tried on a source that hasn't answered anything
+    EXPECT_EQ(fake::exchange::stats().rateLimited, 1);
+    EXPECT_EQ(fake::exchange::stats().historyRequests, 0);
+}
+
+TEST_F(NativeWiFiManagerTest, serverErrorIsRetriedThenFallsBack)
+{
+    fake::exchange::install();
+    fake::exchange::Faults faults;
+    faults.serverErrorRate = 1;
+    fake::exchange::setFaults(faults, "api.coingecko.com");
+
+    Quotes quotes;
+    getPrices(quotes);
+
+    // the error bodies are never parsed as prices
+    ASSERT_EQ(quotes.valid(), TimeframeSet({Timeframe::NOW, Timeframe::ONE_DAY}));
+    EXPECT_EQ(quotes[Timeframe::NOW].source, SourceId::KUCOIN);
+    EXPECT_NEAR(quotes[Timeframe::NOW].price.toDouble(), expectedPrice(0), expectedPrice(0) * 0.01);
+    EXPECT_EQ(fake::exchange::stats().serverErrors, constants::WiFiRequestRetries);
+    // the retries are one failure of the wake, not enough on their own to cool the source down
+    SourceScore score = SourceScoreboard::getScore(SourceId::COINGECKO, "BTC", "USD", 0);
+    EXPECT_EQ(score.samples, 1);
+    EXPECT_EQ(score.consecutiveFailures, 1);
+    EXPECT_FALSE(score.coolingDown);
+}
+
+TEST_F(NativeWiFiManagerTest, sourcesWithoutThePairAreNeverAsked)
+{
+    // neither kucoin nor binance lists BTC/GBP, so with coingecko down nothing is sent to them either
+    fake::exchange::install();
+    fake::exchange::Faults faults;
+    faults.rateLimitRate = 1;
+    fake::exchange::setFaults(faults, "api.coingecko.com");
+
+    Quotes quotes;
+    getPrices(quotes, "GBP");
+
+    EXPECT_TRUE(quotes.valid().empty());
+    EXPECT_GT(fake::network::requestCount("api.coingecko.com"), 0);
+    EXPECT_EQ(fake::network::requestCount("api.kucoin.com"), 0);
+    EXPECT_EQ(fake::network::requestCount("api.binance.com"), 0);
+}
+
+TEST_F(NativeWiFiManagerTest, truncatedBodyFallsBack)
+{
+    fake::exchange::install();
+    fake::exchange::Faults faults;
+    faults.truncateRate = 1;
+    fake::exchange::setFaults(faults, "api.coingecko.com");
+
+    Quotes quotes;
+    getPrices(quotes);
+
+    ASSERT_EQ(quotes.valid(), TimeframeSet({Timeframe::NOW, Timeframe::ONE_DAY}));
+    EXPECT_EQ(quotes[Timeframe::NOW].source, SourceId::KUCOIN);
+    EXPECT_GT(fake::exchange::stats().truncated, 0);
+}
+
+TEST_F(NativeWiFiManagerTest, slowServerCostsAwakeTime)
+{
+    fake::exchange::install();
+    Quotes quotes;
+    uint32_t healthy = getPrices(quotes);
+    ASSERT_EQ(quotes.valid(), TimeframeSet({Timeframe::NOW, Timeframe::ONE_DAY}));
+
+    // the next wake, with the body trickling in slower than anything times out
+    fake::clock::deepSleep(5 * 60 * 1000000ULL);
+    fake::exchange::Faults faults;
+    faults.slowLorisRate = 1;
+    fake::exchange::setFaults(faults, "api.coingecko.com");
+    uint32_t slow = getPrices(quotes);
+
+    ASSERT_EQ(quotes.valid(), TimeframeSet({Timeframe::NOW, Timeframe::ONE_DAY}));
+    EXPECT_GT(fake::exchange::stats().slowLoris, 0);
+    EXPECT_GT(slow, healthy + 1000);
+}
+
+TEST_F(NativeWiFiManagerTest, storeIsFilledFromWhatTheSourceServes)
+{
+    // the store keeps more days than coingecko serves, the days before are left out of the history request
+    fake::exchange::install();
+    Quotes quotes;
+    getPrices(quotes, "USD", {Timeframe::NOW, Timeframe::THIRTY_DAYS});
+
+    ASSERT_EQ(quotes.valid(), TimeframeSet({Timeframe::NOW, Timeframe::THIRTY_DAYS}));
+    EXPECT_EQ(quotes[Timeframe::THIRTY_DAYS].source, SourceId::STORE);
+    EXPECT_EQ(fake::exchange::stats().historyRequests, 1);
+    EXPECT_EQ(fake::network::requestCount("api.kucoin.com"), 0);
+    EXPECT_EQ(SourceScoreboard::getScore(SourceId::COINGECKO, "BTC", "USD", constants::SecondsOneMonth).successRate, 1.0f);
+}
+
+TEST_F(NativeWiFiManagerTest, serverOverrideSendsEverySourceToOneHost)
+{
+    fake::exchange::install(fake::exchange::Options(), "mock.local");
+    RequestBase::setServerOverride("mock.local");
+
+    Quotes quotes;
+    getPrices(quotes);
+
+    ASSERT_EQ(quotes.valid(), TimeframeSet({Timeframe::NOW, Timeframe::ONE_DAY}));
+    EXPECT_EQ(quotes[Timeframe::NOW].source, SourceId::COINGECKO);
+    EXPECT_GT(fake::network::requestCount("mock.local"), 0);
+    EXPECT_EQ(fake::network::requestCount("api.coingecko.com"), 0);
+}
+
+} // namespace WiFiManagerLib
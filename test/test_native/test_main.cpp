@@ -0,0 +1,16 @@
+#include <gtest/gtest.h>
+#include <Arduino.h>
+
+// ------------------------------------------------------------------------
+// Host build of the ticker, run with: pio test -e native
+// The libs are built against the fakes in test/native/Fakes instead of the
+// ESP32 core, see "Native build" in the README. Everything runs on the
+// fake virtual clock, so the timings checked here are the ones the device
+// would see, without any of the tests taking that long.
+// ------------------------------------------------------------------------
+
+int main(int argc, char** argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
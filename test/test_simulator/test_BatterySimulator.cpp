@@ -0,0 +1,116 @@
+#include "BatterySimulator.h"
+#include <gtest/gtest.h>
+
+class BatterySimulatorTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        m_cfg.ssid = "home";
+        m_cfg.pass = "secret";
+        m_cfg.crypto = "BTC";
+        m_cfg.fiat = "USD";
+        m_cfg.refreshMins = "30";
+        m_cfg.tz = "GMT0BST,M3.5.0/1,M10.5.0";
+        m_cfg.displayMode = constants::ConfigDisplayModeSimple;
+    }
+
+    simulator::Result run(const char* name, int days, 
+                          const simulator::FailureProfile& failures = simulator::FailureProfile())
+    {
+        simulator::Result result = simulator::run(m_cfg, days, simulator::CurrentModel(), failures);
+        simulator::printReport(name, result);
+        RecordProperty("mah_per_day", std::to_string(result.milliampHoursPerDay()));
+        RecordProperty("wakes_per_day", std::to_string(result.wakesPerDay()));
+        return result;
+    }
+
+    utils::CurrentConfig m_cfg;
+};
+
+TEST_F(BatterySimulatorTest, refreshIntervalSetsWakes)
+{
+    m_cfg.refreshMins = "5";
+    simulator::Result fast = run("simple, 5 min", 7);
+    m_cfg.refreshMins = "60";
+    simulator::Result slow = run("simple, 60 min", 7);
+
+    // each wake takes a few seconds on top of the refresh time
+    EXPECT_NEAR(fast.wakesPerDay(), 24 * 12, 10);
+    EXPECT_NEAR(slow.wakesPerDay(), 24, 1);
+    EXPECT_EQ(slow.normalWakes, slow.wakes);
+    EXPECT_GT(fast.milliampHoursPerDay(), 5 * slow.milliampHoursPerDay());
+}
+
+TEST_F(BatterySimulatorTest, overnightSleepChainsWakes)
+{
+    simulator::Result awake = run("simple, 30 min", 14);
+    m_cfg.overnightSleepStart = 23;
+    m_cfg.overnightSleepLength = 8;
+    simulator::Result asleep = run("simple, 30 min, 8h night", 14);
+
+    // 16 hours of refreshes, then a chain of hour long sleeps and a short last one overnight
+    EXPECT_NEAR(asleep.normalWakes / asleep.days, 16 * 2 + 2, 2);
+    EXPECT_NEAR((asleep.wakes - asleep.normalWakes) / asleep.days, 7, 1);
+    EXPECT_LT(asleep.milliampHoursPerDay(), awake.milliampHoursPerDay() * 0.9);
+    // after the drift has been learned the time is only synced after each night and now and then in the day
+    EXPECT_LT(asleep.ntpSyncs / asleep.days, 6);
+}
+
+TEST_F(BatterySimulatorTest, wifiFailuresBackOff)
+{
+    simulator::FailureProfile failures;
+    failures.wifiFailRate = 1;
+    m_cfg.refreshMins = "5";
+    simulator::Result down = run("simple, 5 min, no WiFi", 7, failures);
+
+    // backs off to an hour, the failure is drawn every wake as the first one was on the first boot, which
+    // also drew the config
+    EXPECT_NEAR(down.wakesPerDay(), 24, 2);
+    EXPECT_EQ(down.wifiFails, down.normalWakes);
+    EXPECT_EQ(down.draws, down.normalWakes + 1);
+}
+
+TEST_F(BatterySimulatorTest, flakyNetworkCostsMore)
+{
+    simulator::Result steady = run("simple, 30 min", 14);
+
+    simulator::FailureProfile failures;
+    failures.wifiFailRate = 0.05f;
+    failures.dataFailRate = 0.1f;
+    failures.ntpFailRate = 0.1f;
+    simulator::Result flaky = run("simple, 30 min, flaky", 14, failures);
+
+    EXPECT_GT(flaky.dataFails, 0);
+    EXPECT_GT(flaky.wifiFails, 0);
+    // a failure is retried after a minute rather than waiting for the next refresh
+    EXPECT_GT(flaky.wakesPerDay(), steady.wakesPerDay());
+    EXPECT_GT(flaky.milliampHoursPerDay(), steady.milliampHoursPerDay());
+}
+
+TEST_F(BatterySimulatorTest, readmeConfigLastsOneMonth)
+{
+    // the 1 month in the README: hourly refresh, in advanced mode, asleep overnight
+    m_cfg.refreshMins = "60";
+    m_cfg.displayMode = constants::ConfigDisplayModeAdvanced;
+    m_cfg.overnightSleepStart = 23;
+    m_cfg.overnightSleepLength = 8;
+
+    simulator::FailureProfile failures;
+    failures.wifiFailRate = 0.02f;
+    failures.dataFailRate = 0.05f;
+    simulator::Result result = run("advanced, 60 min, 8h night", 90, failures);
+
+    EXPECT_GE(result.batteryDays(), 30);
+}
+
+TEST_F(BatterySimulatorTest, historyIsOnlyRequestedForWhatIsNotKept)
+{
+    m_cfg.refreshMins = "60";
+    m_cfg.displayMode = constants::ConfigDisplayModeAdvanced;
+    simulator::Result result = run("advanced, 60 min", 90);
+
+    // a day ago until the prices kept in RTC memory go back that far, then the daily samples filled on the
+    // first wake and topped up every 30 days
+    EXPECT_NEAR(result.historyRequests, 24 + 3, 2);
+}
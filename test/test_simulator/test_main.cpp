@@ -0,0 +1,16 @@
+#include <gtest/gtest.h>
+#include <Arduino.h>
+
+// ------------------------------------------------------------------------
+// Battery life of the ticker, run with: pio test -e native -f test_simulator
+// Each test runs weeks or months of wakes on the virtual clock through the
+// real sleep scheduling, see BatterySimulator.h, and prints the predicted
+// mAh and wakes per day. Change the configs and the current model here to
+// check a config before putting it on a device.
+// ------------------------------------------------------------------------
+
+int main(int argc, char** argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}